@@ -5,6 +5,7 @@
 #include "../Actions.hpp"
 
 #define HOVER_INFO_SIZE 64
+#define TRACE_FILE_PATH "meltdown_trace.json"
 
 ProfilerGui::ProfilerGui() : windowSize{350.0f, 250.0f}, windowPos{20.0f, 450.0f}
 {
@@ -23,6 +24,9 @@ void ProfilerGui::renderGui()
 	ImGui::SetNextWindowPos(windowPos, ImGuiCond_FirstUseEver);
 	ImGui::Begin("Frame Profiler", &showWindow);
 
+	if(ImGui::Button("Export trace"))
+		mtd::Profiler::exportChromeTrace(TRACE_FILE_PATH);
+
 	profilerGraphic();
 
 	ImGui::End();
@@ -35,6 +39,7 @@ void ProfilerGui::profilerGraphic()
 
 	ImGui::Text("Total frame duration: %3.3f ms", profileData.totalFrameTime);
 	ImGui::Text("Framerate: %4.1f FPS", 1000.0f / profileData.totalFrameTime);
+	ImGui::Text("Draw calls: %u", profileData.drawCallCount);
 
 	ImDrawList* drawList = ImGui::GetWindowDrawList();
 	ImVec2 canvasSize = ImGui::GetContentRegionAvail();
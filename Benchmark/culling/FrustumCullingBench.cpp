@@ -0,0 +1,341 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <numeric>
+#include <random>
+#include <string_view>
+
+#include <Culling/BoundingVolumeHierarchy.hpp>
+#include <Jobs/JobScheduler.hpp>
+
+// Command line options of the frustum culling benchmark
+struct CullingBenchOptions
+{
+	// Bounding boxes tested in each run
+	uint32_t boxCount = 1000000U;
+	// Timed runs of each culling method
+	uint32_t runCount = 5U;
+	// Boxes removed, inserted and moved in the incremental hierarchy changes
+	uint32_t changeCount = 10000U;
+	// Job system worker threads (hardware concurrency if zero)
+	uint32_t workerCount = 0U;
+};
+
+// Prints the available command line options
+static void printUsage()
+{
+	printf
+	(
+		"Usage: meltdown_culling_bench [options]\n"
+		"  --boxes <count>    Bounding boxes tested in each run (default: 1000000)\n"
+		"  --runs <count>     Timed runs of each culling method (default: 5)\n"
+		"  --changes <count>  Boxes removed, inserted and moved in the hierarchy (default: 10000)\n"
+		"  --workers <count>  Job system worker threads (default: hardware concurrency - 1)\n"
+	);
+}
+
+// Fills the options with the command line arguments, returning false for invalid arguments
+static bool parseArguments(int argc, char** argv, CullingBenchOptions& options)
+{
+	for(int i = 1; i < argc; i++)
+	{
+		std::string_view argument{argv[i]};
+		if(argument == "--help" || i + 1 >= argc)
+			return false;
+
+		const char* value = argv[++i];
+		if(argument == "--boxes")
+			options.boxCount = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if(argument == "--runs")
+			options.runCount = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if(argument == "--changes")
+			options.changeCount = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if(argument == "--workers")
+			options.workerCount = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else
+		{
+			fprintf(stderr, "[BENCH] Unknown option: \"%s\".\n", argv[i - 1]);
+			return false;
+		}
+	}
+	return options.boxCount > 0U && options.runCount > 0U;
+}
+
+// Scatters rotated and scaled boxes around the camera, so part of them is inside the frustum
+static std::vector<mtd::RenderObject> generateRenderObjects(uint32_t count)
+{
+	std::mt19937 generator{42U};
+	std::uniform_real_distribution<float> position{-150.0f, 150.0f};
+	std::uniform_real_distribution<float> angle{0.0f, 6.2831853f};
+	std::uniform_real_distribution<float> size{0.25f, 2.0f};
+
+	std::vector<mtd::RenderObject> renderObjects;
+	renderObjects.reserve(count);
+	for(uint32_t i = 0U; i < count; i++)
+	{
+		float yaw = angle(generator);
+		float scale = size(generator);
+		mtd::Mat4x4 transform
+		{
+			scale * std::cos(yaw), 0.0f, -scale * std::sin(yaw), 0.0f,
+			0.0f, scale, 0.0f, 0.0f,
+			scale * std::sin(yaw), 0.0f, scale * std::cos(yaw), 0.0f,
+			position(generator), position(generator), position(generator), 1.0f
+		};
+		mtd::Vec3 center{0.0f, 0.5f * size(generator), 0.0f};
+		mtd::Vec3 extent{size(generator), size(generator), size(generator)};
+
+		renderObjects.push_back(mtd::RenderObject{transform, 0U, 0U, 1U, 0U, center, 0.0f, extent, 0.0f});
+	}
+	return renderObjects;
+}
+
+// Moves half of the render objects slightly, so the hierarchy only refits their ancestors, and the other half to
+// random positions, so their leaves are inserted again
+static void moveRenderObjects(std::vector<mtd::RenderObject>& renderObjects, const std::vector<uint32_t>& indices)
+{
+	std::mt19937 generator{7U};
+	std::uniform_real_distribution<float> offset{-0.5f, 0.5f};
+	std::uniform_real_distribution<float> position{-150.0f, 150.0f};
+
+	for(uint32_t i = 0U; i < indices.size(); i++)
+	{
+		mtd::Vec4& translation = renderObjects[indices[i]].transform.w;
+		if(i % 2U == 0U)
+			translation += mtd::Vec4{offset(generator), offset(generator), offset(generator), 0.0f};
+		else
+			translation = mtd::Vec4{position(generator), position(generator), position(generator), 1.0f};
+	}
+}
+
+// World bounding box of a render object, as used by the engine hierarchy
+static mtd::BoundingBox getWorldBounds(const mtd::RenderObject& renderObject)
+{
+	return mtd::BoundingBox::fromTransformedBox
+	(
+		renderObject.transform, renderObject.centerAABB, renderObject.extentAABB
+	);
+}
+
+// Perspective projection of a camera at the origin looking at +Z, built as in the engine camera
+static mtd::Mat4x4 createProjectionView()
+{
+	const float cotanY = 1.0f / std::tan(0.5f * 70.0f * 3.14159265f / 180.0f);
+	const float aspectRatio = 16.0f / 9.0f;
+	const float nearPlane = 0.1f;
+	const float farPlane = 200.0f;
+
+	return mtd::Mat4x4
+	{
+		cotanY / aspectRatio, 0.0f, 0.0f, 0.0f,
+		0.0f, cotanY, 0.0f, 0.0f,
+		0.0f, 0.0f, farPlane / (farPlane - nearPlane), 1.0f,
+		0.0f, 0.0f, (nearPlane * farPlane) / (nearPlane - farPlane), 0.0f
+	};
+}
+
+// Runs the culling several times, returning the fastest time in milliseconds
+template<typename Culling>
+static double measure(uint32_t runCount, const Culling& culling)
+{
+	double bestTime = 0.0;
+	for(uint32_t run = 0U; run < runCount; run++)
+	{
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		culling();
+		std::chrono::duration<double, std::milli> elapsedTime = std::chrono::steady_clock::now() - startTime;
+		if(run == 0U || elapsedTime.count() < bestTime)
+			bestTime = elapsedTime.count();
+	}
+	return bestTime;
+}
+
+// Converts the keys found by the hierarchy to a visibility array
+static std::vector<uint8_t> toVisibility(const std::vector<uint32_t>& keys, uint32_t boxCount)
+{
+	std::vector<uint8_t> visibility(boxCount, 0U);
+	for(uint32_t key: keys)
+		visibility[key] = 1U;
+	return visibility;
+}
+
+// Counts the boxes with a different result in each visibility array
+static uint32_t countMismatches(const std::vector<uint8_t>& reference, const std::vector<uint8_t>& visibility)
+{
+	uint32_t mismatchCount = 0U;
+	for(size_t i = 0UL; i < reference.size(); i++)
+		mismatchCount += (reference[i] != visibility[i]) ? 1U : 0U;
+	return mismatchCount;
+}
+
+// Times the scalar, vectorized, multithreaded and hierarchical frustum culling, checking that they agree, and the
+// build and incremental changes of the bounding volume hierarchy
+int main(int argc, char** argv)
+{
+	CullingBenchOptions options{};
+	if(!parseArguments(argc, argv, options))
+	{
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	std::vector<mtd::RenderObject> renderObjects = generateRenderObjects(options.boxCount);
+	mtd::FrustumPlanes planes = mtd::FrustumCulling::extractPlanes(createProjectionView());
+	mtd::JobScheduler jobScheduler{options.workerCount};
+
+	std::vector<uint32_t> keys(options.boxCount);
+	std::iota(keys.begin(), keys.end(), 0U);
+	std::vector<mtd::BoundingBox> boxes(options.boxCount);
+	for(uint32_t i = 0U; i < options.boxCount; i++)
+		boxes[i] = getWorldBounds(renderObjects[i]);
+
+	std::vector<uint8_t> scalarVisibility(options.boxCount);
+	double scalarTime = measure(options.runCount, [&]()
+	{
+		mtd::FrustumCulling::cullRangeScalar(planes, renderObjects.data(), options.boxCount, scalarVisibility.data());
+	});
+
+	std::vector<uint8_t> vectorVisibility(options.boxCount);
+	double vectorTime = measure(options.runCount, [&]()
+	{
+		mtd::FrustumCulling::cullRange(planes, renderObjects.data(), options.boxCount, vectorVisibility.data());
+	});
+
+	std::vector<uint8_t> parallelVisibility;
+	double parallelTime = measure(options.runCount, [&]()
+	{
+		mtd::FrustumCulling::cullRenderObjects(planes, renderObjects, parallelVisibility);
+	});
+
+	mtd::BoundingVolumeHierarchy hierarchy{};
+	double buildTime = measure(options.runCount, [&]()
+	{
+		hierarchy.build(keys, boxes);
+	});
+
+	std::vector<uint32_t> hierarchyKeys;
+	double hierarchyTime = measure(options.runCount, [&]()
+	{
+		hierarchyKeys.clear();
+		hierarchy.cullFrustum(planes, hierarchyKeys);
+	});
+	std::vector<uint8_t> hierarchyVisibility = toVisibility(hierarchyKeys, options.boxCount);
+
+	uint32_t visibleCount = 0U;
+	for(uint8_t visible: scalarVisibility)
+		visibleCount += visible;
+
+	// Boxes touching a plane may flip when the compiler fuses the multiplications and additions differently
+	uint32_t mismatchCount = countMismatches(scalarVisibility, vectorVisibility)
+		+ countMismatches(scalarVisibility, parallelVisibility)
+		+ countMismatches(scalarVisibility, hierarchyVisibility);
+	const uint32_t allowedMismatches = options.boxCount / 100000U;
+
+	// Removes part of the boxes, inserts them back and moves them, as the render object manager does with the
+	// changed scene instances
+	std::vector<uint32_t> changedKeys = keys;
+	std::shuffle(changedKeys.begin(), changedKeys.end(), std::mt19937{13U});
+	changedKeys.resize(std::min(options.changeCount, options.boxCount));
+
+	double removeTime = measure(1U, [&]()
+	{
+		for(uint32_t key: changedKeys)
+			hierarchy.remove(key);
+	});
+	uint32_t removedKeysKept = static_cast<uint32_t>
+	(
+		std::count_if(changedKeys.cbegin(), changedKeys.cend(), [&](uint32_t key) { return hierarchy.contains(key); })
+	);
+	uint32_t remainingLeafCount = hierarchy.getLeafCount();
+
+	double insertTime = measure(1U, [&]()
+	{
+		for(uint32_t key: changedKeys)
+			hierarchy.insert(key, boxes[key]);
+	});
+
+	moveRenderObjects(renderObjects, changedKeys);
+	for(uint32_t key: changedKeys)
+		boxes[key] = getWorldBounds(renderObjects[key]);
+	double updateTime = measure(1U, [&]()
+	{
+		for(uint32_t key: changedKeys)
+			hierarchy.update(key, boxes[key]);
+	});
+
+	// With a still camera, the render object manager only tests the changed render objects again
+	std::sort(changedKeys.begin(), changedKeys.end());
+	double retestTime = measure(options.runCount, [&]()
+	{
+		mtd::FrustumCulling::cullRenderObjects(planes, renderObjects, changedKeys, parallelVisibility);
+	});
+
+	mtd::FrustumCulling::cullRangeScalar(planes, renderObjects.data(), options.boxCount, scalarVisibility.data());
+	hierarchyKeys.clear();
+	hierarchy.cullFrustum(planes, hierarchyKeys);
+	uint32_t changedMismatchCount = countMismatches(scalarVisibility, toVisibility(hierarchyKeys, options.boxCount))
+		+ countMismatches(scalarVisibility, parallelVisibility);
+
+	printf
+	(
+		"[BENCH] %u boxes, %u visible (%.1f%%), %s, %u worker threads\n",
+		options.boxCount, visibleCount, 100.0 * visibleCount / options.boxCount,
+		mtd::FrustumCulling::getInstructionSet(), jobScheduler.getWorkerCount()
+	);
+	printf
+	(
+		"[BENCH] Scalar:         %9.3f ms (%8.1f M boxes/s)\n", scalarTime, 0.001 * options.boxCount / scalarTime
+	);
+	printf
+	(
+		"[BENCH] Vectorized:     %9.3f ms (%8.1f M boxes/s)\n", vectorTime, 0.001 * options.boxCount / vectorTime
+	);
+	printf
+	(
+		"[BENCH] Multithreaded:  %9.3f ms (%8.1f M boxes/s)\n", parallelTime, 0.001 * options.boxCount / parallelTime
+	);
+	printf
+	(
+		"[BENCH] Hierarchical:   %9.3f ms (%8.1f M boxes/s)\n",
+		hierarchyTime, 0.001 * options.boxCount / hierarchyTime
+	);
+	printf
+	(
+		"[BENCH] Speedup: %.2fx vectorized, %.2fx multithreaded, %.2fx hierarchical\n",
+		scalarTime / vectorTime, scalarTime / parallelTime, scalarTime / hierarchyTime
+	);
+	printf("[BENCH] Hierarchy build: %9.3f ms\n", buildTime);
+	printf
+	(
+		"[BENCH] Hierarchy changes of %zu boxes: %.3f ms removal, %.3f ms insertion, %.3f ms update\n",
+		changedKeys.size(), removeTime, insertTime, updateTime
+	);
+	printf("[BENCH] Changed boxes tested again: %.3f ms\n", retestTime);
+
+	if(mismatchCount > allowedMismatches)
+	{
+		fprintf(stderr, "[BENCH] The culling methods disagree on %u boxes.\n", mismatchCount);
+		return EXIT_FAILURE;
+	}
+	if(removedKeysKept != 0U || remainingLeafCount != options.boxCount - changedKeys.size())
+	{
+		fprintf
+		(
+			stderr, "[BENCH] The hierarchy kept %u removed boxes, with %u leaves left.\n",
+			removedKeysKept, remainingLeafCount
+		);
+		return EXIT_FAILURE;
+	}
+	if(changedMismatchCount > allowedMismatches)
+	{
+		fprintf
+		(
+			stderr,
+			"[BENCH] The changed boxes disagree with the scalar culling on %u boxes.\n", changedMismatchCount
+		);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,118 @@
+#include "LegacyObjParser.hpp"
+
+#include <fstream>
+
+namespace LegacyObjParser
+{
+	// Data bundle for the .obj loader
+	struct ObjData
+	{
+		std::vector<mtd::Vertex>& vertices;
+		std::vector<uint32_t>& indices;
+		std::vector<mtd::Vec3> positions;
+		std::vector<mtd::Vec2> textureCoordinates;
+		std::vector<mtd::Vec3> normals;
+		std::unordered_map<std::string, uint32_t> history;
+	};
+
+	// Separates a line into substrings, using the specified delimiter
+	static void split(std::string line, std::string delimiter, std::vector<std::string>& output);
+	// Parses each triangle of a face, returning the number of triangles
+	static size_t readFaceData(const std::vector<std::string>& words, ObjData& data);
+	// Parses a single vertex
+	static void readVertex(const std::string& vertexDescription, ObjData& data);
+}
+
+void LegacyObjParser::parse
+(
+	const std::string& filePath,
+	std::unordered_map<std::string, uint32_t>& materialIDs,
+	std::vector<mtd::Vertex>& vertices,
+	std::vector<uint32_t>& indices,
+	std::vector<uint16_t>& materialIndices
+)
+{
+	std::string line;
+	std::vector<std::string> words;
+	uint16_t currentMaterialID = 0;
+
+	ObjData data{vertices, indices};
+
+	std::ifstream file;
+	file.open(filePath);
+	while(std::getline(file, line))
+	{
+		split(line, " ", words);
+
+		if(!words[0].compare("v"))
+			data.positions.emplace_back(std::stof(words[1]), std::stof(words[2]), std::stof(words[3]));
+		else if(!words[0].compare("vt"))
+			data.textureCoordinates.emplace_back(std::stof(words[1]), std::stof(words[2]));
+		else if(!words[0].compare("vn"))
+			data.normals.emplace_back(std::stof(words[1]), std::stof(words[2]), std::stof(words[3]));
+		else if(!words[0].compare("f"))
+		{
+			const size_t triangleCount = readFaceData(words, data);
+			materialIndices.insert(materialIndices.cend(), triangleCount, currentMaterialID);
+		}
+		else if(!words[0].compare("usemtl"))
+			currentMaterialID = materialIDs[words[1]];
+	}
+	file.close();
+}
+
+void LegacyObjParser::split(std::string line, std::string delimiter, std::vector<std::string>& output)
+{
+	output.clear();
+
+	size_t pos = line.find(delimiter);
+	while(pos != std::string::npos)
+	{
+		output.push_back(line.substr(0, pos));
+		line.erase(0, pos + delimiter.length());
+
+		pos = line.find(delimiter);
+	}
+
+	output.push_back(line);
+}
+
+size_t LegacyObjParser::readFaceData(const std::vector<std::string>& words, ObjData& data)
+{
+	size_t triangleCount = words.size() - 3;
+	for(size_t i = 0; i < triangleCount; i++)
+	{
+		readVertex(words[1], data);
+		readVertex(words[2 + i], data);
+		readVertex(words[3 + i], data);
+	}
+	return triangleCount;
+}
+
+void LegacyObjParser::readVertex(const std::string& vertexDescription, ObjData& data)
+{
+	if(data.history.contains(vertexDescription))
+	{
+		data.indices.push_back(data.history[vertexDescription]);
+		return;
+	}
+
+	uint32_t index = static_cast<uint32_t>(data.history.size());
+	data.history.insert({vertexDescription, index});
+	data.indices.push_back(index);
+
+	std::vector<std::string> fullVertexData;
+	split(vertexDescription, "/", fullVertexData);
+
+	mtd::Vec3 pos = data.positions[stol(fullVertexData[0]) - 1];
+
+	mtd::Vec2 texCoord{0.0f, 0.0f};
+	if(fullVertexData.size() > 1 && fullVertexData[1].size() > 0)
+		texCoord = data.textureCoordinates[stol(fullVertexData[1]) - 1];
+
+	mtd::Vec3 normal{0.0f, 0.0f, -1.0f};
+	if(fullVertexData.size() > 2 && fullVertexData[2].size() > 0)
+		normal = data.normals[stol(fullVertexData[2]) - 1];
+
+	data.vertices.emplace_back(pos, texCoord, normal);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <Utils/EngineStructs.hpp>
+
+// Previous line based .obj parser of the engine, kept as the benchmark baseline
+namespace LegacyObjParser
+{
+	// Parses the triangles of the .obj file with getline, string splitting and string keyed vertex welding
+	void parse
+	(
+		const std::string& filePath,
+		std::unordered_map<std::string, uint32_t>& materialIDs,
+		std::vector<mtd::Vertex>& vertices,
+		std::vector<uint32_t>& indices,
+		std::vector<uint16_t>& materialIndices
+	);
+}
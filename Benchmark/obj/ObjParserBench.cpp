@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+
+#include <Jobs/JobScheduler.hpp>
+#include <Utils/MappedFile.hpp>
+#include <Vulkan/Mesh/ObjParser.hpp>
+
+#include "LegacyObjParser.hpp"
+
+// Triangles of the material boundary check, enough for the text to be split into several chunks
+#define MATERIAL_BOUNDARY_TRIANGLES 16384U
+
+// Command line options of the OBJ parser benchmark
+struct ObjBenchOptions
+{
+	// Triangles of the generated mesh
+	uint32_t triangleCount = 1000000U;
+	// Timed runs of each parser
+	uint32_t runCount = 3U;
+	// Job system worker threads (hardware concurrency if zero)
+	uint32_t workerCount = 0U;
+	// Existing .obj file to parse instead of the generated mesh
+	std::string filePath;
+};
+
+// Results of a parser run, compared between both parsers
+struct ParsedMesh
+{
+	std::vector<mtd::Vertex> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<uint16_t> materialIndices;
+};
+
+// Prints the available command line options
+static void printUsage()
+{
+	printf
+	(
+		"Usage: meltdown_obj_bench [options]\n"
+		"  --triangles <count>  Triangles of the generated grid mesh (default: 1000000)\n"
+		"  --runs <count>       Timed runs of each parser (default: 3)\n"
+		"  --workers <count>    Job system worker threads (default: hardware concurrency - 1)\n"
+		"  --file <path>        Parses an existing .obj file instead of the generated mesh\n"
+	);
+}
+
+// Fills the options with the command line arguments, returning false for invalid arguments
+static bool parseArguments(int argc, char** argv, ObjBenchOptions& options)
+{
+	for(int i = 1; i < argc; i++)
+	{
+		std::string_view argument{argv[i]};
+		if(argument == "--help" || i + 1 >= argc)
+			return false;
+
+		const char* value = argv[++i];
+		if(argument == "--triangles")
+			options.triangleCount = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if(argument == "--runs")
+			options.runCount = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if(argument == "--workers")
+			options.workerCount = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if(argument == "--file")
+			options.filePath = value;
+		else
+		{
+			fprintf(stderr, "[BENCH] Unknown option: \"%s\".\n", argv[i - 1]);
+			return false;
+		}
+	}
+	return options.triangleCount > 0U && options.runCount > 0U;
+}
+
+// Writes a wavy grid made of quads, with normals, texture coordinates and a material change per row band
+static bool generateGridMesh(const std::string& filePath, uint32_t triangleCount)
+{
+	const uint32_t quadsPerSide = std::max(static_cast<uint32_t>(std::sqrt(triangleCount / 2.0)), 1U);
+	const uint32_t verticesPerSide = quadsPerSide + 1U;
+
+	std::ofstream file{filePath};
+	if(!file) return false;
+
+	file << "mtllib grid.mtl\no Grid\n";
+	char line[128];
+	for(uint32_t y = 0U; y < verticesPerSide; y++)
+	{
+		for(uint32_t x = 0U; x < verticesPerSide; x++)
+		{
+			float height = 0.1f * std::sin(0.3f * x) * std::cos(0.2f * y);
+			snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", static_cast<float>(x), height, static_cast<float>(y));
+			file << line;
+		}
+	}
+	for(uint32_t y = 0U; y < verticesPerSide; y++)
+	{
+		for(uint32_t x = 0U; x < verticesPerSide; x++)
+		{
+			snprintf(line, sizeof(line), "vt %.6f %.6f\n", x / static_cast<float>(quadsPerSide), y / static_cast<float>(quadsPerSide));
+			file << line;
+		}
+	}
+	file << "vn 0.0000 1.0000 0.0000\nvn 0.0000 0.9950 0.0998\n";
+
+	const uint32_t rowsPerMaterial = std::max(quadsPerSide / 4U, 1U);
+	for(uint32_t y = 0U; y < quadsPerSide; y++)
+	{
+		if(y % rowsPerMaterial == 0U)
+			file << ((y / rowsPerMaterial) % 2U == 0U ? "usemtl grid_a\n" : "usemtl grid_b\n");
+
+		for(uint32_t x = 0U; x < quadsPerSide; x++)
+		{
+			uint32_t a = y * verticesPerSide + x + 1U;
+			uint32_t b = a + 1U;
+			uint32_t c = a + verticesPerSide + 1U;
+			uint32_t d = a + verticesPerSide;
+			uint32_t n = 1U + (x + y) % 2U;
+			snprintf(line, sizeof(line), "f %u/%u/%u %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, n, b, b, n, c, c, n, d, d, n);
+			file << line;
+		}
+	}
+	return static_cast<bool>(file);
+}
+
+// Writes a triangle per material change, with material names long enough that the chunks almost always end right
+// after a "usemtl" line, so the material selected at the end of a chunk must carry over to the next one
+static bool generateMaterialBoundaryMesh(const std::string& filePath, const std::string (&materialNames)[2])
+{
+	std::ofstream file{filePath};
+	if(!file) return false;
+
+	file << "v 0.0 0.0 0.0\nv 1.0 0.0 0.0\nv 0.0 1.0 0.0\n";
+	for(uint32_t i = 0U; i < MATERIAL_BOUNDARY_TRIANGLES; i++)
+		file << "usemtl " << materialNames[i % 2U] << "\nf 1 2 3\n";
+	return static_cast<bool>(file);
+}
+
+// Parses the same mesh with both parsers, returning the results
+static void parseOnce
+(
+	const std::string& filePath,
+	const std::unordered_map<std::string, uint32_t>& materialIDs,
+	ParsedMesh& legacyMesh,
+	ParsedMesh& parallelMesh
+)
+{
+	std::unordered_map<std::string, uint32_t> legacyMaterialIDs{materialIDs};
+	LegacyObjParser::parse
+	(
+		filePath, legacyMaterialIDs, legacyMesh.vertices, legacyMesh.indices, legacyMesh.materialIndices
+	);
+
+	mtd::MappedFile objFile{filePath};
+	std::string_view objText{reinterpret_cast<const char*>(objFile.getData()), objFile.getSize()};
+	mtd::ObjParser::parse
+	(
+		objText, materialIDs, parallelMesh.vertices, parallelMesh.indices, parallelMesh.materialIndices
+	);
+}
+
+// Runs the parser several times, returning the fastest time in milliseconds
+template<typename Parser>
+static double measure(uint32_t runCount, ParsedMesh& parsedMesh, const Parser& parser)
+{
+	double bestTime = 0.0;
+	for(uint32_t run = 0U; run < runCount; run++)
+	{
+		parsedMesh = ParsedMesh{};
+		std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+		parser(parsedMesh);
+		std::chrono::duration<double, std::milli> elapsedTime = std::chrono::steady_clock::now() - startTime;
+		if(run == 0U || elapsedTime.count() < bestTime)
+			bestTime = elapsedTime.count();
+	}
+	return bestTime;
+}
+
+// Checks if both parsers produced the same triangles
+static bool compareResults(const ParsedMesh& legacy, const ParsedMesh& parallel)
+{
+	return legacy.indices == parallel.indices
+		&& legacy.materialIndices == parallel.materialIndices
+		&& legacy.vertices.size() == parallel.vertices.size()
+		&& std::memcmp(legacy.vertices.data(), parallel.vertices.data(), legacy.vertices.size() * sizeof(mtd::Vertex)) == 0;
+}
+
+// Times the previous and the parallel OBJ parsers on the same file, checking that both agree
+int main(int argc, char** argv)
+{
+	ObjBenchOptions options{};
+	if(!parseArguments(argc, argv, options))
+	{
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	bool generatedFile = options.filePath.empty();
+	if(generatedFile)
+	{
+		options.filePath = (std::filesystem::temp_directory_path() / "meltdown_obj_bench.obj").string();
+		if(!generateGridMesh(options.filePath, options.triangleCount))
+		{
+			fprintf(stderr, "[BENCH] Failed to write the generated mesh to \"%s\".\n", options.filePath.c_str());
+			return EXIT_FAILURE;
+		}
+	}
+	double fileSizeMiB = std::filesystem::file_size(options.filePath) / (1024.0 * 1024.0);
+
+	mtd::JobScheduler jobScheduler{options.workerCount};
+	std::unordered_map<std::string, uint32_t> materialIDs{{"grid_a", 0U}, {"grid_b", 1U}};
+
+	ParsedMesh legacyMesh;
+	double legacyTime = measure
+	(
+		options.runCount, legacyMesh,
+		[&](ParsedMesh& mesh)
+		{
+			std::unordered_map<std::string, uint32_t> legacyMaterialIDs{materialIDs};
+			LegacyObjParser::parse
+			(
+				options.filePath, legacyMaterialIDs, mesh.vertices, mesh.indices, mesh.materialIndices
+			);
+		}
+	);
+
+	ParsedMesh parallelMesh;
+	double parallelTime = measure
+	(
+		options.runCount, parallelMesh,
+		[&](ParsedMesh& mesh)
+		{
+			mtd::MappedFile objFile{options.filePath};
+			std::string_view objText{reinterpret_cast<const char*>(objFile.getData()), objFile.getSize()};
+			mtd::ObjParser::parse(objText, materialIDs, mesh.vertices, mesh.indices, mesh.materialIndices);
+		}
+	);
+
+	if(generatedFile)
+		std::filesystem::remove(options.filePath);
+
+	const std::string materialNames[2]{"boundary_a_" + std::string(120, 'a'), "boundary_b_" + std::string(120, 'b')};
+	std::unordered_map<std::string, uint32_t> boundaryMaterialIDs{{materialNames[0], 0U}, {materialNames[1], 1U}};
+	std::string boundaryFilePath = (std::filesystem::temp_directory_path() / "meltdown_obj_bench_mtl.obj").string();
+	ParsedMesh legacyBoundaryMesh;
+	ParsedMesh parallelBoundaryMesh;
+	if(!generateMaterialBoundaryMesh(boundaryFilePath, materialNames))
+	{
+		fprintf(stderr, "[BENCH] Failed to write the material boundary mesh to \"%s\".\n", boundaryFilePath.c_str());
+		return EXIT_FAILURE;
+	}
+	parseOnce(boundaryFilePath, boundaryMaterialIDs, legacyBoundaryMesh, parallelBoundaryMesh);
+	std::filesystem::remove(boundaryFilePath);
+
+	printf
+	(
+		"[BENCH] %.1f MiB, %zu triangles, %zu vertices, %u worker threads\n",
+		fileSizeMiB, parallelMesh.materialIndices.size(), parallelMesh.vertices.size(), jobScheduler.getWorkerCount()
+	);
+	printf("[BENCH] Legacy parser:   %9.2f ms (%7.1f MiB/s)\n", legacyTime, 1000.0 * fileSizeMiB / legacyTime);
+	printf("[BENCH] Parallel parser: %9.2f ms (%7.1f MiB/s)\n", parallelTime, 1000.0 * fileSizeMiB / parallelTime);
+	printf("[BENCH] Speedup: %.2fx\n", legacyTime / parallelTime);
+
+	if(!compareResults(legacyMesh, parallelMesh))
+	{
+		fprintf(stderr, "[BENCH] The parsers produced different meshes.\n");
+		return EXIT_FAILURE;
+	}
+	if(!compareResults(legacyBoundaryMesh, parallelBoundaryMesh))
+	{
+		fprintf(stderr, "[BENCH] The parsers disagree on the materials selected at the end of a chunk.\n");
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,124 @@
+#include "Benchmark.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+#ifndef MTD_RESOURCES_PATH
+	#define MTD_RESOURCES_PATH "./resources/"
+#endif
+
+Benchmark::Benchmark(const BenchmarkSettings& settings)
+	: settings{settings},
+	meltdownEngine
+	{
+		mtd::EngineInfo
+		{
+			"Meltdown Benchmark", 1U, 0U, 0U, settings.enableRayTracing, true, settings.width, settings.height
+		}
+	}
+{
+	if(this->settings.scenes.empty())
+		findScenes();
+}
+
+void Benchmark::run()
+{
+	for(const std::string& sceneFile: settings.scenes)
+	{
+		if(!isSceneSupported(sceneFile))
+		{
+			printf("[BENCH] Skipping \"%s\": ray tracing is not enabled.\n", sceneFile.c_str());
+			continue;
+		}
+		replayScene(sceneFile);
+	}
+}
+
+nlohmann::json Benchmark::createReport() const
+{
+	nlohmann::json report =
+	{
+		{"bench-version", BENCH_REPORT_VERSION},
+		{"frames", settings.frameCount},
+		{"warmup-frames", settings.warmupFrames},
+		{"delta-time", settings.deltaTime},
+		{"resolution", {settings.width, settings.height}},
+		{"scenes", nlohmann::json::object()}
+	};
+
+	for(const auto& [sceneFile, stageSamples]: sceneSamples)
+		report["scenes"][sceneFile] = Report::createSceneReport(stageSamples);
+
+	return report;
+}
+
+void Benchmark::findScenes()
+{
+	std::filesystem::path scenesPath{MTD_RESOURCES_PATH "scenes/"};
+	if(!std::filesystem::is_directory(scenesPath))
+	{
+		fprintf(stderr, "[BENCH] Scenes folder not found: \"%s\".\n", scenesPath.string().c_str());
+		return;
+	}
+
+	for(const std::filesystem::directory_entry& entry: std::filesystem::directory_iterator{scenesPath})
+	{
+		if(entry.is_regular_file() && entry.path().extension() == ".json")
+			settings.scenes.push_back(entry.path().filename().string());
+	}
+
+	// Directory iteration order is unspecified, so the scenes are sorted to keep runs comparable
+	std::sort(settings.scenes.begin(), settings.scenes.end());
+}
+
+bool Benchmark::isSceneSupported(const std::string& sceneFile) const
+{
+	if(meltdownEngine.isRayTracingEnabled()) return true;
+
+	std::ifstream file{MTD_RESOURCES_PATH "scenes/" + sceneFile};
+	nlohmann::json sceneJson = nlohmann::json::parse(file, nullptr, false);
+	if(sceneJson.is_discarded()) return true;
+
+	const nlohmann::json& rayTracingPipelines = sceneJson.value("ray-tracing-pipelines", nlohmann::json::array());
+	return rayTracingPipelines.empty();
+}
+
+void Benchmark::replayScene(const std::string& sceneFile)
+{
+	using ChronoClock = std::chrono::steady_clock;
+	using ChronoDuration = std::chrono::duration<float, std::milli>;
+
+	printf("[BENCH] Replaying \"%s\" for %u frames...\n", sceneFile.c_str(), settings.frameCount);
+
+	meltdownEngine.loadScene(sceneFile.c_str());
+	meltdownEngine.runFrames(settings.warmupFrames, settings.deltaTime, [](double) {});
+
+	Report::StageSamples& stageSamples = sceneSamples[sceneFile];
+	stageSamples[TOTAL_FRAME_STAGE].reserve(settings.frameCount);
+	uint64_t drawCallCount = 0UL;
+
+	for(uint32_t frame = 0U; frame < settings.frameCount; frame++)
+	{
+		ChronoClock::time_point frameStart = ChronoClock::now();
+		meltdownEngine.runFrames(1U, settings.deltaTime, [](double) {});
+		ChronoDuration frameDuration = ChronoClock::now() - frameStart;
+
+		stageSamples[TOTAL_FRAME_STAGE].push_back(frameDuration.count());
+
+		const mtd::Profiler::FrameData& frameData = mtd::Profiler::getProfiledData();
+		for(const auto& [stageName, stageTime]: frameData.stageTimes)
+			stageSamples[stageName].push_back(stageTime);
+		drawCallCount += frameData.drawCallCount;
+	}
+
+	Report::StageStatistics totalStatistics = Report::computeStatistics(stageSamples[TOTAL_FRAME_STAGE]);
+	printf
+	(
+		"[BENCH] \"%s\": p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms, %.1f draw calls per frame\n",
+		sceneFile.c_str(), totalStatistics.p50, totalStatistics.p95, totalStatistics.p99, totalStatistics.max,
+		static_cast<double>(drawCallCount) / std::max(settings.frameCount, 1U)
+	);
+}
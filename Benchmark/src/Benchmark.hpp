@@ -0,0 +1,62 @@
+#pragma once
+
+#include <map>
+
+#include <Meltdown.hpp>
+
+#include "Report.hpp"
+
+// Options for replaying the scenes
+struct BenchmarkSettings
+{
+	// Frames measured for each scene
+	uint32_t frameCount = 600U;
+	// Frames rendered before measuring, to let caches and allocations settle
+	uint32_t warmupFrames = 60U;
+	// Fixed time step passed to every update, in seconds
+	double deltaTime = 1.0 / 60.0;
+
+	// Offscreen render resolution
+	uint32_t width = 1280U;
+	uint32_t height = 720U;
+
+	// Enables ray tracing scenes when the hardware supports it
+	bool enableRayTracing = false;
+
+	// Scene files to replay (all scenes in the resources folder when empty)
+	std::vector<std::string> scenes;
+};
+
+// Replays scenes headlessly and collects the frame stage times
+class Benchmark
+{
+	public:
+		Benchmark(const BenchmarkSettings& settings);
+		~Benchmark() = default;
+
+		Benchmark(const Benchmark&) = delete;
+		Benchmark& operator=(const Benchmark&) = delete;
+
+		// Replays every selected scene
+		void run();
+
+		// Builds the JSON report with the statistics of every scene stage
+		nlohmann::json createReport() const;
+
+	private:
+		// Replay configuration
+		BenchmarkSettings settings;
+		// Headless engine instance
+		mtd::MeltdownEngine meltdownEngine;
+
+		// Frame time samples, in milliseconds, indexed by scene and by stage
+		std::map<std::string, Report::StageSamples> sceneSamples;
+
+		// Lists all JSON scenes available in the resources folder
+		void findScenes();
+		// Checks if the scene can be rendered with the current engine configuration
+		bool isSceneSupported(const std::string& sceneFile) const;
+
+		// Renders the scene for the configured amount of frames, storing the measured times
+		void replayScene(const std::string& sceneFile);
+};
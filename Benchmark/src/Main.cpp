@@ -0,0 +1,156 @@
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string_view>
+
+#include "Benchmark.hpp"
+
+// Command line options besides the replay settings
+struct CommandLineOptions
+{
+	// Path of the JSON report to be written
+	std::string outputPath = "meltdown_bench.json";
+	// Path of the Chrome trace exported after the replay (no trace if empty)
+	std::string tracePath;
+	// Path of a previous report to compare against (no comparison if empty)
+	std::string baselinePath;
+	// Relative slowdown that counts as a regression
+	double regressionThreshold = 0.10;
+	// Absolute slowdown, in milliseconds, ignored as measurement noise
+	double minimumDeltaMs = 0.02;
+};
+
+// Prints the available command line options
+static void printUsage()
+{
+	printf
+	(
+		"Usage: meltdown_bench [options]\n"
+		"  --frames <count>          Measured frames per scene (default: 600)\n"
+		"  --warmup <count>          Unmeasured frames before measuring (default: 60)\n"
+		"  --delta-time <seconds>    Fixed update time step (default: 0.016667)\n"
+		"  --resolution <w>x<h>      Offscreen render resolution (default: 1280x720)\n"
+		"  --scenes <a.json,b.json>  Scenes to replay (default: all scenes in resources/scenes)\n"
+		"  --ray-tracing             Enables ray tracing scenes, if supported by the hardware\n"
+		"  --output <file>           JSON report path (default: meltdown_bench.json)\n"
+		"  --trace <file>            Exports the profiler trace of the last frames in the Chrome format\n"
+		"  --baseline <file>         Previous report to compare against\n"
+		"  --threshold <fraction>    Slowdown considered a regression (default: 0.10)\n"
+		"  --min-delta <ms>          Slowdown ignored as noise, in milliseconds (default: 0.02)\n"
+	);
+}
+
+// Fills the settings with the command line arguments, returning false for invalid arguments
+static bool parseArguments(int argc, char** argv, BenchmarkSettings& settings, CommandLineOptions& options)
+{
+	for(int i = 1; i < argc; i++)
+	{
+		std::string_view argument{argv[i]};
+		if(argument == "--ray-tracing")
+		{
+			settings.enableRayTracing = true;
+			continue;
+		}
+		if(argument == "--help")
+			return false;
+
+		if(i + 1 >= argc)
+		{
+			fprintf(stderr, "[BENCH] Missing value for \"%s\".\n", argv[i]);
+			return false;
+		}
+		const char* value = argv[++i];
+
+		if(argument == "--frames")
+			settings.frameCount = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if(argument == "--warmup")
+			settings.warmupFrames = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else if(argument == "--delta-time")
+			settings.deltaTime = std::strtod(value, nullptr);
+		else if(argument == "--resolution")
+		{
+			if(sscanf(value, "%ux%u", &settings.width, &settings.height) != 2)
+			{
+				fprintf(stderr, "[BENCH] Invalid resolution: \"%s\".\n", value);
+				return false;
+			}
+		}
+		else if(argument == "--scenes")
+		{
+			std::stringstream sceneList{value};
+			std::string sceneFile;
+			while(std::getline(sceneList, sceneFile, ','))
+				if(!sceneFile.empty()) settings.scenes.push_back(sceneFile);
+		}
+		else if(argument == "--output")
+			options.outputPath = value;
+		else if(argument == "--trace")
+			options.tracePath = value;
+		else if(argument == "--baseline")
+			options.baselinePath = value;
+		else if(argument == "--threshold")
+			options.regressionThreshold = std::strtod(value, nullptr);
+		else if(argument == "--min-delta")
+			options.minimumDeltaMs = std::strtod(value, nullptr);
+		else
+		{
+			fprintf(stderr, "[BENCH] Unknown option: \"%s\".\n", argv[i - 1]);
+			return false;
+		}
+	}
+
+	if(settings.frameCount == 0U || settings.width == 0U || settings.height == 0U || settings.deltaTime <= 0.0)
+	{
+		fprintf(stderr, "[BENCH] The frame count, resolution and delta time must be positive.\n");
+		return false;
+	}
+	return true;
+}
+
+// Replays the scenes, writes the report and compares it against the baseline, if any
+int main(int argc, char** argv)
+{
+	BenchmarkSettings settings{};
+	CommandLineOptions options{};
+	if(!parseArguments(argc, argv, settings, options))
+	{
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	nlohmann::json report;
+	{
+		Benchmark benchmark{settings};
+		benchmark.run();
+		report = benchmark.createReport();
+	}
+
+	if(!options.tracePath.empty() && !mtd::Profiler::exportChromeTrace(options.tracePath.c_str()))
+		fprintf(stderr, "[BENCH] Failed to export trace: \"%s\".\n", options.tracePath.c_str());
+
+	std::ofstream outputFile{options.outputPath};
+	if(!outputFile)
+	{
+		fprintf(stderr, "[BENCH] Failed to write report: \"%s\".\n", options.outputPath.c_str());
+		return EXIT_FAILURE;
+	}
+	outputFile << report.dump(4) << '\n';
+	printf("[BENCH] Report saved to \"%s\".\n", options.outputPath.c_str());
+
+	if(options.baselinePath.empty()) return EXIT_SUCCESS;
+
+	std::ifstream baselineFile{options.baselinePath};
+	nlohmann::json baseline = nlohmann::json::parse(baselineFile, nullptr, false);
+	if(!baselineFile || baseline.is_discarded())
+	{
+		fprintf(stderr, "[BENCH] Failed to read baseline: \"%s\".\n", options.baselinePath.c_str());
+		return EXIT_FAILURE;
+	}
+
+	bool passed = Report::compareWithBaseline
+	(
+		report, baseline, options.regressionThreshold, options.minimumDeltaMs
+	);
+	return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
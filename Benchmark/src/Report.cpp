@@ -0,0 +1,176 @@
+#include "Report.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+
+// Percentiles compared against the baseline
+static constexpr std::array<const char*, 2> comparedMetrics{"p50", "p95"};
+
+// Stage recording all render passes, which replaced the stages of each pipeline and of the GUI in version 0.2.0
+#define RECORD_PASSES_STAGE "Render - Record render passes"
+
+// Nearest-rank percentile of sorted samples
+static float percentile(const std::vector<float>& sortedSamples, double fraction)
+{
+	size_t rank = static_cast<size_t>(std::ceil(fraction * sortedSamples.size()));
+	return sortedSamples[std::clamp<size_t>(rank, 1UL, sortedSamples.size()) - 1UL];
+}
+
+Report::StageStatistics Report::computeStatistics(std::vector<float> samples)
+{
+	StageStatistics statistics{};
+	if(samples.empty()) return statistics;
+
+	std::sort(samples.begin(), samples.end());
+
+	statistics.p50 = percentile(samples, 0.50);
+	statistics.p95 = percentile(samples, 0.95);
+	statistics.p99 = percentile(samples, 0.99);
+	statistics.max = samples.back();
+	statistics.sampleCount = static_cast<uint32_t>(samples.size());
+
+	return statistics;
+}
+
+nlohmann::json Report::createSceneReport(const StageSamples& stageSamples)
+{
+	nlohmann::json sceneReport = nlohmann::json::object();
+
+	for(const auto& [stageName, samples]: stageSamples)
+	{
+		StageStatistics statistics = computeStatistics(samples);
+		sceneReport[stageName] =
+		{
+			{"p50", statistics.p50},
+			{"p95", statistics.p95},
+			{"p99", statistics.p99},
+			{"max", statistics.max},
+			{"samples", statistics.sampleCount}
+		};
+	}
+
+	return sceneReport;
+}
+
+// Merges the render pass stages of a version 0.1.0 baseline, missing from the current report, into the stage that
+// replaced them, summing their percentiles as an upper bound for the merged stage
+static nlohmann::json migrateBaselineStages
+(
+	const nlohmann::json& baselineStages, const nlohmann::json& currentStages, const std::string& sceneName
+)
+{
+	if(!currentStages.contains(RECORD_PASSES_STAGE) || baselineStages.contains(RECORD_PASSES_STAGE))
+		return baselineStages;
+
+	nlohmann::json migratedStages = nlohmann::json::object();
+	nlohmann::json mergedStats = nlohmann::json::object();
+	for(const char* metric: comparedMetrics)
+		mergedStats[metric] = 0.0;
+
+	for(const auto& [stageName, baselineStats]: baselineStages.items())
+	{
+		if(currentStages.contains(stageName))
+		{
+			migratedStages[stageName] = baselineStats;
+			continue;
+		}
+
+		for(const char* metric: comparedMetrics)
+			mergedStats[metric] = mergedStats[metric].get<double>() + baselineStats.value(metric, 0.0);
+		printf
+		(
+			"[BENCH] Stage \"%s\" of scene \"%s\" merged into \"" RECORD_PASSES_STAGE "\".\n",
+			stageName.c_str(), sceneName.c_str()
+		);
+	}
+	migratedStages[RECORD_PASSES_STAGE] = std::move(mergedStats);
+
+	return migratedStages;
+}
+
+bool Report::compareWithBaseline
+(
+	const nlohmann::json& report,
+	const nlohmann::json& baseline,
+	double relativeThreshold,
+	double minimumDeltaMs
+)
+{
+	if(!baseline.contains("scenes") || !baseline["scenes"].is_object())
+	{
+		fprintf(stderr, "[BENCH] The baseline has no scene data to compare against.\n");
+		return false;
+	}
+
+	// Until version 0.2.0, each render pass pipeline was measured as a separate stage
+	bool migrationRequired = (baseline.value("bench-version", "") == "0.1.0");
+	if(migrationRequired)
+	{
+		printf
+		(
+			"[BENCH] The baseline was written by report version 0.1.0. Its render pass stages are merged for the "
+			"comparison, and the baseline should be regenerated.\n"
+		);
+	}
+
+	uint32_t regressionCount = 0U;
+	for(const auto& [sceneName, baselineStages]: baseline["scenes"].items())
+	{
+		if(!report["scenes"].contains(sceneName))
+		{
+			printf("[BENCH] Scene \"%s\" is in the baseline but was not replayed.\n", sceneName.c_str());
+			continue;
+		}
+		const nlohmann::json& currentStages = report["scenes"][sceneName];
+		nlohmann::json comparedStages = migrationRequired
+			? migrateBaselineStages(baselineStages, currentStages, sceneName)
+			: baselineStages;
+
+		for(const auto& [stageName, baselineStats]: comparedStages.items())
+		{
+			if(!currentStages.contains(stageName))
+			{
+				printf
+				(
+					"[BENCH] Stage \"%s\" of scene \"%s\" was not measured.\n", stageName.c_str(), sceneName.c_str()
+				);
+				continue;
+			}
+			const nlohmann::json& currentStats = currentStages[stageName];
+
+			for(const char* metric: comparedMetrics)
+			{
+				double baselineTime = baselineStats.value(metric, 0.0);
+				double currentTime = currentStats.value(metric, 0.0);
+				double delta = currentTime - baselineTime;
+
+				if(delta <= minimumDeltaMs || delta <= relativeThreshold * baselineTime) continue;
+
+				fprintf
+				(
+					stderr,
+					"[BENCH] REGRESSION in \"%s\" / \"%s\" (%s): %.4f ms -> %.4f ms (+%.1f%%)\n",
+					sceneName.c_str(), stageName.c_str(), metric,
+					baselineTime, currentTime, 100.0 * delta / baselineTime
+				);
+				regressionCount++;
+			}
+		}
+	}
+
+	if(regressionCount != 0U)
+	{
+		fprintf
+		(
+			stderr,
+			"[BENCH] %u regression(s) above %.1f%% found when comparing against the baseline.\n",
+			regressionCount, 100.0 * relativeThreshold
+		);
+		return false;
+	}
+
+	printf("[BENCH] No regressions above %.1f%% found.\n", 100.0 * relativeThreshold);
+	return true;
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+// Version of the report layout, increased when the JSON structure or the measured stages change
+#define BENCH_REPORT_VERSION "0.2.0"
+
+// Name of the stage holding the whole frame duration
+#define TOTAL_FRAME_STAGE "Total frame"
+
+// Statistics and baseline comparison of the benchmark results
+namespace Report
+{
+	// Frame time samples, in milliseconds, indexed by the stage name
+	using StageSamples = std::map<std::string, std::vector<float>>;
+
+	// Summary of the samples of a single stage, in milliseconds
+	struct StageStatistics
+	{
+		float p50 = 0.0f;
+		float p95 = 0.0f;
+		float p99 = 0.0f;
+		float max = 0.0f;
+		uint32_t sampleCount = 0U;
+	};
+
+	// Calculates the percentiles and the maximum value of the samples
+	StageStatistics computeStatistics(std::vector<float> samples);
+
+	// Converts the samples of every stage to their JSON statistics
+	nlohmann::json createSceneReport(const StageSamples& stageSamples);
+
+	// Compares a report against a baseline, returning false if any stage regressed above the threshold
+	bool compareWithBaseline
+	(
+		const nlohmann::json& report,
+		const nlohmann::json& baseline,
+		double relativeThreshold,
+		double minimumDeltaMs
+	);
+}
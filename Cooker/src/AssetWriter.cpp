@@ -0,0 +1,393 @@
+#include "AssetWriter.hpp"
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <system_error>
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+#include "Compression.hpp"
+#include "ContentHash.hpp"
+
+using namespace Cooked;
+
+namespace AssetWriter
+{
+	constexpr uint64_t MESH_MAGIC = "MTD_MESH"_u64;
+	constexpr uint64_t MESH_FILE_VERSION = 2UL;
+	constexpr uint64_t MATERIAL_MAGIC = "MTD_MTRL"_u64;
+	constexpr uint64_t MATERIAL_FILE_VERSION = 2UL;
+	constexpr uint64_t SCENE_MAGIC = "MTD_SCNE"_u64;
+	constexpr uint64_t SCENE_FILE_VERSION = 1UL;
+	constexpr uint64_t ARCHIVE_MAGIC = "MTD_MPAK"_u64;
+	constexpr uint64_t ARCHIVE_FILE_VERSION = 1UL;
+	constexpr uint64_t ARCHIVE_ENTRY_ALIGNMENT = 4096UL;
+	// Compression identifiers of the archive entries
+	constexpr uint32_t ARCHIVE_UNCOMPRESSED = 0U;
+	constexpr uint32_t ARCHIVE_LZ4 = 1U;
+	// Encodings of the version 2 mesh and material blocks, and the uncompressed size of their chunks
+	constexpr uint32_t BLOCK_RAW = 0U;
+	constexpr uint32_t BLOCK_CHUNKED_LZ4 = 1U;
+	constexpr uint32_t BLOCK_CHUNK_SIZE = 256U << 10;
+
+	// Mesh asset file header, as read by the engine mesh loader
+	struct MeshHeader
+	{
+		uint64_t magic;
+		uint64_t version;
+		uint32_t vertexStride;
+		Vec3 centerAABB;
+		Vec3 extentAABB;
+	};
+	static_assert(sizeof(MeshHeader) == 48, "The mesh header must match the engine layout.");
+
+	// Submesh block entry, as stored in the GPU submesh buffer
+	struct SubmeshData
+	{
+		uint32_t indexOffset;
+		uint32_t indexCount;
+		uint32_t materialSlot;
+		uint32_t padding0;
+		Vec3 centerAABB;
+		float padding1;
+		Vec3 extentAABB;
+		float padding2;
+	};
+	static_assert(sizeof(SubmeshData) == 48, "The submesh data must match the engine layout.");
+
+	// Block header of the version 2 mesh and material files
+	struct EncodedBlockHeader
+	{
+		uint64_t blockID;
+		uint64_t blockSize;
+		uint64_t uncompressedSize;
+		uint32_t encoding;
+		uint32_t chunkSize;
+	};
+	static_assert(sizeof(EncodedBlockHeader) == 32, "The block header must match the engine layout.");
+
+	// Block ready to be written, with its data compressed if that saves enough space
+	struct EncodedBlock
+	{
+		EncodedBlockHeader header;
+		const void* pData;
+		std::vector<uint8_t> compressedData;
+	};
+
+	// Archive file header, followed by the table of contents
+	struct ArchiveHeader
+	{
+		uint64_t magic;
+		uint64_t version;
+		uint32_t entryCount;
+		uint32_t slotCount;
+		uint64_t tableOffset;
+		uint64_t pathTableOffset;
+		uint64_t pathTableSize;
+	};
+	static_assert(sizeof(ArchiveHeader) == 48, "The archive header must match the engine layout.");
+
+	// Table of contents slot, empty if its path length is zero
+	struct ArchiveEntry
+	{
+		uint64_t pathHash;
+		uint64_t dataOffset;
+		uint64_t storedSize;
+		uint64_t size;
+		uint32_t pathOffset;
+		uint32_t pathLength;
+		uint32_t compression;
+		uint32_t padding;
+	};
+	static_assert(sizeof(ArchiveEntry) == 48, "The archive entry must match the engine layout.");
+
+	// Float attributes of the ray tracing materials, following the shader layout
+	struct MaterialFloatAttributes
+	{
+		float diffuse[4];
+		float emissionAndIoR[4];
+		float roughness;
+		float metallic;
+		float padding[2];
+	};
+
+	// Compresses the block data in chunks, keeping it raw unless that saves at least an eighth of its size
+	static void encodeBlock(uint64_t blockID, const void* pData, size_t size, EncodedBlock& block);
+	// Encodes a string table block: the string count, followed by the null terminated strings
+	static std::string encodeStringTable(const std::vector<std::string>& strings);
+
+	// Writes the data to a temporary file, replacing the output only if everything was written
+	static bool writeAtomically
+	(
+		const std::filesystem::path& outputPath, const std::vector<std::pair<const void*, size_t>>& chunks
+	);
+}
+
+bool AssetWriter::writeMesh(const std::filesystem::path& outputPath, const Mesh& mesh)
+{
+	MeshHeader header{MESH_MAGIC, MESH_FILE_VERSION, sizeof(Vertex), mesh.bounds.center, mesh.bounds.extent};
+
+	std::vector<SubmeshData> submeshes;
+	submeshes.reserve(mesh.submeshes.size());
+	for(const Submesh& submesh: mesh.submeshes)
+	{
+		submeshes.push_back
+		(
+			SubmeshData
+			{
+				submesh.indexOffset, submesh.indexCount, submesh.materialSlot, 0U,
+				submesh.bounds.center, 0.0f,
+				submesh.bounds.extent, 0.0f
+			}
+		);
+	}
+
+	EncodedBlock vertexBlock, indexBlock, submeshBlock;
+	encodeBlock("Vertices"_u64, mesh.vertices.data(), mesh.vertices.size() * sizeof(Vertex), vertexBlock);
+	encodeBlock("Indices\0"_u64, mesh.indices.data(), mesh.indices.size() * sizeof(uint32_t), indexBlock);
+	encodeBlock("Submesh\0"_u64, submeshes.data(), submeshes.size() * sizeof(SubmeshData), submeshBlock);
+
+	return writeAtomically
+	(
+		outputPath,
+		{
+			{&header, sizeof(MeshHeader)},
+			{&vertexBlock.header, sizeof(EncodedBlockHeader)},
+			{vertexBlock.pData, vertexBlock.header.blockSize},
+			{&indexBlock.header, sizeof(EncodedBlockHeader)},
+			{indexBlock.pData, indexBlock.header.blockSize},
+			{&submeshBlock.header, sizeof(EncodedBlockHeader)},
+			{submeshBlock.pData, submeshBlock.header.blockSize}
+		}
+	);
+}
+
+bool AssetWriter::writeMaterial(const std::filesystem::path& outputPath, const Material& material)
+{
+	const uint64_t header[2]{MATERIAL_MAGIC, MATERIAL_FILE_VERSION};
+	MaterialFloatAttributes attributes
+	{
+		{material.diffuse.x, material.diffuse.y, material.diffuse.z, material.opacity},
+		{material.emission.x, material.emission.y, material.emission.z, material.indexOfRefraction},
+		material.roughness,
+		material.metallic,
+		{0.0f, 0.0f}
+	};
+
+	EncodedBlock materialBlock;
+	encodeBlock("Material"_u64, &attributes, sizeof(MaterialFloatAttributes), materialBlock);
+
+	return writeAtomically
+	(
+		outputPath,
+		{
+			{header, sizeof(header)},
+			{&materialBlock.header, sizeof(EncodedBlockHeader)},
+			{materialBlock.pData, materialBlock.header.blockSize}
+		}
+	);
+}
+
+bool AssetWriter::writeScene(const std::filesystem::path& outputPath, const Scene& scene)
+{
+	const uint64_t header[2]{SCENE_MAGIC, SCENE_FILE_VERSION};
+
+	const std::string textureTable = encodeStringTable(scene.texturePaths);
+	const std::string materialTable = encodeStringTable(scene.materialPaths);
+	const std::string meshTable = encodeStringTable(scene.meshPaths);
+
+	const uint64_t settingsBlock[2]{"Settings"_u64, scene.settings.size()};
+	const uint64_t textureBlock[2]{"Textures"_u64, textureTable.size()};
+	const uint64_t materialBlock[2]{"Material"_u64, materialTable.size()};
+	const uint64_t meshBlock[2]{"Meshes\0\0"_u64, meshTable.size()};
+	const uint64_t instanceBlock[2]{"Instance"_u64, scene.instances.size() * sizeof(SceneInstance)};
+
+	return writeAtomically
+	(
+		outputPath,
+		{
+			{header, sizeof(header)},
+			{settingsBlock, sizeof(settingsBlock)},
+			{scene.settings.data(), settingsBlock[1]},
+			{textureBlock, sizeof(textureBlock)},
+			{textureTable.data(), textureBlock[1]},
+			{materialBlock, sizeof(materialBlock)},
+			{materialTable.data(), materialBlock[1]},
+			{meshBlock, sizeof(meshBlock)},
+			{meshTable.data(), meshBlock[1]},
+			{instanceBlock, sizeof(instanceBlock)},
+			{scene.instances.data(), instanceBlock[1]}
+		}
+	);
+}
+
+bool AssetWriter::writeTexture(const std::filesystem::path& sourcePath, const std::filesystem::path& outputPath)
+{
+	std::string sourceData;
+	if(!readFile(sourcePath, sourceData)) return false;
+
+	// PNG files are already read by the engine, so they are copied without a lossy round trip
+	constexpr char PNG_SIGNATURE[]{'\x89', 'P', 'N', 'G', '\r', '\n', '\x1a', '\n'};
+	if(sourceData.compare(0, sizeof(PNG_SIGNATURE), PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) == 0)
+		return writeAtomically(outputPath, {{sourceData.data(), sourceData.size()}});
+
+	int width, height, channels;
+	stbi_uc* pPixels = stbi_load_from_memory
+	(
+		reinterpret_cast<const stbi_uc*>(sourceData.data()),
+		static_cast<int>(sourceData.size()),
+		&width, &height, &channels,
+		STBI_rgb_alpha
+	);
+	if(!pPixels) return false;
+
+	int pngSize = 0;
+	unsigned char* pPng = stbi_write_png_to_mem(pPixels, width * 4, width, height, 4, &pngSize);
+	stbi_image_free(pPixels);
+	if(!pPng) return false;
+
+	bool written = writeAtomically(outputPath, {{pPng, static_cast<size_t>(pngSize)}});
+	STBIW_FREE(pPng);
+	return written;
+}
+
+bool AssetWriter::writeArchive(const std::filesystem::path& outputPath, const std::vector<ArchiveFile>& files)
+{
+	// At most half of the slots are used, so the engine probes few slots and always reaches an empty one
+	uint32_t slotCount = 1U;
+	while(slotCount < 2U * files.size() + 1U)
+		slotCount <<= 1;
+	const uint32_t slotMask = slotCount - 1U;
+
+	std::vector<ArchiveEntry> slots(slotCount, ArchiveEntry{});
+	std::string pathTable;
+	for(const ArchiveFile& file: files)
+		pathTable += file.path;
+
+	ArchiveHeader header
+	{
+		ARCHIVE_MAGIC,
+		ARCHIVE_FILE_VERSION,
+		static_cast<uint32_t>(files.size()),
+		slotCount,
+		sizeof(ArchiveHeader),
+		sizeof(ArchiveHeader) + slotCount * sizeof(ArchiveEntry),
+		pathTable.size()
+	};
+
+	// Entries start at page boundaries, so each of them is mapped by its own pages
+	static constexpr std::array<uint8_t, ARCHIVE_ENTRY_ALIGNMENT> ZERO_PADDING{};
+	auto paddingSize = [](uint64_t offset)
+	{
+		return (ARCHIVE_ENTRY_ALIGNMENT - offset % ARCHIVE_ENTRY_ALIGNMENT) % ARCHIVE_ENTRY_ALIGNMENT;
+	};
+
+	std::vector<std::pair<const void*, size_t>> chunks
+	{
+		{&header, sizeof(ArchiveHeader)},
+		{slots.data(), slots.size() * sizeof(ArchiveEntry)},
+		{pathTable.data(), pathTable.size()}
+	};
+	uint64_t dataOffset = header.pathTableOffset + pathTable.size();
+	uint32_t pathOffset = 0U;
+	for(const ArchiveFile& file: files)
+	{
+		chunks.emplace_back(ZERO_PADDING.data(), paddingSize(dataOffset));
+		dataOffset += paddingSize(dataOffset);
+
+		ContentHash pathHash{};
+		pathHash.update(file.path.data(), file.path.size());
+
+		uint32_t slot = static_cast<uint32_t>(pathHash.getValue()) & slotMask;
+		while(slots[slot].pathLength != 0U)
+			slot = (slot + 1U) & slotMask;
+		slots[slot] = ArchiveEntry
+		{
+			pathHash.getValue(),
+			dataOffset,
+			file.data.size(),
+			file.size,
+			pathOffset,
+			static_cast<uint32_t>(file.path.size()),
+			file.compressed ? ARCHIVE_LZ4 : ARCHIVE_UNCOMPRESSED,
+			0U
+		};
+
+		chunks.emplace_back(file.data.data(), file.data.size());
+		dataOffset += file.data.size();
+		pathOffset += static_cast<uint32_t>(file.path.size());
+	}
+
+	return writeAtomically(outputPath, chunks);
+}
+
+bool AssetWriter::readFile(const std::filesystem::path& filePath, std::string& content)
+{
+	std::ifstream file{filePath, std::ios::binary | std::ios::ate};
+	if(!file) return false;
+
+	content.resize(static_cast<size_t>(file.tellg()));
+	file.seekg(0, std::ios::beg);
+	file.read(content.data(), static_cast<std::streamsize>(content.size()));
+	return static_cast<bool>(file);
+}
+
+void AssetWriter::encodeBlock(uint64_t blockID, const void* pData, size_t size, EncodedBlock& block)
+{
+	block.header = EncodedBlockHeader{blockID, size, size, BLOCK_RAW, 0U};
+	block.pData = pData;
+
+	size_t compressedSize = Compression::compressChunkedLZ4
+	(
+		static_cast<const uint8_t*>(pData), size, BLOCK_CHUNK_SIZE, block.compressedData
+	);
+	if(compressedSize >= size - size / 8)
+	{
+		block.compressedData.clear();
+		return;
+	}
+
+	block.header.blockSize = compressedSize;
+	block.header.encoding = BLOCK_CHUNKED_LZ4;
+	block.header.chunkSize = BLOCK_CHUNK_SIZE;
+	block.pData = block.compressedData.data();
+}
+
+std::string AssetWriter::encodeStringTable(const std::vector<std::string>& strings)
+{
+	const uint32_t stringCount = static_cast<uint32_t>(strings.size());
+	std::string table(sizeof(uint32_t), '\0');
+	memcpy(table.data(), &stringCount, sizeof(uint32_t));
+
+	for(const std::string& string: strings)
+	{
+		table += string;
+		table += '\0';
+	}
+	return table;
+}
+
+bool AssetWriter::writeAtomically
+(
+	const std::filesystem::path& outputPath, const std::vector<std::pair<const void*, size_t>>& chunks
+)
+{
+	std::error_code errorCode;
+	std::filesystem::create_directories(outputPath.parent_path(), errorCode);
+
+	std::filesystem::path temporaryPath{outputPath};
+	temporaryPath += ".tmp";
+	{
+		std::ofstream file{temporaryPath, std::ios::binary | std::ios::trunc};
+		for(const auto& [pData, size]: chunks)
+			file.write(static_cast<const char*>(pData), static_cast<std::streamsize>(size));
+		if(!file) return false;
+	}
+
+	std::filesystem::rename(temporaryPath, outputPath, errorCode);
+	return !errorCode;
+}
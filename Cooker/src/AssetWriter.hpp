@@ -0,0 +1,23 @@
+#pragma once
+
+#include <filesystem>
+
+#include "CookedAssets.hpp"
+
+// Writers of the engine asset files
+namespace AssetWriter
+{
+	// Writes the mesh in the .mesh format
+	bool writeMesh(const std::filesystem::path& outputPath, const Cooked::Mesh& mesh);
+	// Writes the material in the .mtrl format, with the ray tracing float attributes layout
+	bool writeMaterial(const std::filesystem::path& outputPath, const Cooked::Material& material);
+	// Writes the scene in the .mscene format
+	bool writeScene(const std::filesystem::path& outputPath, const Cooked::Scene& scene);
+	// Converts an image to a .png texture, copying the file if it already is a PNG image
+	bool writeTexture(const std::filesystem::path& sourcePath, const std::filesystem::path& outputPath);
+	// Writes the files in the .mpak archive format, with a hashed table of contents and 4 KiB aligned entries
+	bool writeArchive(const std::filesystem::path& outputPath, const std::vector<Cooked::ArchiveFile>& files);
+
+	// Reads the whole file, returning false if it could not be opened
+	bool readFile(const std::filesystem::path& filePath, std::string& content);
+}
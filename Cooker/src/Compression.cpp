@@ -0,0 +1,124 @@
+#include "Compression.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace Compression
+{
+	// Minimum length of an LZ4 match, and the maximum distance to its source
+	constexpr size_t MIN_MATCH = 4;
+	constexpr size_t MAX_OFFSET = 65535;
+	// The last 5 bytes are always literals, and the last match starts at least 12 bytes before the end
+	constexpr size_t LAST_LITERALS = 5;
+	constexpr size_t MATCH_FIND_LIMIT = 12;
+	// Positions of the last occurrences of the 4 byte sequences
+	constexpr uint32_t HASH_BITS = 16;
+
+	// Hashes the 4 bytes at the position
+	static uint32_t hashSequence(const uint8_t* pData)
+	{
+		uint32_t sequence;
+		memcpy(&sequence, pData, sizeof(uint32_t));
+		return (sequence * 2654435761U) >> (32 - HASH_BITS);
+	}
+
+	// Appends the extra bytes of a literal or match length above 15
+	static void writeLength(size_t length, std::vector<uint8_t>& output)
+	{
+		for(; length >= 255; length -= 255)
+			output.push_back(255);
+		output.push_back(static_cast<uint8_t>(length));
+	}
+
+	// Appends a sequence of literals, followed by a match if its length is not zero
+	static void writeSequence
+	(
+		const uint8_t* pLiterals, size_t literalLength, size_t matchOffset, size_t matchLength, std::vector<uint8_t>& output
+	)
+	{
+		size_t matchToken = (matchLength > 0) ? matchLength - MIN_MATCH : 0;
+		output.push_back
+		(
+			static_cast<uint8_t>((std::min<size_t>(literalLength, 15) << 4) | std::min<size_t>(matchToken, 15))
+		);
+		if(literalLength >= 15)
+			writeLength(literalLength - 15, output);
+		output.insert(output.end(), pLiterals, pLiterals + literalLength);
+
+		if(matchLength == 0) return;
+		output.push_back(static_cast<uint8_t>(matchOffset & 0xFF));
+		output.push_back(static_cast<uint8_t>(matchOffset >> 8));
+		if(matchToken >= 15)
+			writeLength(matchToken - 15, output);
+	}
+}
+
+size_t Compression::compressLZ4(const uint8_t* pData, size_t size, std::vector<uint8_t>& output)
+{
+	const size_t startSize = output.size();
+	size_t anchor = 0;
+
+	// Greedy parsing, taking the first match found for each position
+	if(size > MATCH_FIND_LIMIT)
+	{
+		std::vector<uint32_t> lastPositions(size_t{1} << HASH_BITS, UINT32_MAX);
+		const size_t matchEndLimit = size - LAST_LITERALS;
+
+		size_t position = 0;
+		while(position + MATCH_FIND_LIMIT <= size)
+		{
+			uint32_t& lastPosition = lastPositions[hashSequence(pData + position)];
+			size_t candidate = lastPosition;
+			lastPosition = static_cast<uint32_t>(position);
+
+			if
+			(
+				candidate == UINT32_MAX || position - candidate > MAX_OFFSET ||
+				memcmp(pData + candidate, pData + position, MIN_MATCH) != 0
+			)
+			{
+				position++;
+				continue;
+			}
+
+			size_t matchLength = MIN_MATCH;
+			while(position + matchLength < matchEndLimit && pData[candidate + matchLength] == pData[position + matchLength])
+				matchLength++;
+
+			writeSequence(pData + anchor, position - anchor, position - candidate, matchLength, output);
+			position += matchLength;
+			anchor = position;
+		}
+	}
+
+	writeSequence(pData + anchor, size - anchor, 0, 0, output);
+	return output.size() - startSize;
+}
+
+size_t Compression::compressChunkedLZ4(const uint8_t* pData, size_t size, uint32_t chunkSize, std::vector<uint8_t>& output)
+{
+	const size_t startSize = output.size();
+	const size_t chunkCount = (size + chunkSize - 1) / chunkSize;
+
+	size_t tableOffset = output.size();
+	output.resize(output.size() + chunkCount * sizeof(uint32_t));
+	for(size_t i = 0; i < chunkCount; i++)
+	{
+		const uint8_t* pChunk = pData + i * chunkSize;
+		const size_t uncompressedChunkSize = std::min<size_t>(chunkSize, size - i * chunkSize);
+
+		size_t chunkStart = output.size();
+		size_t storedChunkSize = compressLZ4(pChunk, uncompressedChunkSize, output);
+		// The engine copies the chunks stored with their uncompressed size
+		if(storedChunkSize >= uncompressedChunkSize)
+		{
+			output.resize(chunkStart);
+			output.insert(output.end(), pChunk, pChunk + uncompressedChunkSize);
+			storedChunkSize = uncompressedChunkSize;
+		}
+
+		uint32_t tableEntry = static_cast<uint32_t>(storedChunkSize);
+		memcpy(output.data() + tableOffset + i * sizeof(uint32_t), &tableEntry, sizeof(uint32_t));
+	}
+	return output.size() - startSize;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Encoders for the compressed asset data, read by the engine decoders
+namespace Compression
+{
+	// Encodes the data as an LZ4 block, appending it to the output and returning the encoded size
+	size_t compressLZ4(const uint8_t* pData, size_t size, std::vector<uint8_t>& output);
+	// Splits the data in chunks compressed independently, so the engine can decompress them in parallel.
+	// Appends the stored size of each chunk followed by the chunks, which are kept raw if they do not shrink.
+	size_t compressChunkedLZ4(const uint8_t* pData, size_t size, uint32_t chunkSize, std::vector<uint8_t>& output);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+// Incremental 64-bit FNV-1a hash, identifying the content of the cooking inputs
+class ContentHash
+{
+	public:
+		// Mixes the bytes into the hash
+		void update(const void* pData, size_t size)
+		{
+			const unsigned char* bytes = static_cast<const unsigned char*>(pData);
+			for(size_t i = 0; i < size; i++)
+				hash = (hash ^ bytes[i]) * FNV_PRIME;
+		}
+		void update(std::string_view text)
+		{
+			update(text.data(), text.size());
+			// Separates consecutive strings, so that "ab" + "c" and "a" + "bc" differ
+			update("", 1);
+		}
+		void update(uint64_t value) { update(&value, sizeof(uint64_t)); }
+
+		// Current hash value
+		uint64_t getValue() const { return hash; }
+		// Hexadecimal representation of the hash
+		std::string toString() const
+		{
+			char text[17];
+			snprintf(text, sizeof(text), "%016llx", static_cast<unsigned long long>(hash));
+			return std::string{text};
+		}
+
+	private:
+		static constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037UL;
+		static constexpr uint64_t FNV_PRIME = 1099511628211UL;
+
+		uint64_t hash = FNV_OFFSET_BASIS;
+};
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Data layouts shared by the cooker stages, matching the engine asset formats
+namespace Cooked
+{
+	// Converts an 8-character string literal to an uint64_t, as the engine asset identifiers
+	constexpr uint64_t operator""_u64(const char* str, size_t size)
+	{
+		if(size != sizeof(uint64_t))
+			throw "Literal must contain exactly 8 characters.";
+
+		uint64_t value = 0UL;
+		for(size_t i = 0; i < size; i++)
+			value |= static_cast<uint64_t>(str[i]) << (8 * i);
+		return value;
+	}
+
+	struct Vec2
+	{
+		float x, y;
+	};
+	struct Vec3
+	{
+		float x, y, z;
+	};
+
+	// Vertex layout of the default .mesh files
+	struct Vertex
+	{
+		Vec3 position;
+		Vec2 textureCoordinate;
+		Vec3 normal;
+	};
+	static_assert(sizeof(Vertex) == 32, "The vertex must match the engine vertex stride.");
+
+	// Axis aligned bounding box, stored as center and half extent
+	struct BoundingBox
+	{
+		Vec3 center;
+		Vec3 extent;
+	};
+
+	// Range of the mesh indices drawn with a single material slot
+	struct Submesh
+	{
+		uint32_t indexOffset;
+		uint32_t indexCount;
+		uint32_t materialSlot;
+		BoundingBox bounds;
+	};
+
+	// Mesh ready to be written as a .mesh file
+	struct Mesh
+	{
+		std::vector<Vertex> vertices;
+		std::vector<uint32_t> indices;
+		std::vector<Submesh> submeshes;
+		BoundingBox bounds;
+	};
+
+	// Material parameters read from a .mtl file
+	struct Material
+	{
+		std::string name;
+		Vec3 diffuse{0.8f, 0.8f, 0.8f};
+		float opacity = 1.0f;
+		Vec3 emission{0.0f, 0.0f, 0.0f};
+		float indexOfRefraction = 1.0f;
+		float roughness = 1.0f;
+		float metallic = 0.0f;
+		// Diffuse texture path, relative to the .mtl file (empty if untextured)
+		std::string diffuseMap;
+	};
+
+	// Instance table entry of the .mscene files, copied as is to the engine scene instances
+	struct SceneInstance
+	{
+		float transform[16];
+		uint32_t pipelineID;
+		uint32_t meshID;
+		uint32_t materialSetID;
+		uint8_t visible;
+		uint8_t padding[3];
+	};
+	static_assert(sizeof(SceneInstance) == 80, "The scene instance must match the engine layout.");
+
+	// Scene ready to be written as a .mscene file
+	struct Scene
+	{
+		// Camera, GPU resources, descriptors, pipelines and material sets, encoded as MessagePack
+		std::vector<uint8_t> settings;
+		// Resource paths, relative to the resources folder
+		std::vector<std::string> texturePaths;
+		std::vector<std::string> materialPaths;
+		std::vector<std::string> meshPaths;
+		std::vector<SceneInstance> instances;
+	};
+
+	// File to be packed in an .mpak archive
+	struct ArchiveFile
+	{
+		// Path relative to the archive root, with '/' separators
+		std::string path;
+		// Stored data, LZ4 compressed if that saves enough space
+		std::vector<uint8_t> data;
+		uint64_t size;
+		bool compressed;
+	};
+}
@@ -0,0 +1,416 @@
+#include "Cooker.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+#include "AssetWriter.hpp"
+#include "Compression.hpp"
+#include "ContentHash.hpp"
+#include "MeshOptimizer.hpp"
+#include "ObjImporter.hpp"
+#include "SceneImporter.hpp"
+
+// Changing the cooked formats or the optimizations must increase the version, invalidating the manifest
+constexpr uint64_t COOKER_VERSION = 2UL;
+// Manifest file name, in the output folder
+constexpr const char* MANIFEST_FILE = ".cook_manifest.json";
+// Extensions of the files read by the engine, which are packed in the archive
+constexpr std::string_view ARCHIVE_EXTENSIONS[]{".mesh", ".mtrl", ".png", ".jpg", ".mscene", ".json", ".spv"};
+// Extensions of already compressed files, which are stored as they are
+constexpr std::string_view COMPRESSED_EXTENSIONS[]{".png", ".jpg"};
+
+// Name of an asset created from a material, suffixed with the material name when the source has several
+static std::string materialAssetName(const std::string& sourceName, const std::string& materialName, bool suffixed)
+{
+	return suffixed ? sourceName + '_' + materialName : sourceName;
+}
+
+Cooker::Cooker(const CookerSettings& settings)
+	: settings{settings}
+{
+	if(this->settings.outputPath.empty())
+		this->settings.outputPath = this->settings.resourcesPath;
+	if(this->settings.threadCount == 0U)
+		this->settings.threadCount = std::max(std::thread::hardware_concurrency(), 1U);
+}
+
+CookStatistics Cooker::run()
+{
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+
+	loadManifest();
+	discoverTasks();
+
+	runInParallel(tasks.size(), [this](size_t i) { runTask(tasks[i]); });
+
+	CookStatistics statistics{};
+	for(const CookTask& task: tasks)
+	{
+		if(task.failed)
+			statistics.failedCount++;
+		else if(task.upToDate)
+			statistics.upToDateCount++;
+		else
+			statistics.cookedCount++;
+	}
+	saveManifest();
+
+	if(!settings.archivePath.empty() && !packArchive(statistics.packedCount))
+		statistics.failedCount++;
+
+	std::chrono::duration<double> elapsedTime = std::chrono::steady_clock::now() - startTime;
+	statistics.elapsedSeconds = elapsedTime.count();
+	return statistics;
+}
+
+void Cooker::discoverTasks()
+{
+	std::error_code errorCode;
+	std::filesystem::path meshesPath = settings.resourcesPath / "meshes";
+	for(const std::filesystem::directory_entry& entry: std::filesystem::recursive_directory_iterator{meshesPath, errorCode})
+	{
+		if(!entry.is_regular_file() || entry.path().extension() != ".obj") continue;
+
+		const std::filesystem::path& objPath = entry.path();
+		const std::string sourceName = objPath.stem().string();
+		std::filesystem::path mtlPath = objPath;
+		mtlPath.replace_extension(".mtl");
+
+		CookTask& meshTask = tasks.emplace_back();
+		meshTask.type = TaskType::Mesh;
+		meshTask.name = "mesh:" + sourceName;
+		meshTask.inputs.push_back(objPath);
+		meshTask.output = std::filesystem::path{"meshes"} / (sourceName + ".mesh");
+
+		// The material slots follow the declaration order in the .mtl file, which must be next to the .obj
+		std::string mtlContent;
+		if(!AssetWriter::readFile(mtlPath, mtlContent)) continue;
+		meshTask.inputs.push_back(mtlPath);
+
+		CookTask& materialTask = tasks.emplace_back();
+		materialTask.type = TaskType::Materials;
+		materialTask.name = "materials:" + sourceName;
+		materialTask.inputs.push_back(mtlPath);
+		materialTask.output = std::filesystem::path{"materials"} / sourceName;
+
+		std::vector<Cooked::Material> materials;
+		ObjImporter::loadMaterials(mtlContent, materials);
+
+		uint32_t textureCount = 0U;
+		for(const Cooked::Material& material: materials)
+			textureCount += material.diffuseMap.empty() ? 0U : 1U;
+
+		for(const Cooked::Material& material: materials)
+		{
+			if(material.diffuseMap.empty()) continue;
+
+			std::string textureName = materialAssetName(sourceName, material.name, textureCount > 1U);
+			CookTask& textureTask = tasks.emplace_back();
+			textureTask.type = TaskType::Texture;
+			textureTask.name = "texture:" + textureName;
+			textureTask.inputs.push_back(mtlPath.parent_path() / material.diffuseMap);
+			textureTask.output = std::filesystem::path{"textures"} / (textureName + ".png");
+		}
+	}
+
+	if(errorCode)
+		fprintf(stderr, "[COOK] Failed to read the source folder \"%s\".\n", meshesPath.string().c_str());
+
+	std::filesystem::path scenesPath = settings.resourcesPath / "scenes";
+	for(const std::filesystem::directory_entry& entry: std::filesystem::directory_iterator{scenesPath, errorCode})
+	{
+		if(!entry.is_regular_file() || entry.path().extension() != ".json") continue;
+
+		const std::string sceneName = entry.path().stem().string();
+		CookTask& sceneTask = tasks.emplace_back();
+		sceneTask.type = TaskType::Scene;
+		sceneTask.name = "scene:" + sceneName;
+		sceneTask.inputs.push_back(entry.path());
+		sceneTask.output = std::filesystem::path{"scenes"} / (sceneName + ".mscene");
+	}
+
+	if(errorCode)
+		fprintf(stderr, "[COOK] Failed to read the source folder \"%s\".\n", scenesPath.string().c_str());
+}
+
+void Cooker::runTask(CookTask& task)
+{
+	std::vector<std::string> inputData(task.inputs.size());
+	ContentHash hash{};
+	hash.update(COOKER_VERSION);
+	hash.update(task.name);
+	for(size_t i = 0; i < task.inputs.size(); i++)
+	{
+		if(!AssetWriter::readFile(task.inputs[i], inputData[i]))
+		{
+			task.failed = true;
+			task.message = "failed to read \"" + task.inputs[i].string() + '"';
+			break;
+		}
+		hash.update(inputData[i]);
+	}
+	task.contentHash = hash.toString();
+
+	if(!task.failed)
+	{
+		task.upToDate = !settings.forceCook && isUpToDate(task);
+		if(task.upToDate) return;
+
+		switch(task.type)
+		{
+			case TaskType::Mesh:
+				task.failed = !cookMesh(task, inputData);
+				break;
+			case TaskType::Materials:
+				task.failed = !cookMaterials(task, inputData);
+				break;
+			case TaskType::Texture:
+				task.failed = !cookTexture(task);
+				break;
+			case TaskType::Scene:
+				task.failed = !cookScene(task, inputData);
+				break;
+		}
+	}
+
+	std::lock_guard<std::mutex> lock{printMutex};
+	if(task.failed)
+		fprintf(stderr, "[COOK] Failed to cook \"%s\": %s.\n", task.name.c_str(), task.message.c_str());
+	else
+		printf("[COOK] Cooked \"%s\"%s.\n", task.name.c_str(), task.message.c_str());
+}
+
+bool Cooker::cookMesh(CookTask& task, const std::vector<std::string>& inputData)
+{
+	std::vector<Cooked::Material> materials;
+	if(inputData.size() > 1)
+		ObjImporter::loadMaterials(inputData[1], materials);
+
+	Cooked::Mesh mesh{};
+	if(!ObjImporter::loadMesh(inputData[0], materials, mesh, task.message))
+		return false;
+
+	MeshOptimizer::CacheStatistics sourceCache = MeshOptimizer::analyzeVertexCache(mesh.indices, mesh.vertices.size());
+	MeshOptimizer::optimizeSubmeshes(mesh);
+	MeshOptimizer::optimizeVertexFetch(mesh);
+	MeshOptimizer::computeBounds(mesh);
+	MeshOptimizer::CacheStatistics cookedCache = MeshOptimizer::analyzeVertexCache(mesh.indices, mesh.vertices.size());
+
+	if(!AssetWriter::writeMesh(settings.outputPath / task.output, mesh))
+	{
+		task.message = "failed to write \"" + task.output.generic_string() + '"';
+		return false;
+	}
+	task.outputs.push_back(task.output.generic_string());
+
+	char summary[128];
+	snprintf
+	(
+		summary, sizeof(summary), " (%zu vertices, %zu triangles, %zu submeshes, ACMR %.2f -> %.2f)",
+		mesh.vertices.size(), mesh.indices.size() / 3, mesh.submeshes.size(), sourceCache.acmr, cookedCache.acmr
+	);
+	task.message = summary;
+	return true;
+}
+
+bool Cooker::cookMaterials(CookTask& task, const std::vector<std::string>& inputData)
+{
+	std::vector<Cooked::Material> materials;
+	ObjImporter::loadMaterials(inputData[0], materials);
+
+	// Textured materials reference the texture index in the scene, so their .mtrl files are written by hand
+	const std::string sourceName = task.output.filename().string();
+	uint32_t skippedCount = 0U;
+	for(const Cooked::Material& material: materials)
+	{
+		if(!material.diffuseMap.empty())
+		{
+			skippedCount++;
+			continue;
+		}
+
+		std::filesystem::path outputFile = task.output.parent_path()
+			/ (materialAssetName(sourceName, material.name, materials.size() > 1) + ".mtrl");
+		if(!AssetWriter::writeMaterial(settings.outputPath / outputFile, material))
+		{
+			task.message = "failed to write \"" + outputFile.generic_string() + '"';
+			return false;
+		}
+		task.outputs.push_back(outputFile.generic_string());
+	}
+
+	task.message = " (" + std::to_string(task.outputs.size()) + " materials";
+	if(skippedCount > 0U)
+		task.message += ", " + std::to_string(skippedCount) + " textured materials left to the scene";
+	task.message += ')';
+	return true;
+}
+
+bool Cooker::cookTexture(CookTask& task)
+{
+	if(!AssetWriter::writeTexture(task.inputs[0], settings.outputPath / task.output))
+	{
+		task.message = "failed to convert \"" + task.inputs[0].string() + '"';
+		return false;
+	}
+	task.outputs.push_back(task.output.generic_string());
+	return true;
+}
+
+bool Cooker::cookScene(CookTask& task, const std::vector<std::string>& inputData)
+{
+	Cooked::Scene scene{};
+	if(!SceneImporter::loadScene(inputData[0], scene, task.message))
+		return false;
+
+	if(!AssetWriter::writeScene(settings.outputPath / task.output, scene))
+	{
+		task.message = "failed to write \"" + task.output.generic_string() + '"';
+		return false;
+	}
+	task.outputs.push_back(task.output.generic_string());
+
+	task.message = " (" + std::to_string(scene.instances.size()) + " instances)";
+	return true;
+}
+
+bool Cooker::packArchive(uint32_t& packedCount)
+{
+	std::vector<std::filesystem::path> filePaths;
+	std::error_code errorCode;
+	for
+	(
+		const std::filesystem::directory_entry& entry:
+		std::filesystem::recursive_directory_iterator{settings.outputPath, errorCode}
+	)
+	{
+		// Hidden files, such as the manifest, are not engine assets
+		if(!entry.is_regular_file() || entry.path().filename().string().starts_with('.')) continue;
+		if(std::ranges::find(ARCHIVE_EXTENSIONS, entry.path().extension().string()) != std::end(ARCHIVE_EXTENSIONS))
+			filePaths.push_back(entry.path());
+	}
+	// Sorted paths keep the archive identical between runs with the same assets
+	std::ranges::sort(filePaths);
+
+	std::vector<Cooked::ArchiveFile> files(filePaths.size());
+	std::atomic<bool> readFailed = false;
+	runInParallel(files.size(), [&](size_t i)
+	{
+		std::string content;
+		if(!AssetWriter::readFile(filePaths[i], content))
+		{
+			readFailed.store(true);
+			return;
+		}
+
+		Cooked::ArchiveFile& file = files[i];
+		file.path = filePaths[i].lexically_relative(settings.outputPath).generic_string();
+		file.size = content.size();
+		file.compressed = false;
+
+		// Entries are compressed only if that saves at least an eighth of their size
+		const uint8_t* pContent = reinterpret_cast<const uint8_t*>(content.data());
+		bool compressible = content.size() < UINT32_MAX && std::ranges::find
+		(
+			COMPRESSED_EXTENSIONS, filePaths[i].extension().string()
+		) == std::end(COMPRESSED_EXTENSIONS);
+		if(compressible && Compression::compressLZ4(pContent, content.size(), file.data) < content.size() - content.size() / 8)
+		{
+			file.compressed = true;
+			return;
+		}
+		file.data.assign(pContent, pContent + content.size());
+	});
+
+	if(readFailed.load() || !AssetWriter::writeArchive(settings.archivePath, files))
+	{
+		fprintf(stderr, "[COOK] Failed to pack the archive \"%s\".\n", settings.archivePath.string().c_str());
+		return false;
+	}
+
+	uint64_t totalSize = 0UL;
+	uint64_t storedSize = 0UL;
+	for(const Cooked::ArchiveFile& file: files)
+	{
+		totalSize += file.size;
+		storedSize += file.data.size();
+	}
+	printf
+	(
+		"[COOK] Packed %zu files in \"%s\" (%.1f KiB stored for %.1f KiB).\n",
+		files.size(), settings.archivePath.string().c_str(),
+		static_cast<double>(storedSize) / 1024.0, static_cast<double>(totalSize) / 1024.0
+	);
+	packedCount = static_cast<uint32_t>(files.size());
+	return true;
+}
+
+void Cooker::runInParallel(size_t count, const std::function<void(size_t)>& work) const
+{
+	// Each worker takes the next index until none is left, so large files do not hold the others back
+	std::atomic<size_t> nextIndex{0};
+	auto worker = [count, &work, &nextIndex]()
+	{
+		for(size_t i = nextIndex++; i < count; i = nextIndex++)
+			work(i);
+	};
+
+	size_t workerCount = std::min<size_t>(settings.threadCount, count);
+	std::vector<std::thread> workers;
+	for(size_t i = 1; i < workerCount; i++)
+		workers.emplace_back(worker);
+	worker();
+	for(std::thread& thread: workers)
+		thread.join();
+}
+
+bool Cooker::isUpToDate(const CookTask& task) const
+{
+	auto entry = manifest["assets"].find(task.name);
+	if(entry == manifest["assets"].end() || entry->value("hash", "") != task.contentHash)
+		return false;
+
+	for(const nlohmann::json& output: entry->value("outputs", nlohmann::json::array()))
+	{
+		if(!std::filesystem::exists(settings.outputPath / output.get<std::string>()))
+			return false;
+	}
+	return true;
+}
+
+void Cooker::loadManifest()
+{
+	std::ifstream manifestFile{settings.outputPath / MANIFEST_FILE};
+	manifest = nlohmann::json::parse(manifestFile, nullptr, false);
+
+	// Results of a different cooker version are discarded
+	if(!manifestFile || manifest.is_discarded() || manifest.value("version", 0UL) != COOKER_VERSION)
+		manifest = nlohmann::json::object();
+	if(!manifest.contains("assets") || !manifest["assets"].is_object())
+		manifest["assets"] = nlohmann::json::object();
+}
+
+void Cooker::saveManifest() const
+{
+	nlohmann::json updatedManifest{{"version", COOKER_VERSION}, {"assets", nlohmann::json::object()}};
+	nlohmann::json& assets = updatedManifest["assets"];
+
+	// Failed tasks are left out, so that the next run retries them
+	for(const CookTask& task: tasks)
+	{
+		if(task.failed) continue;
+		if(task.upToDate)
+			assets[task.name] = manifest["assets"][task.name];
+		else
+			assets[task.name] = nlohmann::json{{"hash", task.contentHash}, {"outputs", task.outputs}};
+	}
+
+	std::ofstream manifestFile{settings.outputPath / MANIFEST_FILE};
+	manifestFile << updatedManifest.dump(4) << '\n';
+	if(!manifestFile)
+		fprintf(stderr, "[COOK] Failed to write the manifest to \"%s\".\n", settings.outputPath.string().c_str());
+}
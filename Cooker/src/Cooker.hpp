@@ -0,0 +1,112 @@
+#pragma once
+
+#include <filesystem>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+#include "CookedAssets.hpp"
+
+// Settings of a cooking run
+struct CookerSettings
+{
+	// Folder with the "meshes/<name>/<name>.obj" and "scenes/<name>.json" sources
+	std::filesystem::path resourcesPath;
+	// Folder receiving the cooked "meshes", "materials", "textures" and "scenes" (the resources folder if empty)
+	std::filesystem::path outputPath;
+	// Worker threads cooking the assets (hardware concurrency if zero)
+	uint32_t threadCount = 0U;
+	// Cooks every asset, even if its inputs did not change
+	bool forceCook = false;
+	// .mpak archive receiving the cooked assets and shaders of the output folder (no archive if empty)
+	std::filesystem::path archivePath;
+};
+
+// Results of a cooking run
+struct CookStatistics
+{
+	uint32_t cookedCount = 0U;
+	uint32_t upToDateCount = 0U;
+	uint32_t failedCount = 0U;
+	uint32_t packedCount = 0U;
+	double elapsedSeconds = 0.0;
+};
+
+// Converts the .obj/.mtl/image sources to the engine asset formats, skipping the assets whose inputs did not change
+class Cooker
+{
+	public:
+		Cooker(const CookerSettings& settings);
+		~Cooker() = default;
+
+		Cooker(const Cooker&) = delete;
+		Cooker& operator=(const Cooker&) = delete;
+
+		// Cooks the outdated assets in parallel, updates the manifest and packs the archive if requested
+		CookStatistics run();
+
+	private:
+		// Kind of asset produced by a task
+		enum class TaskType
+		{
+			Mesh,
+			Materials,
+			Texture,
+			Scene
+		};
+
+		// Conversion of one set of source files
+		struct CookTask
+		{
+			TaskType type;
+			// Manifest key of the task
+			std::string name;
+			// Source files, whose contents identify the cooked result
+			std::vector<std::filesystem::path> inputs;
+			// Output asset, or the name prefix of the materials
+			std::filesystem::path output;
+
+			// Results of the task
+			std::string contentHash;
+			std::vector<std::string> outputs;
+			bool upToDate = false;
+			bool failed = false;
+			std::string message;
+		};
+
+		// Run settings, and the tasks found in the resources folder
+		CookerSettings settings;
+		std::vector<CookTask> tasks;
+
+		// Previous cooking results, and the guard for the progress messages
+		nlohmann::json manifest;
+		std::mutex printMutex;
+
+		// Creates the tasks for every source mesh and JSON scene found in the resources folder
+		void discoverTasks();
+		// Hashes the inputs of the task, cooking it if the previous result is outdated
+		void runTask(CookTask& task);
+
+		// Converts the .obj file to an optimized .mesh file
+		bool cookMesh(CookTask& task, const std::vector<std::string>& inputData);
+		// Converts the untextured materials of a .mtl file to .mtrl files
+		bool cookMaterials(CookTask& task, const std::vector<std::string>& inputData);
+		// Converts a material texture to a .png file
+		bool cookTexture(CookTask& task);
+		// Converts a JSON scene to a .mscene file
+		bool cookScene(CookTask& task, const std::vector<std::string>& inputData);
+
+		// Packs the engine assets of the output folder in the archive, compressing the entries in parallel
+		bool packArchive(uint32_t& packedCount);
+		// Runs the work for each index on the worker threads, each worker taking the next index until none is left
+		void runInParallel(size_t count, const std::function<void(size_t)>& work) const;
+
+		// Checks if the manifest holds the same hash for the task, and that its outputs still exist
+		bool isUpToDate(const CookTask& task) const;
+		// Reads and writes the manifest in the output folder
+		void loadManifest();
+		void saveManifest() const;
+};
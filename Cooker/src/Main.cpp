@@ -0,0 +1,93 @@
+#include <cstdio>
+#include <cstdlib>
+#include <string_view>
+
+#include "Cooker.hpp"
+
+#ifndef MTD_RESOURCES_PATH
+	#define MTD_RESOURCES_PATH "./resources/"
+#endif
+
+// Prints the available command line options
+static void printUsage()
+{
+	printf
+	(
+		"Usage: meltdown_cook [options]\n"
+		"  --resources <folder>  Folder with the .obj and JSON scene sources (default: engine resources)\n"
+		"  --output <folder>     Folder receiving the cooked assets (default: the resources folder)\n"
+		"  --jobs <count>        Worker threads (default: hardware concurrency)\n"
+		"  --force               Cooks every asset, ignoring the previous results\n"
+		"  --pack <file>         Packs the cooked assets and shaders of the output folder in an .mpak archive\n"
+	);
+}
+
+// Fills the settings with the command line arguments, returning false for invalid arguments
+static bool parseArguments(int argc, char** argv, CookerSettings& settings)
+{
+	for(int i = 1; i < argc; i++)
+	{
+		std::string_view argument{argv[i]};
+		if(argument == "--force")
+		{
+			settings.forceCook = true;
+			continue;
+		}
+		if(argument == "--help")
+			return false;
+
+		if(i + 1 >= argc)
+		{
+			fprintf(stderr, "[COOK] Missing value for \"%s\".\n", argv[i]);
+			return false;
+		}
+		const char* value = argv[++i];
+
+		if(argument == "--resources")
+			settings.resourcesPath = value;
+		else if(argument == "--output")
+			settings.outputPath = value;
+		else if(argument == "--pack")
+			settings.archivePath = value;
+		else if(argument == "--jobs")
+			settings.threadCount = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+		else
+		{
+			fprintf(stderr, "[COOK] Unknown option: \"%s\".\n", argv[i - 1]);
+			return false;
+		}
+	}
+
+	if(!std::filesystem::is_directory(settings.resourcesPath))
+	{
+		fprintf(stderr, "[COOK] Resources folder not found: \"%s\".\n", settings.resourcesPath.string().c_str());
+		return false;
+	}
+	return true;
+}
+
+// Cooks the outdated assets, returning a failure exit code if any of them could not be cooked
+int main(int argc, char** argv)
+{
+	CookerSettings settings{};
+	settings.resourcesPath = MTD_RESOURCES_PATH;
+
+	if(!parseArguments(argc, argv, settings))
+	{
+		printUsage();
+		return EXIT_FAILURE;
+	}
+
+	Cooker cooker{settings};
+	CookStatistics statistics = cooker.run();
+	printf
+	(
+		"[COOK] %u cooked, %u up to date, %u failed, %u packed in %.2f s.\n",
+		statistics.cookedCount,
+		statistics.upToDateCount,
+		statistics.failedCount,
+		statistics.packedCount,
+		statistics.elapsedSeconds
+	);
+	return (statistics.failedCount == 0U) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
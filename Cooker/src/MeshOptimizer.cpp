@@ -0,0 +1,444 @@
+#include "MeshOptimizer.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+
+namespace MeshOptimizer
+{
+	// Cache size modeled by the triangle scores
+	constexpr int32_t SCORING_CACHE_SIZE = 32;
+	// FIFO cache size used to measure the misses, close to the behavior of current GPUs
+	constexpr uint32_t FIFO_CACHE_SIZE = 16U;
+	// Tolerated growth of the cache misses to split the triangles in more clusters for the overdraw sorting
+	constexpr float OVERDRAW_THRESHOLD = 1.05f;
+
+	// Score weights of the vertex cache optimization
+	constexpr float LAST_TRIANGLE_SCORE = 0.75f;
+	constexpr float CACHE_DECAY_POWER = 1.5f;
+	constexpr float VALENCE_BOOST_SCALE = 2.0f;
+	constexpr float VALENCE_BOOST_POWER = 0.5f;
+
+	// Reorders the triangles of a submesh to reuse the transformed vertices, based on the Forsyth algorithm
+	static void optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount);
+	// Sorts clusters of triangles so that the ones facing outwards are drawn first
+	static void optimizeOverdraw
+	(
+		uint32_t* indices, size_t indexCount, const std::vector<Cooked::Vertex>& vertices
+	);
+	// Splits the triangles in clusters starting with a cold cache, returning the first triangle of each cluster
+	static std::vector<uint32_t> generateClusters(const uint32_t* indices, size_t indexCount, size_t vertexCount);
+
+	// Scores how much emitting a triangle using the vertex helps the cache
+	static float calculateVertexScore(int32_t cachePosition, uint32_t remainingValence);
+}
+
+void MeshOptimizer::optimizeSubmeshes(Cooked::Mesh& mesh)
+{
+	for(const Cooked::Submesh& submesh: mesh.submeshes)
+	{
+		uint32_t* submeshIndices = mesh.indices.data() + submesh.indexOffset;
+		optimizeVertexCache(submeshIndices, submesh.indexCount, mesh.vertices.size());
+		optimizeOverdraw(submeshIndices, submesh.indexCount, mesh.vertices);
+	}
+}
+
+void MeshOptimizer::optimizeVertexFetch(Cooked::Mesh& mesh)
+{
+	constexpr uint32_t UNUSED = std::numeric_limits<uint32_t>::max();
+	std::vector<uint32_t> remap(mesh.vertices.size(), UNUSED);
+	std::vector<Cooked::Vertex> vertices;
+	vertices.reserve(mesh.vertices.size());
+
+	for(uint32_t& index: mesh.indices)
+	{
+		if(remap[index] == UNUSED)
+		{
+			remap[index] = static_cast<uint32_t>(vertices.size());
+			vertices.push_back(mesh.vertices[index]);
+		}
+		index = remap[index];
+	}
+	mesh.vertices = std::move(vertices);
+}
+
+void MeshOptimizer::computeBounds(Cooked::Mesh& mesh)
+{
+	constexpr float MAX_FLOAT = std::numeric_limits<float>::max();
+	Cooked::Vec3 meshMin{MAX_FLOAT, MAX_FLOAT, MAX_FLOAT};
+	Cooked::Vec3 meshMax{-MAX_FLOAT, -MAX_FLOAT, -MAX_FLOAT};
+
+	for(Cooked::Submesh& submesh: mesh.submeshes)
+	{
+		Cooked::Vec3 min{MAX_FLOAT, MAX_FLOAT, MAX_FLOAT};
+		Cooked::Vec3 max{-MAX_FLOAT, -MAX_FLOAT, -MAX_FLOAT};
+		for(uint32_t i = submesh.indexOffset; i < submesh.indexOffset + submesh.indexCount; i++)
+		{
+			const Cooked::Vec3& position = mesh.vertices[mesh.indices[i]].position;
+			min = Cooked::Vec3{std::min(min.x, position.x), std::min(min.y, position.y), std::min(min.z, position.z)};
+			max = Cooked::Vec3{std::max(max.x, position.x), std::max(max.y, position.y), std::max(max.z, position.z)};
+		}
+		if(submesh.indexCount == 0U)
+		{
+			submesh.bounds = Cooked::BoundingBox{};
+			continue;
+		}
+
+		submesh.bounds.center = Cooked::Vec3{(min.x + max.x) / 2.0f, (min.y + max.y) / 2.0f, (min.z + max.z) / 2.0f};
+		submesh.bounds.extent = Cooked::Vec3{(max.x - min.x) / 2.0f, (max.y - min.y) / 2.0f, (max.z - min.z) / 2.0f};
+
+		meshMin = Cooked::Vec3{std::min(meshMin.x, min.x), std::min(meshMin.y, min.y), std::min(meshMin.z, min.z)};
+		meshMax = Cooked::Vec3{std::max(meshMax.x, max.x), std::max(meshMax.y, max.y), std::max(meshMax.z, max.z)};
+	}
+
+	if(meshMin.x > meshMax.x)
+	{
+		mesh.bounds = Cooked::BoundingBox{};
+		return;
+	}
+	mesh.bounds.center = Cooked::Vec3
+	{
+		(meshMin.x + meshMax.x) / 2.0f, (meshMin.y + meshMax.y) / 2.0f, (meshMin.z + meshMax.z) / 2.0f
+	};
+	mesh.bounds.extent = Cooked::Vec3
+	{
+		(meshMax.x - meshMin.x) / 2.0f, (meshMax.y - meshMin.y) / 2.0f, (meshMax.z - meshMin.z) / 2.0f
+	};
+}
+
+MeshOptimizer::CacheStatistics MeshOptimizer::analyzeVertexCache
+(
+	const std::vector<uint32_t>& indices, size_t vertexCount
+)
+{
+	CacheStatistics statistics{};
+	if(indices.empty()) return statistics;
+
+	// A vertex is in the FIFO cache if less than the cache size vertices were loaded after it
+	std::vector<uint32_t> loadTimestamps(vertexCount, 0U);
+	std::vector<bool> referenced(vertexCount, false);
+	uint32_t timestamp = FIFO_CACHE_SIZE + 1U;
+	uint32_t misses = 0U;
+	uint32_t referencedCount = 0U;
+
+	for(uint32_t index: indices)
+	{
+		if(timestamp - loadTimestamps[index] > FIFO_CACHE_SIZE)
+		{
+			loadTimestamps[index] = timestamp++;
+			misses++;
+		}
+		if(!referenced[index])
+		{
+			referenced[index] = true;
+			referencedCount++;
+		}
+	}
+
+	statistics.acmr = static_cast<float>(misses) / static_cast<float>(indices.size() / 3);
+	statistics.atvr = static_cast<float>(misses) / static_cast<float>(referencedCount);
+	return statistics;
+}
+
+void MeshOptimizer::optimizeVertexCache(uint32_t* indices, size_t indexCount, size_t vertexCount)
+{
+	const size_t triangleCount = indexCount / 3;
+	if(triangleCount < 2) return;
+
+	// Triangles using each vertex, with the emitted ones moved past the remaining valence
+	std::vector<uint32_t> remainingValence(vertexCount, 0U);
+	for(size_t i = 0; i < indexCount; i++)
+		remainingValence[indices[i]]++;
+
+	std::vector<uint32_t> adjacencyOffsets(vertexCount + 1, 0U);
+	for(size_t vertex = 0; vertex < vertexCount; vertex++)
+		adjacencyOffsets[vertex + 1] = adjacencyOffsets[vertex] + remainingValence[vertex];
+
+	std::vector<uint32_t> adjacentTriangles(indexCount);
+	std::vector<uint32_t> adjacencyFill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+	for(size_t i = 0; i < indexCount; i++)
+		adjacentTriangles[adjacencyFill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+	std::vector<int32_t> cachePositions(vertexCount, -1);
+	std::vector<float> vertexScores(vertexCount);
+	for(size_t vertex = 0; vertex < vertexCount; vertex++)
+		vertexScores[vertex] = calculateVertexScore(-1, remainingValence[vertex]);
+
+	std::vector<float> triangleScores(triangleCount);
+	std::vector<bool> emittedTriangles(triangleCount, false);
+	uint32_t bestTriangle = 0U;
+	for(size_t triangle = 0; triangle < triangleCount; triangle++)
+	{
+		const uint32_t* vertices = indices + 3 * triangle;
+		triangleScores[triangle] = vertexScores[vertices[0]] + vertexScores[vertices[1]] + vertexScores[vertices[2]];
+		if(triangleScores[triangle] > triangleScores[bestTriangle])
+			bestTriangle = static_cast<uint32_t>(triangle);
+	}
+
+	std::vector<uint32_t> optimizedIndices(indexCount);
+	std::array<uint32_t, SCORING_CACHE_SIZE + 3> cache;
+	std::array<uint32_t, SCORING_CACHE_SIZE + 3> nextCache;
+	size_t cacheSize = 0;
+	size_t searchCursor = 0;
+
+	for(size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+	{
+		const uint32_t triangleVertices[3]
+		{
+			indices[3 * bestTriangle], indices[3 * bestTriangle + 1], indices[3 * bestTriangle + 2]
+		};
+		std::copy_n(triangleVertices, 3, optimizedIndices.begin() + 3 * emittedCount);
+		emittedTriangles[bestTriangle] = true;
+
+		// Removes the emitted triangle from the adjacency of its vertices
+		for(uint32_t vertex: triangleVertices)
+		{
+			uint32_t* adjacency = adjacentTriangles.data() + adjacencyOffsets[vertex];
+			uint32_t* adjacencyEnd = adjacency + remainingValence[vertex];
+			*std::find(adjacency, adjacencyEnd, bestTriangle) = *(adjacencyEnd - 1);
+			remainingValence[vertex]--;
+		}
+
+		// The emitted vertices move to the front of the cache, pushing the others back
+		size_t nextCacheSize = 0;
+		for(uint32_t vertex: triangleVertices)
+		{
+			if(std::find(nextCache.begin(), nextCache.begin() + nextCacheSize, vertex) == nextCache.begin() + nextCacheSize)
+				nextCache[nextCacheSize++] = vertex;
+		}
+		for(size_t i = 0; i < cacheSize; i++)
+		{
+			uint32_t vertex = cache[i];
+			if(vertex != triangleVertices[0] && vertex != triangleVertices[1] && vertex != triangleVertices[2])
+				nextCache[nextCacheSize++] = vertex;
+		}
+		std::swap(cache, nextCache);
+		cacheSize = nextCacheSize;
+
+		// Updates the scores of the cached and evicted vertices, searching for the best triangle around them
+		float bestScore = -1.0f;
+		for(size_t i = 0; i < cacheSize; i++)
+		{
+			uint32_t vertex = cache[i];
+			cachePositions[vertex] = (i < SCORING_CACHE_SIZE) ? static_cast<int32_t>(i) : -1;
+			vertexScores[vertex] = calculateVertexScore(cachePositions[vertex], remainingValence[vertex]);
+		}
+		for(size_t i = 0; i < cacheSize; i++)
+		{
+			uint32_t vertex = cache[i];
+			const uint32_t* adjacency = adjacentTriangles.data() + adjacencyOffsets[vertex];
+			for(uint32_t j = 0; j < remainingValence[vertex]; j++)
+			{
+				uint32_t triangle = adjacency[j];
+				const uint32_t* vertices = indices + 3 * triangle;
+				triangleScores[triangle] =
+					vertexScores[vertices[0]] + vertexScores[vertices[1]] + vertexScores[vertices[2]];
+				if(triangleScores[triangle] > bestScore)
+				{
+					bestScore = triangleScores[triangle];
+					bestTriangle = triangle;
+				}
+			}
+		}
+		cacheSize = std::min<size_t>(cacheSize, SCORING_CACHE_SIZE);
+
+		// Continues from the next unemitted triangle when the cached vertices have no triangles left
+		if(bestScore < 0.0f && emittedCount + 1 < triangleCount)
+		{
+			while(emittedTriangles[searchCursor])
+				searchCursor++;
+			bestTriangle = static_cast<uint32_t>(searchCursor);
+		}
+	}
+
+	std::copy(optimizedIndices.begin(), optimizedIndices.end(), indices);
+}
+
+void MeshOptimizer::optimizeOverdraw
+(
+	uint32_t* indices, size_t indexCount, const std::vector<Cooked::Vertex>& vertices
+)
+{
+	const size_t triangleCount = indexCount / 3;
+	std::vector<uint32_t> clusterStarts = generateClusters(indices, indexCount, vertices.size());
+	if(clusterStarts.size() < 2) return;
+	clusterStarts.push_back(static_cast<uint32_t>(triangleCount));
+
+	// Area weighted centroid and normal of each cluster, and the centroid of the whole submesh
+	struct Cluster
+	{
+		uint32_t firstTriangle;
+		uint32_t triangleCount;
+		Cooked::Vec3 centroid;
+		Cooked::Vec3 normal;
+		float area;
+		float sortKey;
+	};
+	std::vector<Cluster> clusters(clusterStarts.size() - 1);
+	Cooked::Vec3 submeshCentroid{0.0f, 0.0f, 0.0f};
+	float submeshArea = 0.0f;
+
+	for(size_t clusterIndex = 0; clusterIndex < clusters.size(); clusterIndex++)
+	{
+		Cluster& cluster = clusters[clusterIndex];
+		cluster.firstTriangle = clusterStarts[clusterIndex];
+		cluster.triangleCount = clusterStarts[clusterIndex + 1] - clusterStarts[clusterIndex];
+		cluster.centroid = Cooked::Vec3{0.0f, 0.0f, 0.0f};
+		cluster.normal = Cooked::Vec3{0.0f, 0.0f, 0.0f};
+		cluster.area = 0.0f;
+
+		for(uint32_t triangle = cluster.firstTriangle; triangle < clusterStarts[clusterIndex + 1]; triangle++)
+		{
+			const Cooked::Vec3& a = vertices[indices[3 * triangle]].position;
+			const Cooked::Vec3& b = vertices[indices[3 * triangle + 1]].position;
+			const Cooked::Vec3& c = vertices[indices[3 * triangle + 2]].position;
+
+			Cooked::Vec3 ab{b.x - a.x, b.y - a.y, b.z - a.z};
+			Cooked::Vec3 ac{c.x - a.x, c.y - a.y, c.z - a.z};
+			Cooked::Vec3 normal{ab.y * ac.z - ab.z * ac.y, ab.z * ac.x - ab.x * ac.z, ab.x * ac.y - ab.y * ac.x};
+			float area = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+
+			cluster.centroid.x += area * (a.x + b.x + c.x) / 3.0f;
+			cluster.centroid.y += area * (a.y + b.y + c.y) / 3.0f;
+			cluster.centroid.z += area * (a.z + b.z + c.z) / 3.0f;
+			cluster.normal.x += normal.x;
+			cluster.normal.y += normal.y;
+			cluster.normal.z += normal.z;
+			cluster.area += area;
+		}
+
+		submeshCentroid.x += cluster.centroid.x;
+		submeshCentroid.y += cluster.centroid.y;
+		submeshCentroid.z += cluster.centroid.z;
+		submeshArea += cluster.area;
+	}
+	if(submeshArea <= 0.0f) return;
+
+	submeshCentroid = Cooked::Vec3
+	{
+		submeshCentroid.x / submeshArea, submeshCentroid.y / submeshArea, submeshCentroid.z / submeshArea
+	};
+
+	// Clusters far along their own normal occlude the others from most view directions, so they are drawn first
+	for(Cluster& cluster: clusters)
+	{
+		float normalLength = std::sqrt
+		(
+			cluster.normal.x * cluster.normal.x + cluster.normal.y * cluster.normal.y + cluster.normal.z * cluster.normal.z
+		);
+		if(cluster.area <= 0.0f || normalLength <= 0.0f)
+		{
+			cluster.sortKey = -std::numeric_limits<float>::max();
+			continue;
+		}
+
+		Cooked::Vec3 offset
+		{
+			cluster.centroid.x / cluster.area - submeshCentroid.x,
+			cluster.centroid.y / cluster.area - submeshCentroid.y,
+			cluster.centroid.z / cluster.area - submeshCentroid.z
+		};
+		cluster.sortKey =
+			(offset.x * cluster.normal.x + offset.y * cluster.normal.y + offset.z * cluster.normal.z) / normalLength;
+	}
+	std::stable_sort
+	(
+		clusters.begin(), clusters.end(),
+		[](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; }
+	);
+
+	std::vector<uint32_t> sortedIndices;
+	sortedIndices.reserve(indexCount);
+	for(const Cluster& cluster: clusters)
+	{
+		const uint32_t* clusterIndices = indices + 3 * cluster.firstTriangle;
+		sortedIndices.insert(sortedIndices.end(), clusterIndices, clusterIndices + 3 * cluster.triangleCount);
+	}
+	std::copy(sortedIndices.begin(), sortedIndices.end(), indices);
+}
+
+std::vector<uint32_t> MeshOptimizer::generateClusters
+(
+	const uint32_t* indices, size_t indexCount, size_t vertexCount
+)
+{
+	const size_t triangleCount = indexCount / 3;
+	std::vector<uint32_t> loadTimestamps(vertexCount, 0U);
+	uint32_t timestamp = FIFO_CACHE_SIZE + 1U;
+
+	auto countMisses = [&](size_t triangle)
+	{
+		uint32_t misses = 0U;
+		for(size_t i = 3 * triangle; i < 3 * triangle + 3; i++)
+		{
+			if(timestamp - loadTimestamps[indices[i]] > FIFO_CACHE_SIZE)
+			{
+				loadTimestamps[indices[i]] = timestamp++;
+				misses++;
+			}
+		}
+		return misses;
+	};
+	auto clearCache = [&]() { timestamp += FIFO_CACHE_SIZE + 1U; };
+
+	// Hard boundaries, where the vertex cache order already restarts with a triangle of three misses
+	std::vector<uint32_t> hardBoundaries;
+	std::vector<uint32_t> triangleMisses(triangleCount);
+	for(size_t triangle = 0; triangle < triangleCount; triangle++)
+	{
+		triangleMisses[triangle] = countMisses(triangle);
+		if(triangleMisses[triangle] == 3U)
+			hardBoundaries.push_back(static_cast<uint32_t>(triangle));
+	}
+	hardBoundaries.push_back(static_cast<uint32_t>(triangleCount));
+
+	// Soft boundaries split the hard clusters where restarting the cache keeps the misses within the threshold
+	std::vector<uint32_t> clusterStarts;
+	for(size_t h = 0; h + 1 < hardBoundaries.size(); h++)
+	{
+		const uint32_t start = hardBoundaries[h];
+		const uint32_t end = hardBoundaries[h + 1];
+
+		uint32_t hardClusterMisses = 0U;
+		for(uint32_t triangle = start; triangle < end; triangle++)
+			hardClusterMisses += triangleMisses[triangle];
+		const float hardClusterAcmr = static_cast<float>(hardClusterMisses) / static_cast<float>(end - start);
+
+		clearCache();
+		clusterStarts.push_back(start);
+		uint32_t clusterStart = start;
+		uint32_t clusterMisses = 0U;
+		for(uint32_t triangle = start; triangle + 1 < end; triangle++)
+		{
+			clusterMisses += countMisses(triangle);
+			float clusterAcmr = static_cast<float>(clusterMisses) / static_cast<float>(triangle - clusterStart + 1U);
+			if(clusterAcmr <= OVERDRAW_THRESHOLD * hardClusterAcmr)
+			{
+				clearCache();
+				clusterStart = triangle + 1U;
+				clusterMisses = 0U;
+				clusterStarts.push_back(clusterStart);
+			}
+		}
+	}
+	return clusterStarts;
+}
+
+float MeshOptimizer::calculateVertexScore(int32_t cachePosition, uint32_t remainingValence)
+{
+	if(remainingValence == 0U) return -1.0f;
+
+	float score = 0.0f;
+	if(cachePosition >= 0)
+	{
+		if(cachePosition < 3)
+			score = LAST_TRIANGLE_SCORE;
+		else
+		{
+			float cacheFactor = 1.0f - static_cast<float>(cachePosition - 3) / (SCORING_CACHE_SIZE - 3);
+			score = std::pow(cacheFactor, CACHE_DECAY_POWER);
+		}
+	}
+	return score + VALENCE_BOOST_SCALE * std::pow(static_cast<float>(remainingValence), -VALENCE_BOOST_POWER);
+}
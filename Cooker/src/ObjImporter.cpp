@@ -0,0 +1,326 @@
+#include "ObjImporter.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <unordered_map>
+
+namespace ObjImporter
+{
+	// Hashes the vertex bytes, so that equal vertices are welded
+	struct VertexHash
+	{
+		size_t operator()(const Cooked::Vertex& vertex) const
+		{
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&vertex);
+			uint64_t hash = 14695981039346656037UL;
+			for(size_t i = 0; i < sizeof(Cooked::Vertex); i++)
+				hash = (hash ^ bytes[i]) * 1099511628211UL;
+			return static_cast<size_t>(hash);
+		}
+	};
+	struct VertexEqual
+	{
+		bool operator()(const Cooked::Vertex& a, const Cooked::Vertex& b) const
+		{
+			return std::memcmp(&a, &b, sizeof(Cooked::Vertex)) == 0;
+		}
+	};
+
+	// Attribute lists and welded vertices of the .obj being parsed
+	struct ObjData
+	{
+		std::vector<Cooked::Vec3> positions;
+		std::vector<Cooked::Vec2> textureCoordinates;
+		std::vector<Cooked::Vec3> normals;
+		std::vector<Cooked::Vertex> vertices;
+		std::unordered_map<Cooked::Vertex, uint32_t, VertexHash, VertexEqual> vertexIndices;
+	};
+
+	// Attribute indices of a face corner, negative if absent
+	struct FaceCorner
+	{
+		int64_t position;
+		int64_t textureCoordinate;
+		int64_t normal;
+	};
+
+	// Moves the next line of the content to the line view, returning false at the end of the content
+	static bool nextLine(std::string_view& content, std::string_view& line);
+	// Extracts the next whitespace separated word of the line
+	static std::string_view nextWord(std::string_view& line);
+	// Parses a float, returning the fallback value if the word is not a number
+	static float parseFloat(std::string_view word, float fallback = 0.0f);
+
+	// Parses a "v/vt/vn" face corner, converting relative indices to absolute ones
+	static bool parseFaceCorner(std::string_view word, const ObjData& data, FaceCorner& corner);
+	// Builds the corner vertex, returning the index of the welded vertex
+	static uint32_t weldVertex(const FaceCorner& corner, const Cooked::Vec3& faceNormal, ObjData& data);
+	// Calculates the normal of the triangle, for corners without normals
+	static Cooked::Vec3 calculateFaceNormal(const Cooked::Vec3& a, const Cooked::Vec3& b, const Cooked::Vec3& c);
+}
+
+void ObjImporter::loadMaterials(std::string_view mtlContent, std::vector<Cooked::Material>& materials)
+{
+	materials.clear();
+	std::vector<float> shininess;
+	std::vector<bool> hasRoughness;
+
+	std::string_view line;
+	while(nextLine(mtlContent, line))
+	{
+		std::string_view keyword = nextWord(line);
+		if(keyword == "newmtl")
+		{
+			materials.emplace_back().name = std::string{nextWord(line)};
+			shininess.push_back(0.0f);
+			hasRoughness.push_back(false);
+			continue;
+		}
+		if(materials.empty()) continue;
+
+		Cooked::Material& material = materials.back();
+		if(keyword == "Kd")
+		{
+			material.diffuse.x = parseFloat(nextWord(line));
+			material.diffuse.y = parseFloat(nextWord(line));
+			material.diffuse.z = parseFloat(nextWord(line));
+		}
+		else if(keyword == "Ke")
+		{
+			material.emission.x = parseFloat(nextWord(line));
+			material.emission.y = parseFloat(nextWord(line));
+			material.emission.z = parseFloat(nextWord(line));
+		}
+		else if(keyword == "Ni")
+			material.indexOfRefraction = parseFloat(nextWord(line), 1.0f);
+		else if(keyword == "d")
+			material.opacity = parseFloat(nextWord(line), 1.0f);
+		else if(keyword == "Ns")
+			shininess.back() = parseFloat(nextWord(line));
+		else if(keyword == "Pr")
+		{
+			material.roughness = parseFloat(nextWord(line), 1.0f);
+			hasRoughness.back() = true;
+		}
+		else if(keyword == "Pm")
+			material.metallic = parseFloat(nextWord(line));
+		else if(keyword == "map_Kd")
+		{
+			// Options before the file name are not supported, so the last word is used as the path
+			for(std::string_view word = nextWord(line); !word.empty(); word = nextWord(line))
+				material.diffuseMap = std::string{word};
+		}
+	}
+
+	// Converts the Phong exponent to a roughness when the PBR extension is absent
+	for(size_t i = 0; i < materials.size(); i++)
+	{
+		if(!hasRoughness[i])
+			materials[i].roughness = std::sqrt(2.0f / (std::max(shininess[i], 0.0f) + 2.0f));
+	}
+}
+
+bool ObjImporter::loadMesh
+(
+	std::string_view objContent,
+	const std::vector<Cooked::Material>& materials,
+	Cooked::Mesh& mesh,
+	std::string& error
+)
+{
+	ObjData data{};
+	std::unordered_map<std::string_view, uint32_t> materialSlots;
+	for(uint32_t i = 0; i < materials.size(); i++)
+		materialSlots.try_emplace(materials[i].name, i);
+
+	// Indices of each material slot, and the slots in order of first use
+	std::vector<std::vector<uint32_t>> slotIndices(std::max<size_t>(materials.size(), 1));
+	std::vector<uint32_t> slotOrder;
+	uint32_t currentSlot = 0U;
+
+	std::vector<FaceCorner> corners;
+	std::string_view line;
+	size_t lineNumber = 0;
+	while(nextLine(objContent, line))
+	{
+		lineNumber++;
+		std::string_view keyword = nextWord(line);
+		if(keyword == "v")
+		{
+			float x = parseFloat(nextWord(line));
+			float y = parseFloat(nextWord(line));
+			float z = parseFloat(nextWord(line));
+			data.positions.push_back(Cooked::Vec3{x, y, z});
+		}
+		else if(keyword == "vt")
+		{
+			float u = parseFloat(nextWord(line));
+			float v = parseFloat(nextWord(line));
+			data.textureCoordinates.push_back(Cooked::Vec2{u, v});
+		}
+		else if(keyword == "vn")
+		{
+			float x = parseFloat(nextWord(line));
+			float y = parseFloat(nextWord(line));
+			float z = parseFloat(nextWord(line));
+			data.normals.push_back(Cooked::Vec3{x, y, z});
+		}
+		else if(keyword == "usemtl")
+		{
+			auto slot = materialSlots.find(nextWord(line));
+			currentSlot = (slot != materialSlots.end()) ? slot->second : 0U;
+		}
+		else if(keyword == "f")
+		{
+			corners.clear();
+			for(std::string_view word = nextWord(line); !word.empty(); word = nextWord(line))
+			{
+				FaceCorner& corner = corners.emplace_back();
+				if(!parseFaceCorner(word, data, corner))
+				{
+					error = "invalid face corner \"" + std::string{word} + "\" at line " + std::to_string(lineNumber);
+					return false;
+				}
+			}
+			if(corners.size() < 3) continue;
+
+			if(slotIndices[currentSlot].empty())
+				slotOrder.push_back(currentSlot);
+
+			// Polygons are triangulated as a fan around the first corner
+			for(size_t i = 1; i + 1 < corners.size(); i++)
+			{
+				Cooked::Vec3 faceNormal{0.0f, 0.0f, -1.0f};
+				if(corners[0].normal < 0 || corners[i].normal < 0 || corners[i + 1].normal < 0)
+				{
+					faceNormal = calculateFaceNormal
+					(
+						data.positions[corners[0].position],
+						data.positions[corners[i].position],
+						data.positions[corners[i + 1].position]
+					);
+				}
+				slotIndices[currentSlot].push_back(weldVertex(corners[0], faceNormal, data));
+				slotIndices[currentSlot].push_back(weldVertex(corners[i], faceNormal, data));
+				slotIndices[currentSlot].push_back(weldVertex(corners[i + 1], faceNormal, data));
+			}
+		}
+	}
+
+	if(slotOrder.empty())
+	{
+		error = "no faces found";
+		return false;
+	}
+
+	mesh.vertices = std::move(data.vertices);
+	mesh.indices.clear();
+	mesh.submeshes.clear();
+	for(uint32_t slot: slotOrder)
+	{
+		Cooked::Submesh& submesh = mesh.submeshes.emplace_back();
+		submesh.indexOffset = static_cast<uint32_t>(mesh.indices.size());
+		submesh.indexCount = static_cast<uint32_t>(slotIndices[slot].size());
+		submesh.materialSlot = slot;
+		mesh.indices.insert(mesh.indices.end(), slotIndices[slot].begin(), slotIndices[slot].end());
+	}
+	return true;
+}
+
+bool ObjImporter::nextLine(std::string_view& content, std::string_view& line)
+{
+	if(content.empty()) return false;
+
+	size_t lineEnd = content.find('\n');
+	line = content.substr(0, lineEnd);
+	content.remove_prefix((lineEnd == std::string_view::npos) ? content.size() : lineEnd + 1);
+
+	if(!line.empty() && line.back() == '\r')
+		line.remove_suffix(1);
+	return true;
+}
+
+std::string_view ObjImporter::nextWord(std::string_view& line)
+{
+	size_t wordBegin = line.find_first_not_of(" \t");
+	if(wordBegin == std::string_view::npos)
+	{
+		line = std::string_view{};
+		return line;
+	}
+
+	size_t wordEnd = line.find_first_of(" \t", wordBegin);
+	std::string_view word = line.substr(wordBegin, wordEnd - wordBegin);
+	line.remove_prefix((wordEnd == std::string_view::npos) ? line.size() : wordEnd);
+	return word;
+}
+
+float ObjImporter::parseFloat(std::string_view word, float fallback)
+{
+	if(!word.empty() && word.front() == '+')
+		word.remove_prefix(1);
+
+	float value = fallback;
+	if(std::from_chars(word.data(), word.data() + word.size(), value).ec != std::errc{})
+		return fallback;
+	// Negative zeros are normalized, so they can be welded with positive zeros
+	return value + 0.0f;
+}
+
+bool ObjImporter::parseFaceCorner(std::string_view word, const ObjData& data, FaceCorner& corner)
+{
+	const size_t attributeCounts[3]{data.positions.size(), data.textureCoordinates.size(), data.normals.size()};
+	int64_t* attributeIndices[3]{&corner.position, &corner.textureCoordinate, &corner.normal};
+
+	for(size_t attribute = 0; attribute < 3; attribute++)
+	{
+		*attributeIndices[attribute] = -1;
+		size_t separator = word.find('/');
+		std::string_view indexText = word.substr(0, separator);
+		word.remove_prefix((separator == std::string_view::npos) ? word.size() : separator + 1);
+		if(indexText.empty()) continue;
+
+		int64_t index = 0;
+		if(std::from_chars(indexText.data(), indexText.data() + indexText.size(), index).ec != std::errc{})
+			return false;
+
+		// Negative indices are relative to the end of the attribute list
+		index = (index < 0) ? static_cast<int64_t>(attributeCounts[attribute]) + index : index - 1;
+		if(index < 0 || index >= static_cast<int64_t>(attributeCounts[attribute]))
+			return false;
+		*attributeIndices[attribute] = index;
+	}
+	return corner.position >= 0;
+}
+
+uint32_t ObjImporter::weldVertex(const FaceCorner& corner, const Cooked::Vec3& faceNormal, ObjData& data)
+{
+	Cooked::Vertex vertex
+	{
+		data.positions[corner.position],
+		(corner.textureCoordinate >= 0) ? data.textureCoordinates[corner.textureCoordinate] : Cooked::Vec2{0.0f, 0.0f},
+		(corner.normal >= 0) ? data.normals[corner.normal] : faceNormal
+	};
+
+	auto [vertexIndex, inserted] = data.vertexIndices.try_emplace
+	(
+		vertex, static_cast<uint32_t>(data.vertices.size())
+	);
+	if(inserted)
+		data.vertices.push_back(vertex);
+	return vertexIndex->second;
+}
+
+Cooked::Vec3 ObjImporter::calculateFaceNormal(const Cooked::Vec3& a, const Cooked::Vec3& b, const Cooked::Vec3& c)
+{
+	Cooked::Vec3 ab{b.x - a.x, b.y - a.y, b.z - a.z};
+	Cooked::Vec3 ac{c.x - a.x, c.y - a.y, c.z - a.z};
+	Cooked::Vec3 normal{ab.y * ac.z - ab.z * ac.y, ab.z * ac.x - ab.x * ac.z, ab.x * ac.y - ab.y * ac.x};
+
+	float length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+	if(length <= 0.0f)
+		return Cooked::Vec3{0.0f, 0.0f, -1.0f};
+	return Cooked::Vec3{normal.x / length, normal.y / length, normal.z / length};
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "CookedAssets.hpp"
+
+// Parser for the Wavefront .obj and .mtl source assets
+namespace ObjImporter
+{
+	// Parses the materials of a .mtl file, in declaration order
+	void loadMaterials(std::string_view mtlContent, std::vector<Cooked::Material>& materials);
+
+	// Parses the triangles of an .obj file, welding equal vertices and grouping the indices by material slot
+	bool loadMesh
+	(
+		std::string_view objContent,
+		const std::vector<Cooked::Material>& materials,
+		Cooked::Mesh& mesh,
+		std::string& error
+	);
+}
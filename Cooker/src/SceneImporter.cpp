@@ -0,0 +1,63 @@
+#include "SceneImporter.hpp"
+
+#include <nlohmann/json.hpp>
+
+// Only the current JSON scene version is converted, as the engine loads no other
+constexpr const char* SCENE_JSON_VERSION = "0.2.2";
+
+bool SceneImporter::loadScene(std::string_view jsonContent, Cooked::Scene& scene, std::string& error)
+{
+	nlohmann::json sceneJson = nlohmann::json::parse(jsonContent, nullptr, false);
+	if(sceneJson.is_discarded() || !sceneJson.is_object())
+	{
+		error = "invalid JSON";
+		return false;
+	}
+	if(sceneJson.value("scene-loader-version", "") != SCENE_JSON_VERSION)
+	{
+		error = "unsupported scene version (expected " + std::string{SCENE_JSON_VERSION} + ')';
+		return false;
+	}
+
+	try
+	{
+		sceneJson.at("textures").get_to(scene.texturePaths);
+		sceneJson.at("materials").get_to(scene.materialPaths);
+		sceneJson.at("meshes").get_to(scene.meshPaths);
+
+		const nlohmann::json& instancesJson = sceneJson.at("instances");
+		scene.instances.reserve(instancesJson.size());
+		for(const nlohmann::json& instanceJson: instancesJson)
+		{
+			const nlohmann::json& transformJson = instanceJson.at("transform");
+			if(transformJson.size() != 16)
+			{
+				error = "instance transform without 16 values";
+				return false;
+			}
+
+			Cooked::SceneInstance& instance = scene.instances.emplace_back();
+			for(size_t i = 0; i < 16; i++)
+				instance.transform[i] = transformJson[i].get<float>();
+			instance.pipelineID = instanceJson.at("pipeline-id").get<uint32_t>();
+			instance.meshID = instanceJson.at("mesh-id").get<uint32_t>();
+			instance.materialSetID = instanceJson.at("material-set-id").get<uint32_t>();
+			instance.visible = instanceJson.at("visible").get<bool>() ? 1U : 0U;
+			instance.padding[0] = instance.padding[1] = instance.padding[2] = 0U;
+		}
+	}
+	catch(const nlohmann::json::exception& exception)
+	{
+		error = exception.what();
+		return false;
+	}
+
+	// The engine reads the remaining fields with the JSON scene loader, so they keep their layout
+	sceneJson.erase("textures");
+	sceneJson.erase("materials");
+	sceneJson.erase("meshes");
+	sceneJson.erase("instances");
+	scene.settings = nlohmann::json::to_msgpack(sceneJson);
+
+	return true;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+#include "CookedAssets.hpp"
+
+// Parser for the JSON scene files
+namespace SceneImporter
+{
+	// Parses a JSON scene, separating the resource paths and the instances from the remaining settings
+	bool loadScene(std::string_view jsonContent, Cooked::Scene& scene, std::string& error);
+}
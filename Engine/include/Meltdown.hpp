@@ -29,6 +29,13 @@ namespace mtd
 			* @param window Window targeted for rendering.
 			*/
 			MeltdownEngine(const EngineInfo& info, Window& window);
+			/*
+			* @brief Initializes Vulkan and other engine dependencies without a window, rendering to offscreen
+			* images. The `headless` flag must be set in the `EngineInfo`.
+			*
+			* @param info Information about the engine options and the application name and version.
+			*/
+			MeltdownEngine(const EngineInfo& info);
 			~MeltdownEngine();
 
 			MeltdownEngine(const MeltdownEngine&) = delete;
@@ -63,15 +70,59 @@ namespace mtd
 			* @param onUpdateCallback Callback function called on every engine update.
 			*/
 			void run(Window& window, const std::function<void(double)>& onUpdateCallback);
+			/*
+			* @brief Runs a fixed amount of frames, updating and rendering on the calling thread.
+			* Intended for the headless mode, where there is no window to keep the main loop running.
+			*
+			* @param frameCount Number of frames to be updated and rendered.
+			* @param fixedDeltaTime Time step, in seconds, passed to every update.
+			* @param onUpdateCallback Callback function called on every engine update.
+			*/
+			void runFrames
+			(
+				uint32_t frameCount, double fixedDeltaTime, const std::function<void(double)>& onUpdateCallback
+			);
+
+			/*
+			* @brief Copies the last rendered frame to CPU memory. Only available in headless mode.
+			*
+			* @param pixels Vector filled with the frame pixels, in the RGBA8 format, row by row from the top.
+			*
+			* @return Whether the frame could be read back or not.
+			*/
+			bool readbackFrame(std::vector<uint8_t>& pixels);
+			/*
+			* @brief Saves the last rendered frame as a PNG image. Only available in headless mode.
+			*
+			* @param filePath Path of the PNG file to be written.
+			*
+			* @return Whether the image was saved or not.
+			*/
+			bool saveFrameToPNG(const char* filePath);
 
 			/*
-			* @brief Loads a new scene to be rendered by the engine. It needs to be called before starting
-			* the main engine loop.
-			* If a scene is already being rendered, it will be cleared before loading the new scene.
+			* @brief Loads a new scene to be rendered by the engine, blocking until it is loaded. It needs to be
+			* called before starting the main engine loop.
+			* If a scene is already being rendered, it will be cleared after loading the new scene, unless it
+			* can be kept resident (see `EngineInfo::maxResidentScenes`). A resident scene is activated without loading.
+			* To change the scene while the engine is running, dispatch a `ChangeSceneEvent` instead, which loads
+			* the scene in the background.
 			*
 			* @param sceneFile Path to the file containing the new scene data.
 			*/
 			void loadScene(const char* sceneFile);
+			/*
+			* @brief Checks if a scene requested by a `ChangeSceneEvent` is still loading.
+			*
+			* @return Whether a scene is being loaded in the background or not.
+			*/
+			bool isLoadingScene() const;
+			/*
+			* @brief Getter for the progress of the scene being loaded in the background.
+			*
+			* @return Fraction of the scene loading already done, between 0.0f and 1.0f.
+			*/
+			float getSceneLoadProgress() const;
 
 			/*
 			* @brief Enables GUIs to be rendered by the engine.
@@ -218,6 +269,97 @@ namespace mtd
 		void MELTDOWN_API unmapAction(uint32_t action);
 	}
 
+	/*
+	* @brief Creates, deletes and changes the scene instances of the active scene. The instances are identified by their
+	* indices in the scene, following the instance order of the scene file, and the indices of deleted instances may be
+	* reused by new instances. The changes are applied in the next rendered frame.
+	* Should be called from the update callback, while the active scene cannot be replaced.
+	*/
+	namespace SceneInstances
+	{
+		/*
+		* @brief Adds a new instance to the active scene.
+		*
+		* @param instanceInfo Transform, pipeline, mesh and material set of the new instance.
+		* @param instanceIndex Output for the index of the new instance, only written when it is created.
+		*
+		* @return Whether the instance has been created, which fails without an active scene or with an invalid mesh.
+		*/
+		bool MELTDOWN_API createInstance(const SceneInstanceInfo& instanceInfo, uint32_t& instanceIndex);
+		/*
+		* @brief Removes an instance from the active scene. Ignored if the index does not refer to an instance.
+		*
+		* @param instanceIndex Index of the instance to be removed.
+		*/
+		void MELTDOWN_API deleteInstance(uint32_t instanceIndex);
+
+		/*
+		* @brief Getter for the current state of an instance, such as one found by a `SpatialQuery`.
+		*
+		* @param instanceIndex Index of the target instance.
+		* @param instanceInfo Output for the transform, pipeline, mesh, material set and visibility of the instance,
+		* only written when the index refers to an instance.
+		*
+		* @return Whether the index refers to an instance of the active scene.
+		*/
+		bool MELTDOWN_API getInstance(uint32_t instanceIndex, SceneInstanceInfo& instanceInfo);
+
+		/*
+		* @brief Replaces the transformation matrix of an instance. Ignored if the index does not refer to an instance.
+		*
+		* @param instanceIndex Index of the target instance.
+		* @param transform New transformation matrix from the mesh coordinates to the world coordinates.
+		*/
+		void MELTDOWN_API setTransform(uint32_t instanceIndex, const Mat4x4& transform);
+		/*
+		* @brief Shows or hides an instance. Ignored if the index does not refer to an instance.
+		*
+		* @param instanceIndex Index of the target instance.
+		* @param visible Whether the instance should be rendered or not.
+		*/
+		void MELTDOWN_API setVisibility(uint32_t instanceIndex, bool visible);
+	}
+
+	/*
+	* @brief Finds the scene instances of the active scene by their world space bounding boxes, which enclose the
+	* mesh bounding boxes transformed by the instance transforms. Only instances being rendered are found, with the
+	* transforms applied in the last rendered frame. The instances are identified by their indices in the scene, the
+	* same used by the `SceneInstances` functions, such as `SceneInstances::getInstance()` to find their meshes.
+	* Should be called from the update callback, while the active scene cannot be replaced.
+	*/
+	namespace SpatialQuery
+	{
+		/*
+		* @brief Finds the instances whose bounding boxes overlap an axis aligned box.
+		*
+		* @param minCorner Corner of the box with the lowest coordinates.
+		* @param maxCorner Corner of the box with the highest coordinates.
+		*
+		* @return Indices of the overlapping scene instances, in no particular order.
+		*/
+		std::vector<uint32_t> MELTDOWN_API overlapBox(const Vec3& minCorner, const Vec3& maxCorner);
+		/*
+		* @brief Finds the instances whose bounding boxes overlap a sphere.
+		*
+		* @param center Position of the sphere center.
+		* @param radius Radius of the sphere.
+		*
+		* @return Indices of the overlapping scene instances, in no particular order.
+		*/
+		std::vector<uint32_t> MELTDOWN_API overlapSphere(const Vec3& center, float radius);
+		/*
+		* @brief Finds the closest instance whose bounding box is hit by a ray, such as for picking.
+		*
+		* @param origin Starting point of the ray.
+		* @param direction Direction of the ray, which does not need to be normalized.
+		* @param maxDistance Length of the ray, beyond which the instances are ignored.
+		* @param hit Output for the closest instance hit, only written when an instance is hit.
+		*
+		* @return Whether any instance has been hit.
+		*/
+		bool MELTDOWN_API raycast(const Vec3& origin, const Vec3& direction, float maxDistance, RaycastHit& hit);
+	}
+
 	/*
 	* @brief Handles performance metrics collection.
 	*/
@@ -225,9 +367,64 @@ namespace mtd
 	{
 		/*
 		* @brief Retrieves the data collected from the last frame by the profiler.
+		* Should be called from the thread running the engine main loop.
 		*
 		* @return Profiled data from the last frame.
 		*/
 		const FrameData& getProfiledData();
+		/*
+		* @brief Retrieves the data collected from the most recent frames, ordered from the oldest to the newest.
+		* Should be called from the thread running the engine main loop.
+		*
+		* @return Copy of the profiled data from the frame history.
+		*/
+		std::vector<FrameData> MELTDOWN_API getFrameHistory();
+
+		/*
+		* @brief Enables or disables the collection of profiling data. Enabled by default, in all build types.
+		*
+		* @param enable Value to which the profiler state will be set.
+		*/
+		void MELTDOWN_API setEnabled(bool enable);
+
+		/*
+		* @brief Starts measuring a zone of code in the calling thread. Zones can be nested, and each call must be
+		* paired with an `endZone()` call in the same thread. Prefer using a `ScopedZone` instead.
+		*
+		* @param name Name of the zone, exhibited in the trace.
+		*/
+		void MELTDOWN_API beginZone(const char* name);
+		/*
+		* @brief Stops measuring the last zone started in the calling thread.
+		*/
+		void MELTDOWN_API endZone();
+
+		/*
+		* @brief Writes the most recent zones and frame stages of all threads to a JSON file in the
+		* Chrome trace event format, which can be opened with `about:tracing` or Perfetto.
+		*
+		* @param filePath Path to the output file.
+		*
+		* @return Whether the trace has been written successfully.
+		*/
+		bool MELTDOWN_API exportChromeTrace(const char* filePath);
+
+		/*
+		* @brief Measures a zone from its construction until the end of its scope.
+		*/
+		class ScopedZone
+		{
+			public:
+				/*
+				* @brief Starts measuring the zone.
+				*
+				* @param name Name of the zone, exhibited in the trace.
+				*/
+				ScopedZone(const char* name) { beginZone(name); }
+				~ScopedZone() { endZone(); }
+
+				ScopedZone(const ScopedZone&) = delete;
+				ScopedZone& operator=(const ScopedZone&) = delete;
+		};
 	}
 }
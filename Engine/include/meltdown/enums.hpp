@@ -75,7 +75,8 @@ namespace mtd
 		Vertex = 1U << 2,
 		Index = 1U << 3,
 		TransferSource = 1U << 4,
-		TransferDestination = 1U << 5
+		TransferDestination = 1U << 5,
+		Indirect = 1U << 6
 	};
 	ENABLE_ENUM_FLAGS(GpuBufferType)
 
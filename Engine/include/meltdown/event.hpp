@@ -312,7 +312,9 @@ namespace mtd
 
 	/*
 	* @brief Event class for changing the current scene. Dispatching it will load the scene with
-	* the specified scene name.
+	* the specified scene name in the background, while the current scene keeps being rendered.
+	* The new scene replaces the current one at the start of the first frame after it finishes loading.
+	* If the scene is resident (see `EngineInfo::maxResidentScenes`), it is switched to immediately and restarted.
 	*/
 	class ChangeSceneEvent : public Event
 	{
@@ -335,6 +337,32 @@ namespace mtd
 			const char* sceneName;
 	};
 
+	/*
+	* @brief Event class for preloading a scene. Dispatching it will load the scene with the specified
+	* scene name in the background and keep it resident, so a later `ChangeSceneEvent` switches to it
+	* immediately. Requires `EngineInfo::maxResidentScenes` to be greater than one.
+	*/
+	class PreloadSceneEvent : public Event
+	{
+		public:
+			/*
+			* @brief Creates an event to preload a scene.
+			*
+			* @param sceneName Scene file name.
+			*/
+			PreloadSceneEvent(const char* sceneName);
+
+			/*
+			* @brief Getter for the name of the scene to be preloaded.
+			*
+			* @return String with the scene file name.
+			*/
+			const char* getSceneName() const;
+
+		private:
+			const char* sceneName;
+	};
+
 	/*
 	* @brief Event class for adding instances of a specific mesh.
 	*/
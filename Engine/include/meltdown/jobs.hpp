@@ -0,0 +1,137 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <meltdown/macros.hpp>
+
+namespace mtd
+{
+	/*
+	* @brief Type for the functions executed by the job system. Jobs must not throw exceptions.
+	*/
+	using Job = std::function<void()>;
+
+	/*
+	* @brief Tracks the completion of a group of jobs, allowing to wait for them or to schedule dependent jobs.
+	* The counter must outlive all jobs submitted with it.
+	*/
+	class MELTDOWN_API JobCounter
+	{
+		public:
+			JobCounter() = default;
+			~JobCounter() = default;
+
+			JobCounter(const JobCounter&) = delete;
+			JobCounter& operator=(const JobCounter&) = delete;
+
+			/*
+			* @brief Checks if all jobs tracked by the counter have finished.
+			*
+			* @return Whether there are no pending jobs.
+			*/
+			bool isDone() const { return pendingJobs.load(std::memory_order_acquire) == 0U; }
+
+		private:
+			/*
+			* @brief Job waiting for the counter to reach zero, and the counter tracking the job itself.
+			*/
+			struct Continuation
+			{
+				Job job;
+				JobCounter* pCounter;
+			};
+
+			/* @brief Amount of submitted jobs that have not finished yet. */
+			std::atomic<uint32_t> pendingJobs{0U};
+			/* @brief Guards the continuations and the completion of the jobs. */
+			std::mutex counterMutex;
+			/* @brief Jobs submitted only when all tracked jobs have finished. */
+			std::vector<Continuation> continuations;
+
+			friend class JobScheduler;
+	};
+
+	/*
+	* @brief Schedules jobs into a pool of worker threads, which steal jobs from each other when idle.
+	* Without a running engine, the jobs are executed immediately in the calling thread.
+	*/
+	namespace JobSystem
+	{
+		/*
+		* @brief Gets the amount of worker threads in the job system.
+		*
+		* @return Number of worker threads, or zero if the job system is not running.
+		*/
+		uint32_t MELTDOWN_API getWorkerCount();
+
+		/*
+		* @brief Submits a job to be executed by a worker thread.
+		*
+		* @param job Function to be executed.
+		* @param pCounter Optional counter incremented now and decremented when the job finishes.
+		*/
+		void MELTDOWN_API submit(Job job, JobCounter* pCounter = nullptr);
+		/*
+		* @brief Submits a job that only starts after all jobs tracked by a counter have finished.
+		*
+		* @param dependency Counter that must reach zero before the job is started.
+		* @param job Function to be executed.
+		* @param pCounter Optional counter incremented now and decremented when the job finishes.
+		*/
+		void MELTDOWN_API submitAfter(JobCounter& dependency, Job job, JobCounter* pCounter = nullptr);
+
+		/*
+		* @brief Blocks until all jobs tracked by the counter have finished.
+		* The calling thread executes pending jobs while waiting, so it is safe to wait inside a job. Threads
+		* outside the job system only execute the jobs tracked by the counter.
+		*
+		* @param counter Counter tracking the jobs to be waited.
+		*/
+		void MELTDOWN_API wait(JobCounter& counter);
+
+		/*
+		* @brief Splits the range `[begin, end)` into chunks, processing them in parallel and returning when all
+		* chunks are done. The calling thread processes the first chunk.
+		*
+		* @param begin First index of the range.
+		* @param end Index after the last one of the range.
+		* @param grainSize Maximum amount of indices in each chunk. If zero, a size is chosen based on the
+		* amount of worker threads.
+		* @param function Callable receiving the `(chunkBegin, chunkEnd)` indices of each chunk.
+		* It must be safe to call concurrently for different chunks.
+		*/
+		template<typename Function>
+		void parallelFor(uint32_t begin, uint32_t end, uint32_t grainSize, const Function& function)
+		{
+			if(begin >= end) return;
+
+			uint32_t rangeSize = end - begin;
+			if(grainSize == 0U)
+			{
+				uint32_t chunkCount = 4U * (getWorkerCount() + 1U);
+				grainSize = std::max((rangeSize + chunkCount - 1U) / chunkCount, 1U);
+			}
+			if(rangeSize <= grainSize)
+			{
+				function(begin, end);
+				return;
+			}
+
+			JobCounter counter;
+			uint32_t chunkBegin = begin + grainSize;
+			while(chunkBegin < end)
+			{
+				uint32_t chunkEnd = chunkBegin + std::min(grainSize, end - chunkBegin);
+				submit([&function, chunkBegin, chunkEnd]() { function(chunkBegin, chunkEnd); }, &counter);
+				chunkBegin = chunkEnd;
+			}
+
+			function(begin, begin + grainSize);
+			wait(counter);
+		}
+	}
+}
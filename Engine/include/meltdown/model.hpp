@@ -2,6 +2,7 @@
 
 #include <functional>
 #include <memory>
+#include <span>
 #include <string>
 #include <type_traits>
 #include <unordered_map>
@@ -73,8 +74,61 @@ namespace mtd
 			uint64_t instanceID;
 	};
 
+	/*
+	* @brief Stores and updates all instances of a model type at once, keeping the instance data in dense arrays.
+	* The transforms are owned by the engine and passed as a span, indexed in the same order as the instances.
+	*/
+	class ModelBatch
+	{
+		public:
+			ModelBatch() = default;
+			virtual ~ModelBatch() = default;
+
+			ModelBatch(const ModelBatch&) = delete;
+			ModelBatch& operator=(const ModelBatch&) = delete;
+
+			/*
+			* @brief Appends new instances to the end of the batch.
+			*
+			* @param transforms Pre transform matrices of the new instances, which may be modified by the batch.
+			* @param instanceIDs Output span, with the same size as `transforms`, for the new instance IDs.
+			*/
+			virtual void addInstances(std::span<Mat4x4> transforms, std::span<uint64_t> instanceIDs) = 0;
+			/*
+			* @brief Removes an instance by moving the last instance to its place.
+			*
+			* @param instanceIndex Index of the instance in the batch.
+			*/
+			virtual void removeInstance(uint32_t instanceIndex) = 0;
+
+			/*
+			* @brief Runs the start code for a range of instances.
+			*
+			* @param transforms Transforms of the instances in the range.
+			* @param firstInstance Index of the first instance of the range in the batch.
+			*/
+			virtual void start(std::span<Mat4x4> transforms, uint32_t firstInstance) = 0;
+			/*
+			* @brief Runs the update code for a range of instances.
+			*
+			* @param transforms Transforms of the instances in the range.
+			* @param firstInstance Index of the first instance of the range in the batch.
+			* @param deltaTime Time, in seconds, between the last frame and the current one.
+			*/
+			virtual void update(std::span<Mat4x4> transforms, uint32_t firstInstance, double deltaTime) = 0;
+
+			/*
+			* @brief Checks if disjoint instance ranges can be updated at the same time, by different threads.
+			*
+			* @return Whether the update can be split among the job system worker threads.
+			*/
+			virtual bool supportsParallelUpdate() const { return false; }
+	};
+
 	using ModelFactory = std::function<std::unique_ptr<Model>(const Mat4x4&)>;
 	using ModelFactories = std::unordered_map<std::string, mtd::ModelFactory>;
+	using ModelBatchFactory = std::function<std::unique_ptr<ModelBatch>()>;
+	using ModelBatchFactories = std::unordered_map<std::string, mtd::ModelBatchFactory>;
 
 	/*
 	* @brief Stores and handles model instantiation, which describes an object in the engine.
@@ -95,8 +149,26 @@ namespace mtd
 			*/
 			static ModelFactory getModelFactory(const std::string& modelID);
 
+			/*
+			* @brief Creates the batch that stores and updates the instances of a model. Models registered with
+			* `registerModel()` are wrapped in a batch that calls `Model::update()` for each instance.
+			*
+			* @param modelID String identifying a specific registered model.
+			*
+			* @return The model batch, which does not update its instances if the model is not registered.
+			*/
+			static std::unique_ptr<ModelBatch> createModelBatch(const std::string& modelID);
+
+			/*
+			* @brief Generates a new ID, unique among all instances of the current scene.
+			*
+			* @return Numeric ID for a new instance.
+			*/
+			static uint64_t createInstanceID();
+
 			/*
 			* @brief Returns a pointer to the model instance associated to an ID.
+			* Instances of batch models do not have a `Model` object, returning a `nullptr`.
 			*
 			* @param instanceID Unique number identifying all instances present in the current scene.
 			*
@@ -125,16 +197,111 @@ namespace mtd
 					"ModelT must be a derived class of Model in registerModel<ModelT>()."
 				);
 
-				modelFactoryRegistry[modelID] = [&modelID](const Mat4x4& preTransform)
+				modelFactoryRegistry[modelID] = [modelName = std::string{modelID}](const Mat4x4& preTransform)
 				{
-					return std::make_unique<ModelT>(modelID, preTransform);
+					return std::make_unique<ModelT>(modelName.c_str(), preTransform);
 				};
 			}
 
+			/*
+			* @brief Stores a new batch model, which will be linked based on the model ID.
+			* The state of each instance is kept in a dense array of `BehaviourT`, and ranges of instances are started
+			* and updated at once by the static functions `BehaviourT::start(transforms, behaviours)` and
+			* `BehaviourT::update(transforms, behaviours, deltaTime)`, avoiding a virtual call per instance.
+			* The update function is called concurrently for disjoint ranges by the job system, so it must only
+			* modify the instances in the spans it receives.
+			*
+			* @param modelID String identifying the model to be registered.
+			*/
+			template<typename BehaviourT>
+			static void registerBatchModel(const char* modelID);
+
 		private:
 			/*
 			* @brief Stores the callbacks to create new model instances.
 			*/
 			static ModelFactories modelFactoryRegistry;
+			/*
+			* @brief Stores the callbacks to create new model batches.
+			*/
+			static ModelBatchFactories modelBatchFactoryRegistry;
 	};
+
+	/*
+	* @brief Model batch storing the instance states in a dense array of `BehaviourT`.
+	*/
+	template<typename BehaviourT>
+	class BehaviourModelBatch : public ModelBatch
+	{
+		static_assert
+		(
+			requires(std::span<Mat4x4> transforms, std::span<BehaviourT> behaviours, double deltaTime)
+			{
+				BehaviourT::start(transforms, behaviours);
+				BehaviourT::update(transforms, behaviours, deltaTime);
+			},
+			"BehaviourT must have static start(transforms, behaviours) and update(transforms, behaviours, deltaTime)."
+		);
+
+		public:
+			BehaviourModelBatch() = default;
+			virtual ~BehaviourModelBatch() = default;
+
+			/*
+			* @brief Appends new instances with default constructed behaviours.
+			*/
+			virtual void addInstances(std::span<Mat4x4> transforms, std::span<uint64_t> instanceIDs) override
+			{
+				behaviours.resize(behaviours.size() + transforms.size());
+				for(uint64_t& instanceID: instanceIDs)
+					instanceID = ModelHandler::createInstanceID();
+			}
+			/*
+			* @brief Removes an instance by moving the last behaviour to its place.
+			*/
+			virtual void removeInstance(uint32_t instanceIndex) override
+			{
+				if(instanceIndex >= behaviours.size()) return;
+
+				behaviours[instanceIndex] = std::move(behaviours.back());
+				behaviours.pop_back();
+			}
+
+			/*
+			* @brief Starts a range of instances in a single call.
+			*/
+			virtual void start(std::span<Mat4x4> transforms, uint32_t firstInstance) override
+			{
+				std::span<BehaviourT> behaviourSpan{behaviours};
+				BehaviourT::start(transforms, behaviourSpan.subspan(firstInstance, transforms.size()));
+			}
+			/*
+			* @brief Updates a range of instances in a single call.
+			*/
+			virtual void update(std::span<Mat4x4> transforms, uint32_t firstInstance, double deltaTime) override
+			{
+				std::span<BehaviourT> behaviourSpan{behaviours};
+				BehaviourT::update(transforms, behaviourSpan.subspan(firstInstance, transforms.size()), deltaTime);
+			}
+
+			/*
+			* @brief Batch models are updated in parallel.
+			*/
+			virtual bool supportsParallelUpdate() const override { return true; }
+
+		private:
+			/*
+			* @brief State of each instance, in the same order as the transforms.
+			*/
+			std::vector<BehaviourT> behaviours;
+	};
+
+	template<typename BehaviourT>
+	void ModelHandler::registerBatchModel(const char* modelID)
+	{
+		modelBatchFactoryRegistry[modelID] = []()
+		{
+			return std::make_unique<BehaviourModelBatch<BehaviourT>>();
+		};
+	}
 }
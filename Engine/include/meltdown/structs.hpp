@@ -27,6 +27,30 @@ namespace mtd
 		uint32_t appVersionPatch = 0U;
 		/* @brief Flag to enable ray tracing if the hardware supports it. */
 		bool enableRayTracing = false;
+		/*
+		* @brief Flag to render without a window, surface or swapchain, targeting offscreen images instead.
+		* The engine must be created with the constructor that does not take a window.
+		*/
+		bool headless = false;
+		/* @brief Horizontal resolution of the offscreen images, used only in headless mode. */
+		uint32_t headlessWidth = 1280U;
+		/* @brief Vertical resolution of the offscreen images, used only in headless mode. */
+		uint32_t headlessHeight = 720U;
+		/*
+		* @brief GPU memory budget, in bytes, for the textures, meshes, materials and shaders kept across scene changes.
+		* Assets no longer used by any scene are evicted, least recently used first, while the cache exceeds it.
+		*/
+		uint64_t assetCacheBudget = 512UL << 20;
+		/*
+		* @brief Maximum amount of fully prepared scenes kept in memory, including the active one.
+		* Switching to a resident scene skips its loading. Values above one also enable `PreloadSceneEvent`.
+		*/
+		uint32_t maxResidentScenes = 1U;
+		/*
+		* @brief GPU memory budget, in bytes, for the resident scenes other than the active one.
+		* The least recently active scenes are destroyed while the resident scenes exceed it.
+		*/
+		uint64_t residentSceneBudget = 256UL << 20;
 	};
 
 	/*
@@ -60,6 +84,8 @@ namespace mtd
 			float totalFrameTime = 0.0f;
 			/* @brief Time taken for each stage of the frame, in milliseconds, indexed by the stage name. */
 			std::unordered_map<const char*, float> stageTimes;
+			/* @brief Amount of draw calls recorded for the scene in the frame, not counting the GUI. */
+			uint32_t drawCallCount = 0U;
 		};
 	}
 
@@ -147,6 +173,12 @@ namespace mtd
 		ShaderFaceCulling faceCulling = ShaderFaceCulling::None;
 		/* @brief Enables alpha blending for the pipeline. */
 		bool useTransparency = false;
+		/*
+		* @brief Skips the instances whose bounding box is outside the camera frustum, either on the GPU culling pass or on
+		* the CPU culling used when the device does not support it.
+		* Disable it for pipelines whose vertex shaders move the vertices outside the transformed mesh bounds.
+		*/
+		bool frustumCulling = true;
 	};
 
 	/*
@@ -211,4 +243,33 @@ namespace mtd
 		/* @brief Defines the workgroup X and Y count based on the image resolution and workgroup local sizes. */
 		std::array<bool, 2> calculateWorkgroupsFromImage = {false, false};
 	};
+
+	/*
+	* @brief Information for creating a scene instance, rendered by a rasterization pipeline.
+	* The IDs follow the same order as the pipelines, meshes and material sets listed in the scene file.
+	*/
+	struct SceneInstanceInfo
+	{
+		/* @brief Transformation matrix from the mesh coordinates to the world coordinates. */
+		Mat4x4 transform = Mat4x4{1.0f};
+		/* @brief Index of the rasterization pipeline that renders the instance. */
+		uint32_t pipelineID = 0U;
+		/* @brief Index of the mesh rendered by the instance. */
+		uint32_t meshID = 0U;
+		/* @brief Index of the material set used by the instance. */
+		uint32_t materialSetID = 0U;
+		/* @brief Whether the instance is rendered or not. */
+		bool visible = true;
+	};
+
+	/*
+	* @brief Closest scene instance hit by a ray in a spatial query.
+	*/
+	struct RaycastHit
+	{
+		/* @brief Index of the scene instance whose bounding box was hit. */
+		uint32_t instanceIndex;
+		/* @brief Distance from the ray origin to the point where the ray enters the bounding box. */
+		float distance;
+	};
 }
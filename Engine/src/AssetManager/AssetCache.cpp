@@ -0,0 +1,263 @@
+#include <pch.hpp>
+#include "AssetCache.hpp"
+
+#include "../Utils/FileHandler.hpp"
+#include "../Utils/Logger.hpp"
+#include "../Vulkan/EnumMapping/EnumMapping.hpp"
+
+namespace mtd
+{
+    constexpr uint64_t FNV_OFFSET_BASIS = 0xCBF29CE484222325UL;
+    constexpr uint64_t FNV_PRIME = 0x100000001B3UL;
+
+    // Smallest arena of each type, so small scenes share the same arenas
+    constexpr std::array<uint64_t, 3> MIN_ARENA_CAPACITIES{32UL << 20, 16UL << 20, 1UL << 20};
+    // Buffer types of the arenas, matching the buffers they replace in the scene descriptors
+    constexpr std::array<GpuBufferType, 3> ARENA_BUFFER_TYPES
+    {
+        GpuBufferType::Vertex, GpuBufferType::Index, GpuBufferType::Storage
+    };
+}
+
+mtd::AssetArena::AssetArena(const Device& mtdDevice, GpuBufferType type, uint64_t capacity)
+    : buffer
+    {
+        std::make_shared<GpuBuffer>
+        (
+            mtdDevice,
+            capacity,
+            EnumMapping::getBufferUsage(type)
+                | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst,
+            EnumMapping::getMemoryProperties(GpuMemoryUsage::GpuOnly)
+        )
+    }
+{
+    freeRanges.emplace(0UL, capacity);
+}
+
+bool mtd::AssetArena::allocate(uint64_t size, uint64_t alignment, uint64_t& offset)
+{
+    std::lock_guard<std::mutex> lock{arenaMutex};
+
+    for(auto rangeIterator = freeRanges.begin(); rangeIterator != freeRanges.end(); rangeIterator++)
+    {
+        auto [rangeOffset, rangeSize] = *rangeIterator;
+        uint64_t alignedOffset = (rangeOffset + alignment - 1UL) / alignment * alignment;
+        if(alignedOffset + size > rangeOffset + rangeSize) continue;
+
+        // The padding before the aligned offset and the space after the range stay free
+        freeRanges.erase(rangeIterator);
+        if(alignedOffset > rangeOffset)
+            freeRanges.emplace(rangeOffset, alignedOffset - rangeOffset);
+        if(alignedOffset + size < rangeOffset + rangeSize)
+            freeRanges.emplace(alignedOffset + size, rangeOffset + rangeSize - alignedOffset - size);
+
+        offset = alignedOffset;
+        return true;
+    }
+    return false;
+}
+
+void mtd::AssetArena::free(uint64_t offset, uint64_t size)
+{
+    std::lock_guard<std::mutex> lock{arenaMutex};
+
+    auto nextIterator = freeRanges.lower_bound(offset);
+    if(nextIterator != freeRanges.end() && offset + size == nextIterator->first)
+    {
+        size += nextIterator->second;
+        nextIterator = freeRanges.erase(nextIterator);
+    }
+    if(nextIterator != freeRanges.begin())
+    {
+        auto previousIterator = std::prev(nextIterator);
+        if(previousIterator->first + previousIterator->second == offset)
+        {
+            previousIterator->second += size;
+            return;
+        }
+    }
+    freeRanges.emplace(offset, size);
+}
+
+mtd::AssetCache::AssetCache(const Device& mtdDevice, uint64_t memoryBudget)
+    : mtdDevice{mtdDevice}, memoryBudget{memoryBudget}
+{
+}
+
+uint64_t mtd::AssetCache::hashContent(const void* pData, size_t size)
+{
+    // FNV-1a over 8 byte words, folding the high bits back after each step, since they barely affect the low ones
+    const std::byte* pBytes = static_cast<const std::byte*>(pData);
+    uint64_t hash = FNV_OFFSET_BASIS ^ size;
+
+    size_t i = 0;
+    for(; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+    {
+        uint64_t word;
+        memcpy(&word, pBytes + i, sizeof(uint64_t));
+        hash = (hash ^ word) * FNV_PRIME;
+        hash ^= hash >> 32;
+    }
+    for(; i < size; i++)
+        hash = (hash ^ static_cast<uint64_t>(pBytes[i])) * FNV_PRIME;
+
+    return hash;
+}
+
+void mtd::AssetCache::insert(AssetKey key, std::shared_ptr<void> pAsset, uint64_t gpuSize, uint32_t arenaMask)
+{
+    std::lock_guard<std::mutex> lock{cacheMutex};
+
+    auto entryIterator = entries.find(key);
+    if(entryIterator != entries.end())
+        evict(entryIterator);
+
+    entries.emplace(std::move(key), CacheEntry{std::move(pAsset), gpuSize, useCounter++, arenaMask});
+    cachedSize += gpuSize;
+}
+
+std::shared_ptr<mtd::AssetArena> mtd::AssetCache::prepareArena(ArenaType type, uint64_t sceneDataSize)
+{
+    std::lock_guard<std::mutex> lock{cacheMutex};
+
+    const std::shared_ptr<AssetArena>& pArena = arenas[static_cast<uint32_t>(type)];
+    if(!pArena || pArena->getCapacity() < sceneDataSize)
+        createArena(type, sceneDataSize);
+
+    return pArena;
+}
+
+std::shared_ptr<mtd::ArenaRange> mtd::AssetCache::allocateRange(ArenaType type, uint64_t size, uint64_t alignment)
+{
+    std::lock_guard<std::mutex> lock{cacheMutex};
+
+    const std::shared_ptr<AssetArena>& pArena = arenas[static_cast<uint32_t>(type)];
+    assert(pArena && "The arena must be prepared before allocating ranges from it.");
+
+    uint64_t offset = 0UL;
+    if(pArena->allocate(size, alignment, offset))
+        return std::make_shared<ArenaRange>(pArena, offset, size);
+
+    // Unused assets in the arena are evicted, least recently used first, until the range fits
+    std::vector<std::pair<uint64_t, AssetKey>> evictionCandidates;
+    for(const auto& [key, entry]: entries)
+    {
+        if((entry.arenaMask & arenaBit(type)) != 0U && entry.pAsset.use_count() == 1L)
+            evictionCandidates.emplace_back(entry.lastUse, key);
+    }
+    std::ranges::sort(evictionCandidates, {}, &std::pair<uint64_t, AssetKey>::first);
+
+    for(const auto& [lastUse, key]: evictionCandidates)
+    {
+        evict(entries.find(key));
+        if(pArena->allocate(size, alignment, offset))
+            return std::make_shared<ArenaRange>(pArena, offset, size);
+    }
+    return nullptr;
+}
+
+void mtd::AssetCache::replaceArena(ArenaType type, uint64_t sceneDataSize)
+{
+    std::lock_guard<std::mutex> lock{cacheMutex};
+    createArena(type, sceneDataSize);
+}
+
+std::shared_ptr<const mtd::ShaderModule> mtd::AssetCache::loadShader
+(
+    vk::ShaderStageFlagBits shaderStage, const std::string& shaderFile
+)
+{
+    std::string shaderPath{MTD_RESOURCES_PATH};
+    shaderPath.append("shaders/");
+    shaderPath.append(shaderFile);
+
+    std::vector<char> shaderCode;
+    if(!FileHandler::readFile(shaderPath, shaderCode))
+        return std::make_shared<ShaderModule>(mtdDevice.getDevice(), shaderStage, shaderCode, shaderPath.c_str());
+
+    // The same file may be used by different shader stages, which need their own modules
+    AssetKey key
+    {
+        AssetType::Shader,
+        shaderPath + ':' + std::to_string(static_cast<uint32_t>(shaderStage)),
+        hashContent(shaderCode.data(), shaderCode.size())
+    };
+    std::shared_ptr<const ShaderModule> pShader = find<const ShaderModule>(key);
+    if(pShader) return pShader;
+
+    std::shared_ptr<ShaderModule> pNewShader =
+        std::make_shared<ShaderModule>(mtdDevice.getDevice(), shaderStage, shaderCode, shaderPath.c_str());
+    insert(std::move(key), pNewShader, shaderCode.size());
+    return pNewShader;
+}
+
+void mtd::AssetCache::trim()
+{
+    std::lock_guard<std::mutex> lock{cacheMutex};
+    if(cachedSize <= memoryBudget) return;
+
+    std::vector<std::pair<uint64_t, AssetKey>> evictionCandidates;
+    for(const auto& [key, entry]: entries)
+    {
+        if(entry.pAsset.use_count() == 1L)
+            evictionCandidates.emplace_back(entry.lastUse, key);
+    }
+    std::ranges::sort(evictionCandidates, {}, &std::pair<uint64_t, AssetKey>::first);
+
+    uint32_t evictedCount = 0U;
+    for(const auto& [lastUse, key]: evictionCandidates)
+    {
+        if(cachedSize <= memoryBudget) break;
+        evict(entries.find(key));
+        evictedCount++;
+    }
+
+    LOG_VERBOSE
+    (
+        "Evicted %d unused assets from the asset cache (%d KiB cached).", evictedCount, cachedSize >> 10
+    );
+}
+
+size_t mtd::AssetCache::AssetKeyHash::operator()(const AssetKey& key) const
+{
+    size_t hash = std::hash<std::string>{}(key.path);
+    hash ^= static_cast<size_t>(key.contentHash) + 0x9E3779B97F4A7C15UL + (hash << 6) + (hash >> 2);
+    return hash ^ static_cast<size_t>(key.type);
+}
+
+std::shared_ptr<void> mtd::AssetCache::findAsset(const AssetKey& key)
+{
+    std::lock_guard<std::mutex> lock{cacheMutex};
+
+    auto entryIterator = entries.find(key);
+    if(entryIterator == entries.end()) return nullptr;
+
+    entryIterator->second.lastUse = useCounter++;
+    return entryIterator->second.pAsset;
+}
+
+void mtd::AssetCache::evict(std::unordered_map<AssetKey, CacheEntry, AssetKeyHash>::iterator entryIterator)
+{
+    cachedSize -= entryIterator->second.gpuSize;
+    entries.erase(entryIterator);
+}
+
+void mtd::AssetCache::createArena(ArenaType type, uint64_t sceneDataSize)
+{
+    uint32_t typeIndex = static_cast<uint32_t>(type);
+
+    // Assets in the old arena can no longer be shared with new scenes, which only bind the current arena.
+    // The old arena is destroyed once the scenes using it are destroyed.
+    std::erase_if(entries, [this, type](const auto& keyEntry)
+    {
+        if((keyEntry.second.arenaMask & arenaBit(type)) == 0U) return false;
+        cachedSize -= keyEntry.second.gpuSize;
+        return true;
+    });
+
+    uint64_t capacity = std::max(MIN_ARENA_CAPACITIES[typeIndex], 2UL * sceneDataSize);
+    arenas[typeIndex] = std::make_shared<AssetArena>(mtdDevice, ARENA_BUFFER_TYPES[typeIndex], capacity);
+
+    LOG_VERBOSE("Created asset arena of type %d with %d KiB.", typeIndex, capacity >> 10);
+}
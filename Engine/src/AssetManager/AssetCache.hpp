@@ -0,0 +1,178 @@
+#pragma once
+
+#include <map>
+
+#include "ResourceManager.hpp"
+#include "../Utils/EngineStructs.hpp"
+#include "../Vulkan/Pipeline/ShaderModule.hpp"
+
+namespace mtd
+{
+    // Kinds of assets kept in the asset cache
+    enum class AssetType : uint32_t
+    {
+        Texture,
+        Mesh,
+        Material,
+        Shader
+    };
+
+    // Kinds of shared buffers which the mesh and material ranges are allocated from
+    enum class ArenaType : uint32_t
+    {
+        Vertex,
+        Index,
+        Material
+    };
+    // Bit of the arena type in the arena masks of the cached assets
+    constexpr uint32_t arenaBit(ArenaType type) { return 1U << static_cast<uint32_t>(type); }
+
+    // Identifies a cached asset by its file path and by a hash of the file content
+    struct AssetKey
+    {
+        AssetType type;
+        std::string path;
+        uint64_t contentHash;
+
+        bool operator==(const AssetKey& other) const = default;
+    };
+
+    // GPU buffer shared by the cached assets of several scenes, split in ranges by a first-fit allocator
+    class AssetArena
+    {
+        public:
+            AssetArena(const Device& mtdDevice, GpuBufferType type, uint64_t capacity);
+            ~AssetArena() = default;
+
+            AssetArena(const AssetArena&) = delete;
+            AssetArena& operator=(const AssetArena&) = delete;
+
+            // Getters
+            const std::shared_ptr<GpuBuffer>& getBuffer() const { return buffer; }
+            uint64_t getCapacity() const { return buffer->getSize(); }
+
+            // Reserves a range starting at a multiple of the alignment, which does not need to be a power of two
+            bool allocate(uint64_t size, uint64_t alignment, uint64_t& offset);
+            // Returns a range to the arena, merging it with the adjacent free ranges
+            void free(uint64_t offset, uint64_t size);
+
+        private:
+            // Buffer holding the data of all ranges
+            std::shared_ptr<GpuBuffer> buffer;
+            // Free ranges of the buffer, mapping their offsets to their sizes
+            std::map<uint64_t, uint64_t> freeRanges;
+            // Guards the free ranges, as ranges are released by any thread destroying a scene
+            std::mutex arenaMutex;
+    };
+
+    // Range of an arena owned by a cached asset, released when the asset is destroyed
+    class ArenaRange
+    {
+        public:
+            ArenaRange(std::shared_ptr<AssetArena> pArena, uint64_t offset, uint64_t size)
+                : pArena{std::move(pArena)}, offset{offset}, size{size} {}
+            ~ArenaRange() { pArena->free(offset, size); }
+
+            ArenaRange(const ArenaRange&) = delete;
+            ArenaRange& operator=(const ArenaRange&) = delete;
+
+            // Getters
+            const std::shared_ptr<AssetArena>& getArena() const { return pArena; }
+            uint64_t getOffset() const { return offset; }
+            uint64_t getSize() const { return size; }
+
+        private:
+            std::shared_ptr<AssetArena> pArena;
+            uint64_t offset;
+            uint64_t size;
+    };
+
+    // Mesh data resident in the vertex and index arenas
+    struct CachedMesh
+    {
+        // Mesh description, with the vertex and index offsets inside the arenas
+        MeshData meshData;
+        std::shared_ptr<ArenaRange> vertexRange;
+        std::shared_ptr<ArenaRange> indexRange;
+    };
+
+    // Reference counted cache of the assets loaded by the scenes, keeping them alive across scene changes
+    class AssetCache
+    {
+        public:
+            AssetCache(const Device& mtdDevice, uint64_t memoryBudget);
+            ~AssetCache() = default;
+
+            AssetCache(const AssetCache&) = delete;
+            AssetCache& operator=(const AssetCache&) = delete;
+
+            // Hashes the content of an asset file
+            static uint64_t hashContent(const void* pData, size_t size);
+
+            // Finds a cached asset, marking it as recently used
+            template<typename AssetT>
+            std::shared_ptr<AssetT> find(const AssetKey& key)
+            {
+                return std::static_pointer_cast<AssetT>(findAsset(key));
+            }
+            // Adds an asset to the cache, along with the GPU memory it holds and the arenas it was allocated from
+            void insert(AssetKey key, std::shared_ptr<void> pAsset, uint64_t gpuSize, uint32_t arenaMask = 0U);
+
+            // Gets the current arena of the type, creating it or replacing it if it cannot hold the scene data size
+            std::shared_ptr<AssetArena> prepareArena(ArenaType type, uint64_t sceneDataSize);
+            // Reserves a range in the current arena, evicting unused assets from it if necessary.
+            // Returns null if the range does not fit, in which case the arena should be replaced.
+            std::shared_ptr<ArenaRange> allocateRange(ArenaType type, uint64_t size, uint64_t alignment);
+            // Replaces the current arena with a new one, dropping the cached assets allocated from the old one
+            void replaceArena(ArenaType type, uint64_t sceneDataSize);
+
+            // Loads a shader module from the shaders folder, reusing the cached module if the file is unchanged
+            std::shared_ptr<const ShaderModule> loadShader
+            (
+                vk::ShaderStageFlagBits shaderStage, const std::string& shaderFile
+            );
+
+            // Evicts the least recently used assets not referenced by any scene, until the cache fits its budget
+            void trim();
+
+        private:
+            // Hasher for the asset keys
+            struct AssetKeyHash
+            {
+                size_t operator()(const AssetKey& key) const;
+            };
+
+            // Cached asset, shared with the scenes using it
+            struct CacheEntry
+            {
+                std::shared_ptr<void> pAsset;
+                uint64_t gpuSize;
+                uint64_t lastUse;
+                uint32_t arenaMask;
+            };
+
+            // Cached assets
+            std::unordered_map<AssetKey, CacheEntry, AssetKeyHash> entries;
+            // Arenas which new mesh and material ranges are allocated from
+            std::array<std::shared_ptr<AssetArena>, 3> arenas;
+
+            // GPU memory held by the cached assets, and the amount they may keep while unused
+            uint64_t cachedSize = 0UL;
+            uint64_t memoryBudget;
+            // Counter ordering the uses of the assets, for the least recently used eviction
+            uint64_t useCounter = 0UL;
+
+            // Guards the cache, which is used by the scene loading thread
+            std::mutex cacheMutex;
+
+            // Device reference
+            const Device& mtdDevice;
+
+            // Finds a cached asset, without casting it
+            std::shared_ptr<void> findAsset(const AssetKey& key);
+            // Removes an entry from the cache, releasing the asset if no scene references it
+            void evict(std::unordered_map<AssetKey, CacheEntry, AssetKeyHash>::iterator entryIterator);
+            // Creates a new arena of the type, with room for the scene data and for the data of later scenes
+            void createArena(ArenaType type, uint64_t sceneDataSize);
+    };
+}
@@ -1,16 +1,23 @@
 #include <pch.hpp>
 #include "MaterialLoader.hpp"
 
+#include <meltdown/jobs.hpp>
+
+#include "../Utils/Compression.hpp"
 #include "../Utils/EngineStructs.hpp"
 #include "../Utils/FileHandler.hpp"
 #include "../Utils/Logger.hpp"
 #include "../Utils/StringParser.hpp"
+#include "../Utils/VirtualFileSystem.hpp"
 
 namespace mtd::MaterialLoader
 {
     constexpr uint64_t MATERIAL_MAGIC = "MTD_MTRL"_u64;
-    constexpr uint64_t MATERIAL_FILE_VERSION = 1UL;
+    // Version 1 files have the raw material data after the header, and version 2 files have an encoded block
+    constexpr uint64_t MATERIAL_FILE_VERSION = 2UL;
     constexpr size_t MATERIAL_ALIGNMENT = 16UL;
+    // Maximum memory held by decoded textures waiting to be uploaded
+    constexpr uint64_t TEXTURE_DECODE_BUDGET = 256UL << 20;
 
     static constexpr UIntVec2 MISSING_TEXTURE_DIMENSIONS{16U, 16U};
     static constexpr std::array<uint32_t, 256> MISSING_TEXTURE = []() constexpr
@@ -21,12 +28,36 @@ namespace mtd::MaterialLoader
         return texture;
     }();
 
+    // Texture decoded by a worker thread, with the memory reserved for it in the decode budget
+    struct DecodedTexture
+    {
+        void* pData = nullptr;
+        UIntVec2 dimensions{0U, 0U};
+        uint32_t channels = 0U;
+        uint64_t reservedSize = 0UL;
+    };
+
+    // Material file content, and the range it occupies in the material arena
+    struct LoadedMaterial
+    {
+        std::vector<std::byte> data;
+        AssetKey key;
+        std::shared_ptr<ArenaRange> range;
+        bool cached = false;
+    };
+
     static bool loadFromFile(std::string_view filePath, std::vector<std::byte>& materialData);
+    // Finds or allocates the arena ranges of all materials, which must share the same arena
+    static bool allocateMaterialRanges
+    (
+        AssetCache& assetCache, const std::shared_ptr<AssetArena>& pArena, std::vector<LoadedMaterial>& materials
+    );
 }
 
 void mtd::MaterialLoader::loadTextures
 (
     ResourceManager& resourceManager,
+    AssetCache& assetCache,
     const std::vector<std::string>& texturePaths,
     std::vector<ResourceID>& textureIDs
 )
@@ -34,27 +65,110 @@ void mtd::MaterialLoader::loadTextures
     textureIDs.clear();
     textureIDs.reserve(texturePaths.size());
 
-    ResourceID missingTextureID = resourceManager.loadImage
-    (
-        "MissingTexture",
-        MISSING_TEXTURE_DIMENSIONS,
-        MISSING_TEXTURE.data(),
-        MISSING_TEXTURE.size() * sizeof(uint32_t),
-        vk::Format::eR8G8B8A8Unorm,
-        vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled
-    );
+    ResourceID missingTextureID = 0U;
+    AssetKey missingTextureKey{AssetType::Texture, "MissingTexture", 0UL};
+    std::shared_ptr<Image> pMissingTexture = assetCache.find<Image>(missingTextureKey);
+    if(pMissingTexture)
+        missingTextureID = resourceManager.addSharedImage("MissingTexture", std::move(pMissingTexture));
+    else
+    {
+        missingTextureID = resourceManager.loadImage
+        (
+            "MissingTexture",
+            MISSING_TEXTURE_DIMENSIONS,
+            MISSING_TEXTURE.data(),
+            MISSING_TEXTURE.size() * sizeof(uint32_t),
+            vk::Format::eR8G8B8A8Unorm,
+            vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled
+        );
+        pMissingTexture = resourceManager.getSharedImage(missingTextureID);
+        uint64_t imageSize = pMissingTexture->getMemorySize();
+        assetCache.insert(std::move(missingTextureKey), std::move(pMissingTexture), imageSize);
+    }
+
+    // The texture files are hashed in parallel, so the unchanged textures of previous scenes skip the decoding.
+    // The new textures are decoded from the same opened files, which are closed once decoded.
+    std::vector<VirtualFile> textureFiles(texturePaths.size());
+    std::vector<AssetKey> textureKeys(texturePaths.size());
+    std::vector<std::shared_ptr<Image>> cachedTextures(texturePaths.size());
+    JobSystem::parallelFor(0U, static_cast<uint32_t>(texturePaths.size()), 1U, [&](uint32_t begin, uint32_t end)
+    {
+        for(uint32_t i = begin; i < end; i++)
+        {
+            VirtualFile& textureFile = textureFiles[i];
+            textureFile = VirtualFileSystem::openFile(texturePaths[i]);
+            if(!textureFile.isOpen()) continue;
+
+            uint64_t contentHash = AssetCache::hashContent(textureFile.getData(), textureFile.getSize());
+            textureKeys[i] = AssetKey{AssetType::Texture, texturePaths[i], contentHash};
+            cachedTextures[i] = assetCache.find<Image>(textureKeys[i]);
+            if(cachedTextures[i])
+                textureFile = VirtualFile{};
+        }
+    });
+
+    // Textures are decoded in parallel ahead of the uploads, as long as the decoded data fits in the budget.
+    // The uploads follow the scene order, so the texture IDs do not depend on which decode finishes first.
+    std::vector<DecodedTexture> decodedTextures(texturePaths.size());
+    std::unique_ptr<JobCounter[]> decodeCounters = std::make_unique<JobCounter[]>(texturePaths.size());
+    size_t nextDecodeIndex = 0UL;
+    uint64_t reservedBytes = 0UL;
+    size_t reusedCount = 0UL;
 
     for(size_t i = 0U; i < texturePaths.size(); i++)
     {
-        UIntVec2 dimensions{0U, 0U};
-        uint32_t channels = 0U;
-        void* pImageData = FileHandler::readImage(texturePaths[i], dimensions, channels);
-        if(!pImageData)
+        while(nextDecodeIndex < texturePaths.size())
+        {
+            VirtualFile& textureFile = textureFiles[nextDecodeIndex];
+            DecodedTexture& decodedTexture = decodedTextures[nextDecodeIndex];
+            if(cachedTextures[nextDecodeIndex])
+            {
+                nextDecodeIndex++;
+                continue;
+            }
+            if(decodedTexture.reservedSize == 0UL)
+            {
+                UIntVec2& dimensions = decodedTexture.dimensions;
+                if(!FileHandler::readImageInfo(textureFile, dimensions, decodedTexture.channels))
+                {
+                    nextDecodeIndex++;
+                    continue;
+                }
+                decodedTexture.reservedSize = static_cast<uint64_t>(dimensions.x) * dimensions.y * decodedTexture.channels;
+            }
+
+            // The texture being uploaded is always decoded, even if it alone exceeds the budget
+            if(nextDecodeIndex > i && reservedBytes + decodedTexture.reservedSize > TEXTURE_DECODE_BUDGET) break;
+
+            reservedBytes += decodedTexture.reservedSize;
+            JobSystem::submit([&decodedTexture, &textureFile]()
+            {
+                decodedTexture.pData =
+                    FileHandler::readImage(textureFile, decodedTexture.dimensions, decodedTexture.channels);
+                textureFile = VirtualFile{};
+            }, &decodeCounters[nextDecodeIndex]);
+            nextDecodeIndex++;
+        }
+
+        if(cachedTextures[i])
+        {
+            textureIDs.emplace_back(resourceManager.addSharedImage("", std::move(cachedTextures[i])));
+            reusedCount++;
+            continue;
+        }
+
+        JobSystem::wait(decodeCounters[i]);
+        DecodedTexture& decodedTexture = decodedTextures[i];
+        reservedBytes -= decodedTexture.reservedSize;
+
+        if(!decodedTexture.pData)
         {
             textureIDs.emplace_back(missingTextureID);
             continue;
         }
 
+        UIntVec2 dimensions = decodedTexture.dimensions;
+        uint32_t channels = decodedTexture.channels;
         vk::Format imageFormat = vk::Format::eUndefined;
         switch(channels)
         {
@@ -73,17 +187,31 @@ void mtd::MaterialLoader::loadTextures
 
         textureIDs.emplace_back(resourceManager.loadImage
         (
-            "", dimensions, pImageData, static_cast<size_t>(dimensions.x * dimensions.y * channels),
+            "", dimensions, decodedTexture.pData, static_cast<size_t>(dimensions.x * dimensions.y * channels),
             imageFormat, vk::ImageUsageFlagBits::eTransferDst | vk::ImageUsageFlagBits::eSampled
         ));
 
-        free(pImageData);
+        free(decodedTexture.pData);
+
+        std::shared_ptr<Image> pTexture = resourceManager.getSharedImage(textureIDs.back());
+        if(pTexture && !textureKeys[i].path.empty())
+        {
+            uint64_t imageSize = pTexture->getMemorySize();
+            assetCache.insert(std::move(textureKeys[i]), std::move(pTexture), imageSize);
+        }
     }
+
+    LOG_VERBOSE
+    (
+        "Decoded %d textures using %d worker threads (%d reused from the asset cache).",
+        texturePaths.size() - reusedCount, JobSystem::getWorkerCount(), reusedCount
+    );
 }
 
 void mtd::MaterialLoader::loadMaterials
 (
     ResourceManager& resourceManager,
+    AssetCache& assetCache,
     const std::vector<std::string>& materialFiles,
     const std::vector<std::vector<uint32_t>>& sets,
     ResourceID& materialBufferID,
@@ -99,17 +227,51 @@ void mtd::MaterialLoader::loadMaterials
         return;
     }
 
-    std::vector<std::byte> materialData;
+    std::vector<LoadedMaterial> materials;
     std::vector<uint32_t> materialIndexing;
     std::vector<uint32_t> materialSetData;
+    materials.reserve(materialFiles.size());
     materialIndexing.reserve(materialFiles.size());
 
-    uint32_t currentMaterialOffset = 0U;
-    for(std::string_view materialPath: materialFiles)
+    uint64_t materialDataSize = 0UL;
+    for(const std::string& materialPath: materialFiles)
     {
-        if(!loadFromFile(materialPath, materialData)) continue;
-        materialIndexing.push_back(currentMaterialOffset);
-        currentMaterialOffset = static_cast<uint32_t>(materialData.size() >> 4);
+        LoadedMaterial material{};
+        if(!loadFromFile(materialPath, material.data)) continue;
+
+        material.key = AssetKey
+        {
+            AssetType::Material, materialPath, AssetCache::hashContent(material.data.data(), material.data.size())
+        };
+        materialDataSize += material.data.size();
+        materials.push_back(std::move(material));
+    }
+
+    // All scene materials are read from the same arena, which is replaced if they do not fit in it
+    std::shared_ptr<AssetArena> pArena = assetCache.prepareArena(ArenaType::Material, materialDataSize);
+    if(!allocateMaterialRanges(assetCache, pArena, materials))
+    {
+        assetCache.replaceArena(ArenaType::Material, materialDataSize);
+        pArena = assetCache.prepareArena(ArenaType::Material, materialDataSize);
+        allocateMaterialRanges(assetCache, pArena, materials);
+    }
+
+    materialBufferID = resourceManager.addSharedBuffer("MaterialBuffer", pArena->getBuffer());
+    for(LoadedMaterial& material: materials)
+    {
+        materialIndexing.push_back(static_cast<uint32_t>(material.range->getOffset() >> 4));
+        resourceManager.retainAsset(material.range);
+        if(material.cached) continue;
+
+        resourceManager.uploadBufferRange
+        (
+            materialBufferID, material.range->getOffset(), material.data.size(),
+            [&material](void* pBufferData) { memcpy(pBufferData, material.data.data(), material.data.size()); }
+        );
+        assetCache.insert
+        (
+            std::move(material.key), material.range, material.data.size(), arenaBit(ArenaType::Material)
+        );
     }
 
     for(const std::vector<uint32_t>& set: sets)
@@ -117,10 +279,6 @@ void mtd::MaterialLoader::loadMaterials
     if(materialSetData.empty())
         materialSetData.push_back(0U);
 
-    materialBufferID = resourceManager.createBuffer
-    (
-        "MaterialBuffer", GpuBufferType::Storage, GpuMemoryUsage::GpuOnly, materialData.size(), materialData.data()
-    );
     materialIndexingBufferID = resourceManager.createBuffer
     (
         "MaterialIndexingBuffer", GpuBufferType::Storage, GpuMemoryUsage::GpuOnly,
@@ -135,28 +293,52 @@ void mtd::MaterialLoader::loadMaterials
 
 bool mtd::MaterialLoader::loadFromFile(std::string_view filePath, std::vector<std::byte>& materialData)
 {
-    std::ifstream materialFile{filePath.data(), std::ios::binary | std::ios::ate};
-    if(!materialFile)
+    VirtualFile materialFile = VirtualFileSystem::openFile(filePath);
+    if(!materialFile.isOpen())
     {
         LOG_WARNING("Failed to find material file \"%s\" for loading.", filePath.data());
         return false;
     }
 
-    std::streamsize materialFileSize = materialFile.tellg();
-    if(materialFileSize < static_cast<std::streamsize>(sizeof(AssetHeader)))
+    if(materialFile.getSize() < sizeof(AssetHeader))
     {
         LOG_WARNING("Invalid header for material file \"%s\".", filePath.data());
         return false;
     }
-    size_t materialSize = materialFileSize - sizeof(AssetHeader);
 
     AssetHeader materialHeader{};
-    materialFile.seekg(0, std::ios::beg);
-    materialFile.read(reinterpret_cast<char*>(&materialHeader), sizeof(AssetHeader));
+    memcpy(&materialHeader, materialFile.getData(), sizeof(AssetHeader));
+
+    EncodedBlock materialBlock;
+    const std::byte* pBlockData = materialFile.getData() + sizeof(AssetHeader);
+    const size_t blockSize = materialFile.getSize() - sizeof(AssetHeader);
+    if(materialHeader.version == 1UL)
+        materialBlock = EncodedBlock{pBlockData, blockSize};
+    else if(materialHeader.version == MATERIAL_FILE_VERSION && blockSize >= sizeof(EncodedBlockHeader))
+    {
+        EncodedBlockHeader blockHeader;
+        memcpy(&blockHeader, pBlockData, sizeof(EncodedBlockHeader));
+
+        bool validBlock = (blockHeader.blockID == "Material"_u64);
+        validBlock &= (blockHeader.blockSize <= blockSize - sizeof(EncodedBlockHeader));
+        if(validBlock && blockHeader.encoding == BlockEncoding::Raw)
+            materialBlock = EncodedBlock{pBlockData + sizeof(EncodedBlockHeader), blockHeader.blockSize};
+        else if(validBlock && blockHeader.encoding == BlockEncoding::ChunkedLZ4)
+        {
+            materialBlock = EncodedBlock
+            {
+                pBlockData + sizeof(EncodedBlockHeader),
+                blockHeader.blockSize,
+                blockHeader.uncompressedSize,
+                blockHeader.chunkSize
+            };
+        }
+    }
+    size_t materialSize = materialBlock.getSize();
 
     bool validMaterialFile = true;
     validMaterialFile &= (materialHeader.magic == MATERIAL_MAGIC);
-    validMaterialFile &= (materialHeader.version == MATERIAL_FILE_VERSION);
+    validMaterialFile &= materialBlock.isValid();
     validMaterialFile &= (materialSize > 0UL);
     if(!validMaterialFile)
     {
@@ -169,12 +351,40 @@ bool mtd::MaterialLoader::loadFromFile(std::string_view filePath, std::vector<st
     size_t padding = (MATERIAL_ALIGNMENT - (newMaterialLumpSize % MATERIAL_ALIGNMENT)) % MATERIAL_ALIGNMENT;
 
     materialData.resize(newMaterialLumpSize + padding);
-    std::span<std::byte> loadTarget{materialData.data() + oldMaterialLumpSize, materialSize};
-
-    materialFile.seekg(sizeof(AssetHeader), std::ios::beg);
-    materialFile.read(reinterpret_cast<char*>(loadTarget.data()), loadTarget.size());
-    materialFile.close();
+    if(!materialBlock.decode(materialData.data() + oldMaterialLumpSize, materialSize))
+    {
+        LOG_WARNING("Failed to decode material file \"%s\".", filePath.data());
+        materialData.resize(oldMaterialLumpSize);
+        return false;
+    }
 
     LOG_VERBOSE("Material loaded from \"%s\".", filePath.data());
     return true;
 }
+
+bool mtd::MaterialLoader::allocateMaterialRanges
+(
+    AssetCache& assetCache, const std::shared_ptr<AssetArena>& pArena, std::vector<LoadedMaterial>& materials
+)
+{
+    for(LoadedMaterial& material: materials)
+    {
+        std::shared_ptr<ArenaRange> pCachedRange = assetCache.find<ArenaRange>(material.key);
+        material.cached = (pCachedRange && pCachedRange->getArena() == pArena);
+        if(material.cached)
+        {
+            material.range = std::move(pCachedRange);
+            continue;
+        }
+
+        material.range = assetCache.allocateRange(ArenaType::Material, material.data.size(), MATERIAL_ALIGNMENT);
+        if(!material.range)
+        {
+            // The ranges found so far are released, so the old arena can be destroyed once unused
+            for(LoadedMaterial& loadedMaterial: materials)
+                loadedMaterial.range.reset();
+            return false;
+        }
+    }
+    return true;
+}
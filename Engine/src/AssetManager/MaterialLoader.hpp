@@ -1,22 +1,24 @@
 #pragma once
 
-#include "ResourceManager.hpp"
+#include "AssetCache.hpp"
 
 // Responsible for loading materials from files to the GPU
 namespace mtd::MaterialLoader
 {
-    // Loads all scene textures from the disk to the GPU
+    // Loads all scene textures from the disk to the GPU, reusing the cached textures
     void loadTextures
     (
         ResourceManager& resourceManager,
+        AssetCache& assetCache,
         const std::vector<std::string>& texturePaths,
         std::vector<ResourceID>& textureIDs
     );
 
-    // Loads all scene materials and material sets to the GPU
+    // Loads all scene materials and material sets to the GPU, reusing the cached materials
     void loadMaterials
     (
         ResourceManager& resourceManager,
+        AssetCache& assetCache,
         const std::vector<std::string>& materialFiles,
         const std::vector<std::vector<uint32_t>>& sets,
         ResourceID& materialBufferID,
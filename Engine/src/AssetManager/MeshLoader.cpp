@@ -1,13 +1,18 @@
 #include <pch.hpp>
 #include "MeshLoader.hpp"
 
+#include <meltdown/jobs.hpp>
+
+#include "../Utils/Compression.hpp"
 #include "../Utils/Logger.hpp"
 #include "../Utils/StringParser.hpp"
+#include "../Utils/VirtualFileSystem.hpp"
 
 namespace mtd::MeshLoader
 {
     constexpr uint64_t MESH_MAGIC = "MTD_MESH"_u64;
-    constexpr uint64_t MESH_FILE_VERSION = 1UL;
+    // Version 1 files have raw blocks, and version 2 files have encoded block headers
+    constexpr uint64_t MESH_FILE_VERSION = 2UL;
 
     // Mesh asset file header
     struct MeshHeader : AssetHeader
@@ -17,19 +22,38 @@ namespace mtd::MeshLoader
         Vec3 extentAABB = Vec3{0.0f};
     };
 
-    // Loads a .mesh file and appends it to the mesh data
-    static bool loadFromFile
+    // Memory mapped mesh file, with the location of its data blocks and the cached mesh holding its GPU data
+    struct MappedMesh
+    {
+        VirtualFile file;
+        EncodedBlock vertexBlock;
+        size_t vertexDataSize = 0;
+        EncodedBlock indexBlock;
+        size_t indexDataSize = 0;
+        MeshData meshData{};
+        AssetKey key{};
+        std::shared_ptr<CachedMesh> pCachedMesh;
+        bool cached = false;
+    };
+
+    // Validates the block headers of a mapped .mesh file in place, filling its mesh data
+    static bool parseMeshFile(const std::string_view filePath, MappedMesh& mappedMesh);
+    // Decodes a vertex or index block straight to the staging memory, its compressed chunks in parallel
+    static void decodeBlock(const std::string& filePath, const EncodedBlock& block, size_t dataSize, void* pBufferData);
+    // Finds or allocates the arena ranges of all meshes, which must share the same vertex and index arenas
+    static bool allocateMeshRanges
     (
-        const std::string_view filePath,
-        std::vector<std::byte>& vertexData,
-        std::vector<uint32_t>& indexData,
-        std::vector<MeshData>& meshes
+        AssetCache& assetCache,
+        const std::shared_ptr<AssetArena>& pVertexArena,
+        const std::shared_ptr<AssetArena>& pIndexArena,
+        std::vector<MappedMesh>& mappedMeshes
     );
 }
 
 void mtd::MeshLoader::loadMeshes
 (
     ResourceManager& resourceManager,
+    AssetCache& assetCache,
     const std::vector<std::string>& meshFiles,
     std::vector<MeshData>& meshes,
     ResourceID& vertexBufferID,
@@ -37,89 +61,157 @@ void mtd::MeshLoader::loadMeshes
     ResourceID& submeshBufferID
 )
 {
-    std::vector<std::byte> vertexData;
-    std::vector<uint32_t> indexData;
     meshes.clear();
 
-    for(const std::string_view file: meshFiles)
-        MeshLoader::loadFromFile(file, vertexData, indexData, meshes);
-    if(meshes.empty()) return;
+    // First pass over the headers only, so the arenas are prepared for the data size of the whole scene
+    std::vector<MappedMesh> mappedMeshes;
+    mappedMeshes.reserve(meshFiles.size());
+    size_t vertexDataSize = 0;
+    size_t indexDataSize = 0;
+    for(const std::string& file: meshFiles)
+    {
+        MappedMesh mappedMesh{VirtualFileSystem::openFile(file)};
+        if(!parseMeshFile(file, mappedMesh)) continue;
+
+        mappedMesh.key = AssetKey{AssetType::Mesh, file, 0UL};
+        // Vertices may be padded up to a multiple of the stride
+        vertexDataSize += mappedMesh.vertexDataSize + mappedMesh.meshData.vertexStride;
+        indexDataSize += mappedMesh.indexDataSize;
+        mappedMeshes.push_back(std::move(mappedMesh));
+    }
+    if(mappedMeshes.empty()) return;
 
+    JobSystem::parallelFor(0U, static_cast<uint32_t>(mappedMeshes.size()), 1U, [&](uint32_t begin, uint32_t end)
+    {
+        for(uint32_t i = begin; i < end; i++)
+        {
+            const VirtualFile& file = mappedMeshes[i].file;
+            mappedMeshes[i].key.contentHash = AssetCache::hashContent(file.getData(), file.getSize());
+        }
+    });
+
+    // The scene binds a single vertex and index buffer, so the arenas are replaced if the meshes do not fit in them
+    std::shared_ptr<AssetArena> pVertexArena = assetCache.prepareArena(ArenaType::Vertex, vertexDataSize);
+    std::shared_ptr<AssetArena> pIndexArena = assetCache.prepareArena(ArenaType::Index, indexDataSize);
+    if(!allocateMeshRanges(assetCache, pVertexArena, pIndexArena, mappedMeshes))
+    {
+        assetCache.replaceArena(ArenaType::Vertex, vertexDataSize);
+        assetCache.replaceArena(ArenaType::Index, indexDataSize);
+        pVertexArena = assetCache.prepareArena(ArenaType::Vertex, vertexDataSize);
+        pIndexArena = assetCache.prepareArena(ArenaType::Index, indexDataSize);
+        allocateMeshRanges(assetCache, pVertexArena, pIndexArena, mappedMeshes);
+    }
+
+    vertexBufferID = resourceManager.addSharedBuffer("VertexBuffer", pVertexArena->getBuffer());
+    indexBufferID = resourceManager.addSharedBuffer("IndexBuffer", pIndexArena->getBuffer());
+
+    // The vertex and index blocks of new meshes are decoded straight from the mapped files to the staging memory
     std::vector<SubmeshData> submeshes;
-    submeshes.reserve(meshes.back().submeshOffset + meshes.back().submeshes.size());
-    for(const MeshData& mesh: meshes)
-        submeshes.insert(submeshes.end(), mesh.submeshes.begin(), mesh.submeshes.end());
+    uint32_t reusedCount = 0U;
+    for(MappedMesh& mappedMesh: mappedMeshes)
+    {
+        std::shared_ptr<CachedMesh>& pCachedMesh = mappedMesh.pCachedMesh;
+        resourceManager.retainAsset(pCachedMesh);
+
+        MeshData& meshData = meshes.emplace_back(pCachedMesh->meshData);
+        meshData.submeshOffset = static_cast<uint32_t>(submeshes.size());
+        submeshes.insert(submeshes.end(), meshData.submeshes.begin(), meshData.submeshes.end());
+
+        if(mappedMesh.cached)
+        {
+            reusedCount++;
+            continue;
+        }
+
+        if(mappedMesh.vertexDataSize > 0)
+        {
+            resourceManager.uploadBufferRange
+            (
+                vertexBufferID, pCachedMesh->vertexRange->getOffset(), mappedMesh.vertexDataSize,
+                [&mappedMesh](void* pBufferData)
+                {
+                    decodeBlock(mappedMesh.key.path, mappedMesh.vertexBlock, mappedMesh.vertexDataSize, pBufferData);
+                }
+            );
+        }
+        if(mappedMesh.indexDataSize > 0)
+        {
+            resourceManager.uploadBufferRange
+            (
+                indexBufferID, pCachedMesh->indexRange->getOffset(), mappedMesh.indexDataSize,
+                [&mappedMesh](void* pBufferData)
+                {
+                    decodeBlock(mappedMesh.key.path, mappedMesh.indexBlock, mappedMesh.indexDataSize, pBufferData);
+                }
+            );
+        }
+        assetCache.insert
+        (
+            std::move(mappedMesh.key), pCachedMesh, mappedMesh.vertexDataSize + mappedMesh.indexDataSize,
+            arenaBit(ArenaType::Vertex) | arenaBit(ArenaType::Index)
+        );
+    }
 
-    vertexBufferID = resourceManager.createBuffer
-    (
-        "VertexBuffer", GpuBufferType::Vertex, GpuMemoryUsage::GpuOnly,
-        vertexData.size(), vertexData.data()
-    );
-    indexBufferID = resourceManager.createBuffer
-    (
-        "IndexBuffer", GpuBufferType::Index, GpuMemoryUsage::GpuOnly,
-        sizeof(uint32_t) * indexData.size(), indexData.data()
-    );
     submeshBufferID = resourceManager.createBuffer
     (
         "SubmeshBuffer", GpuBufferType::Index, GpuMemoryUsage::GpuOnly,
         sizeof(SubmeshData) * submeshes.size(), submeshes.data()
     );
 
-    LOG_INFO("Loaded %d meshes.", meshFiles.size());
+    LOG_INFO
+    (
+        "Loaded %d meshes (%d KiB of vertices, %d KiB of indices), %d of them reused from the asset cache.",
+        meshes.size(), vertexDataSize >> 10, indexDataSize >> 10, reusedCount
+    );
 }
 
-bool mtd::MeshLoader::loadFromFile
-(
-    const std::string_view filePath,
-    std::vector<std::byte>& vertexData,
-    std::vector<uint32_t>& indexData,
-    std::vector<MeshData>& meshes
-)
+bool mtd::MeshLoader::parseMeshFile(const std::string_view filePath, MappedMesh& mappedMesh)
 {
-    std::ifstream meshFile{filePath.data(), std::ios::binary | std::ios::ate};
-    if(!meshFile)
+    if(!mappedMesh.file.isOpen())
     {
         LOG_WARNING("Failed to find mesh file \"%s\" for loading.", filePath.data());
         return false;
     }
 
-    std::streamsize meshFileSize = meshFile.tellg();
-    if(meshFileSize < static_cast<std::streamsize>(sizeof(MeshHeader) + sizeof(AssetBlockHeader)))
+    const std::byte* pFileData = mappedMesh.file.getData();
+    const size_t meshFileSize = mappedMesh.file.getSize();
+    if(meshFileSize < sizeof(MeshHeader) + sizeof(AssetBlockHeader))
     {
         LOG_WARNING("Invalid header for mesh file \"%s\".", filePath.data());
         return false;
     }
 
     MeshHeader meshHeader;
-    meshFile.seekg(0, std::ios::beg);
-    meshFile.read(reinterpret_cast<char*>(&meshHeader), sizeof(MeshHeader));
+    memcpy(&meshHeader, pFileData, sizeof(MeshHeader));
 
     bool validMeshFile = true;
     validMeshFile &= (meshHeader.magic == MESH_MAGIC);
-    validMeshFile &= (meshHeader.version == MESH_FILE_VERSION);
+    validMeshFile &= (meshHeader.version >= 1UL && meshHeader.version <= MESH_FILE_VERSION);
+    validMeshFile &= (meshHeader.vertexStride > 0U);
     if(!validMeshFile)
     {
         LOG_WARNING("Invalid mesh file \"%s\".", filePath.data());
         return false;
     }
 
-    AssetBlockHeader blockHeader;
-    meshFile.read(reinterpret_cast<char*>(&blockHeader), sizeof(AssetBlockHeader));
-
-    MeshData meshData{};
+    MeshData& meshData = mappedMesh.meshData;
     meshData.vertexStride = meshHeader.vertexStride;
-    meshData.indexOffset = static_cast<uint32_t>(indexData.size());
+    meshData.vertexOffset = 0U;
+    meshData.indexOffset = 0U;
     meshData.materialSlotCount = 0U;
     meshData.centerAABB = meshHeader.centerAABB;
     meshData.extentAABB = meshHeader.extentAABB;
     meshData.submeshOffset = 0U;
-    if(!meshes.empty())
-        meshData.submeshOffset = meshes.back().submeshOffset + meshes.back().submeshes.size();
 
-    std::streamoff currentOffset = meshFile.tellg();
-    while(currentOffset < meshFileSize)
+    // Version 1 blocks only have the ID and size, and are always raw
+    const size_t blockHeaderSize = (meshHeader.version == 1UL) ? sizeof(AssetBlockHeader) : sizeof(EncodedBlockHeader);
+    size_t currentOffset = sizeof(MeshHeader);
+    while(currentOffset + blockHeaderSize <= meshFileSize)
     {
+        EncodedBlockHeader blockHeader{};
+        memcpy(&blockHeader, pFileData + currentOffset, blockHeaderSize);
+        currentOffset += blockHeaderSize;
+
         if(meshFileSize - currentOffset < blockHeader.blockSize)
         {
             LOG_WARNING
@@ -129,30 +221,65 @@ bool mtd::MeshLoader::loadFromFile
             );
             break;
         }
+        const std::byte* pBlockData = pFileData + currentOffset;
+        currentOffset += blockHeader.blockSize;
+
+        EncodedBlock block;
+        if(blockHeader.encoding == BlockEncoding::Raw)
+            block = EncodedBlock{pBlockData, blockHeader.blockSize};
+        else if(blockHeader.encoding == BlockEncoding::ChunkedLZ4)
+        {
+            block = EncodedBlock
+            {
+                pBlockData, blockHeader.blockSize, blockHeader.uncompressedSize, blockHeader.chunkSize
+            };
+        }
+        if(!block.isValid())
+        {
+            LOG_WARNING
+            (
+                "Invalid encoding of block [%d] in mesh file \"%s\". Skipping...", blockHeader.blockID, filePath.data()
+            );
+            continue;
+        }
 
-        size_t oldBufferSize = 0;
-        size_t vertexOffset = 0;
         switch(blockHeader.blockID)
         {
             case "Vertices"_u64:
-                oldBufferSize = vertexData.size();
-                if(oldBufferSize % meshData.vertexStride == 0)
-                    vertexOffset = oldBufferSize;
-                else
-                    vertexOffset = oldBufferSize + meshData.vertexStride - (oldBufferSize % meshData.vertexStride);
-                meshData.vertexOffset = static_cast<uint32_t>(vertexOffset / meshData.vertexStride);
-                vertexData.resize(oldBufferSize + blockHeader.blockSize);
-                meshFile.read(reinterpret_cast<char*>(vertexData.data() + oldBufferSize), blockHeader.blockSize);
+                if(mappedMesh.vertexBlock.isValid())
+                {
+                    LOG_WARNING("Duplicated vertex block in mesh file \"%s\". Skipping...", filePath.data());
+                    break;
+                }
+                mappedMesh.vertexBlock = std::move(block);
+                mappedMesh.vertexDataSize = mappedMesh.vertexBlock.getSize();
                 break;
 
             case "Indices\0"_u64:
-                indexData.resize(meshData.indexOffset + (blockHeader.blockSize / sizeof(uint32_t)));
-                meshFile.read(reinterpret_cast<char*>(indexData.data() + meshData.indexOffset), blockHeader.blockSize);
+                if(mappedMesh.indexBlock.isValid())
+                {
+                    LOG_WARNING("Duplicated index block in mesh file \"%s\". Skipping...", filePath.data());
+                    break;
+                }
+                mappedMesh.indexBlock = std::move(block);
+                mappedMesh.indexDataSize =
+                    mappedMesh.indexBlock.getSize() - (mappedMesh.indexBlock.getSize() % sizeof(uint32_t));
                 break;
 
             case "Submesh\0"_u64:
-                meshData.submeshes.resize(blockHeader.blockSize / sizeof(SubmeshData));
-                meshFile.read(reinterpret_cast<char*>(meshData.submeshes.data()), blockHeader.blockSize);
+                meshData.submeshes.resize(block.getSize() / sizeof(SubmeshData));
+                if
+                (
+                    !block.decode
+                    (
+                        reinterpret_cast<std::byte*>(meshData.submeshes.data()),
+                        meshData.submeshes.size() * sizeof(SubmeshData)
+                    )
+                )
+                {
+                    LOG_WARNING("Failed to decode the submesh block in mesh file \"%s\".", filePath.data());
+                    meshData.submeshes.clear();
+                }
                 for(const SubmeshData& submesh: meshData.submeshes)
                 {
                     if(submesh.materialSlot + 1U > meshData.materialSlotCount)
@@ -162,20 +289,66 @@ bool mtd::MeshLoader::loadFromFile
 
             default:
                 LOG_WARNING("Unknown block [%d] in mesh file \"%s\". Skipping...", blockHeader.blockID, filePath.data());
-                meshFile.seekg(blockHeader.blockSize, std::ios_base::cur);
         }
+    }
 
-        currentOffset = meshFile.tellg();
-        if(meshFileSize < currentOffset + static_cast<std::streamsize>(sizeof(AssetBlockHeader))) break;
+    LOG_VERBOSE("Mesh mapped from \"%s\".", filePath.data());
+    return true;
+}
 
-        meshFile.read(reinterpret_cast<char*>(&blockHeader), sizeof(AssetBlockHeader));
-        currentOffset = meshFile.tellg();
+void mtd::MeshLoader::decodeBlock(const std::string& filePath, const EncodedBlock& block, size_t dataSize, void* pBufferData)
+{
+    if(!block.decode(static_cast<std::byte*>(pBufferData), dataSize))
+    {
+        // The range is cleared, so a corrupted block does not leave stale data from previous scenes
+        LOG_WARNING("Failed to decode mesh data from \"%s\".", filePath.c_str());
+        memset(pBufferData, 0, dataSize);
     }
+}
 
-    meshFile.close();
+bool mtd::MeshLoader::allocateMeshRanges
+(
+    AssetCache& assetCache,
+    const std::shared_ptr<AssetArena>& pVertexArena,
+    const std::shared_ptr<AssetArena>& pIndexArena,
+    std::vector<MappedMesh>& mappedMeshes
+)
+{
+    for(MappedMesh& mappedMesh: mappedMeshes)
+    {
+        std::shared_ptr<CachedMesh> pCachedMesh = assetCache.find<CachedMesh>(mappedMesh.key);
+        mappedMesh.cached = pCachedMesh &&
+            pCachedMesh->vertexRange->getArena() == pVertexArena && pCachedMesh->indexRange->getArena() == pIndexArena;
+        if(mappedMesh.cached)
+        {
+            mappedMesh.pCachedMesh = std::move(pCachedMesh);
+            continue;
+        }
 
-    meshes.emplace_back(std::move(meshData));
+        // Vertices start at a multiple of the stride, so they can be addressed by the vertex offset
+        const uint32_t vertexStride = mappedMesh.meshData.vertexStride;
+        pCachedMesh = std::make_shared<CachedMesh>();
+        pCachedMesh->meshData = mappedMesh.meshData;
+        pCachedMesh->vertexRange =
+            assetCache.allocateRange(ArenaType::Vertex, mappedMesh.vertexDataSize, vertexStride);
+        if(pCachedMesh->vertexRange)
+        {
+            pCachedMesh->indexRange =
+                assetCache.allocateRange(ArenaType::Index, mappedMesh.indexDataSize, sizeof(uint32_t));
+        }
+        if(!pCachedMesh->indexRange)
+        {
+            // The ranges found so far are released, so the old arenas can be destroyed once unused
+            for(MappedMesh& loadedMesh: mappedMeshes)
+                loadedMesh.pCachedMesh.reset();
+            return false;
+        }
 
-    LOG_VERBOSE("Mesh loaded from \"%s\".", filePath.data());
+        pCachedMesh->meshData.vertexOffset =
+            static_cast<uint32_t>(pCachedMesh->vertexRange->getOffset() / vertexStride);
+        pCachedMesh->meshData.indexOffset =
+            static_cast<uint32_t>(pCachedMesh->indexRange->getOffset() / sizeof(uint32_t));
+        mappedMesh.pCachedMesh = std::move(pCachedMesh);
+    }
     return true;
 }
@@ -1,14 +1,15 @@
 #pragma once
 
-#include "ResourceManager.hpp"
+#include "AssetCache.hpp"
 
 // Responsible for loading mesh data from files to the GPU
 namespace mtd::MeshLoader
 {
-    // Loads all scene mesh data to the GPU
+    // Loads all scene mesh data to the GPU, reusing the meshes already resident in the asset cache arenas
     void loadMeshes
     (
         ResourceManager& resourceManager,
+        AssetCache& assetCache,
         const std::vector<std::string>& meshFiles,
         std::vector<MeshData>& meshes,
         ResourceID& vertexBufferID,
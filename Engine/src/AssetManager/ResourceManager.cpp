@@ -2,19 +2,25 @@
 #include "ResourceManager.hpp"
 
 #include "../Utils/Logger.hpp"
+#include "../Utils/Profiler.hpp"
 #include "../Vulkan/EnumMapping/EnumMapping.hpp"
 
 namespace mtd
 {
     using ResourceIdConstIterator = std::unordered_map<std::string, ResourceID>::const_iterator;
-    using BufferIterator = std::unordered_map<ResourceID, GpuBuffer>::iterator;
-    using BufferConstIterator = std::unordered_map<ResourceID, GpuBuffer>::const_iterator;
-    using ImageIterator = std::unordered_map<ResourceID, Image>::iterator;
-    using ImageConstIterator = std::unordered_map<ResourceID, Image>::const_iterator;
+    using BufferIterator = std::unordered_map<ResourceID, std::shared_ptr<GpuBuffer>>::iterator;
+    using BufferConstIterator = std::unordered_map<ResourceID, std::shared_ptr<GpuBuffer>>::const_iterator;
+    using ImageIterator = std::unordered_map<ResourceID, std::shared_ptr<Image>>::iterator;
+    using ImageConstIterator = std::unordered_map<ResourceID, std::shared_ptr<Image>>::const_iterator;
+
+    // Initial upload ring size for each frame in flight
+    constexpr uint64_t UPLOAD_RING_FRAME_CAPACITY = 4UL << 20;
+    // Alignment of the pending update data in the upload ring
+    constexpr uint64_t UPLOAD_ALIGNMENT = 16UL;
 }
 
 mtd::ResourceManager::ResourceManager(const Device& mtdDevice, UIntVec2 windowResolution)
-    : mtdDevice{mtdDevice}, windowResolution{windowResolution}, commandHandler{mtdDevice}
+    : mtdDevice{mtdDevice}, windowResolution{windowResolution}, commandHandler{mtdDevice}, uploadQueue{mtdDevice}
 {
     configureEventCallbacks();
 }
@@ -33,7 +39,7 @@ vk::Buffer mtd::ResourceManager::getVulkanBuffer(ResourceID bufferID) const
     BufferConstIterator bufferIterator = buffers.find(bufferID);
     if(bufferIterator == buffers.cend()) return nullptr;
 
-    return bufferIterator->second.getBuffer();
+    return bufferIterator->second->getBuffer();
 }
 
 uint64_t mtd::ResourceManager::getBufferSize(ResourceID bufferID) const
@@ -42,26 +48,68 @@ uint64_t mtd::ResourceManager::getBufferSize(ResourceID bufferID) const
     BufferConstIterator bufferIterator = buffers.find(bufferID);
     if(bufferIterator == buffers.cend()) return 0UL;
 
-    return bufferIterator->second.getSize();
+    return bufferIterator->second->getSize();
+}
+
+vk::Image mtd::ResourceManager::getVulkanImage(ResourceID imageID) const
+{
+    if(imageID == 0U) return nullptr;
+    ImageConstIterator imageIterator = images.find(imageID);
+    if(imageIterator == images.cend()) return nullptr;
+
+    return imageIterator->second->getImage();
 }
 
 mtd::ResourceID mtd::ResourceManager::createBuffer
 (
     std::string resourceName, GpuBufferType type, GpuMemoryUsage memoryUsage, uint64_t bufferSize, const void* pData
 )
+{
+    if(!pData)
+        return createBuffer(std::move(resourceName), type, memoryUsage, bufferSize, UploadWriter{});
+
+    return createBuffer
+    (
+        std::move(resourceName), type, memoryUsage, bufferSize,
+        [pData, bufferSize](void* pBufferData) { memcpy(pBufferData, pData, bufferSize); }
+    );
+}
+
+mtd::ResourceID mtd::ResourceManager::createBuffer
+(
+    std::string resourceName,
+    GpuBufferType type,
+    GpuMemoryUsage memoryUsage,
+    uint64_t bufferSize,
+    const UploadWriter& writeData
+)
 {
     if(memoryUsage == GpuMemoryUsage::Auto)
         memoryUsage = EnumMapping::defaultMemoryUsage(type);
     vk::BufferUsageFlags bufferUsage = EnumMapping::getBufferUsage(type);
     vk::MemoryPropertyFlags memoryProperties = EnumMapping::getMemoryProperties(memoryUsage);
 
+    // Buffer updates and resizes are done through transfer commands, including on host visible buffers
+    bufferUsage |= vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst;
+
     if(bufferSize == 0UL)
-        buffers.emplace(nextID, GpuBuffer{mtdDevice, bufferUsage, memoryProperties});
+        buffers.emplace(nextID, std::make_shared<GpuBuffer>(mtdDevice, bufferUsage, memoryProperties));
     else
     {
-        buffers.emplace(nextID, GpuBuffer{mtdDevice, bufferSize, bufferUsage, memoryProperties});
-        if(pData)
-            buffers.at(nextID).copyMemoryToBuffer(bufferSize, pData);
+        buffers.emplace(nextID, std::make_shared<GpuBuffer>(mtdDevice, bufferSize, bufferUsage, memoryProperties));
+        if(writeData)
+        {
+            // The data is written once, either to the buffer itself or to the staging memory of the upload
+            GpuBuffer& buffer = *buffers.at(nextID);
+            const MemoryAllocation& allocation = buffer.getAllocation();
+            if(allocation.pMappedData)
+            {
+                writeData(allocation.pMappedData);
+                mtdDevice.getMemoryAllocator().flush(allocation, 0UL, bufferSize);
+            }
+            else
+                uploadQueue.uploadToBuffer(buffer.getBuffer(), 0UL, bufferSize, writeData);
+        }
     }
 
     if(resourceName.length() != 0UL)
@@ -92,8 +140,8 @@ mtd::ResourceID mtd::ResourceManager::createImage
     images.emplace
     (
         nextID,
-        Image
-        {
+        std::make_shared<Image>
+        (
             mtdDevice,
             imageDimensions,
             imageFormat,
@@ -104,7 +152,7 @@ mtd::ResourceID mtd::ResourceManager::createImage
             viewType,
             samplerType,
             windowResolutionRatio
-        }
+        )
     );
 
     if(resourceName.length() != 0UL)
@@ -137,15 +185,36 @@ mtd::ResourceID mtd::ResourceManager::loadImage
     images.emplace
     (
         nextID,
-        Image{mtdDevice, imageDimensions, imageFormat, tiling, usage, memoryProperties, aspects, viewType, samplerType}
+        std::make_shared<Image>
+        (
+            mtdDevice, imageDimensions, imageFormat, tiling, usage, memoryProperties, aspects, viewType, samplerType
+        )
     );
-    GpuBuffer stagingBuffer
-    {
-        mtdDevice, dataSize, vk::BufferUsageFlagBits::eTransferSrc,
-        vk::MemoryPropertyFlagBits::eHostCoherent | vk::MemoryPropertyFlagBits::eHostVisible
-    };
-    stagingBuffer.copyMemoryToBuffer(dataSize, pData);
-    images.at(nextID).copyBufferToImage(commandHandler, stagingBuffer.getBuffer());
+    images.at(nextID)->uploadData(uploadQueue, dataSize, pData);
+
+    if(resourceName.length() != 0UL)
+        nameIdMap.emplace(std::move(resourceName), nextID);
+
+    return nextID++;
+}
+
+mtd::ResourceID mtd::ResourceManager::addSharedBuffer(std::string resourceName, std::shared_ptr<GpuBuffer> buffer)
+{
+    if(!buffer) return 0U;
+
+    buffers.emplace(nextID, std::move(buffer));
+
+    if(resourceName.length() != 0UL)
+        nameIdMap.emplace(std::move(resourceName), nextID);
+
+    return nextID++;
+}
+
+mtd::ResourceID mtd::ResourceManager::addSharedImage(std::string resourceName, std::shared_ptr<Image> image)
+{
+    if(!image) return 0U;
+
+    images.emplace(nextID, std::move(image));
 
     if(resourceName.length() != 0UL)
         nameIdMap.emplace(std::move(resourceName), nextID);
@@ -153,6 +222,64 @@ mtd::ResourceID mtd::ResourceManager::loadImage
     return nextID++;
 }
 
+std::shared_ptr<mtd::Image> mtd::ResourceManager::getSharedImage(ResourceID imageID) const
+{
+    if(imageID == 0U) return nullptr;
+    ImageConstIterator imageIterator = images.find(imageID);
+    if(imageIterator == images.cend()) return nullptr;
+
+    return imageIterator->second;
+}
+
+uint64_t mtd::ResourceManager::getMemoryUsage() const
+{
+    // Shared resources belong to the asset cache, and are not released with this manager
+    uint64_t memoryUsage = 0UL;
+    for(const auto& [id, buffer]: buffers)
+    {
+        if(buffer.use_count() == 1L)
+            memoryUsage += buffer->getSize();
+    }
+    for(const auto& [id, image]: images)
+    {
+        if(image.use_count() == 1L)
+            memoryUsage += image->getMemorySize();
+    }
+    return memoryUsage;
+}
+
+bool mtd::ResourceManager::uploadBufferRange
+(
+    ResourceID id, uint64_t bufferOffset, uint64_t dataSize, const UploadWriter& writeData
+)
+{
+    if(id == 0U) return false;
+    BufferIterator bufferIterator = buffers.find(id);
+    if(bufferIterator == buffers.cend()) return false;
+
+    GpuBuffer& buffer = *bufferIterator->second;
+    if(bufferOffset + dataSize > buffer.getSize())
+    {
+        LOG_ERROR("Buffer upload range (%d bytes) exceeds the buffer size.", static_cast<uint32_t>(dataSize));
+        return false;
+    }
+
+    const MemoryAllocation& allocation = buffer.getAllocation();
+    if(allocation.pMappedData)
+    {
+        writeData(static_cast<std::byte*>(allocation.pMappedData) + bufferOffset);
+        mtdDevice.getMemoryAllocator().flush(allocation, bufferOffset, dataSize);
+    }
+    else
+        uploadQueue.uploadToBuffer(buffer.getBuffer(), bufferOffset, dataSize, writeData);
+    return true;
+}
+
+void mtd::ResourceManager::retainAsset(std::shared_ptr<const void> pAsset)
+{
+    retainedAssets.push_back(std::move(pAsset));
+}
+
 bool mtd::ResourceManager::updateBufferData
 (
     ResourceID id, uint64_t copySize, const void* srcData, uint64_t bufferOffset
@@ -162,20 +289,165 @@ bool mtd::ResourceManager::updateBufferData
     BufferIterator bufferIterator = buffers.find(id);
     if(bufferIterator == buffers.cend()) return false;
 
-    bufferIterator->second.copyMemoryToBuffer(copySize, srcData, bufferOffset);
+    // Host visible buffers are not written directly either, since the frames in flight may still read them
+    const GpuBuffer& buffer = *bufferIterator->second;
+    if(bufferOffset >= buffer.getSize())
+    {
+        LOG_ERROR("Buffer update offset (%d) exceeds the buffer size.", static_cast<uint32_t>(bufferOffset));
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock{uploadMutex};
+
+    uint64_t dataOffset = (pendingUploadData.size() + UPLOAD_ALIGNMENT - 1UL) & ~(UPLOAD_ALIGNMENT - 1UL);
+    pendingUploadData.resize(dataOffset + copySize);
+    memcpy(pendingUploadData.data() + dataOffset, srcData, copySize);
+    pendingUploads.push_back(PendingUpload{id, dataOffset, copySize, bufferOffset});
     return true;
 }
 
+void mtd::ResourceManager::beginUploadFrame(uint32_t frameIndex, uint32_t frameCount)
+{
+    if(!uploadRing)
+        uploadRing = std::make_unique<FrameRingBuffer>(mtdDevice, UPLOAD_RING_FRAME_CAPACITY);
+
+    uploadRing->beginFrame(frameIndex, frameCount);
+
+    // Retired buffers are released once every frame has moved on to the new buffers
+    for(auto& [retiredBuffer, remainingFrames]: retiredBuffers)
+        remainingFrames--;
+    std::erase_if(retiredBuffers, [](const auto& retiredBuffer) { return retiredBuffer.second == 0U; });
+    uploadFrameCount = frameCount;
+}
+
+void mtd::ResourceManager::recordPendingUploads(vk::CommandBuffer commandBuffer)
+{
+    std::lock_guard<std::mutex> lock{uploadMutex};
+    if(pendingUploads.empty()) return;
+
+    PROFILER_ZONE("Record pending uploads");
+    assert(uploadRing && "The upload frame must begin before recording the pending uploads.");
+
+    RingAllocation staging = uploadRing->allocate(pendingUploadData.size(), UPLOAD_ALIGNMENT);
+    memcpy(staging.pData, pendingUploadData.data(), pendingUploadData.size());
+
+    // Previous frames may still read or write the destination buffers
+    vk::MemoryBarrier memoryBarrier{};
+    memoryBarrier.srcAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite;
+    memoryBarrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+    commandBuffer.pipelineBarrier
+    (
+        vk::PipelineStageFlagBits::eAllCommands,
+        vk::PipelineStageFlagBits::eTransfer,
+        vk::DependencyFlags(),
+        memoryBarrier,
+        nullptr,
+        nullptr
+    );
+
+    // Consecutive updates of the same buffer are merged in a single copy, unless their ranges overlap
+    vk::Buffer dstBuffer = nullptr;
+    std::vector<vk::BufferCopy> copyRegions;
+    std::vector<std::tuple<vk::Buffer, uint64_t, uint64_t>> writtenRanges;
+    auto recordCopy = [&]()
+    {
+        if(copyRegions.empty()) return;
+        commandBuffer.copyBuffer
+        (
+            staging.buffer, dstBuffer, static_cast<uint32_t>(copyRegions.size()), copyRegions.data()
+        );
+        copyRegions.clear();
+    };
+
+    for(const PendingUpload& upload: pendingUploads)
+    {
+        BufferConstIterator bufferIterator = buffers.find(upload.id);
+        if(bufferIterator == buffers.cend()) continue;
+
+        // The buffer may have been resized or recreated after the update was requested
+        const GpuBuffer& buffer = *bufferIterator->second;
+        if(upload.bufferOffset >= buffer.getSize()) continue;
+        uint64_t copySize = std::min(upload.size, buffer.getSize() - upload.bufferOffset);
+        uint64_t copyEnd = upload.bufferOffset + copySize;
+
+        vk::Buffer vulkanBuffer = buffer.getBuffer();
+        bool overlaps = std::ranges::any_of(writtenRanges, [&](const auto& range)
+        {
+            return std::get<0>(range) == vulkanBuffer &&
+                upload.bufferOffset < std::get<2>(range) && std::get<1>(range) < copyEnd;
+        });
+        if(overlaps || vulkanBuffer != dstBuffer)
+        {
+            recordCopy();
+            dstBuffer = vulkanBuffer;
+        }
+        if(overlaps)
+        {
+            // Later updates of the same range must be applied after the earlier ones
+            memoryBarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+            memoryBarrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+            commandBuffer.pipelineBarrier
+            (
+                vk::PipelineStageFlagBits::eTransfer,
+                vk::PipelineStageFlagBits::eTransfer,
+                vk::DependencyFlags(),
+                memoryBarrier,
+                nullptr,
+                nullptr
+            );
+            writtenRanges.clear();
+        }
+
+        copyRegions.emplace_back(staging.offset + upload.dataOffset, upload.bufferOffset, copySize);
+        writtenRanges.emplace_back(vulkanBuffer, upload.bufferOffset, copyEnd);
+    }
+    recordCopy();
+
+    memoryBarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+    memoryBarrier.dstAccessMask = vk::AccessFlagBits::eMemoryRead | vk::AccessFlagBits::eMemoryWrite;
+    commandBuffer.pipelineBarrier
+    (
+        vk::PipelineStageFlagBits::eTransfer,
+        vk::PipelineStageFlagBits::eAllCommands,
+        vk::DependencyFlags(),
+        memoryBarrier,
+        nullptr,
+        nullptr
+    );
+
+    pendingUploads.clear();
+    pendingUploadData.clear();
+}
+
 bool mtd::ResourceManager::resizeBuffer(ResourceID id, uint64_t newSize)
 {
     if(id == 0U) return false;
     BufferIterator bufferIterator = buffers.find(id);
     if(bufferIterator == buffers.cend()) return false;
 
-    bufferIterator->second.resizeBuffer(commandHandler, newSize);
+    // Recreating a buffer shared with other resource managers would leave them with a destroyed buffer
+    if(bufferIterator->second.use_count() > 1L)
+    {
+        LOG_ERROR("Cannot resize a GPU buffer shared with other resource managers.");
+        return false;
+    }
+
+    // The buffer data is copied to the new buffer, so its initial upload must have finished
+    uploadQueue.flush();
+    retireBuffer(bufferIterator->second->resizeBuffer(commandHandler, newSize));
     return true;
 }
 
+void mtd::ResourceManager::submitUploads()
+{
+    uploadQueue.submit();
+}
+
+void mtd::ResourceManager::finishUploads()
+{
+    uploadQueue.flush();
+}
+
 bool mtd::ResourceManager::transitionImageLayout
 (
     ResourceID id,
@@ -189,7 +461,7 @@ bool mtd::ResourceManager::transitionImageLayout
     ImageConstIterator imageIterator = images.find(id);
     if(imageIterator == images.cend()) return false;
 
-    imageIterator->second.transitionImageLayout(commandBuffer, newLayout, srcStage, dstStage);
+    imageIterator->second->transitionImageLayout(commandBuffer, newLayout, srcStage, dstStage);
     return true;
 }
 
@@ -199,10 +471,10 @@ void mtd::ResourceManager::updateWindowResolutionLinkedImages(UIntVec2 newWindow
 
     for(auto& [id, image]: images)
     {
-        Vec2 ratio = image.getWindowResolutionRatio();
+        Vec2 ratio = image->getWindowResolutionRatio();
         if(ratio.x <= 0.0f && ratio.y <= 0.0f) continue;
 
-        image.resize
+        image->resize
         ({
             static_cast<uint32_t>(ratio.x * windowResolution.x),
             static_cast<uint32_t>(ratio.y * windowResolution.y)
@@ -210,16 +482,66 @@ void mtd::ResourceManager::updateWindowResolutionLinkedImages(UIntVec2 newWindow
     }
 }
 
+bool mtd::ResourceManager::readbackImage
+(
+    ResourceID id, vk::ImageLayout currentLayout, std::vector<uint8_t>& pixels
+) const
+{
+    if(id == 0U) return false;
+    ImageConstIterator imageIterator = images.find(id);
+    if(imageIterator == images.cend()) return false;
+
+    const Image& image = *imageIterator->second;
+    UIntVec2 dimensions = image.getDimensions();
+    uint64_t dataSize = 4UL * dimensions.x * dimensions.y;
+
+    GpuBuffer readbackBuffer
+    {
+        mtdDevice, dataSize, vk::BufferUsageFlagBits::eTransferDst,
+        EnumMapping::getMemoryProperties(GpuMemoryUsage::CpuReadback)
+    };
+    image.copyImageToBuffer(commandHandler, readbackBuffer.getBuffer(), currentLayout);
+
+    pixels.resize(dataSize);
+    readbackBuffer.copyBufferToMemory(dataSize, pixels.data());
+    return true;
+}
+
+void mtd::ResourceManager::setPersistent(ResourceID id)
+{
+    if(id == 0U) return;
+    persistentResources.insert(id);
+}
+
 bool mtd::ResourceManager::deleteResource(ResourceID id)
 {
+    uploadQueue.flush();
+    persistentResources.erase(id);
+    std::erase_if(nameIdMap, [id](const auto& nameID) { return nameID.second == id; });
     return (buffers.erase(id) > 0UL) || (images.erase(id) > 0UL);
 }
 
 void mtd::ResourceManager::clearResources()
 {
-    buffers.clear();
-    images.clear();
-    nameIdMap.clear();
+    uploadQueue.flush();
+
+    auto isDisposable = [this](const auto& resource) { return !persistentResources.contains(resource.first); };
+
+    std::erase_if(buffers, isDisposable);
+    std::erase_if(images, isDisposable);
+    std::erase_if(nameIdMap, [this](const auto& nameID) { return !persistentResources.contains(nameID.second); });
+
+    retainedAssets.clear();
+
+    // Persistent buffers left alone in sparse memory blocks are moved, so the blocks can be released.
+    // Buffers shared with other resource managers stay in place, as they may still be in use.
+    MemoryAllocator& memoryAllocator = mtdDevice.getMemoryAllocator();
+    for(auto& [id, buffer]: buffers)
+    {
+        if(buffer.use_count() == 1L && memoryAllocator.shouldRelocate(buffer->getAllocation()))
+            retireBuffer(buffer->relocate(commandHandler));
+    }
+    memoryAllocator.releaseEmptyBlocks();
 }
 
 bool mtd::ResourceManager::fetchDescriptorBufferInfo(ResourceID id, vk::DescriptorBufferInfo& info) const
@@ -228,7 +550,7 @@ bool mtd::ResourceManager::fetchDescriptorBufferInfo(ResourceID id, vk::Descript
     BufferConstIterator bufferIterator = buffers.find(id);
     if(bufferIterator == buffers.cend()) return false;
 
-    bufferIterator->second.updateDescriptorInfo(info);
+    bufferIterator->second->updateDescriptorInfo(info);
     return true;
 }
 
@@ -238,7 +560,7 @@ bool mtd::ResourceManager::fetchDescriptorImageInfo(ResourceID id, vk::Descripto
     ImageConstIterator imageIterator = images.find(id);
     if(imageIterator == images.cend()) return false;
 
-    imageIterator->second.updateDescriptorInfo(info);
+    imageIterator->second->updateDescriptorInfo(info);
     return true;
 }
 
@@ -256,7 +578,7 @@ bool mtd::ResourceManager::fetchDescriptorImageInfos
         ImageConstIterator imageIterator = images.find(ids[i]);
         if(imageIterator == images.cend()) fails++;
 
-        imageIterator->second.updateDescriptorInfo(infos[i]);
+        imageIterator->second->updateDescriptorInfo(infos[i]);
     }
     if(fails != 0U)
     {
@@ -267,6 +589,14 @@ bool mtd::ResourceManager::fetchDescriptorImageInfos
     return true;
 }
 
+void mtd::ResourceManager::retireBuffer(std::unique_ptr<GpuBuffer> pBuffer)
+{
+    // Before the first frame, no command may be using the buffer
+    if(!pBuffer || uploadFrameCount == 0U) return;
+
+    retiredBuffers.emplace_back(std::move(pBuffer), uploadFrameCount);
+}
+
 void mtd::ResourceManager::configureEventCallbacks()
 {
     updateGpuBufferHandle = EventManager::addCallback([this](const UpdateGpuBufferEvent& event)
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <unordered_set>
+
 #include <meltdown/event.hpp>
 
-#include "../Vulkan/Device/GpuBuffer.hpp"
+#include "../Vulkan/Device/FrameRingBuffer.hpp"
 #include "../Vulkan/Image/Image.hpp"
 
 namespace mtd
@@ -21,6 +23,10 @@ namespace mtd
             ResourceID getResourceID(std::string_view resourceName) const;
             vk::Buffer getVulkanBuffer(ResourceID bufferID) const;
             uint64_t getBufferSize(ResourceID bufferID) const;
+            vk::Image getVulkanImage(ResourceID imageID) const;
+            std::shared_ptr<Image> getSharedImage(ResourceID imageID) const;
+            // Gets the GPU memory held only by this manager, excluding the resources shared with other managers
+            uint64_t getMemoryUsage() const;
 
             // Creates a new GPU buffer
             ResourceID createBuffer
@@ -31,6 +37,15 @@ namespace mtd
                 uint64_t bufferSize = 0UL,
                 const void* pData = nullptr
             );
+            // Creates a new GPU buffer, letting the writer fill its initial data directly in the mapped memory
+            ResourceID createBuffer
+            (
+                std::string resourceName,
+                GpuBufferType type,
+                GpuMemoryUsage memoryUsage,
+                uint64_t bufferSize,
+                const UploadWriter& writeData
+            );
             // Creates a new image on the GPU
             ResourceID createImage
             (
@@ -60,12 +75,29 @@ namespace mtd
                 vk::ImageViewType viewType = vk::ImageViewType::e2D,
                 vk::MemoryPropertyFlags memoryProperties = vk::MemoryPropertyFlagBits::eDeviceLocal
             );
-
-            // Updates buffer data
+            // Adds a GPU buffer shared with other resource managers, such as a cached asset arena
+            ResourceID addSharedBuffer(std::string resourceName, std::shared_ptr<GpuBuffer> buffer);
+            // Adds an image shared with other resource managers, such as a cached texture
+            ResourceID addSharedImage(std::string resourceName, std::shared_ptr<Image> image);
+            // Queues the upload of the initial data of a buffer range, which must not be in use by the GPU
+            bool uploadBufferRange(ResourceID id, uint64_t bufferOffset, uint64_t dataSize, const UploadWriter& writeData);
+            // Keeps a cached asset alive while the resources of this manager exist
+            void retainAsset(std::shared_ptr<const void> pAsset);
+
+            // Updates buffer data, deferring the write to the transfer commands of the next recorded frame
             bool updateBufferData(ResourceID id, uint64_t copySize, const void* srcData, uint64_t bufferOffset = 0UL);
-            // Resizes the specified GPU buffer
+            // Starts the upload ring section of the frame, after its previous commands have finished
+            void beginUploadFrame(uint32_t frameIndex, uint32_t frameCount);
+            // Records the copies of the pending buffer updates, before any command reading the buffers
+            void recordPendingUploads(vk::CommandBuffer commandBuffer);
+            // Resizes the specified GPU buffer, keeping the replaced buffer until the frames in flight finish
             bool resizeBuffer(ResourceID id, uint64_t newSize);
 
+            // Submits the queued resource uploads without waiting for them
+            void submitUploads();
+            // Submits the queued resource uploads and blocks until all of them finish
+            void finishUploads();
+
             // Transitions the specified image layout
             bool transitionImageLayout
             (
@@ -79,9 +111,14 @@ namespace mtd
             // Updates resolution of all images where the resolution is linked to the window size
             void updateWindowResolutionLinkedImages(UIntVec2 newWindowResolution);
 
+            // Copies the content of a color image with 4 bytes per pixel to CPU memory
+            bool readbackImage(ResourceID id, vk::ImageLayout currentLayout, std::vector<uint8_t>& pixels) const;
+
+            // Keeps the specified GPU resource alive when the resources are cleared
+            void setPersistent(ResourceID id);
             // Deletes the specified GPU resource
             bool deleteResource(ResourceID id);
-            // Deletes all resources and resets the ID counter
+            // Deletes all non-persistent resources, compacting the GPU memory used by the remaining ones
             void clearResources();
 
             // Fetches the descriptor buffer info for the specified buffer
@@ -95,12 +132,25 @@ namespace mtd
             ) const;
 
         private:
-            // GPU resources
-            std::unordered_map<ResourceID, GpuBuffer> buffers;
-            std::unordered_map<ResourceID, Image> images;
+            // Buffer update waiting to be copied from the upload ring
+            struct PendingUpload
+            {
+                ResourceID id;
+                uint64_t dataOffset;
+                uint64_t size;
+                uint64_t bufferOffset;
+            };
+
+            // GPU resources, which may be shared with other resource managers
+            std::unordered_map<ResourceID, std::shared_ptr<GpuBuffer>> buffers;
+            std::unordered_map<ResourceID, std::shared_ptr<Image>> images;
+            // Cached assets referenced by the resources, such as the arena ranges of meshes and materials
+            std::vector<std::shared_ptr<const void>> retainedAssets;
 
             // Map linking the resource name to its ID
             std::unordered_map<std::string, ResourceID> nameIdMap;
+            // Resources that are not deleted when clearing the resources (e.g. headless render targets)
+            std::unordered_set<ResourceID> persistentResources;
             // Resource ID counter
             ResourceID nextID = 1U;
 
@@ -109,6 +159,20 @@ namespace mtd
 
             // Resource manager's command handler
             CommandHandler commandHandler;
+            // Batched uploads of the initial data of new resources
+            UploadQueue uploadQueue;
+
+            // Data of the pending buffer updates, packed in the order they were requested
+            std::vector<uint8_t> pendingUploadData;
+            std::vector<PendingUpload> pendingUploads;
+            // Guards the pending updates, which may be requested from other threads through events
+            std::mutex uploadMutex;
+            // Persistently mapped staging memory for the pending updates, split per frame in flight
+            std::unique_ptr<FrameRingBuffer> uploadRing;
+            // Buffers replaced when resized or relocated, kept until the frames using them finish
+            std::vector<std::pair<std::unique_ptr<GpuBuffer>, uint32_t>> retiredBuffers;
+            // Frames in flight of the last upload frame, or zero if no frame has begun yet
+            uint32_t uploadFrameCount = 0U;
 
             // Callback handle to update buffers as requested
             EventCallbackHandle updateGpuBufferHandle;
@@ -116,6 +180,9 @@ namespace mtd
             // Device reference
             const Device& mtdDevice;
 
+            // Keeps a replaced buffer until every frame in flight has begun again
+            void retireBuffer(std::unique_ptr<GpuBuffer> pBuffer);
+
             // Configures the event callbacks
             void configureEventCallbacks();
     };
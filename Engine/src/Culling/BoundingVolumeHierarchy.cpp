@@ -0,0 +1,692 @@
+#include <pch.hpp>
+#include "BoundingVolumeHierarchy.hpp"
+
+#include <meltdown/jobs.hpp>
+
+namespace mtd
+{
+	// Maximum bins along each axis evaluated as split candidates by the surface area heuristic
+	constexpr uint32_t SAH_BIN_COUNT = 16U;
+	// Items of a subtree above which one of its children is built by another job
+	constexpr uint32_t BUILD_JOB_THRESHOLD = 16384U;
+	// Boxes processed by each job when preparing the build items
+	constexpr uint32_t BUILD_GRAIN_SIZE = 16384U;
+
+	// Box enclosing nothing, which any box or point grows
+	static BoundingBox createEmptyBox()
+	{
+		constexpr float infinity = std::numeric_limits<float>::infinity();
+		return BoundingBox{{infinity, infinity, infinity}, {-infinity, -infinity, -infinity}};
+	}
+
+	// Grows the box to enclose another box
+	static void growBox(BoundingBox& box, const BoundingBox& other)
+	{
+		for(uint32_t axis = 0U; axis < 3U; axis++)
+		{
+			box.min[axis] = std::min(box.min[axis], other.min[axis]);
+			box.max[axis] = std::max(box.max[axis], other.max[axis]);
+		}
+	}
+
+	// Grows the box to enclose a point
+	static void growBox(BoundingBox& box, const std::array<float, 3>& point)
+	{
+		for(uint32_t axis = 0U; axis < 3U; axis++)
+		{
+			box.min[axis] = std::min(box.min[axis], point[axis]);
+			box.max[axis] = std::max(box.max[axis], point[axis]);
+		}
+	}
+
+	// Smallest box enclosing both boxes
+	static BoundingBox mergeBoxes(const BoundingBox& a, const BoundingBox& b)
+	{
+		BoundingBox box = a;
+		growBox(box, b);
+		return box;
+	}
+
+	// Half of the surface area of the box, as only the ratios between areas matter
+	static float getSurfaceArea(const BoundingBox& box)
+	{
+		float sizeX = box.max[0] - box.min[0];
+		float sizeY = box.max[1] - box.min[1];
+		float sizeZ = box.max[2] - box.min[2];
+		return sizeX * sizeY + sizeY * sizeZ + sizeZ * sizeX;
+	}
+
+	// Checks if two boxes overlap, including touching faces
+	static bool boxesOverlap(const BoundingBox& a, const BoundingBox& b)
+	{
+		return a.min[0] <= b.max[0] && a.max[0] >= b.min[0]
+			&& a.min[1] <= b.max[1] && a.max[1] >= b.min[1]
+			&& a.min[2] <= b.max[2] && a.max[2] >= b.min[2];
+	}
+
+	// Distance along the ray where it enters the box, or infinity if it misses the box before the maximum distance
+	static float intersectRay
+	(
+		const BoundingBox& box,
+		const std::array<float, 3>& origin,
+		const std::array<float, 3>& inverseDirection,
+		float maxDistance
+	)
+	{
+		float entry = 0.0f;
+		float exit = maxDistance;
+		for(uint32_t axis = 0U; axis < 3U; axis++)
+		{
+			float near = (box.min[axis] - origin[axis]) * inverseDirection[axis];
+			float far = (box.max[axis] - origin[axis]) * inverseDirection[axis];
+			// Zero times infinity is NaN for rays starting on a face parallel to them, which the comparisons ignore
+			entry = std::max(entry, std::min(near, far));
+			exit = std::min(exit, std::max(near, far));
+		}
+		return (entry <= exit) ? entry : std::numeric_limits<float>::infinity();
+	}
+
+	// Bin of the item centroid along an axis, in the range [0, binCount)
+	static uint32_t getBinIndex(float centroid, float centroidMin, float binScale, uint32_t binCount)
+	{
+		return std::min(static_cast<uint32_t>((centroid - centroidMin) * binScale), binCount - 1U);
+	}
+}
+
+mtd::BoundingBox mtd::BoundingBox::fromTransformedBox(const Mat4x4& transform, const Vec3& center, const Vec3& extent)
+{
+	std::array<float, 3> worldCenter
+	{
+		transform.x.x * center.x + transform.y.x * center.y + transform.z.x * center.z + transform.w.x,
+		transform.x.y * center.x + transform.y.y * center.y + transform.z.y * center.z + transform.w.y,
+		transform.x.z * center.x + transform.y.z * center.y + transform.z.z * center.z + transform.w.z
+	};
+	std::array<float, 3> worldExtent
+	{
+		std::abs(transform.x.x) * extent.x + std::abs(transform.y.x) * extent.y + std::abs(transform.z.x) * extent.z,
+		std::abs(transform.x.y) * extent.x + std::abs(transform.y.y) * extent.y + std::abs(transform.z.y) * extent.z,
+		std::abs(transform.x.z) * extent.x + std::abs(transform.y.z) * extent.y + std::abs(transform.z.z) * extent.z
+	};
+
+	return BoundingBox
+	{
+		{worldCenter[0] - worldExtent[0], worldCenter[1] - worldExtent[1], worldCenter[2] - worldExtent[2]},
+		{worldCenter[0] + worldExtent[0], worldCenter[1] + worldExtent[1], worldCenter[2] + worldExtent[2]}
+	};
+}
+
+void mtd::BoundingVolumeHierarchy::build(const std::vector<uint32_t>& keys, const std::vector<BoundingBox>& boxes)
+{
+	assert(keys.size() == boxes.size() && "Each key must have a bounding box.");
+
+	clear();
+	if(keys.empty()) return;
+
+	uint32_t itemCount = static_cast<uint32_t>(keys.size());
+	std::vector<BuildItem> items(itemCount);
+	JobSystem::parallelFor(0U, itemCount, BUILD_GRAIN_SIZE, [&](uint32_t begin, uint32_t end)
+	{
+		for(uint32_t i = begin; i < end; i++)
+		{
+			const BoundingBox& box = boxes[i];
+			items[i] = BuildItem
+			{
+				box,
+				{
+					0.5f * (box.min[0] + box.max[0]), 0.5f * (box.min[1] + box.max[1]), 0.5f * (box.min[2] + box.max[2])
+				},
+				keys[i]
+			};
+		}
+	});
+
+	BoundingBox bounds = createEmptyBox();
+	BoundingBox centroidBounds = createEmptyBox();
+	for(const BuildItem& item: items)
+	{
+		growBox(bounds, item.box);
+		growBox(centroidBounds, item.centroid);
+	}
+
+	keyLeaves.resize(*std::max_element(keys.cbegin(), keys.cend()) + 1U, INVALID_NODE);
+	nodes.resize(2UL * itemCount - 1UL);
+	buildNode(items, 0U, itemCount, 0U, INVALID_NODE, bounds, centroidBounds);
+
+	rootNode = 0U;
+	leafCount = itemCount;
+}
+
+void mtd::BoundingVolumeHierarchy::clear()
+{
+	nodes.clear();
+	freeNodes.clear();
+	keyLeaves.clear();
+	rootNode = INVALID_NODE;
+	leafCount = 0U;
+}
+
+void mtd::BoundingVolumeHierarchy::insert(uint32_t key, const BoundingBox& box)
+{
+	assert(!contains(key) && "The key must not be in the hierarchy yet.");
+
+	if(key >= keyLeaves.size())
+		keyLeaves.resize(key + 1U, INVALID_NODE);
+
+	uint32_t leafIndex = allocateNode();
+	nodes[leafIndex] = Node{box, INVALID_NODE, key, INVALID_NODE};
+	keyLeaves[key] = leafIndex;
+	leafCount++;
+
+	insertLeaf(leafIndex);
+}
+
+void mtd::BoundingVolumeHierarchy::update(uint32_t key, const BoundingBox& box)
+{
+	if(!contains(key))
+	{
+		insert(key, box);
+		return;
+	}
+
+	uint32_t leafIndex = keyLeaves[key];
+	uint32_t parentIndex = nodes[leafIndex].parent;
+	nodes[leafIndex].bounds = box;
+	if(parentIndex == INVALID_NODE) return;
+
+	// Refitting keeps the structure, which only stays efficient while the box remains near its previous neighbors
+	if(boxesOverlap(box, nodes[parentIndex].bounds))
+	{
+		refitAncestors(parentIndex);
+		return;
+	}
+
+	removeLeaf(leafIndex);
+	insertLeaf(leafIndex);
+}
+
+void mtd::BoundingVolumeHierarchy::remove(uint32_t key)
+{
+	if(!contains(key)) return;
+
+	uint32_t leafIndex = keyLeaves[key];
+	removeLeaf(leafIndex);
+	freeNodes.push_back(leafIndex);
+	keyLeaves[key] = INVALID_NODE;
+	leafCount--;
+}
+
+void mtd::BoundingVolumeHierarchy::cullFrustum(const FrustumPlanes& planes, std::vector<uint32_t>& keys) const
+{
+	if(rootNode == INVALID_NODE) return;
+
+	// Each node is tested only against the planes its parent is not fully inside of, so the nodes fully inside the
+	// frustum have their leaves appended without any test
+	constexpr uint32_t ALL_PLANES_MASK = 0x3FU;
+	std::vector<std::pair<uint32_t, uint32_t>> nodeStack{{rootNode, ALL_PLANES_MASK}};
+	while(!nodeStack.empty())
+	{
+		auto [nodeIndex, planeMask] = nodeStack.back();
+		nodeStack.pop_back();
+
+		const Node& node = nodes[nodeIndex];
+		if(planeMask != 0U)
+		{
+			const BoundingBox& bounds = node.bounds;
+			float centerX = 0.5f * (bounds.min[0] + bounds.max[0]);
+			float centerY = 0.5f * (bounds.min[1] + bounds.max[1]);
+			float centerZ = 0.5f * (bounds.min[2] + bounds.max[2]);
+			float extentX = 0.5f * (bounds.max[0] - bounds.min[0]);
+			float extentY = 0.5f * (bounds.max[1] - bounds.min[1]);
+			float extentZ = 0.5f * (bounds.max[2] - bounds.min[2]);
+
+			bool outside = false;
+			for(uint32_t i = 0U; i < 6U && !outside; i++)
+			{
+				if((planeMask & (1U << i)) == 0U) continue;
+
+				float distance = planes.normalX[i] * centerX + planes.normalY[i] * centerY
+					+ planes.normalZ[i] * centerZ + planes.distance[i];
+				float radius = std::abs(planes.normalX[i]) * extentX + std::abs(planes.normalY[i]) * extentY
+					+ std::abs(planes.normalZ[i]) * extentZ;
+				outside = distance + radius < 0.0f;
+				if(distance - radius >= 0.0f)
+					planeMask &= ~(1U << i);
+			}
+			if(outside) continue;
+		}
+
+		if(isLeaf(nodeIndex))
+			keys.push_back(node.firstChild);
+		else
+		{
+			nodeStack.emplace_back(node.secondChild, planeMask);
+			nodeStack.emplace_back(node.firstChild, planeMask);
+		}
+	}
+}
+
+void mtd::BoundingVolumeHierarchy::overlapBox(const BoundingBox& box, std::vector<uint32_t>& keys) const
+{
+	if(rootNode == INVALID_NODE) return;
+
+	std::vector<uint32_t> nodeStack{rootNode};
+	while(!nodeStack.empty())
+	{
+		uint32_t nodeIndex = nodeStack.back();
+		nodeStack.pop_back();
+
+		const Node& node = nodes[nodeIndex];
+		if(!boxesOverlap(node.bounds, box)) continue;
+
+		if(isLeaf(nodeIndex))
+			keys.push_back(node.firstChild);
+		else
+		{
+			nodeStack.push_back(node.secondChild);
+			nodeStack.push_back(node.firstChild);
+		}
+	}
+}
+
+void mtd::BoundingVolumeHierarchy::overlapSphere(const Vec3& center, float radius, std::vector<uint32_t>& keys) const
+{
+	if(rootNode == INVALID_NODE) return;
+
+	std::array<float, 3> sphereCenter{center.x, center.y, center.z};
+	float squaredRadius = radius * radius;
+
+	std::vector<uint32_t> nodeStack{rootNode};
+	while(!nodeStack.empty())
+	{
+		uint32_t nodeIndex = nodeStack.back();
+		nodeStack.pop_back();
+
+		// Squared distance from the sphere center to the closest point of the node bounds
+		const Node& node = nodes[nodeIndex];
+		float squaredDistance = 0.0f;
+		for(uint32_t axis = 0U; axis < 3U; axis++)
+		{
+			float offset = sphereCenter[axis]
+				- std::clamp(sphereCenter[axis], node.bounds.min[axis], node.bounds.max[axis]);
+			squaredDistance += offset * offset;
+		}
+		if(squaredDistance > squaredRadius) continue;
+
+		if(isLeaf(nodeIndex))
+			keys.push_back(node.firstChild);
+		else
+		{
+			nodeStack.push_back(node.secondChild);
+			nodeStack.push_back(node.firstChild);
+		}
+	}
+}
+
+bool mtd::BoundingVolumeHierarchy::raycast
+(
+	const Vec3& origin, const Vec3& direction, float maxDistance, uint32_t& key, float& distance
+) const
+{
+	float directionLength = direction.length();
+	if(rootNode == INVALID_NODE || directionLength == 0.0f) return false;
+
+	// Distances are measured along the normalized direction, and division by zero yields infinities
+	std::array<float, 3> rayOrigin{origin.x, origin.y, origin.z};
+	std::array<float, 3> inverseDirection
+	{
+		directionLength / direction.x, directionLength / direction.y, directionLength / direction.z
+	};
+
+	float closestDistance = maxDistance;
+	bool hit = false;
+
+	// Nodes are visited closest first, skipping the ones entered after the closest hit found so far
+	std::vector<std::pair<uint32_t, float>> nodeStack;
+	float rootDistance = intersectRay(nodes[rootNode].bounds, rayOrigin, inverseDirection, closestDistance);
+	if(rootDistance <= closestDistance)
+		nodeStack.emplace_back(rootNode, rootDistance);
+
+	while(!nodeStack.empty())
+	{
+		auto [nodeIndex, entryDistance] = nodeStack.back();
+		nodeStack.pop_back();
+		if(entryDistance > closestDistance) continue;
+
+		const Node& node = nodes[nodeIndex];
+		if(isLeaf(nodeIndex))
+		{
+			closestDistance = entryDistance;
+			key = node.firstChild;
+			hit = true;
+			continue;
+		}
+
+		float firstDistance = intersectRay(nodes[node.firstChild].bounds, rayOrigin, inverseDirection, closestDistance);
+		float secondDistance =
+			intersectRay(nodes[node.secondChild].bounds, rayOrigin, inverseDirection, closestDistance);
+		std::pair<uint32_t, float> nearChild{node.firstChild, firstDistance};
+		std::pair<uint32_t, float> farChild{node.secondChild, secondDistance};
+		if(secondDistance < firstDistance)
+			std::swap(nearChild, farChild);
+
+		if(farChild.second <= closestDistance)
+			nodeStack.push_back(farChild);
+		if(nearChild.second <= closestDistance)
+			nodeStack.push_back(nearChild);
+	}
+
+	if(hit)
+		distance = closestDistance;
+	return hit;
+}
+
+void mtd::BoundingVolumeHierarchy::buildNode
+(
+	std::vector<BuildItem>& items,
+	uint32_t begin,
+	uint32_t end,
+	uint32_t nodeIndex,
+	uint32_t parentIndex,
+	const BoundingBox& bounds,
+	const BoundingBox& centroidBounds
+)
+{
+	Node& node = nodes[nodeIndex];
+	node.bounds = bounds;
+	node.parent = parentIndex;
+
+	if(end - begin == 1U)
+	{
+		node.firstChild = items[begin].key;
+		node.secondChild = INVALID_NODE;
+		keyLeaves[items[begin].key] = nodeIndex;
+		return;
+	}
+
+	// Bins the items by their centroids along the longest axis of the centroid bounds, tracking the bounds of each
+	// bin. Small ranges use fewer bins, as most nodes are near the leaves.
+	struct Bin
+	{
+		BoundingBox bounds;
+		BoundingBox centroidBounds;
+		uint32_t count;
+	};
+	std::array<Bin, SAH_BIN_COUNT> bins;
+	uint32_t binCount = std::min(SAH_BIN_COUNT, end - begin);
+	for(uint32_t bin = 0U; bin < binCount; bin++)
+		bins[bin] = Bin{createEmptyBox(), createEmptyBox(), 0U};
+
+	uint32_t axis = 0U;
+	for(uint32_t i = 1U; i < 3U; i++)
+	{
+		if(centroidBounds.max[i] - centroidBounds.min[i] > centroidBounds.max[axis] - centroidBounds.min[axis])
+			axis = i;
+	}
+	float centroidMin = centroidBounds.min[axis];
+	float centroidExtent = centroidBounds.max[axis] - centroidMin;
+	float binScale = (centroidExtent > 0.0f) ? binCount / centroidExtent : 0.0f;
+
+	for(uint32_t i = begin; i < end; i++)
+	{
+		const BuildItem& item = items[i];
+		Bin& bin = bins[getBinIndex(item.centroid[axis], centroidMin, binScale, binCount)];
+		growBox(bin.bounds, item.box);
+		growBox(bin.centroidBounds, item.centroid);
+		bin.count++;
+	}
+
+	// Sweeps the bins from both sides, evaluating the cost of splitting after each bin
+	float bestCost = std::numeric_limits<float>::infinity();
+	uint32_t bestBin = 0U;
+	if(binScale > 0.0f)
+	{
+		std::array<float, SAH_BIN_COUNT> rightCosts;
+		BoundingBox rightBounds = createEmptyBox();
+		uint32_t rightCount = 0U;
+		for(uint32_t bin = binCount - 1U; bin > 0U; bin--)
+		{
+			growBox(rightBounds, bins[bin].bounds);
+			rightCount += bins[bin].count;
+			rightCosts[bin] = (rightCount > 0U) ? getSurfaceArea(rightBounds) * rightCount : 0.0f;
+		}
+
+		BoundingBox leftBounds = createEmptyBox();
+		uint32_t leftCount = 0U;
+		for(uint32_t bin = 0U; bin < binCount - 1U; bin++)
+		{
+			growBox(leftBounds, bins[bin].bounds);
+			leftCount += bins[bin].count;
+			if(leftCount == 0U || leftCount == end - begin) continue;
+
+			float cost = getSurfaceArea(leftBounds) * leftCount + rightCosts[bin + 1U];
+			if(cost < bestCost)
+			{
+				bestCost = cost;
+				bestBin = bin;
+			}
+		}
+	}
+
+	uint32_t middle;
+	BoundingBox leftBounds = createEmptyBox();
+	BoundingBox leftCentroidBounds = createEmptyBox();
+	BoundingBox rightBounds = createEmptyBox();
+	BoundingBox rightCentroidBounds = createEmptyBox();
+	if(bestCost < std::numeric_limits<float>::infinity())
+	{
+		middle = static_cast<uint32_t>(std::partition
+		(
+			items.begin() + begin,
+			items.begin() + end,
+			[&](const BuildItem& item)
+			{
+				return getBinIndex(item.centroid[axis], centroidMin, binScale, binCount) <= bestBin;
+			}
+		) - items.begin());
+
+		for(uint32_t bin = 0U; bin < binCount; bin++)
+		{
+			growBox((bin <= bestBin) ? leftBounds : rightBounds, bins[bin].bounds);
+			growBox((bin <= bestBin) ? leftCentroidBounds : rightCentroidBounds, bins[bin].centroidBounds);
+		}
+	}
+	else
+	{
+		// All centroids are at the same position, so the items are split in halves without sorting
+		middle = begin + (end - begin) / 2U;
+		for(uint32_t i = begin; i < end; i++)
+		{
+			growBox((i < middle) ? leftBounds : rightBounds, items[i].box);
+			growBox((i < middle) ? leftCentroidBounds : rightCentroidBounds, items[i].centroid);
+		}
+	}
+
+	// The left subtree takes the nodes right after this one, followed by the right subtree
+	uint32_t leftNode = nodeIndex + 1U;
+	uint32_t rightNode = nodeIndex + 2U * (middle - begin);
+	node.firstChild = leftNode;
+	node.secondChild = rightNode;
+
+	if(end - begin < BUILD_JOB_THRESHOLD || JobSystem::getWorkerCount() == 0U)
+	{
+		buildNode(items, begin, middle, leftNode, nodeIndex, leftBounds, leftCentroidBounds);
+		buildNode(items, middle, end, rightNode, nodeIndex, rightBounds, rightCentroidBounds);
+		return;
+	}
+
+	// Both subtrees write to disjoint ranges of items and nodes
+	JobCounter leftCounter{};
+	JobSystem::submit([&]()
+	{
+		buildNode(items, begin, middle, leftNode, nodeIndex, leftBounds, leftCentroidBounds);
+	}, &leftCounter);
+	buildNode(items, middle, end, rightNode, nodeIndex, rightBounds, rightCentroidBounds);
+	JobSystem::wait(leftCounter);
+}
+
+uint32_t mtd::BoundingVolumeHierarchy::allocateNode()
+{
+	if(freeNodes.empty())
+	{
+		nodes.emplace_back();
+		return static_cast<uint32_t>(nodes.size()) - 1U;
+	}
+
+	uint32_t nodeIndex = freeNodes.back();
+	freeNodes.pop_back();
+	return nodeIndex;
+}
+
+void mtd::BoundingVolumeHierarchy::insertLeaf(uint32_t leafIndex)
+{
+	if(rootNode == INVALID_NODE)
+	{
+		nodes[leafIndex].parent = INVALID_NODE;
+		rootNode = leafIndex;
+		return;
+	}
+
+	// Descends while a child is a cheaper sibling than the current node, counting the growth of the ancestors
+	BoundingBox leafBounds = nodes[leafIndex].bounds;
+	uint32_t siblingIndex = rootNode;
+	while(!isLeaf(siblingIndex))
+	{
+		const Node& node = nodes[siblingIndex];
+		float area = getSurfaceArea(node.bounds);
+		float mergedArea = getSurfaceArea(mergeBoxes(node.bounds, leafBounds));
+
+		float siblingCost = 2.0f * mergedArea;
+		float inheritanceCost = 2.0f * (mergedArea - area);
+
+		auto getChildCost = [&](uint32_t childIndex)
+		{
+			const BoundingBox& childBounds = nodes[childIndex].bounds;
+			float childMergedArea = getSurfaceArea(mergeBoxes(childBounds, leafBounds));
+			if(isLeaf(childIndex))
+				return childMergedArea + inheritanceCost;
+			return childMergedArea - getSurfaceArea(childBounds) + inheritanceCost;
+		};
+		float firstCost = getChildCost(node.firstChild);
+		float secondCost = getChildCost(node.secondChild);
+
+		if(siblingCost < firstCost && siblingCost < secondCost) break;
+		siblingIndex = (firstCost < secondCost) ? node.firstChild : node.secondChild;
+	}
+
+	uint32_t oldParentIndex = nodes[siblingIndex].parent;
+	uint32_t newParentIndex = allocateNode();
+	nodes[newParentIndex] = Node
+	{
+		mergeBoxes(nodes[siblingIndex].bounds, leafBounds), oldParentIndex, siblingIndex, leafIndex
+	};
+	nodes[siblingIndex].parent = newParentIndex;
+	nodes[leafIndex].parent = newParentIndex;
+
+	if(oldParentIndex == INVALID_NODE)
+	{
+		rootNode = newParentIndex;
+		return;
+	}
+
+	Node& oldParent = nodes[oldParentIndex];
+	if(oldParent.firstChild == siblingIndex)
+		oldParent.firstChild = newParentIndex;
+	else
+		oldParent.secondChild = newParentIndex;
+	refitAncestors(oldParentIndex);
+}
+
+void mtd::BoundingVolumeHierarchy::removeLeaf(uint32_t leafIndex)
+{
+	if(leafIndex == rootNode)
+	{
+		rootNode = INVALID_NODE;
+		return;
+	}
+
+	uint32_t parentIndex = nodes[leafIndex].parent;
+	const Node& parent = nodes[parentIndex];
+	uint32_t grandparentIndex = parent.parent;
+	uint32_t siblingIndex = (parent.firstChild == leafIndex) ? parent.secondChild : parent.firstChild;
+
+	// The sibling takes the place of the parent
+	nodes[siblingIndex].parent = grandparentIndex;
+	freeNodes.push_back(parentIndex);
+	if(grandparentIndex == INVALID_NODE)
+	{
+		rootNode = siblingIndex;
+		return;
+	}
+
+	Node& grandparent = nodes[grandparentIndex];
+	if(grandparent.firstChild == parentIndex)
+		grandparent.firstChild = siblingIndex;
+	else
+		grandparent.secondChild = siblingIndex;
+	refitAncestors(grandparentIndex);
+}
+
+void mtd::BoundingVolumeHierarchy::refitAncestors(uint32_t nodeIndex)
+{
+	while(nodeIndex != INVALID_NODE)
+	{
+		Node& node = nodes[nodeIndex];
+		node.bounds = mergeBoxes(nodes[node.firstChild].bounds, nodes[node.secondChild].bounds);
+		rotateNode(nodeIndex);
+		nodeIndex = node.parent;
+	}
+}
+
+void mtd::BoundingVolumeHierarchy::rotateNode(uint32_t nodeIndex)
+{
+	// Candidate swaps between a child of the node and a child of its sibling, with the area each one saves
+	struct Rotation
+	{
+		uint32_t child;
+		uint32_t grandchild;
+		uint32_t grandchildParent;
+		float areaReduction;
+	};
+	Rotation bestRotation{INVALID_NODE, INVALID_NODE, INVALID_NODE, 0.0f};
+
+	const Node& node = nodes[nodeIndex];
+	auto evaluateRotations = [&](uint32_t childIndex, uint32_t siblingIndex)
+	{
+		if(isLeaf(siblingIndex)) return;
+
+		// Swapping the child with a grandchild only changes the bounds of the sibling
+		const Node& sibling = nodes[siblingIndex];
+		const BoundingBox& childBounds = nodes[childIndex].bounds;
+		float siblingArea = getSurfaceArea(sibling.bounds);
+		float firstReduction =
+			siblingArea - getSurfaceArea(mergeBoxes(childBounds, nodes[sibling.secondChild].bounds));
+		float secondReduction =
+			siblingArea - getSurfaceArea(mergeBoxes(childBounds, nodes[sibling.firstChild].bounds));
+
+		if(firstReduction > bestRotation.areaReduction)
+			bestRotation = Rotation{childIndex, sibling.firstChild, siblingIndex, firstReduction};
+		if(secondReduction > bestRotation.areaReduction)
+			bestRotation = Rotation{childIndex, sibling.secondChild, siblingIndex, secondReduction};
+	};
+	evaluateRotations(node.firstChild, node.secondChild);
+	evaluateRotations(node.secondChild, node.firstChild);
+
+	if(bestRotation.child == INVALID_NODE) return;
+
+	Node& changedNode = nodes[nodeIndex];
+	if(changedNode.firstChild == bestRotation.child)
+		changedNode.firstChild = bestRotation.grandchild;
+	else
+		changedNode.secondChild = bestRotation.grandchild;
+
+	Node& grandchildParent = nodes[bestRotation.grandchildParent];
+	if(grandchildParent.firstChild == bestRotation.grandchild)
+		grandchildParent.firstChild = bestRotation.child;
+	else
+		grandchildParent.secondChild = bestRotation.child;
+	grandchildParent.bounds =
+		mergeBoxes(nodes[grandchildParent.firstChild].bounds, nodes[grandchildParent.secondChild].bounds);
+
+	nodes[bestRotation.child].parent = bestRotation.grandchildParent;
+	nodes[bestRotation.grandchild].parent = nodeIndex;
+}
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "FrustumCulling.hpp"
+
+namespace mtd
+{
+	// Axis aligned box in world space, stored as arrays so each axis can be indexed directly
+	struct BoundingBox
+	{
+		std::array<float, 3> min;
+		std::array<float, 3> max;
+
+		// Encloses a mesh bounding box, given by its center and half extent, transformed by an instance transform
+		static BoundingBox fromTransformedBox(const Mat4x4& transform, const Vec3& center, const Vec3& extent);
+	};
+
+	// Dynamic bounding volume hierarchy over boxes identified by keys (e.g. scene instance indices), one per leaf.
+	// Built at once with the surface area heuristic, then refitted and rotated as the boxes change.
+	class BoundingVolumeHierarchy
+	{
+		public:
+			BoundingVolumeHierarchy() = default;
+			~BoundingVolumeHierarchy() = default;
+
+			BoundingVolumeHierarchy(const BoundingVolumeHierarchy&) = delete;
+			BoundingVolumeHierarchy& operator=(const BoundingVolumeHierarchy&) = delete;
+
+			// Getters
+			uint32_t getLeafCount() const { return leafCount; }
+			bool contains(uint32_t key) const { return key < keyLeaves.size() && keyLeaves[key] != INVALID_NODE; }
+
+			// Replaces the hierarchy with a new one over unique keys, splitting large builds across the job system
+			void build(const std::vector<uint32_t>& keys, const std::vector<BoundingBox>& boxes);
+			// Removes all keys from the hierarchy
+			void clear();
+
+			// Adds a key that is not in the hierarchy yet, next to the node whose bounds grow the least
+			void insert(uint32_t key, const BoundingBox& box);
+			// Changes the box of a key, refitting its ancestors, or inserting it again if it moved far away
+			void update(uint32_t key, const BoundingBox& box);
+			// Removes a key from the hierarchy, if present
+			void remove(uint32_t key);
+
+			// Appends the keys whose boxes intersect the frustum, skipping the tests inside fully visible nodes
+			void cullFrustum(const FrustumPlanes& planes, std::vector<uint32_t>& keys) const;
+			// Appends the keys whose boxes overlap the box
+			void overlapBox(const BoundingBox& box, std::vector<uint32_t>& keys) const;
+			// Appends the keys whose boxes overlap the sphere
+			void overlapSphere(const Vec3& center, float radius, std::vector<uint32_t>& keys) const;
+			// Finds the closest box hit by the ray before the maximum distance, returning false if none is hit
+			bool raycast
+			(
+				const Vec3& origin, const Vec3& direction, float maxDistance, uint32_t& key, float& distance
+			) const;
+
+		private:
+			// Marks missing nodes, and the second child of leaves
+			static constexpr uint32_t INVALID_NODE = std::numeric_limits<uint32_t>::max();
+
+			// Internal node with two children, or leaf holding a key in the first child
+			struct Node
+			{
+				BoundingBox bounds;
+				uint32_t parent;
+				uint32_t firstChild;
+				uint32_t secondChild;
+			};
+			// Box being sorted into the hierarchy during a build
+			struct BuildItem
+			{
+				BoundingBox box;
+				std::array<float, 3> centroid;
+				uint32_t key;
+			};
+
+			// Nodes of the hierarchy, including the ones in the free list
+			std::vector<Node> nodes;
+			// Indices of removed nodes, available for new nodes
+			std::vector<uint32_t> freeNodes;
+			// Leaf node of each key, or INVALID_NODE if the key is not in the hierarchy
+			std::vector<uint32_t> keyLeaves;
+			uint32_t rootNode = INVALID_NODE;
+			uint32_t leafCount = 0U;
+
+			// Checks if the node is a leaf
+			bool isLeaf(uint32_t nodeIndex) const { return nodes[nodeIndex].secondChild == INVALID_NODE; }
+
+			// Builds the subtree of a range of items, using (2 * item count - 1) nodes starting at the node index
+			void buildNode
+			(
+				std::vector<BuildItem>& items,
+				uint32_t begin,
+				uint32_t end,
+				uint32_t nodeIndex,
+				uint32_t parentIndex,
+				const BoundingBox& bounds,
+				const BoundingBox& centroidBounds
+			);
+
+			// Gets a node from the free list, or a new one
+			uint32_t allocateNode();
+			// Links a detached leaf to the hierarchy, next to the cheapest sibling found descending from the root
+			void insertLeaf(uint32_t leafIndex);
+			// Unlinks a leaf from the hierarchy, freeing its parent
+			void removeLeaf(uint32_t leafIndex);
+			// Recomputes the bounds of a node and its ancestors, rotating each of them if it lowers the surface area
+			void refitAncestors(uint32_t nodeIndex);
+			// Swaps a child of the node with a grandchild from the other side, if it shrinks the changed child
+			void rotateNode(uint32_t nodeIndex);
+	};
+}
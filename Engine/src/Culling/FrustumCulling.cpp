@@ -0,0 +1,324 @@
+#include <pch.hpp>
+#include "FrustumCulling.hpp"
+
+#include <meltdown/jobs.hpp>
+
+// Widest instruction set enabled in the compiler (AVX2 requires MTD_ENABLE_AVX2)
+#if defined(__AVX2__)
+	#define MTD_CULLING_AVX2
+	#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define MTD_CULLING_SSE2
+	#include <emmintrin.h>
+#endif
+
+namespace mtd
+{
+	// Render objects tested by each job, when splitting the culling across the job system
+	constexpr uint32_t CULLING_GRAIN_SIZE = 4096U;
+	static_assert(sizeof(RenderObject) % sizeof(float) == 0, "Render objects must be an array of floats in memory.");
+
+	// Reads a float of the render object, given its offset in floats from the start of the render object
+	static const float* getRenderObjectFloats(const RenderObject* pRenderObject, size_t offset)
+	{
+		return reinterpret_cast<const float*>(pRenderObject) + offset;
+	}
+
+	// Tests a box against the frustum planes, with the box center and half extent in world space
+	static bool isBoxInsideFrustum(const FrustumPlanes& planes, const Vec3& center, const Vec3& extent)
+	{
+		for(uint32_t i = 0U; i < 6U; i++)
+		{
+			float distance = planes.normalX[i] * center.x + planes.normalY[i] * center.y
+				+ planes.normalZ[i] * center.z + planes.distance[i];
+			float radius = std::abs(planes.normalX[i]) * extent.x + std::abs(planes.normalY[i]) * extent.y
+				+ std::abs(planes.normalZ[i]) * extent.z;
+			if(distance + radius < 0.0f)
+				return false;
+		}
+		return true;
+	}
+
+#if defined(MTD_CULLING_AVX2) || defined(MTD_CULLING_SSE2)
+#if defined(MTD_CULLING_AVX2)
+	// One float of each of 8 render objects
+	struct SimdFloat
+	{
+		static constexpr uint32_t WIDTH = 8U;
+		__m256 value;
+
+		static SimdFloat broadcast(float scalar) { return {_mm256_set1_ps(scalar)}; }
+		SimdFloat operator+(SimdFloat other) const { return {_mm256_add_ps(value, other.value)}; }
+		SimdFloat operator*(SimdFloat other) const { return {_mm256_mul_ps(value, other.value)}; }
+		SimdFloat abs() const { return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), value)}; }
+		SimdFloat operator&(SimdFloat other) const { return {_mm256_and_ps(value, other.value)}; }
+		SimdFloat isNonNegative() const { return {_mm256_cmp_ps(value, _mm256_setzero_ps(), _CMP_GE_OQ)}; }
+		uint32_t mask() const { return static_cast<uint32_t>(_mm256_movemask_ps(value)); }
+
+		// Loads 4 consecutive floats of each render object, with one register per float.
+		// Render objects 0 to 3 are transposed in the lower half, and 4 to 7 in the upper half.
+		static void loadTransposed
+		(
+			const std::array<const RenderObject*, WIDTH>& group, size_t offset, std::array<SimdFloat, 4>& floats
+		)
+		{
+			__m256 rows[4];
+			for(uint32_t i = 0U; i < 4U; i++)
+			{
+				rows[i] = _mm256_insertf128_ps
+				(
+					_mm256_castps128_ps256(_mm_loadu_ps(getRenderObjectFloats(group[i], offset))),
+					_mm_loadu_ps(getRenderObjectFloats(group[i + 4U], offset)),
+					1
+				);
+			}
+
+			__m256 low01 = _mm256_unpacklo_ps(rows[0], rows[1]);
+			__m256 low23 = _mm256_unpacklo_ps(rows[2], rows[3]);
+			__m256 high01 = _mm256_unpackhi_ps(rows[0], rows[1]);
+			__m256 high23 = _mm256_unpackhi_ps(rows[2], rows[3]);
+			floats[0].value = _mm256_shuffle_ps(low01, low23, _MM_SHUFFLE(1, 0, 1, 0));
+			floats[1].value = _mm256_shuffle_ps(low01, low23, _MM_SHUFFLE(3, 2, 3, 2));
+			floats[2].value = _mm256_shuffle_ps(high01, high23, _MM_SHUFFLE(1, 0, 1, 0));
+			floats[3].value = _mm256_shuffle_ps(high01, high23, _MM_SHUFFLE(3, 2, 3, 2));
+		}
+	};
+#else
+	// One float of each of 4 render objects
+	struct SimdFloat
+	{
+		static constexpr uint32_t WIDTH = 4U;
+		__m128 value;
+
+		static SimdFloat broadcast(float scalar) { return {_mm_set1_ps(scalar)}; }
+		SimdFloat operator+(SimdFloat other) const { return {_mm_add_ps(value, other.value)}; }
+		SimdFloat operator*(SimdFloat other) const { return {_mm_mul_ps(value, other.value)}; }
+		SimdFloat abs() const { return {_mm_andnot_ps(_mm_set1_ps(-0.0f), value)}; }
+		SimdFloat operator&(SimdFloat other) const { return {_mm_and_ps(value, other.value)}; }
+		SimdFloat isNonNegative() const { return {_mm_cmpge_ps(value, _mm_setzero_ps())}; }
+		uint32_t mask() const { return static_cast<uint32_t>(_mm_movemask_ps(value)); }
+
+		// Loads 4 consecutive floats of each render object, with one register per float
+		static void loadTransposed
+		(
+			const std::array<const RenderObject*, WIDTH>& group, size_t offset, std::array<SimdFloat, 4>& floats
+		)
+		{
+			__m128 a = _mm_loadu_ps(getRenderObjectFloats(group[0], offset));
+			__m128 b = _mm_loadu_ps(getRenderObjectFloats(group[1], offset));
+			__m128 c = _mm_loadu_ps(getRenderObjectFloats(group[2], offset));
+			__m128 d = _mm_loadu_ps(getRenderObjectFloats(group[3], offset));
+			_MM_TRANSPOSE4_PS(a, b, c, d);
+			floats = {SimdFloat{a}, SimdFloat{b}, SimdFloat{c}, SimdFloat{d}};
+		}
+	};
+#endif
+
+	// Render objects tested together, which may be anywhere in the render objects array
+	using RenderObjectGroup = std::array<const RenderObject*, SimdFloat::WIDTH>;
+
+	// Tests a full group of render objects, returning a bit mask of the visible ones
+	static uint32_t cullGroup(const FrustumPlanes& planes, const RenderObjectGroup& group)
+	{
+		// Each column of the transforms, and the local bounding boxes
+		constexpr size_t columnSize = sizeof(Vec4) / sizeof(float);
+		constexpr size_t centerOffset = offsetof(RenderObject, centerAABB) / sizeof(float);
+		constexpr size_t extentOffset = offsetof(RenderObject, extentAABB) / sizeof(float);
+		std::array<std::array<SimdFloat, 4>, 4> columns;
+		for(uint32_t i = 0U; i < 4U; i++)
+			SimdFloat::loadTransposed(group, i * columnSize, columns[i]);
+		std::array<SimdFloat, 4> localCenter;
+		std::array<SimdFloat, 4> localExtent;
+		SimdFloat::loadTransposed(group, centerOffset, localCenter);
+		SimdFloat::loadTransposed(group, extentOffset, localExtent);
+
+		// Transforms the box center, and encloses the rotated box in a new axis aligned box
+		std::array<SimdFloat, 3> center;
+		std::array<SimdFloat, 3> extent;
+		for(uint32_t i = 0U; i < 3U; i++)
+		{
+			center[i] = columns[0][i] * localCenter[0] + columns[1][i] * localCenter[1]
+				+ columns[2][i] * localCenter[2] + columns[3][i];
+			extent[i] = columns[0][i].abs() * localExtent[0] + columns[1][i].abs() * localExtent[1]
+				+ columns[2][i].abs() * localExtent[2];
+		}
+
+		SimdFloat inside = SimdFloat::broadcast(0.0f).isNonNegative();
+		for(uint32_t i = 0U; i < 6U; i++)
+		{
+			SimdFloat distance = SimdFloat::broadcast(planes.normalX[i]) * center[0]
+				+ SimdFloat::broadcast(planes.normalY[i]) * center[1]
+				+ SimdFloat::broadcast(planes.normalZ[i]) * center[2]
+				+ SimdFloat::broadcast(planes.distance[i]);
+			SimdFloat radius = SimdFloat::broadcast(std::abs(planes.normalX[i])) * extent[0]
+				+ SimdFloat::broadcast(std::abs(planes.normalY[i])) * extent[1]
+				+ SimdFloat::broadcast(std::abs(planes.normalZ[i])) * extent[2];
+			inside = inside & (distance + radius).isNonNegative();
+		}
+		return inside.mask();
+	}
+#endif
+}
+
+mtd::FrustumPlanes mtd::FrustumCulling::extractPlanes(const Mat4x4& projectionView)
+{
+	// Rows of the matrix, as the matrix is stored by columns
+	const Mat4x4& matrix = projectionView;
+	std::array<Vec4, 4> rows
+	{
+		Vec4{matrix.x.x, matrix.y.x, matrix.z.x, matrix.w.x},
+		Vec4{matrix.x.y, matrix.y.y, matrix.z.y, matrix.w.y},
+		Vec4{matrix.x.z, matrix.y.z, matrix.z.z, matrix.w.z},
+		Vec4{matrix.x.w, matrix.y.w, matrix.z.w, matrix.w.w}
+	};
+
+	// Left, right, bottom, top, near and far planes, from -w <= x, y <= w and 0 <= z <= w in clip space
+	std::array<Vec4, 6> planes
+	{
+		rows[3] + rows[0],
+		rows[3] - rows[0],
+		rows[3] + rows[1],
+		rows[3] - rows[1],
+		rows[2],
+		rows[3] - rows[2]
+	};
+
+	FrustumPlanes frustumPlanes{};
+	for(uint32_t i = 0U; i < 6U; i++)
+	{
+		frustumPlanes.normalX[i] = planes[i].x;
+		frustumPlanes.normalY[i] = planes[i].y;
+		frustumPlanes.normalZ[i] = planes[i].z;
+		frustumPlanes.distance[i] = planes[i].w;
+	}
+	return frustumPlanes;
+}
+
+const char* mtd::FrustumCulling::getInstructionSet()
+{
+#if defined(MTD_CULLING_AVX2)
+	return "AVX2";
+#elif defined(MTD_CULLING_SSE2)
+	return "SSE2";
+#else
+	return "Scalar";
+#endif
+}
+
+void mtd::FrustumCulling::cullRange
+(
+	const FrustumPlanes& planes, const RenderObject* pRenderObjects, uint32_t count, uint8_t* pVisibility
+)
+{
+	uint32_t first = 0U;
+#if defined(MTD_CULLING_AVX2) || defined(MTD_CULLING_SSE2)
+	for(; first + SimdFloat::WIDTH <= count; first += SimdFloat::WIDTH)
+	{
+		RenderObjectGroup group;
+		for(uint32_t lane = 0U; lane < SimdFloat::WIDTH; lane++)
+			group[lane] = pRenderObjects + first + lane;
+
+		uint32_t visibleMask = cullGroup(planes, group);
+		for(uint32_t lane = 0U; lane < SimdFloat::WIDTH; lane++)
+			pVisibility[first + lane] = static_cast<uint8_t>((visibleMask >> lane) & 1U);
+	}
+#endif
+
+	// Render objects left out of the last full group
+	cullRangeScalar(planes, pRenderObjects + first, count - first, pVisibility + first);
+}
+
+void mtd::FrustumCulling::cullRangeScalar
+(
+	const FrustumPlanes& planes, const RenderObject* pRenderObjects, uint32_t count, uint8_t* pVisibility
+)
+{
+	for(uint32_t i = 0U; i < count; i++)
+	{
+		const Mat4x4& transform = pRenderObjects[i].transform;
+		const Vec3& localCenter = pRenderObjects[i].centerAABB;
+		const Vec3& localExtent = pRenderObjects[i].extentAABB;
+
+		// Transforms the box center, and encloses the rotated box in a new axis aligned box
+		Vec3 center
+		{
+			transform.x.x * localCenter.x + transform.y.x * localCenter.y
+				+ transform.z.x * localCenter.z + transform.w.x,
+			transform.x.y * localCenter.x + transform.y.y * localCenter.y
+				+ transform.z.y * localCenter.z + transform.w.y,
+			transform.x.z * localCenter.x + transform.y.z * localCenter.y
+				+ transform.z.z * localCenter.z + transform.w.z
+		};
+		Vec3 extent
+		{
+			std::abs(transform.x.x) * localExtent.x + std::abs(transform.y.x) * localExtent.y
+				+ std::abs(transform.z.x) * localExtent.z,
+			std::abs(transform.x.y) * localExtent.x + std::abs(transform.y.y) * localExtent.y
+				+ std::abs(transform.z.y) * localExtent.z,
+			std::abs(transform.x.z) * localExtent.x + std::abs(transform.y.z) * localExtent.y
+				+ std::abs(transform.z.z) * localExtent.z
+		};
+
+		pVisibility[i] = isBoxInsideFrustum(planes, center, extent) ? 1U : 0U;
+	}
+}
+
+void mtd::FrustumCulling::cullIndices
+(
+	const FrustumPlanes& planes,
+	const RenderObject* pRenderObjects,
+	const uint32_t* pIndices,
+	uint32_t count,
+	uint8_t* pVisibility
+)
+{
+	uint32_t first = 0U;
+#if defined(MTD_CULLING_AVX2) || defined(MTD_CULLING_SSE2)
+	for(; first + SimdFloat::WIDTH <= count; first += SimdFloat::WIDTH)
+	{
+		RenderObjectGroup group;
+		for(uint32_t lane = 0U; lane < SimdFloat::WIDTH; lane++)
+			group[lane] = pRenderObjects + pIndices[first + lane];
+
+		uint32_t visibleMask = cullGroup(planes, group);
+		for(uint32_t lane = 0U; lane < SimdFloat::WIDTH; lane++)
+			pVisibility[pIndices[first + lane]] = static_cast<uint8_t>((visibleMask >> lane) & 1U);
+	}
+#endif
+
+	for(; first < count; first++)
+		cullRangeScalar(planes, pRenderObjects + pIndices[first], 1U, pVisibility + pIndices[first]);
+}
+
+void mtd::FrustumCulling::cullRenderObjects
+(
+	const FrustumPlanes& planes, const std::vector<RenderObject>& renderObjects, std::vector<uint8_t>& visibility
+)
+{
+	uint32_t count = static_cast<uint32_t>(renderObjects.size());
+	visibility.resize(count);
+
+	// Each chunk starts at a multiple of the grain size, so only the last chunk has an incomplete group
+	JobSystem::parallelFor(0U, count, CULLING_GRAIN_SIZE, [&](uint32_t begin, uint32_t end)
+	{
+		cullRange(planes, renderObjects.data() + begin, end - begin, visibility.data() + begin);
+	});
+}
+
+void mtd::FrustumCulling::cullRenderObjects
+(
+	const FrustumPlanes& planes,
+	const std::vector<RenderObject>& renderObjects,
+	const std::vector<uint32_t>& indices,
+	std::vector<uint8_t>& visibility
+)
+{
+	assert(visibility.size() == renderObjects.size() && "Visibility must hold an entry for each render object.");
+
+	// Each index is written by a single job, so the jobs never write the same visibility entry
+	uint32_t count = static_cast<uint32_t>(indices.size());
+	JobSystem::parallelFor(0U, count, CULLING_GRAIN_SIZE, [&](uint32_t begin, uint32_t end)
+	{
+		cullIndices(planes, renderObjects.data(), indices.data() + begin, end - begin, visibility.data());
+	});
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "../Utils/EngineStructs.hpp"
+
+namespace mtd
+{
+	// View frustum planes, stored as arrays of each plane component so a group of boxes is tested at once.
+	// The normals point inwards, so points inside the frustum have non-negative distances to all planes.
+	struct FrustumPlanes
+	{
+		std::array<float, 6> normalX;
+		std::array<float, 6> normalY;
+		std::array<float, 6> normalZ;
+		std::array<float, 6> distance;
+
+		bool operator==(const FrustumPlanes& other) const = default;
+	};
+
+	// CPU frustum culling of the render object bounding boxes
+	namespace FrustumCulling
+	{
+		// Extracts the frustum planes from the camera projection view matrix, with the depth in the [0, 1] range
+		FrustumPlanes extractPlanes(const Mat4x4& projectionView);
+
+		// Name of the instruction set used to test the boxes ("AVX2", "SSE2" or "Scalar")
+		const char* getInstructionSet();
+
+		// Tests the mesh bounding boxes transformed by the render object transforms, in the calling thread.
+		// Writes 1 to the visibility of the boxes intersecting the frustum, and 0 to the others.
+		void cullRange
+		(
+			const FrustumPlanes& planes, const RenderObject* pRenderObjects, uint32_t count, uint8_t* pVisibility
+		);
+		// Tests the boxes one at a time, without vector instructions
+		void cullRangeScalar
+		(
+			const FrustumPlanes& planes, const RenderObject* pRenderObjects, uint32_t count, uint8_t* pVisibility
+		);
+		// Tests only the render objects at the given indices, writing the visibility at the same indices
+		void cullIndices
+		(
+			const FrustumPlanes& planes,
+			const RenderObject* pRenderObjects,
+			const uint32_t* pIndices,
+			uint32_t count,
+			uint8_t* pVisibility
+		);
+
+		// Tests all render objects, splitting large amounts of render objects across the job system
+		void cullRenderObjects
+		(
+			const FrustumPlanes& planes,
+			const std::vector<RenderObject>& renderObjects,
+			std::vector<uint8_t>& visibility
+		);
+		// Tests the render objects at the given indices, which must be unique, splitting large amounts of indices
+		// across the job system. The visibility must already hold an entry for each render object.
+		void cullRenderObjects
+		(
+			const FrustumPlanes& planes,
+			const std::vector<RenderObject>& renderObjects,
+			const std::vector<uint32_t>& indices,
+			std::vector<uint8_t>& visibility
+		);
+	}
+}
@@ -1,26 +1,34 @@
 #include <pch.hpp>
 #include "Engine.hpp"
 
+#include "Utils/FileHandler.hpp"
 #include "Utils/Logger.hpp"
 #include "Utils/Profiler.hpp"
 #include "Input/InputHandler.hpp"
 #include "Event/EventManager.hpp"
 #include "Vulkan/Image/SamplerManager.hpp"
 
-mtd::Engine::Engine(const EngineInfo& info, Window& window)
+mtd::Engine::Engine(const EngineInfo& info, Window* pWindow)
 	: vulkanInstance{info},
-	surface{vulkanInstance.getInstance(), window.windowHandler.get()},
+	surface{vulkanInstance.getInstance(), selectWindowHandler(info, pWindow)},
 	device{vulkanInstance.getInstance(), surface.getSurface(), info.enableRayTracing},
-	swapchain{device, surface.getSurface(), window.getDimensions()},
+	assetCache{device, info.assetCacheBudget},
+	resourceManager{device, selectFrameDimensions(info, pWindow)},
+	swapchain{device, resourceManager, surface.getSurface(), selectFrameDimensions(info, pWindow)},
 	commandHandler{device},
 	renderer{device},
-	scene{device},
-	camera{window.getAspectRatio()},
-	imGuiHandler{device.getDevice()},
-	resourceManager{device, window.getDimensions()},
-	descriptorManager{device, resourceManager}
+	maxResidentScenes{std::max(info.maxResidentScenes, 1U)},
+	residentSceneBudget{info.residentSceneBudget},
+	camera
+	{
+		static_cast<float>(swapchain.getExtent().width) / static_cast<float>(swapchain.getExtent().height)
+	},
+	imGuiHandler{device.getDevice()}
 {
+	Profiler::setThreadName("Main thread");
 	SamplerManager::createSamplers(device.getDevice());
+	// Packed assets take precedence over the loose files in the resources folder
+	VirtualFileSystem::mountArchives(MTD_RESOURCES_PATH);
 	configureEventCallbacks();
 
 	LOG_INFO("Engine ready.\n");
@@ -28,8 +36,12 @@ mtd::Engine::Engine(const EngineInfo& info, Window& window)
 
 mtd::Engine::~Engine()
 {
-	device.getDevice().waitIdle();
+	if(sceneLoadThread.joinable())
+		sceneLoadThread.join();
+
+	device.waitIdle();
 	SamplerManager::destroySamplers(device.getDevice());
+	VirtualFileSystem::unmountArchives();
 
 	LOG_INFO("Engine shut down.");
 }
@@ -46,6 +58,12 @@ void mtd::Engine::setVSync(bool enableVSync)
 
 void mtd::Engine::run(Window& window, const std::function<void(double)>& onUpdateCallback)
 {
+	if(swapchain.isHeadless())
+	{
+		LOG_ERROR("The engine main loop requires a window. Use \"runFrames()\" when rendering headless.");
+		return;
+	}
+
 	WindowHandler* const pWindowHandler = window.windowHandler.get();
 	DrawInfo drawInfo
 	{
@@ -58,24 +76,22 @@ void mtd::Engine::run(Window& window, const std::function<void(double)>& onUpdat
 
 	while(running.load())
 	{
-		if(shouldLoadScene.load())
-			loadScene(sceneFileToLoad.c_str());
+		updateSceneContexts();
 
 		PROFILER_START_FRAME("Update descriptors");
-		resourceManager.updateBufferData(cameraResourceID, sizeof(CameraMatrices), camera.fetchUpdatedMatrices());
-
-		renderer.render
-		(
-			swapchain,
-			imGuiHandler,
-			framebuffers,
-			pipelines,
-			scene,
-			resourceManager,
-			descriptorManager,
-			drawInfo,
-			shouldUpdateEngine
-		);
+		if(pActiveScene)
+		{
+			// Copied, so the matrices uploaded and used for culling do not change while the frame is recorded
+			CameraMatrices cameraMatrices = *static_cast<const CameraMatrices*>(camera.fetchUpdatedMatrices());
+			pActiveScene->getResourceManager().updateBufferData
+			(
+				pActiveScene->getCameraResourceID(), sizeof(CameraMatrices), &cameraMatrices
+			);
+			renderer.render
+			(
+				swapchain, imGuiHandler, *pActiveScene, cameraMatrices.projectionView, drawInfo, shouldUpdateEngine
+			);
+		}
 
 		PROFILER_NEXT_STAGE("Update engine");
 		if(shouldUpdateEngine.load())
@@ -89,51 +105,100 @@ void mtd::Engine::run(Window& window, const std::function<void(double)>& onUpdat
 		updateThread.join();
 }
 
-void mtd::Engine::loadScene(const char* sceneFile)
+void mtd::Engine::runFrames
+(
+	uint32_t frameCount, double fixedDeltaTime, const std::function<void(double)>& onUpdateCallback
+)
 {
-	device.getDevice().waitIdle();
-	framebuffers.clear();
-	pipelines.rasterizationPipelines.clear();
-	pipelines.computePipelines.clear();
-	pipelines.rayTracingPipelines.clear();
-	pipelines.framebufferPipelines.clear();
-	resourceManager.clearResources();
-	descriptorManager.clear();
-	Profiler::clearStages();
-
-	std::vector<FramebufferInfo> framebufferInfos;
-	PipelineInfoBundle pipelineInfos;
-
-	cameraResourceID = resourceManager.createBuffer
-	(
-		"Camera", GpuBufferType::Uniform, GpuMemoryUsage::Auto, sizeof(CameraMatrices)
-	);
-	renderer.createRenderObjectsBuffer(resourceManager);
+	DrawInfo drawInfo
+	{
+		swapchain.getRenderPass(),
+		swapchain.getExtent()
+	};
 
-	scene.loadScene
-	(
-		device,
-		sceneFile,
-		framebufferInfos,
-		pipelineInfos,
-		resourceManager,
-		descriptorManager,
-		renderer.getRenderOrder()
-	);
+	for(uint32_t frame = 0U; frame < frameCount; frame++)
+	{
+		updateSceneContexts();
 
-	createRenderResources(framebufferInfos, pipelineInfos);
-	scene.allocateResources(pipelines);
-	configureDescriptors();
+		PROFILER_START_FRAME("Update scene");
+		EventManager::processEvents();
 
-	scene.start();
+		onUpdateCallback(fixedDeltaTime);
+		if(!pActiveScene)
+		{
+			PROFILER_END_FRAME();
+			continue;
+		}
+		pActiveScene->getScene().update(fixedDeltaTime);
 
-	shouldLoadScene.store(false);
-	std::unique_lock sceneLoadLock{sceneLoadMutex};
-	sceneLoadCV.notify_all();
+		PROFILER_NEXT_STAGE("Update descriptors");
+		CameraMatrices cameraMatrices = *static_cast<const CameraMatrices*>(camera.fetchUpdatedMatrices());
+		pActiveScene->getResourceManager().updateBufferData
+		(
+			pActiveScene->getCameraResourceID(), sizeof(CameraMatrices), &cameraMatrices
+		);
+
+		renderer.render
+		(
+			swapchain, imGuiHandler, *pActiveScene, cameraMatrices.projectionView, drawInfo, shouldUpdateEngine
+		);
+
+		PROFILER_END_FRAME();
+	}
+}
+
+bool mtd::Engine::readbackFrame(std::vector<uint8_t>& pixels)
+{
+	device.waitIdle();
+	return swapchain.readbackFrame(renderer.getLastFrameIndex(), pixels);
+}
+
+bool mtd::Engine::saveFrameToPNG(const char* filePath)
+{
+	std::vector<uint8_t> pixels;
+	if(!readbackFrame(pixels)) return false;
+
+	const vk::Extent2D& extent = swapchain.getExtent();
+	return FileHandler::writePNG(filePath, UIntVec2{extent.width, extent.height}, 4U, pixels.data());
+}
+
+void mtd::Engine::loadScene(const char* sceneFile)
+{
+	// A scene requested by an event is superseded by the one loaded directly
+	if(sceneLoadThread.joinable())
+		sceneLoadThread.join();
+	// A scene preloaded in the background stays resident
+	if(sceneLoadReady.load() && !activateLoadedScene)
+	{
+		residentScenes.push_back
+		(
+			ResidentScene{loadingSceneFile, std::move(pLoadedScene), renderer.getSubmittedFrameCount()}
+		);
+	}
+	pLoadedScene.reset();
+	sceneLoadReady.store(false);
+
+	std::string sceneFileName{sceneFile};
+	std::unique_ptr<SceneContext> pSceneContext = takeResidentScene(sceneFileName);
+	if(!pSceneContext)
+		pSceneContext = prepareScene(sceneFileName);
+	activateScene(std::move(pSceneContext), std::move(sceneFileName));
+	trimResidentScenes();
+
+	device.waitIdle();
+	retiredScenes.clear();
+	assetCache.trim();
+	sceneLoading.store(shouldLoadScene.load());
 }
 
 void mtd::Engine::initializeGui(const Window& window)
 {
+	if(swapchain.isHeadless())
+	{
+		LOG_WARNING("GUI is not available when rendering headless.");
+		return;
+	}
+
 	window.windowHandler->initImGuiForGLFW();
 	imGuiHandler.init
 	(
@@ -149,29 +214,56 @@ void mtd::Engine::addGuiWindow(GuiWindow* const pGuiWindow)
 	imGuiHandler.addGuiWindow(pGuiWindow);
 }
 
+mtd::WindowHandler* mtd::Engine::selectWindowHandler(const EngineInfo& info, Window* pWindow)
+{
+	if(info.headless) return nullptr;
+
+	if(!pWindow)
+		throw std::runtime_error("A window is required when not rendering headless.\n");
+	return pWindow->windowHandler.get();
+}
+
+mtd::UIntVec2 mtd::Engine::selectFrameDimensions(const EngineInfo& info, const Window* pWindow)
+{
+	if(info.headless) return UIntVec2{info.headlessWidth, info.headlessHeight};
+
+	return pWindow->getDimensions();
+}
+
 void mtd::Engine::updateLoop(const std::function<void(double)>& onUpdateCallback)
 {
 	using ChronoClock = std::chrono::steady_clock;
 	using ChronoTime = std::chrono::steady_clock::time_point;
 	using ChronoDuration = std::chrono::duration<double>;
 
+	Profiler::setThreadName("Update thread");
+
 	ChronoTime endTime = ChronoClock::now();
 	ChronoDuration totalDuration{0.001};
 
 	while(running.load())
 	{
-		{
-			std::unique_lock sceneLoadLock{sceneLoadMutex};
-			sceneLoadCV.wait(sceneLoadLock, [this] { return !shouldLoadScene.load(); });
-		}
+		// Lets the render thread swap the active scene between two updates
+		sceneSwapPending.wait(true);
 
+		PROFILER_ZONE("Update");
+		std::lock_guard activeSceneLock{activeSceneMutex};
 		ChronoTime startTime = endTime;
 
-		InputHandler::checkActionEvents();
-		EventManager::processEvents();
-
-		onUpdateCallback(totalDuration.count());
-		scene.update(totalDuration.count());
+		{
+			PROFILER_ZONE("Process events");
+			InputHandler::checkActionEvents();
+			EventManager::processEvents();
+		}
+		{
+			PROFILER_ZONE("Update callback");
+			onUpdateCallback(totalDuration.count());
+		}
+		if(pActiveScene)
+		{
+			PROFILER_ZONE("Update scene");
+			pActiveScene->getScene().update(totalDuration.count());
+		}
 
 		endTime = ChronoClock::now();
 		totalDuration = endTime - startTime;
@@ -182,117 +274,275 @@ void mtd::Engine::configureEventCallbacks()
 {
 	changeSceneCallbackHandle = EventManager::addCallback([this](const ChangeSceneEvent& event)
 	{
+		std::lock_guard sceneLoadLock{sceneLoadMutex};
 		sceneFileToLoad = event.getSceneName();
+		sceneLoading.store(true);
 		shouldLoadScene.store(true);
 	});
+	preloadSceneCallbackHandle = EventManager::addCallback([this](const PreloadSceneEvent& event)
+	{
+		if(maxResidentScenes < 2U)
+		{
+			LOG_WARNING("Scene \"%s\" not preloaded, as only the active scene may be resident.", event.getSceneName());
+			return;
+		}
+		std::lock_guard sceneLoadLock{sceneLoadMutex};
+		scenesToPreload.emplace(event.getSceneName());
+	});
 	windowResizeCallbackHandle = EventManager::addCallback([this](const WindowResizeEvent& event)
 	{
 		shouldUpdateEngine.store(true);
 	});
 }
 
-void mtd::Engine::createRenderResources
-(
-	const std::vector<FramebufferInfo>& framebufferInfos,
-	const PipelineInfoBundle& pipelineInfos
-)
+std::unique_ptr<mtd::SceneContext> mtd::Engine::prepareScene(const std::string& sceneFile)
 {
-	scene.setCameraResourceID(cameraResourceID);
+	PROFILER_ZONE("Load scene");
+	sceneLoadProgress.store(0.0f);
 
-	framebuffers.reserve(framebufferInfos.size());
-	for(const FramebufferInfo& framebufferInfo: framebufferInfos)
-		framebuffers.emplace_back(device, framebufferInfo, swapchain.getExtent());
+	// The callbacks of the scene objects are ignored until the scene becomes active
+	uint64_t callbackGroup = EventManager::createCallbackGroup();
+	EventManager::setThreadCallbackGroup(callbackGroup);
 
-	pipelines.rasterizationPipelines.reserve(pipelineInfos.rasterizerInfos.size());
-	for(const RasterizationPipelineInfo& rasterizationPipelineInfo: pipelineInfos.rasterizerInfos)
+	std::unique_ptr<SceneContext> pSceneContext;
 	{
-		int32_t fbIndex = rasterizationPipelineInfo.targetFramebufferIndex;
-		bool targetSwapchain = (fbIndex == -1);
+		std::lock_guard swapchainLock{swapchainMutex};
+		const vk::Extent2D& extent = swapchain.getExtent();
+		pSceneContext = std::make_unique<SceneContext>(device, assetCache, UIntVec2{extent.width, extent.height});
+	}
+	pSceneContext->setCallbackGroup(callbackGroup);
 
-		pipelines.rasterizationPipelines.emplace_back
-		(
-			device.getDevice(),
-			descriptorManager,
-			rasterizationPipelineInfo,
-			targetSwapchain ? swapchain.getExtent() : framebuffers[fbIndex].getExtent(),
-			targetSwapchain ? swapchain.getRenderPass() : framebuffers[fbIndex].getRenderPass()
-		);
+	// Reading the scene file takes the first half of the progress
+	pSceneContext->loadScene(sceneFile, [this](float progress) { sceneLoadProgress.store(0.5f * progress); });
+	// Textures and mesh data upload while the pipelines are created
+	pSceneContext->getResourceManager().submitUploads();
+	sceneLoadProgress.store(0.6f);
+
+	{
+		std::lock_guard swapchainLock{swapchainMutex};
+		pSceneContext->createRenderResources(swapchain);
 	}
+	sceneLoadProgress.store(0.8f);
+
+	pSceneContext->configureDescriptors();
+	sceneLoadProgress.store(0.9f);
+
+	pSceneContext->getResourceManager().finishUploads();
+	EventManager::setThreadCallbackGroup(0UL);
+	sceneLoadProgress.store(1.0f);
 
-	pipelines.framebufferPipelines.reserve(pipelineInfos.framebufferInfos.size());
-	for(const FramebufferPipelineInfo& fbPipelineInfo: pipelineInfos.framebufferInfos)
+	MemoryStatistics memoryStatistics = device.getMemoryAllocator().getStatistics();
+	LOG_INFO
+	(
+		"GPU memory: %.1f/%.1f MiB used in %d blocks and %d dedicated allocations (%d allocations, %d free ranges).",
+		static_cast<double>(memoryStatistics.usedBytes) / (1024.0 * 1024.0),
+		static_cast<double>(memoryStatistics.reservedBytes) / (1024.0 * 1024.0),
+		memoryStatistics.blockCount,
+		memoryStatistics.dedicatedAllocationCount,
+		memoryStatistics.allocationCount,
+		memoryStatistics.freeRangeCount
+	);
+
+	return pSceneContext;
+}
+
+void mtd::Engine::beginSceneLoad(std::string sceneFile, bool activate)
+{
+	loadingSceneFile = sceneFile;
+	activateLoadedScene = activate;
+
+	sceneLoadThread = std::thread{[this, sceneFile = std::move(sceneFile)]()
 	{
-		int32_t fbIndex = fbPipelineInfo.targetFramebufferIndex;
-		bool targetSwapchain = (fbIndex == -1);
+		Profiler::setThreadName("Scene loading thread");
+		pLoadedScene = prepareScene(sceneFile);
+		sceneLoadReady.store(true);
+	}};
+}
 
-		pipelines.framebufferPipelines.emplace_back
-		(
-			device.getDevice(),
-			descriptorManager,
-			fbPipelineInfo,
-			targetSwapchain ? swapchain.getExtent() : framebuffers[fbIndex].getExtent(),
-			targetSwapchain ? swapchain.getRenderPass() : framebuffers[fbIndex].getRenderPass()
-		);
+void mtd::Engine::handleSceneChange()
+{
+	std::string sceneFile;
+	{
+		std::lock_guard sceneLoadLock{sceneLoadMutex};
+		// Another scene being loaded must finish first, unless it is the requested one
+		if(sceneLoadThread.joinable() && sceneFileToLoad != loadingSceneFile) return;
+
+		sceneFile = std::move(sceneFileToLoad);
+		shouldLoadScene.store(false);
 	}
 
-	pipelines.computePipelines.reserve(pipelineInfos.computeInfos.size());
-	for(const ComputePipelineInfo& computePipelineInfo: pipelineInfos.computeInfos)
+	if(sceneLoadThread.joinable())
 	{
-		pipelines.computePipelines.emplace_back
-		(
-			device, descriptorManager, computePipelineInfo, swapchain.getExtent()
-		);
+		// The requested scene is already being preloaded, so it gets activated once ready
+		activateLoadedScene = true;
+		return;
 	}
 
-	if(!device.isRayTracingEnabled()) return;
-	pipelines.rayTracingPipelines.reserve(pipelineInfos.rayTracingInfos.size());
-	for(const RayTracingPipelineInfo& rtPipelineInfo: pipelineInfos.rayTracingInfos)
+	std::unique_ptr<SceneContext> pSceneContext = takeResidentScene(sceneFile);
+	if(!pSceneContext)
 	{
-		pipelines.rayTracingPipelines.emplace_back
-		(
-			device, descriptorManager, rtPipelineInfo, swapchain.getExtent()
-		);
+		beginSceneLoad(std::move(sceneFile), true);
+		return;
 	}
+
+	activateScene(std::move(pSceneContext), std::move(sceneFile));
+	trimResidentScenes();
+	sceneLoading.store(shouldLoadScene.load());
 }
 
-void mtd::Engine::configureDescriptors()
+void mtd::Engine::handleScenePreload()
 {
-	for(ComputePipeline& computePipeline: pipelines.computePipelines)
-		computePipeline.configurePipelineDescriptorSet();
-	for(RayTracingPipeline& rtPipeline: pipelines.rayTracingPipelines)
-		rtPipeline.configurePipelineDescriptorSet();
-	for(FramebufferPipeline& fbPipeline: pipelines.framebufferPipelines)
-		fbPipeline.updateInputImagesDescriptors(framebuffers, pipelines.computePipelines, pipelines.rayTracingPipelines);
+	std::string sceneFile;
+	{
+		std::lock_guard sceneLoadLock{sceneLoadMutex};
+		while(!scenesToPreload.empty() && sceneFile.empty())
+		{
+			const std::string& requestedFile = scenesToPreload.front();
+			bool resident = std::ranges::find(residentScenes, requestedFile, &ResidentScene::sceneFile)
+				!= residentScenes.end();
+			if(requestedFile != activeSceneFile && !resident)
+				sceneFile = std::move(scenesToPreload.front());
+			scenesToPreload.pop();
+		}
+	}
+
+	if(!sceneFile.empty())
+		beginSceneLoad(std::move(sceneFile), false);
 }
 
-void mtd::Engine::updateEngine(WindowHandler* const pWindowHandler)
+void mtd::Engine::updateSceneContexts()
 {
-	pWindowHandler->waitForValidWindowSize();
-	device.getDevice().waitIdle();
+	if(shouldLoadScene.load())
+		handleSceneChange();
+	if(!sceneLoadThread.joinable())
+		handleScenePreload();
 
-	swapchain.recreate(device, surface.getSurface(), pWindowHandler->getDimensions());
+	if(sceneLoadReady.load())
+	{
+		sceneLoadThread.join();
+		sceneLoadReady.store(false);
+		if(activateLoadedScene)
+		{
+			activateScene(std::move(pLoadedScene), loadingSceneFile);
+			sceneLoading.store(shouldLoadScene.load());
+		}
+		else
+		{
+			residentScenes.push_back
+			(
+				ResidentScene{loadingSceneFile, std::move(pLoadedScene), renderer.getSubmittedFrameCount()}
+			);
+		}
+		trimResidentScenes();
+	}
 
-	resourceManager.updateWindowResolutionLinkedImages({swapchain.getExtent().width, swapchain.getExtent().height});
+	if(retiredScenes.empty() || renderer.getSubmittedFrameCount() < retiredScenes.front().retireFrameCount) return;
+
+	// Every frame has been reused since the retirement, so their fences are signaled or about to be
+	PROFILER_ZONE("Destroy retired scenes");
+	swapchain.waitForFrames();
 
-	for(Framebuffer& framebuffer: framebuffers)
-		framebuffer.resize(device, swapchain.getExtent());
-	for(RasterizationPipeline& rasterizationPipeline: pipelines.rasterizationPipelines)
+	std::erase_if(retiredScenes, [this](const RetiredScene& retiredScene)
 	{
-		int32_t fbIndex = rasterizationPipeline.getTargetFramebuffer();
-		if(fbIndex == -1)
-			rasterizationPipeline.recreate(swapchain.getExtent(), swapchain.getRenderPass());
-		else
-			rasterizationPipeline.recreate(framebuffers[fbIndex].getExtent(), framebuffers[fbIndex].getRenderPass());
+		return renderer.getSubmittedFrameCount() >= retiredScene.retireFrameCount;
+	});
+	// Assets used only by the destroyed scenes may now be evicted
+	assetCache.trim();
+}
+
+void mtd::Engine::activateScene(std::unique_ptr<SceneContext> pSceneContext, std::string sceneFile)
+{
+	PROFILER_ZONE("Activate scene");
+
+	// The swapchain may have been resized while the scene was loading or resident
+	const vk::Extent2D& extent = swapchain.getExtent();
+	if(pSceneContext->getExtent() != extent)
+		pSceneContext->resize(swapchain);
+
+	sceneSwapPending.store(true);
+	{
+		std::lock_guard activeSceneLock{activeSceneMutex};
+		if(pActiveScene)
+		{
+			EventManager::setCallbackGroupEnabled(pActiveScene->getCallbackGroup(), false);
+			// A reloaded scene replaces its previous instance
+			if(maxResidentScenes > 1U && activeSceneFile != sceneFile)
+			{
+				residentScenes.push_back
+				(
+					ResidentScene
+					{
+						std::move(activeSceneFile), std::move(pActiveScene), renderer.getSubmittedFrameCount()
+					}
+				);
+			}
+			else
+			{
+				retiredScenes.push_back
+				(
+					RetiredScene{std::move(pActiveScene), renderer.getSubmittedFrameCount() + swapchain.getFrameCount()}
+				);
+			}
+		}
+
+		pActiveScene = std::move(pSceneContext);
+		activeSceneFile = std::move(sceneFile);
+		EventManager::setCallbackGroupEnabled(pActiveScene->getCallbackGroup(), true);
+		Profiler::clearStages();
+		pActiveScene->getScene().start();
 	}
-	for(ComputePipeline& computePipeline: pipelines.computePipelines)
-		computePipeline.resize(device, swapchain.getExtent());
-	for(RayTracingPipeline& rayTracingPipeline: pipelines.rayTracingPipelines)
-		rayTracingPipeline.resize(device, swapchain.getExtent());
-	for(FramebufferPipeline& fbPipeline: pipelines.framebufferPipelines)
+	sceneSwapPending.store(false);
+	sceneSwapPending.notify_all();
+}
+
+std::unique_ptr<mtd::SceneContext> mtd::Engine::takeResidentScene(const std::string& sceneFile)
+{
+	auto residentIterator = std::ranges::find(residentScenes, sceneFile, &ResidentScene::sceneFile);
+	if(residentIterator == residentScenes.end()) return nullptr;
+
+	std::unique_ptr<SceneContext> pSceneContext = std::move(residentIterator->pSceneContext);
+	residentScenes.erase(residentIterator);
+	return pSceneContext;
+}
+
+void mtd::Engine::trimResidentScenes()
+{
+	uint64_t memoryUsage = 0UL;
+	for(const ResidentScene& residentScene: residentScenes)
+		memoryUsage += residentScene.pSceneContext->getMemoryUsage();
+
+	while(!residentScenes.empty() && (residentScenes.size() >= maxResidentScenes || memoryUsage > residentSceneBudget))
 	{
-		fbPipeline.recreate(swapchain.getExtent(), swapchain.getRenderPass());
-		fbPipeline.updateInputImagesDescriptors(framebuffers, pipelines.computePipelines, pipelines.rayTracingPipelines);
+		auto coldestIterator = std::ranges::min_element(residentScenes, {}, &ResidentScene::lastActiveFrame);
+		memoryUsage -= coldestIterator->pSceneContext->getMemoryUsage();
+
+		LOG_VERBOSE("Scene \"%s\" is no longer resident.", coldestIterator->sceneFile.c_str());
+		retiredScenes.push_back
+		(
+			RetiredScene
+			{
+				std::move(coldestIterator->pSceneContext),
+				renderer.getSubmittedFrameCount() + swapchain.getFrameCount()
+			}
+		);
+		residentScenes.erase(coldestIterator);
 	}
+}
+
+void mtd::Engine::updateEngine(WindowHandler* const pWindowHandler)
+{
+	pWindowHandler->waitForValidWindowSize();
+	std::lock_guard swapchainLock{swapchainMutex};
+	device.waitIdle();
+
+	swapchain.recreate(device, surface.getSurface(), pWindowHandler->getDimensions());
+
+	resourceManager.updateWindowResolutionLinkedImages({swapchain.getExtent().width, swapchain.getExtent().height});
+	if(pActiveScene)
+		pActiveScene->resize(swapchain);
+	// Resident scenes are resized as well, since their pipelines use the recreated render pass
+	for(ResidentScene& residentScene: residentScenes)
+		residentScene.pSceneContext->resize(swapchain);
 
 	camera.setAspectRatio(pWindowHandler->getAspectRatio());
 
@@ -1,10 +1,9 @@
 #pragma once
 
-#include <condition_variable>
-
 #include <meltdown/window.hpp>
 
 #include "Camera/Camera.hpp"
+#include "Jobs/JobScheduler.hpp"
 #include "Vulkan/Render/Renderer.hpp"
 #include "Vulkan/Frame/Surface.hpp"
 
@@ -15,7 +14,7 @@ namespace mtd
 	class Engine
 	{
 		public:
-			Engine(const EngineInfo& info, Window& window);
+			Engine(const EngineInfo& info, Window* pWindow);
 			~Engine();
 
 			Engine(const Engine&) = delete;
@@ -24,6 +23,10 @@ namespace mtd
 			// Getters
 			Camera& getCamera() { return camera; }
 			bool isRayTracingEnabled() const { return device.isRayTracingEnabled(); }
+			bool isLoadingScene() const { return sceneLoading.load(); }
+			float getSceneLoadProgress() const { return sceneLoadProgress.load(); }
+			// Scene being rendered, only replaced outside the update callback (null before the first scene is loaded)
+			SceneContext* getActiveScene() { return pActiveScene.get(); }
 
 			// Configures the clear color for the framebuffers
 			void setClearColor(const Vec4& color);
@@ -32,8 +35,18 @@ namespace mtd
 
 			// Begins the engine main loop
 			void run(Window& window, const std::function<void(double)>& onUpdateCallback);
+			// Updates and renders a fixed amount of frames on the calling thread
+			void runFrames
+			(
+				uint32_t frameCount, double fixedDeltaTime, const std::function<void(double)>& onUpdateCallback
+			);
 
-			// Loads a new scene, clearing the previous if necessary
+			// Copies the last rendered frame to CPU memory (headless only)
+			bool readbackFrame(std::vector<uint8_t>& pixels);
+			// Saves the last rendered frame as a PNG file (headless only)
+			bool saveFrameToPNG(const char* filePath);
+
+			// Loads a new scene on the calling thread, replacing the previous if necessary, or activates it if resident
 			void loadScene(const char* sceneFile);
 
 			// Initializes the engine's GUI handler
@@ -42,30 +55,55 @@ namespace mtd
 			void addGuiWindow(GuiWindow* const pGuiWindow);
 
 		private:
+			// Scene replaced by a new one, kept until the frames using it are finished
+			struct RetiredScene
+			{
+				std::unique_ptr<SceneContext> pSceneContext;
+				uint64_t retireFrameCount;
+			};
+			// Prepared scene kept in memory while inactive, to be activated without loading it again
+			struct ResidentScene
+			{
+				std::string sceneFile;
+				std::unique_ptr<SceneContext> pSceneContext;
+				uint64_t lastActiveFrame;
+			};
+
+			// Worker threads for the job system, created before and destroyed after all other engine objects
+			JobScheduler jobScheduler;
+
 			// Engine handler objects
 			VulkanInstance vulkanInstance;
 			Surface surface;
 			Device device;
+			AssetCache assetCache;
+			ResourceManager resourceManager;
 			Swapchain swapchain;
-			std::vector<Framebuffer> framebuffers;
 			CommandHandler commandHandler;
 			Renderer renderer;
 			ImGuiHandler imGuiHandler;
-			ResourceManager resourceManager;
-			DescriptorManager descriptorManager;
-
-			// All pipelines in use by the scene
-			PipelineBundle pipelines;
 
 			// Scene being currently rendered
-			Scene scene;
+			std::unique_ptr<SceneContext> pActiveScene;
+			// Scene loaded in the background, waiting to be swapped with the active scene
+			std::unique_ptr<SceneContext> pLoadedScene;
+			// Previous scenes, waiting for their frames in flight
+			std::vector<RetiredScene> retiredScenes;
+			// Inactive scenes ready to be activated
+			std::vector<ResidentScene> residentScenes;
+			// Scene file of the active scene
+			std::string activeSceneFile;
+
+			// Limits of the resident scenes, in amount (including the active scene) and in GPU memory
+			uint32_t maxResidentScenes;
+			uint64_t residentSceneBudget;
 
 			// Scene's main camera
 			Camera camera;
-			ResourceID cameraResourceID = 0U;
 
 			// Event callback handles
 			EventCallbackHandle changeSceneCallbackHandle;
+			EventCallbackHandle preloadSceneCallbackHandle;
 			EventCallbackHandle windowResizeCallbackHandle;
 
 			// Flag for updating the engine
@@ -76,22 +114,49 @@ namespace mtd
 			// Scene loading objects
 			std::atomic<bool> shouldLoadScene = false;
 			std::string sceneFileToLoad;
+			std::queue<std::string> scenesToPreload;
 			std::mutex sceneLoadMutex;
-			std::condition_variable sceneLoadCV;
+			std::thread sceneLoadThread;
+			// Scene file being loaded by the scene loading thread, and whether it will be activated or kept resident
+			std::string loadingSceneFile;
+			bool activateLoadedScene = false;
+			std::atomic<bool> sceneLoading = false;
+			std::atomic<bool> sceneLoadReady = false;
+			std::atomic<float> sceneLoadProgress = 1.0f;
+
+			// Guards the active scene, which is only swapped between updates
+			std::mutex activeSceneMutex;
+			std::atomic<bool> sceneSwapPending = false;
+			// Keeps the swapchain from being recreated while the scene loading thread creates the pipelines
+			std::mutex swapchainMutex;
+
+			// Selects the window to render to, or none when rendering headless
+			static WindowHandler* selectWindowHandler(const EngineInfo& info, Window* pWindow);
+			// Gets the initial frame resolution, from the window or from the headless settings
+			static UIntVec2 selectFrameDimensions(const EngineInfo& info, const Window* pWindow);
 
 			// Runs the update loop (update thread)
 			void updateLoop(const std::function<void(double)>& onUpdateCallback);
 
 			// Sets up event callback functions
 			void configureEventCallbacks();
-			// Creates the framebuffers and pipelines to be used in the scene
-			void createRenderResources
-			(
-				const std::vector<FramebufferInfo>& framebufferInfos,
-				const PipelineInfoBundle& pipelineInfos
-			);
-			// Sets up the descriptor pools and sets
-			void configureDescriptors();
+
+			// Loads the scene and creates all its resources, on the calling thread
+			std::unique_ptr<SceneContext> prepareScene(const std::string& sceneFile);
+			// Starts loading a scene in the background, to be activated or kept resident when ready
+			void beginSceneLoad(std::string sceneFile, bool activate);
+			// Switches to the requested scene if it is resident, or starts loading it if no other scene is being loaded
+			void handleSceneChange();
+			// Starts loading the next requested scene that is not resident yet, if no other scene is being loaded
+			void handleScenePreload();
+			// Swaps in the requested scenes and destroys the retired scenes no longer in use
+			void updateSceneContexts();
+			// Replaces the active scene, keeping the previous one resident or retiring it
+			void activateScene(std::unique_ptr<SceneContext> pSceneContext, std::string sceneFile);
+			// Takes a resident scene out of the resident scenes, returning null if the scene is not resident
+			std::unique_ptr<SceneContext> takeResidentScene(const std::string& sceneFile);
+			// Retires the least recently active resident scenes while they exceed the amount or memory limits
+			void trimResidentScenes();
 
 			// Recreates swapchain and pipeline to apply new settings
 			void updateEngine(WindowHandler* const pWindowHandler);
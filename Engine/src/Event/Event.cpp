@@ -118,6 +118,14 @@ const char* mtd::ChangeSceneEvent::getSceneName() const
 	return sceneName;
 }
 
+mtd::PreloadSceneEvent::PreloadSceneEvent(const char* sceneName) : sceneName{sceneName}
+{}
+
+const char* mtd::PreloadSceneEvent::getSceneName() const
+{
+	return sceneName;
+}
+
 mtd::CreateInstancesEvent::CreateInstancesEvent(const char* modelID, uint32_t instanceCount)
 	: modelID{modelID}, instanceCount{instanceCount}
 {}
@@ -2,10 +2,25 @@
 #include <meltdown/event.hpp>
 #include "EventManager.hpp"
 
-using EventCallbackMap = std::unordered_map<uint64_t, mtd::EventCallback>;
+#include <unordered_set>
+
+// Registered callback and the group it belongs to
+struct GroupedCallback
+{
+	mtd::EventCallback callback;
+	uint64_t groupID;
+};
+using EventCallbackMap = std::unordered_map<uint64_t, GroupedCallback>;
 
 static std::unordered_map<std::type_index, EventCallbackMap> callbackMaps;
 static uint64_t currentCallbackIndex = 1;
+// Guards the callbacks, which may be added by objects created in the scene loading thread
+static std::recursive_mutex callbackMutex;
+
+// Callback groups, where the callbacks of groups not enabled are skipped
+static std::unordered_set<uint64_t> enabledCallbackGroups;
+static uint64_t currentCallbackGroup = 1;
+static thread_local uint64_t threadCallbackGroup = 0;
 
 static std::queue<std::unique_ptr<mtd::Event>> eventQueue;
 static std::mutex eventQueueMutex;
@@ -43,6 +58,7 @@ mtd::EventCallbackHandle& mtd::EventCallbackHandle::operator=(EventCallbackHandl
 
 void mtd::EventCallbackHandle::removeCallback()
 {
+	std::lock_guard callbackLock{callbackMutex};
 	if(callbackID == 0 || callbackMaps.find(eventType) == callbackMaps.cend()) return;
 	callbackMaps.at(eventType).erase(callbackID);
 
@@ -51,7 +67,8 @@ void mtd::EventCallbackHandle::removeCallback()
 
 mtd::EventCallbackHandle mtd::EventManager::addCallback(std::type_index eventType, const EventCallback& callback)
 {
-	callbackMaps[eventType][currentCallbackIndex] = callback;
+	std::lock_guard callbackLock{callbackMutex};
+	callbackMaps[eventType][currentCallbackIndex] = GroupedCallback{callback, threadCallbackGroup};
 	return {eventType, currentCallbackIndex++};
 }
 
@@ -71,10 +88,34 @@ void mtd::EventManager::processEvents()
 		eventQueue.pop();
 
 		const std::type_index eventType{typeid(event)};
+		std::lock_guard callbackLock{callbackMutex};
 		if(callbackMaps.find(eventType) == callbackMaps.cend()) continue;
 
 		const EventCallbackMap& callbacks = callbackMaps.at(eventType);
-		for(const auto& [index, callback]: callbacks)
-			callback(*pEvent);
+		for(const auto& [index, groupedCallback]: callbacks)
+		{
+			if(groupedCallback.groupID == 0 || enabledCallbackGroups.contains(groupedCallback.groupID))
+				groupedCallback.callback(*pEvent);
+		}
 	}
 }
+
+uint64_t mtd::EventManager::createCallbackGroup()
+{
+	std::lock_guard callbackLock{callbackMutex};
+	return currentCallbackGroup++;
+}
+
+void mtd::EventManager::setThreadCallbackGroup(uint64_t groupID)
+{
+	threadCallbackGroup = groupID;
+}
+
+void mtd::EventManager::setCallbackGroupEnabled(uint64_t groupID, bool enabled)
+{
+	std::lock_guard callbackLock{callbackMutex};
+	if(enabled)
+		enabledCallbackGroups.insert(groupID);
+	else
+		enabledCallbackGroups.erase(groupID);
+}
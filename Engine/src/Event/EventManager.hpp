@@ -4,4 +4,11 @@ namespace mtd::EventManager
 {
 	// Executes all callbacks related to the queued (dispatched) events.
 	void processEvents();
+
+	// Creates a group for callbacks, which are skipped by the event processing until the group is enabled
+	uint64_t createCallbackGroup();
+	// Sets the group of the callbacks added from the calling thread (zero for callbacks without a group)
+	void setThreadCallbackGroup(uint64_t groupID);
+	// Enables or disables the callbacks of the group, returning only when none of them is executing
+	void setCallbackGroupEnabled(uint64_t groupID, bool enabled);
 }
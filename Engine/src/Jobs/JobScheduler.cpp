@@ -0,0 +1,235 @@
+#include <pch.hpp>
+#include "JobScheduler.hpp"
+
+#include "../Utils/Logger.hpp"
+#include "../Utils/Profiler.hpp"
+
+// Worker index of the calling thread, valid only for threads owned by the scheduler
+static thread_local const mtd::JobScheduler* pCurrentScheduler = nullptr;
+static thread_local uint32_t currentWorkerIndex = 0U;
+
+mtd::JobScheduler* mtd::JobScheduler::pActiveScheduler = nullptr;
+
+mtd::JobScheduler::JobScheduler(uint32_t workerCount)
+	: queuedJobCount{0U}, nextQueueIndex{0U}, sleepingWorkerCount{0U}, running{true}
+{
+	// The threads waiting for jobs also execute them, so one core is left for the calling thread
+	if(workerCount == 0U)
+		workerCount = std::max(std::thread::hardware_concurrency(), 2U) - 1U;
+
+	queues.reserve(workerCount);
+	for(uint32_t i = 0U; i < workerCount; i++)
+		queues.push_back(std::make_unique<WorkerQueue>());
+
+	workers.reserve(workerCount);
+	for(uint32_t i = 0U; i < workerCount; i++)
+		workers.emplace_back(&JobScheduler::workerLoop, this, i);
+
+	if(!pActiveScheduler)
+		pActiveScheduler = this;
+
+	LOG_INFO("Job system started with %d worker threads.", workerCount);
+}
+
+mtd::JobScheduler::~JobScheduler()
+{
+	if(pActiveScheduler == this)
+		pActiveScheduler = nullptr;
+
+	{
+		std::lock_guard<std::mutex> sleepLock{sleepMutex};
+		running.store(false);
+	}
+	sleepCV.notify_all();
+
+	for(std::thread& worker: workers)
+	{
+		if(worker.joinable())
+			worker.join();
+	}
+}
+
+uint32_t mtd::JobScheduler::getCurrentThreadIndex()
+{
+	return (pCurrentScheduler && pCurrentScheduler == pActiveScheduler) ? currentWorkerIndex + 1U : 0U;
+}
+
+void mtd::JobScheduler::submit(Job job, JobCounter* pCounter)
+{
+	if(pCounter)
+		pCounter->pendingJobs.fetch_add(1U, std::memory_order_relaxed);
+
+	pushJob(QueuedJob{std::move(job), pCounter});
+}
+
+void mtd::JobScheduler::submitAfter(JobCounter& dependency, Job job, JobCounter* pCounter)
+{
+	if(pCounter)
+		pCounter->pendingJobs.fetch_add(1U, std::memory_order_relaxed);
+
+	{
+		std::lock_guard<std::mutex> counterLock{dependency.counterMutex};
+		if(dependency.pendingJobs.load(std::memory_order_acquire) != 0U)
+		{
+			dependency.continuations.push_back(JobCounter::Continuation{std::move(job), pCounter});
+			return;
+		}
+	}
+
+	pushJob(QueuedJob{std::move(job), pCounter});
+}
+
+void mtd::JobScheduler::wait(JobCounter& counter)
+{
+	while(!counter.isDone())
+	{
+		QueuedJob queuedJob;
+		if(popJob(queuedJob, &counter))
+			executeJob(queuedJob);
+		else
+			std::this_thread::yield();
+	}
+
+	// Ensures the thread that finished the last job is no longer using the counter
+	std::lock_guard<std::mutex> counterLock{counter.counterMutex};
+}
+
+void mtd::JobScheduler::workerLoop(uint32_t workerIndex)
+{
+	pCurrentScheduler = this;
+	currentWorkerIndex = workerIndex;
+
+	std::string threadName = "Job worker " + std::to_string(workerIndex);
+	Profiler::setThreadName(threadName.c_str());
+
+	while(true)
+	{
+		QueuedJob queuedJob;
+		if(popJob(queuedJob, nullptr))
+		{
+			executeJob(queuedJob);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> sleepLock{sleepMutex};
+		if(!running.load() && queuedJobCount.load() == 0U) break;
+
+		sleepingWorkerCount++;
+		sleepCV.wait(sleepLock, [this]() { return queuedJobCount.load() > 0U || !running.load(); });
+		sleepingWorkerCount--;
+	}
+}
+
+void mtd::JobScheduler::pushJob(QueuedJob&& queuedJob)
+{
+	uint32_t queueIndex = (pCurrentScheduler == this)
+		? currentWorkerIndex
+		: nextQueueIndex.fetch_add(1U, std::memory_order_relaxed) % queues.size();
+
+	{
+		WorkerQueue& queue = *queues[queueIndex];
+		std::lock_guard<std::mutex> queueLock{queue.queueMutex};
+		queue.jobs.push_back(std::move(queuedJob));
+	}
+	queuedJobCount++;
+
+	if(sleepingWorkerCount.load() > 0U)
+	{
+		{
+			std::lock_guard<std::mutex> sleepLock{sleepMutex};
+		}
+		sleepCV.notify_one();
+	}
+}
+
+bool mtd::JobScheduler::popJob(QueuedJob& queuedJob, const JobCounter* pWaitedCounter)
+{
+	if(queuedJobCount.load(std::memory_order_relaxed) == 0U) return false;
+
+	bool isWorker = (pCurrentScheduler == this);
+	uint32_t firstQueue = isWorker ? currentWorkerIndex : 0U;
+
+	// Workers take their newest job, to reuse warm caches, and steal the oldest jobs from the other queues
+	for(uint32_t i = 0U; i < queues.size(); i++)
+	{
+		WorkerQueue& queue = *queues[(firstQueue + i) % queues.size()];
+		std::lock_guard<std::mutex> queueLock{queue.queueMutex};
+		if(queue.jobs.empty()) continue;
+
+		if(isWorker && i == 0U)
+		{
+			queuedJob = std::move(queue.jobs.back());
+			queue.jobs.pop_back();
+		}
+		else if(isWorker)
+		{
+			queuedJob = std::move(queue.jobs.front());
+			queue.jobs.pop_front();
+		}
+		else
+		{
+			// Other threads share the thread index zero, so they must not run jobs waited by another thread
+			std::deque<QueuedJob>::iterator jobIt = std::ranges::find(queue.jobs, pWaitedCounter, &QueuedJob::pCounter);
+			if(jobIt == queue.jobs.end()) continue;
+
+			queuedJob = std::move(*jobIt);
+			queue.jobs.erase(jobIt);
+		}
+		queuedJobCount--;
+		return true;
+	}
+	return false;
+}
+
+void mtd::JobScheduler::executeJob(QueuedJob& queuedJob)
+{
+	queuedJob.job();
+
+	JobCounter* pCounter = queuedJob.pCounter;
+	if(!pCounter) return;
+
+	std::vector<JobCounter::Continuation> readyContinuations;
+	{
+		std::lock_guard<std::mutex> counterLock{pCounter->counterMutex};
+		if(pCounter->pendingJobs.fetch_sub(1U, std::memory_order_acq_rel) == 1U)
+			readyContinuations.swap(pCounter->continuations);
+	}
+
+	for(JobCounter::Continuation& continuation: readyContinuations)
+		pushJob(QueuedJob{std::move(continuation.job), continuation.pCounter});
+}
+
+uint32_t mtd::JobSystem::getWorkerCount()
+{
+	JobScheduler* pScheduler = JobScheduler::getActiveScheduler();
+	return pScheduler ? pScheduler->getWorkerCount() : 0U;
+}
+
+void mtd::JobSystem::submit(Job job, JobCounter* pCounter)
+{
+	JobScheduler* pScheduler = JobScheduler::getActiveScheduler();
+	if(!pScheduler)
+	{
+		job();
+		return;
+	}
+	pScheduler->submit(std::move(job), pCounter);
+}
+
+void mtd::JobSystem::submitAfter(JobCounter& dependency, Job job, JobCounter* pCounter)
+{
+	JobScheduler* pScheduler = JobScheduler::getActiveScheduler();
+	if(!pScheduler)
+	{
+		job();
+		return;
+	}
+	pScheduler->submitAfter(dependency, std::move(job), pCounter);
+}
+
+void mtd::JobSystem::wait(JobCounter& counter)
+{
+	JobScheduler* pScheduler = JobScheduler::getActiveScheduler();
+	if(pScheduler)
+		pScheduler->wait(counter);
+}
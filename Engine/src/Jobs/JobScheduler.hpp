@@ -0,0 +1,83 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <thread>
+
+#include <meltdown/jobs.hpp>
+
+namespace mtd
+{
+	// Fixed pool of worker threads with per-worker job queues and work stealing
+	class JobScheduler
+	{
+		public:
+			JobScheduler(uint32_t workerCount = 0U);
+			~JobScheduler();
+
+			JobScheduler(const JobScheduler&) = delete;
+			JobScheduler& operator=(const JobScheduler&) = delete;
+
+			// Getter
+			uint32_t getWorkerCount() const { return static_cast<uint32_t>(workers.size()); }
+
+			// Scheduler used by the public job system functions, if any
+			static JobScheduler* getActiveScheduler() { return pActiveScheduler; }
+			// Index of the calling thread among the threads running jobs: the worker index plus one for the workers
+			// of the active scheduler, or zero for any other thread. Other threads only run the jobs of the counter
+			// they wait for, so jobs using the index must be waited by a single thread that is not a worker.
+			static uint32_t getCurrentThreadIndex();
+
+			// Queues a job, tracking it in the counter
+			void submit(Job job, JobCounter* pCounter);
+			// Queues a job once the dependency counter reaches zero
+			void submitAfter(JobCounter& dependency, Job job, JobCounter* pCounter);
+			// Executes queued jobs until the counter reaches zero, only the ones it tracks if not called by a worker
+			void wait(JobCounter& counter);
+
+		private:
+			// Queued job and the counter tracking it
+			struct QueuedJob
+			{
+				Job job;
+				JobCounter* pCounter;
+			};
+
+			// Job queue owned by a worker, from which other threads can steal
+			struct WorkerQueue
+			{
+				std::mutex queueMutex;
+				std::deque<QueuedJob> jobs;
+			};
+
+			// Scheduler used by the public job system functions
+			static JobScheduler* pActiveScheduler;
+
+			// Worker threads and their queues
+			std::vector<std::thread> workers;
+			std::vector<std::unique_ptr<WorkerQueue>> queues;
+
+			// Amount of jobs in all queues, used to put idle workers to sleep
+			std::atomic<uint32_t> queuedJobCount;
+			// Queue chosen for jobs submitted from outside the worker threads
+			std::atomic<uint32_t> nextQueueIndex;
+
+			// Sleep control for idle workers
+			std::mutex sleepMutex;
+			std::condition_variable sleepCV;
+			std::atomic<uint32_t> sleepingWorkerCount;
+			std::atomic<bool> running;
+
+			// Main loop of each worker thread
+			void workerLoop(uint32_t workerIndex);
+
+			// Pushes a job to a queue, waking up a sleeping worker
+			void pushJob(QueuedJob&& queuedJob);
+			// Pops a job from the own queue, or steals one from another queue. Threads that are not workers only
+			// take the jobs tracked by the counter they wait for.
+			bool popJob(QueuedJob& queuedJob, const JobCounter* pWaitedCounter);
+			// Runs a job and decrements its counter, queuing the continuations when it reaches zero
+			void executeJob(QueuedJob& queuedJob);
+	};
+}
@@ -2,17 +2,28 @@
 #include <Meltdown.hpp>
 
 #include "Engine.hpp"
+#include "Utils/Logger.hpp"
 
+static mtd::Engine* pEngine = nullptr;
 static mtd::Camera* pCamera = nullptr;
 
 mtd::MeltdownEngine::MeltdownEngine(const EngineInfo& applicationInfo, Window& window)
-	: engine{std::make_unique<Engine>(applicationInfo, window)}
+	: engine{std::make_unique<Engine>(applicationInfo, &window)}
 {
+	pEngine = engine.get();
+	pCamera = &(engine->getCamera());
+}
+
+mtd::MeltdownEngine::MeltdownEngine(const EngineInfo& applicationInfo)
+	: engine{std::make_unique<Engine>(applicationInfo, nullptr)}
+{
+	pEngine = engine.get();
 	pCamera = &(engine->getCamera());
 }
 
 mtd::MeltdownEngine::~MeltdownEngine()
 {
+	pEngine = nullptr;
 	pCamera = nullptr;
 }
 
@@ -36,11 +47,39 @@ void mtd::MeltdownEngine::run(Window& window, const std::function<void(double)>&
 	engine->run(window, onUpdateCallback);
 }
 
+void mtd::MeltdownEngine::runFrames
+(
+	uint32_t frameCount, double fixedDeltaTime, const std::function<void(double)>& onUpdateCallback
+)
+{
+	engine->runFrames(frameCount, fixedDeltaTime, onUpdateCallback);
+}
+
+bool mtd::MeltdownEngine::readbackFrame(std::vector<uint8_t>& pixels)
+{
+	return engine->readbackFrame(pixels);
+}
+
+bool mtd::MeltdownEngine::saveFrameToPNG(const char* filePath)
+{
+	return engine->saveFrameToPNG(filePath);
+}
+
 void mtd::MeltdownEngine::loadScene(const char* sceneFile)
 {
 	engine->loadScene(sceneFile);
 }
 
+bool mtd::MeltdownEngine::isLoadingScene() const
+{
+	return engine->isLoadingScene();
+}
+
+float mtd::MeltdownEngine::getSceneLoadProgress() const
+{
+	return engine->getSceneLoadProgress();
+}
+
 void mtd::MeltdownEngine::initializeGui(const Window& window)
 {
 	engine->initializeGui(window);
@@ -125,3 +164,96 @@ void mtd::CameraHandler::rotate(const Quaternion& quaternion)
 {
 	pCamera->rotate(quaternion);
 }
+
+bool mtd::SceneInstances::createInstance(const SceneInstanceInfo& instanceInfo, uint32_t& instanceIndex)
+{
+	SceneContext* pSceneContext = pEngine->getActiveScene();
+	if(!pSceneContext) return false;
+
+	Scene& scene = pSceneContext->getScene();
+	if(instanceInfo.meshID >= scene.getMeshes().size())
+	{
+		LOG_WARNING
+		(
+			"Failed to create a scene instance of mesh %d, as the scene has %d meshes.",
+			instanceInfo.meshID, scene.getMeshes().size()
+		);
+		return false;
+	}
+
+	instanceIndex = scene.getInstanceManager().createInstance
+	(
+		SceneInstance
+		{
+			instanceInfo.transform,
+			instanceInfo.pipelineID,
+			instanceInfo.meshID,
+			instanceInfo.materialSetID,
+			instanceInfo.visible
+		}
+	);
+	return true;
+}
+
+void mtd::SceneInstances::deleteInstance(uint32_t instanceIndex)
+{
+	if(SceneContext* pSceneContext = pEngine->getActiveScene())
+		pSceneContext->getScene().getInstanceManager().deleteInstance(instanceIndex);
+}
+
+bool mtd::SceneInstances::getInstance(uint32_t instanceIndex, SceneInstanceInfo& instanceInfo)
+{
+	SceneContext* pSceneContext = pEngine->getActiveScene();
+	if(!pSceneContext) return false;
+
+	SceneInstance instance{Mat4x4{1.0f}, 0U, 0U, 0U};
+	if(!pSceneContext->getScene().getInstanceManager().getInstance(instanceIndex, instance)) return false;
+
+	instanceInfo = SceneInstanceInfo
+	{
+		instance.transform, instance.pipelineID, instance.meshID, instance.materialSetID, instance.visible
+	};
+	return true;
+}
+
+void mtd::SceneInstances::setTransform(uint32_t instanceIndex, const Mat4x4& transform)
+{
+	if(SceneContext* pSceneContext = pEngine->getActiveScene())
+		pSceneContext->getScene().getInstanceManager().setInstanceTransform(instanceIndex, transform);
+}
+
+void mtd::SceneInstances::setVisibility(uint32_t instanceIndex, bool visible)
+{
+	if(SceneContext* pSceneContext = pEngine->getActiveScene())
+		pSceneContext->getScene().getInstanceManager().setInstanceVisibility(instanceIndex, visible);
+}
+
+std::vector<uint32_t> mtd::SpatialQuery::overlapBox(const Vec3& minCorner, const Vec3& maxCorner)
+{
+	std::vector<uint32_t> instanceIndices;
+	if(SceneContext* pSceneContext = pEngine->getActiveScene())
+	{
+		BoundingBox box{{minCorner.x, minCorner.y, minCorner.z}, {maxCorner.x, maxCorner.y, maxCorner.z}};
+		pSceneContext->getRenderObjectManager().overlapBox(box, instanceIndices);
+	}
+	return instanceIndices;
+}
+
+std::vector<uint32_t> mtd::SpatialQuery::overlapSphere(const Vec3& center, float radius)
+{
+	std::vector<uint32_t> instanceIndices;
+	if(SceneContext* pSceneContext = pEngine->getActiveScene())
+		pSceneContext->getRenderObjectManager().overlapSphere(center, radius, instanceIndices);
+	return instanceIndices;
+}
+
+bool mtd::SpatialQuery::raycast(const Vec3& origin, const Vec3& direction, float maxDistance, RaycastHit& hit)
+{
+	SceneContext* pSceneContext = pEngine->getActiveScene();
+	if(!pSceneContext) return false;
+
+	return pSceneContext->getRenderObjectManager().raycast
+	(
+		origin, direction, maxDistance, hit.instanceIndex, hit.distance
+	);
+}
@@ -13,4 +13,21 @@ namespace mtd
 			virtual void start() override {}
 			virtual void update(double deltaTime) override {}
 	};
+
+	// Empty implementation of the ModelBatch class, used when no registered models were found.
+	class EmptyModelBatch : public ModelBatch
+	{
+		public:
+			virtual void addInstances(std::span<Mat4x4> transforms, std::span<uint64_t> instanceIDs) override
+			{
+				for(uint64_t& instanceID: instanceIDs)
+					instanceID = ModelHandler::createInstanceID();
+			}
+			virtual void removeInstance(uint32_t instanceIndex) override {}
+
+			virtual void start(std::span<Mat4x4> transforms, uint32_t firstInstance) override {}
+			virtual void update(std::span<Mat4x4> transforms, uint32_t firstInstance, double deltaTime) override {}
+
+			virtual bool supportsParallelUpdate() const override { return true; }
+	};
 }
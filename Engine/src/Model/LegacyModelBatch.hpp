@@ -0,0 +1,61 @@
+#pragma once
+
+#include <meltdown/model.hpp>
+
+namespace mtd
+{
+	// Model batch for models registered as classes derived from Model, updating each instance separately.
+	// Models may share state between instances, so they are always updated in the calling thread
+	class LegacyModelBatch : public ModelBatch
+	{
+		public:
+			LegacyModelBatch(ModelFactory modelFactory) : modelFactory{std::move(modelFactory)} {}
+			virtual ~LegacyModelBatch() = default;
+
+			// Instantiates a model object for each new instance
+			virtual void addInstances(std::span<Mat4x4> transforms, std::span<uint64_t> instanceIDs) override
+			{
+				models.reserve(models.size() + transforms.size());
+				for(size_t i = 0; i < transforms.size(); i++)
+				{
+					models.push_back(modelFactory(transforms[i]));
+					instanceIDs[i] = models.back()->getInstanceID();
+				}
+			}
+			// Removes a model object by moving the last one to its place
+			virtual void removeInstance(uint32_t instanceIndex) override
+			{
+				if(instanceIndex >= models.size()) return;
+
+				models[instanceIndex] = std::move(models.back());
+				models.pop_back();
+			}
+
+			// Starts the models and fetches their transforms
+			virtual void start(std::span<Mat4x4> transforms, uint32_t firstInstance) override
+			{
+				for(size_t i = 0; i < transforms.size(); i++)
+				{
+					Model& model = *models[firstInstance + i];
+					model.start();
+					transforms[i] = model.getTransform();
+				}
+			}
+			// Updates the models and fetches their transforms
+			virtual void update(std::span<Mat4x4> transforms, uint32_t firstInstance, double deltaTime) override
+			{
+				for(size_t i = 0; i < transforms.size(); i++)
+				{
+					Model& model = *models[firstInstance + i];
+					model.update(deltaTime);
+					transforms[i] = model.getTransform();
+				}
+			}
+
+		private:
+			// Callback to create the model objects
+			ModelFactory modelFactory;
+			// Model objects, in the same order as the transforms
+			std::vector<std::unique_ptr<Model>> models;
+	};
+}
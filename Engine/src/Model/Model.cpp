@@ -2,17 +2,19 @@
 #include <meltdown/model.hpp>
 
 #include "EmptyModel.hpp"
+#include "LegacyModelBatch.hpp"
 
 using ModelInstanceMap = std::unordered_map<uint64_t, mtd::Model*>;
 static ModelInstanceMap modelInstanceRegistry;
 
-static uint64_t nextModelInstanceID = 0;
+static std::atomic<uint64_t> nextModelInstanceID{0};
 
 mtd::ModelFactories mtd::ModelHandler::modelFactoryRegistry;
+mtd::ModelBatchFactories mtd::ModelHandler::modelBatchFactoryRegistry;
 
 // Model
 mtd::Model::Model(const char* modelID, const Mat4x4& preTransform)
-	: transform{preTransform}, instanceID{nextModelInstanceID++}
+	: transform{preTransform}, instanceID{ModelHandler::createInstanceID()}
 {
 	modelInstanceRegistry[instanceID] = this;
 }
@@ -50,6 +52,24 @@ mtd::ModelFactory mtd::ModelHandler::getModelFactory(const std::string& modelID)
 	};
 }
 
+std::unique_ptr<mtd::ModelBatch> mtd::ModelHandler::createModelBatch(const std::string& modelID)
+{
+	ModelBatchFactories::const_iterator batchIterator = modelBatchFactoryRegistry.find(modelID);
+	if(batchIterator != modelBatchFactoryRegistry.end())
+		return batchIterator->second();
+
+	ModelFactories::const_iterator iterator = modelFactoryRegistry.find(modelID);
+	if(iterator != modelFactoryRegistry.end())
+		return std::make_unique<LegacyModelBatch>(iterator->second);
+
+	return std::make_unique<EmptyModelBatch>();
+}
+
+uint64_t mtd::ModelHandler::createInstanceID()
+{
+	return nextModelInstanceID.fetch_add(1, std::memory_order_relaxed);
+}
+
 mtd::Model* mtd::ModelHandler::getModelInstanceByID(uint64_t instanceID)
 {
 	ModelInstanceMap::const_iterator iterator = modelInstanceRegistry.find(instanceID);
@@ -3,28 +3,106 @@
 
 #include "../Utils/Logger.hpp"
 
-void mtd::InstanceManager::createInstance(SceneInstance& newInstance)
+uint32_t mtd::InstanceManager::createInstance(const SceneInstance& newInstance)
 {
-    instances.push_back(newInstance);
-}
+    std::lock_guard<std::mutex> instanceLock{instanceMutex};
 
-void mtd::InstanceManager::deleteInstance(uint32_t instanceIndex)
-{
-    if(instanceIndex < instances.size() - 1)
+    uint32_t instanceIndex;
+    if(freeInstanceIndices.empty())
     {
-        instances[instanceIndex] = std::move(instances.back());
-        instances.pop_back();
+        instanceIndex = static_cast<uint32_t>(instances.size());
+        instances.push_back(newInstance);
+        aliveInstances.push_back(true);
+        changedFlags.push_back(false);
     }
-    else if(instanceIndex == instances.size() - 1)
+    else
     {
-        instances.pop_back();
+        instanceIndex = freeInstanceIndices.back();
+        freeInstanceIndices.pop_back();
+        instances[instanceIndex] = newInstance;
+        aliveInstances[instanceIndex] = true;
     }
+
+    markChanged(instanceIndex);
+    return instanceIndex;
+}
+
+void mtd::InstanceManager::deleteInstance(uint32_t instanceIndex)
+{
+    std::lock_guard<std::mutex> instanceLock{instanceMutex};
+    if(!isInstanceAlive(instanceIndex)) return;
+
+    aliveInstances[instanceIndex] = false;
+    freeInstanceIndices.push_back(instanceIndex);
+    markChanged(instanceIndex);
+}
+
+bool mtd::InstanceManager::getInstance(uint32_t instanceIndex, SceneInstance& instance)
+{
+    std::lock_guard<std::mutex> instanceLock{instanceMutex};
+    if(!isInstanceAlive(instanceIndex)) return false;
+
+    instance = instances[instanceIndex];
+    return true;
+}
+
+void mtd::InstanceManager::setInstanceTransform(uint32_t instanceIndex, const Mat4x4& transform)
+{
+    std::lock_guard<std::mutex> instanceLock{instanceMutex};
+    if(!isInstanceAlive(instanceIndex)) return;
+
+    instances[instanceIndex].transform = transform;
+    markChanged(instanceIndex);
+}
+
+void mtd::InstanceManager::setInstanceVisibility(uint32_t instanceIndex, bool visible)
+{
+    std::lock_guard<std::mutex> instanceLock{instanceMutex};
+    if(!isInstanceAlive(instanceIndex) || instances[instanceIndex].visible == visible) return;
+
+    instances[instanceIndex].visible = visible;
+    markChanged(instanceIndex);
 }
 
 void mtd::InstanceManager::loadInstances(std::vector<SceneInstance>& newInstances)
 {
+    std::lock_guard<std::mutex> instanceLock{instanceMutex};
+
     instances.clear();
     instances = std::move(newInstances);
+    aliveInstances.assign(instances.size(), true);
+    freeInstanceIndices.clear();
+
+    // All loaded instances are reported as changed, so the renderer builds them in the next frame
+    changedFlags.assign(instances.size(), true);
+    changedInstances.resize(instances.size());
+    for(uint32_t i = 0U; i < instances.size(); i++)
+        changedInstances[i] = i;
 
     LOG_INFO("Loaded %d instances.", instances.size());
 }
+
+void mtd::InstanceManager::processChanges(const InstanceChangeCallback& callback)
+{
+    std::lock_guard<std::mutex> instanceLock{instanceMutex};
+
+    for(uint32_t instanceIndex: changedInstances)
+    {
+        callback(instanceIndex, aliveInstances[instanceIndex] ? &(instances[instanceIndex]) : nullptr);
+        changedFlags[instanceIndex] = false;
+    }
+    changedInstances.clear();
+}
+
+bool mtd::InstanceManager::isInstanceAlive(uint32_t instanceIndex) const
+{
+    return instanceIndex < instances.size() && aliveInstances[instanceIndex];
+}
+
+void mtd::InstanceManager::markChanged(uint32_t instanceIndex)
+{
+    if(changedFlags[instanceIndex]) return;
+
+    changedFlags[instanceIndex] = true;
+    changedInstances.push_back(instanceIndex);
+}
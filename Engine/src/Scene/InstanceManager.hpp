@@ -1,5 +1,7 @@
 #pragma once
 
+#include <functional>
+
 #include "../Utils/EngineStructs.hpp"
 
 namespace mtd
@@ -8,25 +10,52 @@ namespace mtd
     class InstanceManager
     {
         public:
+            // Callback receiving the index of a changed instance, and a pointer to it (null if deleted)
+            using InstanceChangeCallback = std::function<void(uint32_t, const SceneInstance*)>;
+
             InstanceManager() = default;
             ~InstanceManager() = default;
 
             InstanceManager(const InstanceManager&) = delete;
             InstanceManager& operator=(const InstanceManager&) = delete;
 
-            // Getter
-            const std::vector<SceneInstance>& getInstances() const { return instances; }
-
-            // Creates a new scene instance
-            void createInstance(SceneInstance& newInstance);
-            // Deletes a scene instance
+            // Creates a new scene instance, returning its index
+            uint32_t createInstance(const SceneInstance& newInstance);
+            // Deletes a scene instance, whose index may be reused by new instances
             void deleteInstance(uint32_t instanceIndex);
 
+            // Copies a scene instance, returning false if the index does not refer to an instance
+            bool getInstance(uint32_t instanceIndex, SceneInstance& instance);
+
+            // Updates the transformation matrix of a scene instance
+            void setInstanceTransform(uint32_t instanceIndex, const Mat4x4& transform);
+            // Shows or hides a scene instance
+            void setInstanceVisibility(uint32_t instanceIndex, bool visible);
+
             // Clears scene instances and loads the initial state of the scene instances
             void loadInstances(std::vector<SceneInstance>& newInstances);
 
+            // Calls the callback for each instance changed since the last call, then clears the changes
+            void processChanges(const InstanceChangeCallback& callback);
+
         private:
             // Buffer containing the data from all instances currently in use by the scene
             std::vector<SceneInstance> instances;
+            // Flags if each instance index is in use
+            std::vector<bool> aliveInstances;
+            // Indices from deleted instances, available for new instances
+            std::vector<uint32_t> freeInstanceIndices;
+
+            // Instances changed since the last processing, and flags to avoid duplicates
+            std::vector<uint32_t> changedInstances;
+            std::vector<bool> changedFlags;
+
+            // Guards the instance data, which may be changed while being processed by the renderer
+            std::mutex instanceMutex;
+
+            // Checks if the index refers to a valid instance
+            bool isInstanceAlive(uint32_t instanceIndex) const;
+            // Flags the instance as changed
+            void markChanged(uint32_t instanceIndex);
     };
 }
@@ -0,0 +1,259 @@
+#include <pch.hpp>
+#include "JsonSceneParser.hpp"
+
+namespace mtd
+{
+	// Fields an instance must define, as bits of the read field mask
+	constexpr uint32_t REQUIRED_INSTANCE_FIELDS = 0b11111U;
+	// Number of progress reports over the expected instances
+	constexpr size_t PROGRESS_REPORT_COUNT = 100UL;
+}
+
+mtd::JsonSceneParser::JsonSceneParser
+(
+	SceneFileData& sceneData, size_t expectedInstanceCount, const SceneReadCallback& progressCallback
+) : sceneData{sceneData},
+	currentInstance{Mat4x4{1.0f}, 0U, 0U, 0U},
+	expectedInstanceCount{expectedInstanceCount},
+	nextProgressReport{expectedInstanceCount / PROGRESS_REPORT_COUNT},
+	progressCallback{progressCallback}
+{
+	sceneData.instances.reserve(expectedInstanceCount);
+}
+
+bool mtd::JsonSceneParser::null()
+{
+	if(instanceDepth > 0U) return true;
+	addSettingsValue(nullptr);
+	return true;
+}
+
+bool mtd::JsonSceneParser::boolean(bool value)
+{
+	if(instanceDepth == 0U)
+	{
+		addSettingsValue(value);
+		return true;
+	}
+
+	if(instanceDepth == 2U && currentField == InstanceField::Visible)
+	{
+		currentInstance.visible = value;
+		readFieldMask |= 1U << static_cast<uint32_t>(InstanceField::Visible);
+	}
+	return true;
+}
+
+bool mtd::JsonSceneParser::number_integer(nlohmann::json::number_integer_t value)
+{
+	if(instanceDepth == 0U)
+	{
+		addSettingsValue(value);
+		return true;
+	}
+	return setInstanceNumber(static_cast<double>(value), static_cast<uint32_t>(value));
+}
+
+bool mtd::JsonSceneParser::number_unsigned(nlohmann::json::number_unsigned_t value)
+{
+	if(instanceDepth == 0U)
+	{
+		addSettingsValue(value);
+		return true;
+	}
+	return setInstanceNumber(static_cast<double>(value), static_cast<uint32_t>(value));
+}
+
+bool mtd::JsonSceneParser::number_float(nlohmann::json::number_float_t value, const nlohmann::json::string_t& text)
+{
+	if(instanceDepth == 0U)
+	{
+		addSettingsValue(value);
+		return true;
+	}
+	return setInstanceNumber(value, static_cast<uint32_t>(value));
+}
+
+bool mtd::JsonSceneParser::string(nlohmann::json::string_t& value)
+{
+	if(instanceDepth > 0U) return true;
+	addSettingsValue(std::move(value));
+	return true;
+}
+
+bool mtd::JsonSceneParser::binary(nlohmann::json::binary_t& value)
+{
+	if(instanceDepth > 0U) return true;
+	addSettingsValue(std::move(value));
+	return true;
+}
+
+bool mtd::JsonSceneParser::start_object(size_t elementCount)
+{
+	if(instanceDepth > 0U)
+	{
+		instanceDepth++;
+		if(instanceDepth == 2U)
+		{
+			currentInstance = SceneInstance{Mat4x4{1.0f}, 0U, 0U, 0U};
+			transformValueCount = 0U;
+			readFieldMask = 0U;
+		}
+		return true;
+	}
+
+	valueStack.push_back(addSettingsValue(nlohmann::json::object()));
+	return true;
+}
+
+bool mtd::JsonSceneParser::key(nlohmann::json::string_t& value)
+{
+	if(instanceDepth > 0U)
+	{
+		if(instanceDepth != 2U) return true;
+
+		if(value == "transform")
+			currentField = InstanceField::Transform;
+		else if(value == "pipeline-id")
+			currentField = InstanceField::PipelineID;
+		else if(value == "mesh-id")
+			currentField = InstanceField::MeshID;
+		else if(value == "material-set-id")
+			currentField = InstanceField::MaterialSetID;
+		else if(value == "visible")
+			currentField = InstanceField::Visible;
+		else
+			currentField = InstanceField::Unknown;
+		return true;
+	}
+
+	// Only the instance array of the root object is streamed
+	instanceKey = (valueStack.size() == 1 && value == "instances");
+	pKeyValue = &(*valueStack.back())[value];
+	return true;
+}
+
+bool mtd::JsonSceneParser::end_object()
+{
+	if(instanceDepth > 0U)
+	{
+		instanceDepth--;
+		return (instanceDepth == 1U) ? finishInstance() : true;
+	}
+
+	valueStack.pop_back();
+	return true;
+}
+
+bool mtd::JsonSceneParser::start_array(size_t elementCount)
+{
+	if(instanceDepth > 0U)
+	{
+		instanceDepth++;
+		return true;
+	}
+	if(instanceKey)
+	{
+		instanceKey = false;
+		instanceDepth = 1U;
+		return true;
+	}
+
+	valueStack.push_back(addSettingsValue(nlohmann::json::array()));
+	return true;
+}
+
+bool mtd::JsonSceneParser::end_array()
+{
+	if(instanceDepth > 0U)
+	{
+		instanceDepth--;
+		return true;
+	}
+
+	valueStack.pop_back();
+	return true;
+}
+
+bool mtd::JsonSceneParser::parse_error
+(
+	size_t position, const std::string& token, const nlohmann::detail::exception& exception
+)
+{
+	error = exception.what();
+	return false;
+}
+
+nlohmann::json* mtd::JsonSceneParser::addSettingsValue(nlohmann::json&& value)
+{
+	instanceKey = false;
+
+	if(valueStack.empty())
+	{
+		sceneData.settings = std::move(value);
+		return &sceneData.settings;
+	}
+
+	nlohmann::json& parent = *valueStack.back();
+	if(parent.is_array())
+	{
+		parent.push_back(std::move(value));
+		return &parent.back();
+	}
+
+	*pKeyValue = std::move(value);
+	return pKeyValue;
+}
+
+bool mtd::JsonSceneParser::setInstanceNumber(double value, uint32_t integerValue)
+{
+	if(instanceDepth == 3U && currentField == InstanceField::Transform)
+	{
+		if(transformValueCount < 16U)
+		{
+			// The matrix is stored column by column, as the transform array
+			currentInstance.transform[transformValueCount / 4U][transformValueCount % 4U] = static_cast<float>(value);
+		}
+		transformValueCount++;
+		return true;
+	}
+	if(instanceDepth != 2U) return true;
+
+	switch(currentField)
+	{
+		case InstanceField::PipelineID:
+			currentInstance.pipelineID = integerValue;
+			break;
+		case InstanceField::MeshID:
+			currentInstance.meshID = integerValue;
+			break;
+		case InstanceField::MaterialSetID:
+			currentInstance.materialSetID = integerValue;
+			break;
+		default:
+			return true;
+	}
+	readFieldMask |= 1U << static_cast<uint32_t>(currentField);
+	return true;
+}
+
+bool mtd::JsonSceneParser::finishInstance()
+{
+	if(transformValueCount == 16U)
+		readFieldMask |= 1U << static_cast<uint32_t>(InstanceField::Transform);
+	if(readFieldMask != REQUIRED_INSTANCE_FIELDS)
+	{
+		error = "instance " + std::to_string(sceneData.instances.size()) + " is missing fields or has an invalid transform";
+		return false;
+	}
+
+	sceneData.instances.push_back(currentInstance);
+
+	if(progressCallback && sceneData.instances.size() >= nextProgressReport && expectedInstanceCount > 0)
+	{
+		float progress = static_cast<float>(sceneData.instances.size()) / static_cast<float>(expectedInstanceCount);
+		progressCallback(std::min(progress, 1.0f));
+		nextProgressReport += std::max<size_t>(expectedInstanceCount / PROGRESS_REPORT_COUNT, 1UL);
+	}
+	return true;
+}
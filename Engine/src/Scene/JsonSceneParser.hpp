@@ -0,0 +1,78 @@
+#pragma once
+
+#include "SceneFile.hpp"
+
+namespace mtd
+{
+	// SAX handler for JSON scenes, streaming the instances to the scene data while building the settings as a DOM
+	class JsonSceneParser
+	{
+		public:
+			JsonSceneParser(SceneFileData& sceneData, size_t expectedInstanceCount, const SceneReadCallback& progressCallback);
+			~JsonSceneParser() = default;
+
+			JsonSceneParser(const JsonSceneParser&) = delete;
+			JsonSceneParser& operator=(const JsonSceneParser&) = delete;
+
+			// Getter
+			const std::string& getError() const { return error; }
+
+			// SAX events
+			bool null();
+			bool boolean(bool value);
+			bool number_integer(nlohmann::json::number_integer_t value);
+			bool number_unsigned(nlohmann::json::number_unsigned_t value);
+			bool number_float(nlohmann::json::number_float_t value, const nlohmann::json::string_t& text);
+			bool string(nlohmann::json::string_t& value);
+			bool binary(nlohmann::json::binary_t& value);
+			bool start_object(size_t elementCount);
+			bool key(nlohmann::json::string_t& value);
+			bool end_object();
+			bool start_array(size_t elementCount);
+			bool end_array();
+			bool parse_error(size_t position, const std::string& token, const nlohmann::detail::exception& exception);
+
+		private:
+			// Instance field receiving the next value
+			enum class InstanceField
+			{
+				Transform,
+				PipelineID,
+				MeshID,
+				MaterialSetID,
+				Visible,
+				Unknown
+			};
+
+			// Output data, whose settings receive every value outside of the instance array
+			SceneFileData& sceneData;
+			// Settings values being built, and the value of the last key read
+			std::vector<nlohmann::json*> valueStack;
+			nlohmann::json* pKeyValue = nullptr;
+
+			// Nesting depth inside the instance array, which is zero outside of it
+			uint32_t instanceDepth = 0U;
+			// Flags if the last settings key read was the instance array
+			bool instanceKey = false;
+			// Instance being read, its field being read and the fields already read
+			SceneInstance currentInstance;
+			InstanceField currentField = InstanceField::Unknown;
+			uint32_t transformValueCount = 0U;
+			uint32_t readFieldMask = 0U;
+
+			// Instance count estimated before parsing, and the count that triggers the next progress report
+			size_t expectedInstanceCount;
+			size_t nextProgressReport;
+			const SceneReadCallback& progressCallback;
+
+			// Reason for stopping the parsing
+			std::string error;
+
+			// Adds a value to the settings, returning a pointer to it
+			nlohmann::json* addSettingsValue(nlohmann::json&& value);
+			// Stores a number in the current instance field
+			bool setInstanceNumber(double value, uint32_t integerValue);
+			// Validates and stores the instance that has been read
+			bool finishInstance();
+	};
+}
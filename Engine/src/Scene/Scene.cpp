@@ -1,6 +1,8 @@
 #include <pch.hpp>
 #include "Scene.hpp"
 
+#include <Meltdown.hpp>
+
 #include "SceneLoader.hpp"
 #include "../Utils/Logger.hpp"
 #include "../Vulkan/Mesh/MeshManager.hpp"
@@ -12,11 +14,13 @@ void mtd::Scene::loadScene
 (
 	const Device& mtdDevice,
 	std::string_view sceneFileName,
+	AssetCache& assetCache,
 	std::vector<FramebufferInfo>& framebufferInfos,
 	PipelineInfoBundle& pipelineInfos,
 	ResourceManager& resourceManager,
 	DescriptorManager& descriptorManager,
-	std::vector<RenderPassInfo>& renderOrder
+	std::vector<RenderPassInfo>& renderOrder,
+	const SceneReadCallback& progressCallback
 )
 {
 	renderOrder.clear();
@@ -32,9 +36,12 @@ void mtd::Scene::loadScene
 		meshManagers,
 		meshes,
 		resourceManager,
+		assetCache,
 		descriptorManager,
 		instanceManager,
-		gpuResources
+		gpuResources,
+		cameraInfo,
+		progressCallback
 	);
 }
 
@@ -119,6 +126,14 @@ void mtd::Scene::bindMeshData(const ResourceManager& resourceManager, vk::Comman
 
 void mtd::Scene::start() const
 {
+	if(cameraInfo.orthographic)
+		EventManager::dispatch<SetOrthographicCameraEvent>(cameraInfo.viewWidth, cameraInfo.farPlane);
+	else
+		EventManager::dispatch<SetPerspectiveCameraEvent>(cameraInfo.fov, cameraInfo.nearPlane, cameraInfo.farPlane);
+
+	CameraHandler::setPosition(cameraInfo.position);
+	CameraHandler::setOrientation(cameraInfo.yaw, cameraInfo.pitch);
+
 	for(const std::unique_ptr<MeshManager>& pMeshManager: meshManagers)
 	{
 		if(pMeshManager->getMeshCount() > 0U)
@@ -127,11 +142,22 @@ void mtd::Scene::start() const
 }
 
 void mtd::Scene::update(double frameTime) const
+{
+	JobCounter updateJobCounter;
+	for(const std::unique_ptr<MeshManager>& pMeshManager: meshManagers)
+	{
+		if(pMeshManager->getMeshCount() > 0U)
+			pMeshManager->update(frameTime, updateJobCounter);
+	}
+	JobSystem::wait(updateJobCounter);
+}
+
+void mtd::Scene::uploadMeshInstances(uint32_t frameIndex, uint32_t frameCount) const
 {
 	for(const std::unique_ptr<MeshManager>& pMeshManager: meshManagers)
 	{
 		if(pMeshManager->getMeshCount() > 0U)
-			pMeshManager->update(frameTime);
+			pMeshManager->uploadInstances(frameIndex, frameCount);
 	}
 }
 
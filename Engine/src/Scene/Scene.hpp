@@ -3,6 +3,7 @@
 #include <memory>
 
 #include "InstanceManager.hpp"
+#include "SceneFile.hpp"
 #include "../Vulkan/Mesh/MeshManager.hpp"
 #include "../Vulkan/Descriptors/DescriptorPool.hpp"
 #include "../Vulkan/Pipeline/PipelineBundles.hpp"
@@ -21,7 +22,7 @@ namespace mtd
 
 			// Getters
 			const std::vector<MeshData>& getMeshes() const { return meshes; }
-			const std::vector<SceneInstance>& getInstances() const { return instanceManager.getInstances(); }
+			InstanceManager& getInstanceManager() { return instanceManager; }
 			const DescriptorPool& getDescriptorPool() const { return descriptorPool; }
 
 			// Setter
@@ -32,11 +33,13 @@ namespace mtd
 			(
 				const Device& mtdDevice,
 				std::string_view sceneFileName,
+				AssetCache& assetCache,
 				std::vector<FramebufferInfo>& framebufferInfos,
 				PipelineInfoBundle& pipelineInfos,
 				ResourceManager& resourceManager,
 				DescriptorManager& descriptorManager,
-				std::vector<RenderPassInfo>& renderOrder
+				std::vector<RenderPassInfo>& renderOrder,
+				const SceneReadCallback& progressCallback = {}
 			);
 
 			// Allocates resources and loads all mesh data
@@ -45,10 +48,12 @@ namespace mtd
 			// Binds the vertex and index buffers
 			void bindMeshData(const ResourceManager& resourceManager, vk::CommandBuffer commandBuffer) const;
 
-			// Executes starting code on scene
+			// Applies the scene camera settings and executes starting code on scene
 			void start() const;
 			// Updates scene data
 			void update(double frameTime) const;
+			// Uploads the mesh instances to the buffers of the frame being recorded
+			void uploadMeshInstances(uint32_t frameIndex, uint32_t frameCount) const;
 
 		private:
 			// Active mesh managers
@@ -62,6 +67,9 @@ namespace mtd
 			// CPU side data for all scene meshes
 			std::vector<MeshData> meshes;
 
+			// Camera settings, applied only when the scene starts, as the scene may load while another is rendered
+			SceneCameraInfo cameraInfo;
+
 			// Descriptor pool for the pipelines descriptor sets
 			DescriptorPool descriptorPool;
 
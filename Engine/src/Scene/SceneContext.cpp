@@ -0,0 +1,147 @@
+#include <pch.hpp>
+#include "SceneContext.hpp"
+
+mtd::SceneContext::SceneContext(const Device& mtdDevice, AssetCache& assetCache, UIntVec2 frameDimensions)
+	: resourceManager{mtdDevice, frameDimensions},
+	descriptorManager{mtdDevice, resourceManager},
+	scene{mtdDevice},
+	gpuCuller{mtdDevice},
+	indirectDrawer{mtdDevice},
+	extent{frameDimensions.x, frameDimensions.y},
+	mtdDevice{mtdDevice},
+	assetCache{assetCache}
+{
+}
+
+void mtd::SceneContext::loadScene(std::string_view sceneFile, const SceneReadCallback& progressCallback)
+{
+	cameraResourceID = resourceManager.createBuffer
+	(
+		"Camera",
+		GpuBufferType::Uniform | GpuBufferType::TransferDestination,
+		GpuMemoryUsage::GpuOnly,
+		sizeof(CameraMatrices)
+	);
+	renderObjectManager.createBuffer(resourceManager);
+
+	scene.loadScene
+	(
+		mtdDevice,
+		sceneFile,
+		assetCache,
+		framebufferInfos,
+		pipelineInfos,
+		resourceManager,
+		descriptorManager,
+		renderOrder,
+		progressCallback
+	);
+	scene.setCameraResourceID(cameraResourceID);
+}
+
+void mtd::SceneContext::createRenderResources(const Swapchain& swapchain)
+{
+	extent = swapchain.getExtent();
+
+	framebuffers.reserve(framebufferInfos.size());
+	for(const FramebufferInfo& framebufferInfo: framebufferInfos)
+		framebuffers.emplace_back(mtdDevice, framebufferInfo, extent);
+
+	pipelines.rasterizationPipelines.reserve(pipelineInfos.rasterizerInfos.size());
+	for(const RasterizationPipelineInfo& rasterizationPipelineInfo: pipelineInfos.rasterizerInfos)
+	{
+		int32_t fbIndex = rasterizationPipelineInfo.targetFramebufferIndex;
+		bool targetSwapchain = (fbIndex == -1);
+
+		pipelines.rasterizationPipelines.emplace_back
+		(
+			mtdDevice.getDevice(),
+			descriptorManager,
+			assetCache,
+			rasterizationPipelineInfo,
+			targetSwapchain ? extent : framebuffers[fbIndex].getExtent(),
+			targetSwapchain ? swapchain.getRenderPass() : framebuffers[fbIndex].getRenderPass()
+		);
+	}
+
+	gpuCuller.create
+	(
+		assetCache,
+		resourceManager,
+		pipelines.rasterizationPipelines,
+		cameraResourceID,
+		renderObjectManager.getBufferID()
+	);
+	if(!gpuCuller.isEnabled())
+		indirectDrawer.create(resourceManager, static_cast<uint32_t>(pipelines.rasterizationPipelines.size()));
+
+	pipelines.framebufferPipelines.reserve(pipelineInfos.framebufferInfos.size());
+	for(const FramebufferPipelineInfo& fbPipelineInfo: pipelineInfos.framebufferInfos)
+	{
+		int32_t fbIndex = fbPipelineInfo.targetFramebufferIndex;
+		bool targetSwapchain = (fbIndex == -1);
+
+		pipelines.framebufferPipelines.emplace_back
+		(
+			mtdDevice.getDevice(),
+			descriptorManager,
+			assetCache,
+			fbPipelineInfo,
+			targetSwapchain ? extent : framebuffers[fbIndex].getExtent(),
+			targetSwapchain ? swapchain.getRenderPass() : framebuffers[fbIndex].getRenderPass()
+		);
+	}
+
+	pipelines.computePipelines.reserve(pipelineInfos.computeInfos.size());
+	for(const ComputePipelineInfo& computePipelineInfo: pipelineInfos.computeInfos)
+		pipelines.computePipelines.emplace_back(mtdDevice, descriptorManager, assetCache, computePipelineInfo, extent);
+
+	if(mtdDevice.isRayTracingEnabled())
+	{
+		pipelines.rayTracingPipelines.reserve(pipelineInfos.rayTracingInfos.size());
+		for(const RayTracingPipelineInfo& rtPipelineInfo: pipelineInfos.rayTracingInfos)
+			pipelines.rayTracingPipelines.emplace_back(mtdDevice, descriptorManager, assetCache, rtPipelineInfo, extent);
+	}
+
+	framebufferInfos.clear();
+	pipelineInfos = PipelineInfoBundle{};
+}
+
+void mtd::SceneContext::configureDescriptors()
+{
+	scene.allocateResources(pipelines);
+
+	for(ComputePipeline& computePipeline: pipelines.computePipelines)
+		computePipeline.configurePipelineDescriptorSet();
+	for(RayTracingPipeline& rtPipeline: pipelines.rayTracingPipelines)
+		rtPipeline.configurePipelineDescriptorSet();
+	for(FramebufferPipeline& fbPipeline: pipelines.framebufferPipelines)
+		fbPipeline.updateInputImagesDescriptors(framebuffers, pipelines.computePipelines, pipelines.rayTracingPipelines);
+}
+
+void mtd::SceneContext::resize(const Swapchain& swapchain)
+{
+	extent = swapchain.getExtent();
+
+	resourceManager.updateWindowResolutionLinkedImages({extent.width, extent.height});
+
+	for(Framebuffer& framebuffer: framebuffers)
+		framebuffer.resize(mtdDevice, extent);
+	for(RasterizationPipeline& rasterizationPipeline: pipelines.rasterizationPipelines)
+	{
+		int32_t fbIndex = rasterizationPipeline.getTargetFramebuffer();
+		if(fbIndex == -1)
+			rasterizationPipeline.recreate(extent, swapchain.getRenderPass());
+		else
+			rasterizationPipeline.recreate(framebuffers[fbIndex].getExtent(), framebuffers[fbIndex].getRenderPass());
+	}
+	for(ComputePipeline& computePipeline: pipelines.computePipelines)
+		computePipeline.resize(mtdDevice, extent);
+	for(RayTracingPipeline& rayTracingPipeline: pipelines.rayTracingPipelines)
+		rayTracingPipeline.resize(mtdDevice, extent);
+	for(FramebufferPipeline& fbPipeline: pipelines.framebufferPipelines)
+	{
+		fbPipeline.recreate(extent, swapchain.getRenderPass());
+		fbPipeline.updateInputImagesDescriptors(framebuffers, pipelines.computePipelines, pipelines.rayTracingPipelines);
+	}
+}
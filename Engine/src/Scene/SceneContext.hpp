@@ -0,0 +1,84 @@
+#pragma once
+
+#include "Scene.hpp"
+#include "../Vulkan/Frame/Framebuffer.hpp"
+#include "../Vulkan/Frame/Swapchain.hpp"
+#include "../Vulkan/Render/GpuCuller.hpp"
+#include "../Vulkan/Render/IndirectDrawer.hpp"
+
+namespace mtd
+{
+	// Every GPU resource, pipeline and render state owned by a loaded scene
+	class SceneContext
+	{
+		public:
+			SceneContext(const Device& mtdDevice, AssetCache& assetCache, UIntVec2 frameDimensions);
+			~SceneContext() = default;
+
+			SceneContext(const SceneContext&) = delete;
+			SceneContext& operator=(const SceneContext&) = delete;
+
+			// Getters
+			Scene& getScene() { return scene; }
+			ResourceManager& getResourceManager() { return resourceManager; }
+			DescriptorManager& getDescriptorManager() { return descriptorManager; }
+			RenderObjectManager& getRenderObjectManager() { return renderObjectManager; }
+			GpuCuller& getGpuCuller() { return gpuCuller; }
+			IndirectDrawer& getIndirectDrawer() { return indirectDrawer; }
+			const std::vector<Framebuffer>& getFramebuffers() const { return framebuffers; }
+			const PipelineBundle& getPipelines() const { return pipelines; }
+			const std::vector<RenderPassInfo>& getRenderOrder() const { return renderOrder; }
+			ResourceID getCameraResourceID() const { return cameraResourceID; }
+			const vk::Extent2D& getExtent() const { return extent; }
+			uint64_t getCallbackGroup() const { return callbackGroup; }
+			uint64_t getMemoryUsage() const { return resourceManager.getMemoryUsage(); }
+
+			// Setter
+			void setCallbackGroup(uint64_t groupID) { callbackGroup = groupID; }
+
+			// Loads the scene file, queuing the uploads of its resources
+			void loadScene(std::string_view sceneFile, const SceneReadCallback& progressCallback);
+			// Creates the framebuffers and pipelines to be used in the scene
+			void createRenderResources(const Swapchain& swapchain);
+			// Allocates the scene descriptors and sets up the pipeline descriptor sets
+			void configureDescriptors();
+
+			// Recreates the resources that depend on the swapchain extent
+			void resize(const Swapchain& swapchain);
+
+		private:
+			// GPU resources and descriptors of the scene
+			ResourceManager resourceManager;
+			DescriptorManager descriptorManager;
+
+			// Framebuffers and all pipelines in use by the scene
+			std::vector<Framebuffer> framebuffers;
+			PipelineBundle pipelines;
+			// Framebuffer and pipeline infos, kept from the scene loading until the pipelines are created
+			std::vector<FramebufferInfo> framebufferInfos;
+			PipelineInfoBundle pipelineInfos;
+
+			// Scene meshes and instances
+			Scene scene;
+			// Render objects of the scene instances
+			RenderObjectManager renderObjectManager;
+			// GPU frustum culling of the render objects, drawing them with indirect calls
+			GpuCuller gpuCuller;
+			// Multi draw indirect calls of the CPU culled render objects, used when the GPU culling is disabled
+			IndirectDrawer indirectDrawer;
+			// Order which the framebuffers will be rendered
+			std::vector<RenderPassInfo> renderOrder;
+
+			// Scene's camera buffer
+			ResourceID cameraResourceID = 0U;
+			// Swapchain extent which the render resources were created for
+			vk::Extent2D extent;
+			// Event callback group of the objects created for the scene
+			uint64_t callbackGroup = 0UL;
+
+			// Device reference
+			const Device& mtdDevice;
+			// Asset cache reference, sharing assets with the other scenes
+			AssetCache& assetCache;
+	};
+}
@@ -0,0 +1,199 @@
+#include <pch.hpp>
+#include "SceneFile.hpp"
+
+#include <algorithm>
+
+#include "JsonSceneParser.hpp"
+#include "../Utils/Logger.hpp"
+#include "../Utils/VirtualFileSystem.hpp"
+
+namespace mtd::SceneFile
+{
+	// The instance table of the binary scenes is copied straight to the scene instances
+	static_assert(std::is_trivially_copyable_v<SceneInstance>, "Scene instances must be copyable as raw memory.");
+	static_assert
+	(
+		sizeof(SceneInstance) == 80 && offsetof(SceneInstance, visible) == 76,
+		"The scene instance layout must match the .mscene instance table."
+	);
+
+	// Parses a JSON scene with SAX events, streaming the instances and moving the resource lists out of the settings
+	static bool readJson
+	(
+		std::string_view filePath,
+		const VirtualFile& sceneFile,
+		SceneFileData& sceneData,
+		const SceneReadCallback& progressCallback
+	);
+	// Validates the blocks of a binary scene, copying the tables from the mapped file
+	static bool readBinary(std::string_view filePath, const VirtualFile& sceneFile, SceneFileData& sceneData);
+
+	// Reads a string table block: the string count, followed by the null terminated strings
+	static bool readStringTable(const std::byte* pBlockData, size_t blockSize, std::vector<std::string>& strings);
+}
+
+bool mtd::SceneFile::read(std::string_view filePath, SceneFileData& sceneData, const SceneReadCallback& progressCallback)
+{
+	VirtualFile sceneFile = VirtualFileSystem::openFile(filePath);
+	if(!sceneFile.isOpen())
+	{
+		LOG_ERROR("Failed to find scene file \"%s\".", filePath.data());
+		return false;
+	}
+
+	uint64_t magic = 0UL;
+	if(sceneFile.getSize() >= sizeof(uint64_t))
+		memcpy(&magic, sceneFile.getData(), sizeof(uint64_t));
+
+	bool validScene = (magic == SCENE_MAGIC)
+		? readBinary(filePath, sceneFile, sceneData)
+		: readJson(filePath, sceneFile, sceneData, progressCallback);
+
+	if(validScene && progressCallback)
+		progressCallback(1.0f);
+	return validScene;
+}
+
+bool mtd::SceneFile::readJson
+(
+	std::string_view filePath,
+	const VirtualFile& sceneFile,
+	SceneFileData& sceneData,
+	const SceneReadCallback& progressCallback
+)
+{
+	const std::string_view sceneText{reinterpret_cast<const char*>(sceneFile.getData()), sceneFile.getSize()};
+
+	// A quick scan for an instance field gives the instance count, so the instances are never reallocated
+	size_t expectedInstanceCount = 0;
+	constexpr std::string_view INSTANCE_FIELD = "\"pipeline-id\"";
+	for(size_t position = sceneText.find(INSTANCE_FIELD); position != std::string_view::npos; expectedInstanceCount++)
+		position = sceneText.find(INSTANCE_FIELD, position + INSTANCE_FIELD.size());
+
+	// The file is parsed straight from the mapping, and the instance array is never built as a JSON value
+	JsonSceneParser sceneParser{sceneData, expectedInstanceCount, progressCallback};
+	if(!nlohmann::json::sax_parse(sceneText.begin(), sceneText.end(), &sceneParser))
+	{
+		LOG_ERROR("Failed to parse JSON scene file \"%s\": %s.", filePath.data(), sceneParser.getError().c_str());
+		return false;
+	}
+
+	nlohmann::json& sceneJson = sceneData.settings;
+	if(!sceneJson.is_object() || sceneJson.value("scene-loader-version", "") != SCENE_JSON_VERSION)
+	{
+		LOG_ERROR("Scene JSON file (\"%s\") version is incompatible with the scene loader.", filePath.data());
+		return false;
+	}
+
+	sceneJson["textures"].get_to(sceneData.texturePaths);
+	sceneJson["materials"].get_to(sceneData.materialPaths);
+	sceneJson["meshes"].get_to(sceneData.meshPaths);
+
+	// Only the settings are kept as JSON
+	sceneJson.erase("textures");
+	sceneJson.erase("materials");
+	sceneJson.erase("meshes");
+	sceneJson.erase("instances");
+
+	return true;
+}
+
+bool mtd::SceneFile::readBinary(std::string_view filePath, const VirtualFile& sceneFile, SceneFileData& sceneData)
+{
+	const std::byte* pFileData = sceneFile.getData();
+	const size_t sceneFileSize = sceneFile.getSize();
+
+	AssetHeader sceneHeader{};
+	if(sceneFileSize >= sizeof(AssetHeader))
+		memcpy(&sceneHeader, pFileData, sizeof(AssetHeader));
+	if(sceneHeader.version != SCENE_FILE_VERSION)
+	{
+		LOG_ERROR("Binary scene file (\"%s\") version is incompatible with the scene loader.", filePath.data());
+		return false;
+	}
+
+	size_t currentOffset = sizeof(AssetHeader);
+	while(currentOffset + sizeof(AssetBlockHeader) <= sceneFileSize)
+	{
+		AssetBlockHeader blockHeader;
+		memcpy(&blockHeader, pFileData + currentOffset, sizeof(AssetBlockHeader));
+		currentOffset += sizeof(AssetBlockHeader);
+
+		if(sceneFileSize - currentOffset < blockHeader.blockSize)
+		{
+			LOG_ERROR("Truncated block in binary scene file \"%s\".", filePath.data());
+			return false;
+		}
+		const std::byte* pBlockData = pFileData + currentOffset;
+		const size_t blockSize = blockHeader.blockSize;
+		currentOffset += blockSize;
+
+		bool validBlock = true;
+		switch(blockHeader.blockID)
+		{
+			case "Settings"_u64:
+			{
+				const uint8_t* pSettingsData = reinterpret_cast<const uint8_t*>(pBlockData);
+				sceneData.settings = nlohmann::json::from_msgpack(pSettingsData, pSettingsData + blockSize, true, false);
+				validBlock = !sceneData.settings.is_discarded() && sceneData.settings.is_object();
+				break;
+			}
+			case "Textures"_u64:
+				validBlock = readStringTable(pBlockData, blockSize, sceneData.texturePaths);
+				break;
+			case "Material"_u64:
+				validBlock = readStringTable(pBlockData, blockSize, sceneData.materialPaths);
+				break;
+			case "Meshes\0\0"_u64:
+				validBlock = readStringTable(pBlockData, blockSize, sceneData.meshPaths);
+				break;
+			case "Instance"_u64:
+				validBlock = (blockSize % sizeof(SceneInstance) == 0);
+				if(!validBlock) break;
+
+				sceneData.instances.assign(blockSize / sizeof(SceneInstance), SceneInstance{Mat4x4{1.0f}, 0U, 0U, 0U});
+				memcpy(sceneData.instances.data(), pBlockData, blockSize);
+				break;
+			default:
+				LOG_WARNING("Unknown block in binary scene file \"%s\". Skipping...", filePath.data());
+				break;
+		}
+
+		if(!validBlock)
+		{
+			LOG_ERROR("Invalid block in binary scene file \"%s\".", filePath.data());
+			return false;
+		}
+	}
+
+	if(!sceneData.settings.is_object())
+	{
+		LOG_ERROR("Binary scene file \"%s\" has no settings block.", filePath.data());
+		return false;
+	}
+
+	return true;
+}
+
+bool mtd::SceneFile::readStringTable(const std::byte* pBlockData, size_t blockSize, std::vector<std::string>& strings)
+{
+	uint32_t stringCount;
+	if(blockSize < sizeof(uint32_t)) return false;
+	memcpy(&stringCount, pBlockData, sizeof(uint32_t));
+
+	const char* pString = reinterpret_cast<const char*>(pBlockData + sizeof(uint32_t));
+	const char* pBlockEnd = reinterpret_cast<const char*>(pBlockData + blockSize);
+
+	strings.clear();
+	strings.reserve(std::min<size_t>(stringCount, blockSize));
+	for(uint32_t i = 0U; i < stringCount; i++)
+	{
+		const char* pTerminator = std::find(pString, pBlockEnd, '\0');
+		if(pTerminator == pBlockEnd) return false;
+
+		strings.emplace_back(pString, pTerminator);
+		pString = pTerminator + 1;
+	}
+
+	return pString == pBlockEnd;
+}
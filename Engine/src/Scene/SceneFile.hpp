@@ -0,0 +1,39 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+#include "../Utils/EngineStructs.hpp"
+#include "../Utils/StringParser.hpp"
+
+namespace mtd
+{
+	// Contents of a scene file, with the large tables kept out of the JSON settings
+	struct SceneFileData
+	{
+		// Camera, GPU resources, descriptors, pipelines and material sets, in the JSON scene layout
+		nlohmann::json settings;
+		// Resource paths, relative to the resources folder
+		std::vector<std::string> texturePaths;
+		std::vector<std::string> materialPaths;
+		std::vector<std::string> meshPaths;
+		// Initial state of the scene instances
+		std::vector<SceneInstance> instances;
+	};
+
+	// Receives the fraction of the scene file that has been read, from 0 to 1
+	using SceneReadCallback = std::function<void(float progress)>;
+
+	// Reads the JSON (.json) and binary (.mscene) scene formats, told apart by the file contents
+	namespace SceneFile
+	{
+		// Magic number and version of the binary scene format
+		constexpr uint64_t SCENE_MAGIC = "MTD_SCNE"_u64;
+		constexpr uint64_t SCENE_FILE_VERSION = 1UL;
+
+		// Version of the JSON scene format
+		constexpr const char* SCENE_JSON_VERSION = "0.2.2";
+
+		// Reads the scene file, choosing the format by its magic number
+		bool read(std::string_view filePath, SceneFileData& sceneData, const SceneReadCallback& progressCallback = {});
+	}
+}
@@ -5,6 +5,7 @@
 
 #include <Meltdown.hpp>
 
+#include "SceneFile.hpp"
 #include "../AssetManager/MeshLoader.hpp"
 #include "../AssetManager/MaterialLoader.hpp"
 #include "../Utils/FileHandler.hpp"
@@ -13,28 +14,28 @@
 
 namespace mtd::SceneLoader
 {
-	static constexpr const char* SCENE_LOADER_VERSION = "0.2.2";
-
 	// Loads initial camera data for the scene
-	static void loadCamera(const nlohmann::json& cameraJson);
+	static void loadCamera(const nlohmann::json& cameraJson, SceneCameraInfo& cameraInfo);
 
 	// Loads the GPU resources from the scene file and allocates them
 	static void loadGpuResources(const nlohmann::json& resourcesInfoJson, ResourceManager& resourceManager);
 
-	// Fetches all material files and material sets from the scene file and loads them
+	// Loads all textures, material files and material sets of the scene
 	static void loadMaterials
 	(
-		const nlohmann::json& texturesJson,
-		const nlohmann::json& materialsJson,
+		const std::vector<std::string>& texturePaths,
+		const std::vector<std::string>& materialPaths,
 		const nlohmann::json& materialSetsJson,
 		ResourceManager& resourceManager,
+		AssetCache& assetCache,
 		SceneResources& sceneResources
 	);
-	// Fetches all mesh files from the scene file and loads them
+	// Loads all mesh files of the scene
 	static void loadMeshes
 	(
-		const nlohmann::json& meshJson,
+		const std::vector<std::string>& meshPaths,
 		ResourceManager& resourceManager,
+		AssetCache& assetCache,
 		SceneResources& sceneResources,
 		std::vector<MeshData>& meshes
 	);
@@ -89,9 +90,6 @@ namespace mtd::SceneLoader
 		const RayTracingPipelineInfo& rtPipelineInfo,
 		std::vector<std::unique_ptr<MeshManager>>& meshManagers
 	);
-
-	// Loads all instances from the scene file
-	static void loadInstances(const nlohmann::json& instancesJson, InstanceManager& instanceManager);
 }
 
 void mtd::SceneLoader::load
@@ -104,32 +102,44 @@ void mtd::SceneLoader::load
 	std::vector<std::unique_ptr<MeshManager>>& meshManagers,
 	std::vector<MeshData>& meshes,
 	ResourceManager& resourceManager,
+	AssetCache& assetCache,
 	DescriptorManager& descriptorManager,
 	InstanceManager& instanceManager,
-	SceneResources& sceneResources
+	SceneResources& sceneResources,
+	SceneCameraInfo& cameraInfo,
+	const SceneReadCallback& progressCallback
 )
 {
 	std::string scenePath{MTD_RESOURCES_PATH};
 	scenePath.append("scenes/");
 	scenePath.append(fileName);
 
-	nlohmann::json sceneJson;
-	if(!FileHandler::readJSON(scenePath.c_str(), sceneJson)) return;
-
-	std::string fileVersion = sceneJson["scene-loader-version"];
-	if(fileVersion.compare(SCENE_LOADER_VERSION))
+	// Large scenes report their reading progress every 10%
+	uint32_t reportedProgress = 0U;
+	auto logProgress = [&reportedProgress, fileName, &progressCallback](float progress)
 	{
-		LOG_ERROR("Scene JSON file (\"%s\") version is incompatible with the scene loader.", fileName.data());
-		return;
-	}
+		if(progressCallback)
+			progressCallback(progress);
+
+		uint32_t percentage = static_cast<uint32_t>(progress * 10.0f) * 10U;
+		if(percentage <= reportedProgress) return;
+
+		reportedProgress = percentage;
+		LOG_VERBOSE("Reading scene \"%s\": %d%%.", fileName.data(), percentage);
+	};
 
-	loadCamera(sceneJson["camera"]);
+	SceneFileData sceneData;
+	if(!SceneFile::read(scenePath, sceneData, logProgress)) return;
+	nlohmann::json& sceneJson = sceneData.settings;
+
+	loadCamera(sceneJson["camera"], cameraInfo);
 	loadGpuResources(sceneJson["gpu-resources"], resourceManager);
 	loadMaterials
 	(
-		sceneJson["textures"], sceneJson["materials"], sceneJson["material-sets"], resourceManager, sceneResources
+		sceneData.texturePaths, sceneData.materialPaths, sceneJson["material-sets"],
+		resourceManager, assetCache, sceneResources
 	);
-	loadMeshes(sceneJson["meshes"], resourceManager, sceneResources, meshes);
+	loadMeshes(sceneData.meshPaths, resourceManager, assetCache, sceneResources, meshes);
 
 	loadDescriptorLayouts(sceneJson["descriptor-layouts"], descriptorManager);
 	loadDescriptorSets(sceneJson["descriptor-sets"], descriptorManager, resourceManager, sceneResources);
@@ -178,27 +188,28 @@ void mtd::SceneLoader::load
 		}
 	}
 
-	loadInstances(sceneJson["instances"], instanceManager);
+	instanceManager.loadInstances(sceneData.instances);
 
 	LOG_INFO("Scene \"%s\" loaded.", fileName.data());
 }
 
-void mtd::SceneLoader::loadCamera(const nlohmann::json& cameraJson)
+void mtd::SceneLoader::loadCamera(const nlohmann::json& cameraJson, SceneCameraInfo& cameraInfo)
 {
-	if(cameraJson["orthographic"])
+	cameraInfo.orthographic = cameraJson["orthographic"];
+	if(cameraInfo.orthographic)
 	{
-		EventManager::dispatch<SetOrthographicCameraEvent>(cameraJson["view-width"], cameraJson["far-plane"]);
+		cameraInfo.viewWidth = cameraJson["view-width"];
 	}
 	else
 	{
-		EventManager::dispatch<SetPerspectiveCameraEvent>
-		(
-			cameraJson["fov"], cameraJson["near-plane"], cameraJson["far-plane"]
-		);
+		cameraInfo.fov = cameraJson["fov"];
+		cameraInfo.nearPlane = cameraJson["near-plane"];
 	}
+	cameraInfo.farPlane = cameraJson["far-plane"];
 
-	CameraHandler::setPosition(Vec3{cameraJson["position"][0], cameraJson["position"][1], cameraJson["position"][2]});
-	CameraHandler::setOrientation(cameraJson["yaw"], cameraJson["pitch"]);
+	cameraInfo.position = Vec3{cameraJson["position"][0], cameraJson["position"][1], cameraJson["position"][2]};
+	cameraInfo.yaw = cameraJson["yaw"];
+	cameraInfo.pitch = cameraJson["pitch"];
 }
 
 void mtd::SceneLoader::loadGpuResources(const nlohmann::json& resourcesInfoJson, ResourceManager& resourceManager)
@@ -238,56 +249,59 @@ void mtd::SceneLoader::loadGpuResources(const nlohmann::json& resourcesInfoJson,
 
 void mtd::SceneLoader::loadMaterials
 (
-	const nlohmann::json& texturesJson,
-	const nlohmann::json& materialsJson,
+	const std::vector<std::string>& texturePaths,
+	const std::vector<std::string>& materialPaths,
 	const nlohmann::json& materialSetsJson,
 	ResourceManager& resourceManager,
+	AssetCache& assetCache,
 	SceneResources& sceneResources
 )
 {
 	std::vector<std::string> textureInfos;
-	textureInfos.reserve(texturesJson.size());
-	for(const std::string& path: texturesJson)
+	textureInfos.reserve(texturePaths.size());
+	for(const std::string& path: texturePaths)
 		textureInfos.emplace_back(MTD_RESOURCES_PATH + path);
 
-	MaterialLoader::loadTextures(resourceManager, textureInfos, sceneResources.textureIDs);
+	MaterialLoader::loadTextures(resourceManager, assetCache, textureInfos, sceneResources.textureIDs);
 
-	std::vector<std::string> materialPaths;
-	materialPaths.reserve(materialsJson.size());
-	for(const std::string& path: materialsJson)
-		materialPaths.emplace_back(MTD_RESOURCES_PATH + path);
+	std::vector<std::string> materialFiles;
+	materialFiles.reserve(materialPaths.size());
+	for(const std::string& path: materialPaths)
+		materialFiles.emplace_back(MTD_RESOURCES_PATH + path);
 
 	std::vector<std::vector<uint32_t>> materialSets;
 	materialSetsJson.get_to(materialSets);
 
 	MaterialLoader::loadMaterials
 	(
-		resourceManager, materialPaths, materialSets,
+		resourceManager, assetCache, materialFiles, materialSets,
 		sceneResources.materialBufferID,
 		sceneResources.materialIndexingBufferID,
 		sceneResources.materialSetBufferID
 	);
 
-	LOG_INFO("Loaded %d textures and %d materials.", textureInfos.size(), materialPaths.size());
+	LOG_INFO("Loaded %d textures and %d materials.", textureInfos.size(), materialFiles.size());
 }
 
 void mtd::SceneLoader::loadMeshes
 (
-	const nlohmann::json& meshJson,
+	const std::vector<std::string>& meshPaths,
 	ResourceManager& resourceManager,
+	AssetCache& assetCache,
 	SceneResources& sceneResources,
 	std::vector<MeshData>& meshes
 )
 {
-	std::vector<std::string> meshPaths;
-	meshPaths.reserve(meshJson.size());
-	for(const std::string& path: meshJson)
-		meshPaths.emplace_back(MTD_RESOURCES_PATH + path);
+	std::vector<std::string> meshFiles;
+	meshFiles.reserve(meshPaths.size());
+	for(const std::string& path: meshPaths)
+		meshFiles.emplace_back(MTD_RESOURCES_PATH + path);
 
 	MeshLoader::loadMeshes
 	(
 		resourceManager,
-		meshPaths,
+		assetCache,
+		meshFiles,
 		meshes,
 		sceneResources.vertexBufferID,
 		sceneResources.indexBufferID,
@@ -407,6 +421,7 @@ void mtd::SceneLoader::loadRasterizationPipelines
 		static_cast<ShaderPrimitiveTopology>(rasterizationPipelineJson["shader-primitive-topology"]),
 		static_cast<ShaderFaceCulling>(rasterizationPipelineJson["shader-face-culling"]),
 		rasterizationPipelineJson["transparency"],
+		rasterizationPipelineJson.value("frustum-culling", true)
 	});
 }
 
@@ -543,21 +558,3 @@ void mtd::SceneLoader::loadRayTracingMeshes
 		pMeshManager->createNewMesh(i, id.c_str(), file.c_str(), *pPreTransforms);
 	}
 }
-
-void mtd::SceneLoader::loadInstances(const nlohmann::json& instancesJson, InstanceManager& instanceManager)
-{
-	std::vector<SceneInstance> instances;
-	instances.reserve(instancesJson.size());
-	for(const nlohmann::json& instance: instancesJson)
-	{
-		uint32_t pipelineID = instance["pipeline-id"];
-		uint32_t meshID = instance["mesh-id"];
-		uint32_t materialSetID = instance["material-set-id"];
-		const std::array<float, 16>& transform = instance["transform"];
-		const Mat4x4* pTransform = reinterpret_cast<const Mat4x4*>(&transform);
-		bool visible = instance["visible"];
-
-		instances.emplace_back(*pTransform, pipelineID, meshID, materialSetID, visible);
-	}
-	instanceManager.loadInstances(instances);
-}
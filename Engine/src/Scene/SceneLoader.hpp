@@ -3,6 +3,8 @@
 #include <memory>
 
 #include "InstanceManager.hpp"
+#include "SceneFile.hpp"
+#include "../AssetManager/AssetCache.hpp"
 #include "../Vulkan/Descriptors/DescriptorManager.hpp"
 #include "../Vulkan/Mesh/MeshManager.hpp"
 #include "../Vulkan/Pipeline/PipelineBundles.hpp"
@@ -21,8 +23,11 @@ namespace mtd::SceneLoader
 		std::vector<std::unique_ptr<MeshManager>>& meshManagers,
 		std::vector<MeshData>& meshes,
 		ResourceManager& resourceManager,
+		AssetCache& assetCache,
 		DescriptorManager& descriptorManager,
 		InstanceManager& instanceManager,
-		SceneResources& sceneResources
+		SceneResources& sceneResources,
+		SceneCameraInfo& cameraInfo,
+		const SceneReadCallback& progressCallback
 	);
 }
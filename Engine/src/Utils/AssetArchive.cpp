@@ -0,0 +1,128 @@
+#include <pch.hpp>
+#include "AssetArchive.hpp"
+
+#include "Logger.hpp"
+#include "StringParser.hpp"
+
+namespace mtd
+{
+	constexpr uint64_t ARCHIVE_MAGIC = "MTD_MPAK"_u64;
+	constexpr uint64_t ARCHIVE_FILE_VERSION = 1UL;
+	constexpr uint64_t ARCHIVE_ENTRY_ALIGNMENT = 4096UL;
+
+	constexpr uint64_t FNV_OFFSET_BASIS = 0xCBF29CE484222325UL;
+	constexpr uint64_t FNV_PRIME = 0x100000001B3UL;
+
+	// Archive file header, followed by the table of contents
+	struct ArchiveHeader : AssetHeader
+	{
+		uint32_t entryCount;
+		uint32_t slotCount;
+		uint64_t tableOffset;
+		uint64_t pathTableOffset;
+		uint64_t pathTableSize;
+	};
+}
+
+mtd::AssetArchive::AssetArchive(std::string_view archivePath)
+	: archiveFile{archivePath, false}
+{
+	if(!archiveFile.isMapped() || !readTableOfContents(archivePath))
+	{
+		slots.clear();
+		return;
+	}
+
+	LOG_INFO("Mounted asset archive \"%s\" with %d entries.", archivePath.data(), entryCount);
+}
+
+uint64_t mtd::AssetArchive::hashPath(std::string_view path)
+{
+	// Byte-wise FNV-1a, matching the cooker archive writer
+	uint64_t hash = FNV_OFFSET_BASIS;
+	for(char character: path)
+		hash = (hash ^ static_cast<uint8_t>(character)) * FNV_PRIME;
+	return hash;
+}
+
+const mtd::ArchiveEntry* mtd::AssetArchive::findEntry(std::string_view relativePath) const
+{
+	if(slots.empty()) return nullptr;
+
+	// Linear probing from the hashed slot, until an empty slot is found
+	const uint64_t pathHash = hashPath(relativePath);
+	const size_t slotMask = slots.size() - 1;
+	for(size_t i = pathHash & slotMask, probeCount = 0; probeCount < slots.size(); i = (i + 1) & slotMask, probeCount++)
+	{
+		const ArchiveEntry& entry = slots[i];
+		if(entry.pathLength == 0U) return nullptr;
+
+		if(entry.pathHash == pathHash && pathTable.substr(entry.pathOffset, entry.pathLength) == relativePath)
+			return &entry;
+	}
+	return nullptr;
+}
+
+bool mtd::AssetArchive::readTableOfContents(std::string_view archivePath)
+{
+	const std::byte* pArchiveData = archiveFile.getData();
+	const uint64_t archiveSize = archiveFile.getSize();
+	if(archiveSize < sizeof(ArchiveHeader))
+	{
+		LOG_WARNING("Invalid header for asset archive \"%s\".", archivePath.data());
+		return false;
+	}
+
+	ArchiveHeader header;
+	memcpy(&header, pArchiveData, sizeof(ArchiveHeader));
+
+	bool validArchive = true;
+	validArchive &= (header.magic == ARCHIVE_MAGIC);
+	validArchive &= (header.version == ARCHIVE_FILE_VERSION);
+	validArchive &= (header.slotCount > 0U && (header.slotCount & (header.slotCount - 1U)) == 0U);
+	validArchive &= (header.entryCount < header.slotCount);
+	validArchive &= (header.tableOffset <= archiveSize);
+	validArchive &= (static_cast<uint64_t>(header.slotCount) * sizeof(ArchiveEntry) <= archiveSize - header.tableOffset);
+	validArchive &= (header.pathTableOffset <= archiveSize && header.pathTableSize <= archiveSize - header.pathTableOffset);
+	if(!validArchive)
+	{
+		LOG_WARNING("Invalid asset archive \"%s\".", archivePath.data());
+		return false;
+	}
+
+	slots.resize(header.slotCount);
+	memcpy(slots.data(), pArchiveData + header.tableOffset, slots.size() * sizeof(ArchiveEntry));
+	pathTable = std::string_view
+	{
+		reinterpret_cast<const char*>(pArchiveData + header.pathTableOffset), header.pathTableSize
+	};
+
+	// Entries pointing out of the archive would be read by the loaders, so the whole archive is rejected
+	uint32_t usedSlotCount = 0U;
+	for(const ArchiveEntry& entry: slots)
+	{
+		if(entry.pathLength == 0U) continue;
+		usedSlotCount++;
+
+		bool validEntry = true;
+		validEntry &= (static_cast<uint64_t>(entry.pathOffset) + entry.pathLength <= pathTable.size());
+		validEntry &= (entry.dataOffset % ARCHIVE_ENTRY_ALIGNMENT == 0UL);
+		validEntry &= (entry.dataOffset <= archiveSize && entry.storedSize <= archiveSize - entry.dataOffset);
+		validEntry &= (entry.compression == ArchiveCompression::None)
+			? (entry.storedSize == entry.size)
+			: (entry.compression == ArchiveCompression::LZ4);
+		if(!validEntry)
+		{
+			LOG_WARNING("Invalid table of contents in asset archive \"%s\".", archivePath.data());
+			return false;
+		}
+	}
+	if(usedSlotCount != header.entryCount)
+	{
+		LOG_WARNING("Invalid entry count in asset archive \"%s\".", archivePath.data());
+		return false;
+	}
+
+	entryCount = header.entryCount;
+	return true;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "EngineStructs.hpp"
+#include "MappedFile.hpp"
+
+namespace mtd
+{
+	// Encoding of the archive entry data
+	enum class ArchiveCompression : uint32_t
+	{
+		None,
+		LZ4
+	};
+
+	// Table of contents slot of an .mpak archive, locating the data of an entry
+	struct ArchiveEntry
+	{
+		uint64_t pathHash;
+		// Entry data location, aligned to 4 KiB from the start of the archive
+		uint64_t dataOffset;
+		uint64_t storedSize;
+		uint64_t size;
+		// Entry path in the path table, relative to the archive root (empty slots have no path)
+		uint32_t pathOffset;
+		uint32_t pathLength;
+		ArchiveCompression compression;
+		uint32_t padding;
+	};
+
+	// Memory mapped .mpak archive, with a hashed table of contents of its entries
+	class AssetArchive
+	{
+		public:
+			AssetArchive(std::string_view archivePath);
+			~AssetArchive() = default;
+
+			AssetArchive(const AssetArchive&) = delete;
+			AssetArchive& operator=(const AssetArchive&) = delete;
+
+			// Getters
+			bool isValid() const { return !slots.empty(); }
+			uint32_t getEntryCount() const { return entryCount; }
+			const std::byte* getEntryData(const ArchiveEntry& entry) const
+			{
+				return archiveFile.getData() + entry.dataOffset;
+			}
+
+			// Hashes an entry path, as done when building the table of contents
+			static uint64_t hashPath(std::string_view path);
+
+			// Finds the entry with the path relative to the archive root, returning null if there is none
+			const ArchiveEntry* findEntry(std::string_view relativePath) const;
+
+		private:
+			// Mapped archive, accessed at the entries requested by the loaders
+			MappedFile archiveFile;
+			// Hash table of the entries, with a power of two slot count
+			std::vector<ArchiveEntry> slots;
+			uint32_t entryCount = 0U;
+			// Paths of the entries, stored in the mapped archive
+			std::string_view pathTable;
+
+			// Validates the header and the table of contents, copying the entry slots
+			bool readTableOfContents(std::string_view archivePath);
+	};
+}
@@ -0,0 +1,161 @@
+#include <pch.hpp>
+#include "Compression.hpp"
+
+#include <meltdown/jobs.hpp>
+
+#include "Logger.hpp"
+
+namespace mtd::Compression
+{
+	// Minimum length of an LZ4 match, added to the match length of the sequence tokens
+	constexpr size_t LZ4_MIN_MATCH = 4;
+
+	// Reads the extra bytes of a literal or match length, stopping at the first byte below 255
+	static bool readLength(const std::byte*& pSource, const std::byte* pSourceEnd, size_t& length);
+}
+
+bool mtd::Compression::decompressLZ4
+(
+	const std::byte* pSource, size_t sourceSize, std::byte* pDestination, size_t destinationSize
+)
+{
+	const std::byte* const pSourceEnd = pSource + sourceSize;
+	std::byte* const pDestinationStart = pDestination;
+	std::byte* const pDestinationEnd = pDestination + destinationSize;
+
+	while(pSource < pSourceEnd)
+	{
+		uint8_t token = static_cast<uint8_t>(*pSource++);
+
+		size_t literalLength = token >> 4;
+		if(literalLength == 15 && !readLength(pSource, pSourceEnd, literalLength)) return false;
+		if(literalLength > static_cast<size_t>(pSourceEnd - pSource)) return false;
+		if(literalLength > static_cast<size_t>(pDestinationEnd - pDestination)) return false;
+
+		if(literalLength > 0)
+			memcpy(pDestination, pSource, literalLength);
+		pSource += literalLength;
+		pDestination += literalLength;
+
+		// The last sequence of a block only has literals
+		if(pSource == pSourceEnd) break;
+
+		if(pSourceEnd - pSource < 2) return false;
+		size_t matchOffset = static_cast<size_t>(pSource[0]) | (static_cast<size_t>(pSource[1]) << 8);
+		pSource += 2;
+		if(matchOffset == 0 || matchOffset > static_cast<size_t>(pDestination - pDestinationStart)) return false;
+
+		size_t matchLength = token & 0x0F;
+		if(matchLength == 15 && !readLength(pSource, pSourceEnd, matchLength)) return false;
+		matchLength += LZ4_MIN_MATCH;
+		if(matchLength > static_cast<size_t>(pDestinationEnd - pDestination)) return false;
+
+		// Matches may overlap the bytes they produce, repeating the last offset bytes
+		const std::byte* pMatch = pDestination - matchOffset;
+		if(matchOffset >= matchLength)
+			memcpy(pDestination, pMatch, matchLength);
+		else
+		{
+			for(size_t i = 0; i < matchLength; i++)
+				pDestination[i] = pMatch[i];
+		}
+		pDestination += matchLength;
+	}
+
+	return pDestination == pDestinationEnd;
+}
+
+bool mtd::Compression::readLength(const std::byte*& pSource, const std::byte* pSourceEnd, size_t& length)
+{
+	uint8_t lengthByte = 255;
+	while(lengthByte == 255)
+	{
+		if(pSource == pSourceEnd) return false;
+		lengthByte = static_cast<uint8_t>(*pSource++);
+		length += lengthByte;
+	}
+	return true;
+}
+
+mtd::EncodedBlock::EncodedBlock(const std::byte* pBlockData, size_t blockSize)
+	: pData{pBlockData}, size{blockSize}, valid{true}
+{
+}
+
+mtd::EncodedBlock::EncodedBlock
+(
+	const std::byte* pBlockData, size_t blockSize, size_t uncompressedSize, uint32_t chunkSize
+) : size{uncompressedSize}, chunkSize{chunkSize}
+{
+	if(chunkSize == 0U) return;
+
+	const size_t chunkCount = (uncompressedSize + chunkSize - 1) / chunkSize;
+	const size_t tableSize = chunkCount * sizeof(uint32_t);
+	if(tableSize > blockSize) return;
+
+	chunkOffsets.resize(chunkCount + 1);
+	chunkOffsets[0] = 0UL;
+	for(size_t i = 0; i < chunkCount; i++)
+	{
+		uint32_t storedChunkSize;
+		memcpy(&storedChunkSize, pBlockData + i * sizeof(uint32_t), sizeof(uint32_t));
+		chunkOffsets[i + 1] = chunkOffsets[i] + storedChunkSize;
+	}
+
+	// Empty blocks keep a chunk table, so they still count as compressed
+	pData = pBlockData + tableSize;
+	valid = (chunkOffsets.back() == blockSize - tableSize);
+}
+
+bool mtd::EncodedBlock::decode(std::byte* pDestination, size_t decodeSize) const
+{
+	if(!valid || decodeSize > size) return false;
+	if(decodeSize == 0) return true;
+	if(!isCompressed())
+	{
+		memcpy(pDestination, pData, decodeSize);
+		return true;
+	}
+
+	// Chunks cover the whole block, so the chunks past the decoded size are skipped and the last one is cut
+	const uint32_t chunkCount = static_cast<uint32_t>((decodeSize + chunkSize - 1) / chunkSize);
+	std::atomic<bool> decoded = true;
+	JobSystem::parallelFor(0U, chunkCount, 1U, [&](uint32_t begin, uint32_t end)
+	{
+		std::vector<std::byte> lastChunk;
+		for(uint32_t i = begin; i < end; i++)
+		{
+			const size_t chunkStart = static_cast<size_t>(i) * chunkSize;
+			const size_t uncompressedChunkSize = std::min<size_t>(chunkSize, size - chunkStart);
+			const size_t storedChunkSize = chunkOffsets[i + 1] - chunkOffsets[i];
+			const std::byte* pChunkData = pData + chunkOffsets[i];
+
+			std::byte* pChunkDestination = pDestination + chunkStart;
+			if(chunkStart + uncompressedChunkSize > decodeSize)
+			{
+				lastChunk.resize(uncompressedChunkSize);
+				pChunkDestination = lastChunk.data();
+			}
+
+			bool chunkDecoded = true;
+			if(storedChunkSize == uncompressedChunkSize)
+				memcpy(pChunkDestination, pChunkData, uncompressedChunkSize);
+			else
+			{
+				chunkDecoded = Compression::decompressLZ4
+				(
+					pChunkData, storedChunkSize, pChunkDestination, uncompressedChunkSize
+				);
+			}
+
+			if(!chunkDecoded)
+				decoded.store(false);
+			else if(pChunkDestination == lastChunk.data())
+				memcpy(pDestination + chunkStart, lastChunk.data(), decodeSize - chunkStart);
+		}
+	});
+
+	if(!decoded.load())
+		LOG_WARNING("Failed to decompress an asset block of %d bytes.", size);
+	return decoded.load();
+}
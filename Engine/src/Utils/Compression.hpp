@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace mtd
+{
+	// Decoders for the compressed asset data
+	namespace Compression
+	{
+		// Decodes an LZ4 block, which must expand to exactly the destination size.
+		// Returns false for malformed blocks, without reading or writing out of the given ranges.
+		bool decompressLZ4(const std::byte* pSource, size_t sourceSize, std::byte* pDestination, size_t destinationSize);
+	}
+
+	// Asset block data, either raw or split in chunks that are LZ4 compressed independently.
+	// Chunked blocks start with the stored size of each chunk, and chunks stored at full size are raw.
+	class EncodedBlock
+	{
+		public:
+			EncodedBlock() = default;
+			// Raw block
+			EncodedBlock(const std::byte* pBlockData, size_t blockSize);
+			// Chunked block, validating the chunk size table
+			EncodedBlock(const std::byte* pBlockData, size_t blockSize, size_t uncompressedSize, uint32_t chunkSize);
+			~EncodedBlock() = default;
+
+			// Getters
+			bool isValid() const { return valid; }
+			bool isCompressed() const { return !chunkOffsets.empty(); }
+			size_t getSize() const { return size; }
+			// Raw data, valid only for uncompressed blocks
+			const std::byte* getRawData() const { return pData; }
+
+			// Decodes the first bytes of the block to the destination, decompressing the chunks in parallel
+			bool decode(std::byte* pDestination, size_t decodeSize) const;
+
+		private:
+			// Block data, after the chunk size table if chunked
+			const std::byte* pData = nullptr;
+			size_t size = 0;
+			bool valid = false;
+
+			// Uncompressed chunk size, and the offsets of the stored chunks (with the end offset)
+			uint32_t chunkSize = 0U;
+			std::vector<uint64_t> chunkOffsets;
+	};
+}
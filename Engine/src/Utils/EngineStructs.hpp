@@ -69,6 +69,22 @@ namespace mtd
 		uint64_t blockSize;
 	};
 
+	// Storage format of the asset block data
+	enum class BlockEncoding : uint32_t
+	{
+		Raw,
+		ChunkedLZ4
+	};
+
+	// Block header for version 2 asset files, where the block size is the stored (possibly compressed) size
+	struct EncodedBlockHeader : AssetBlockHeader
+	{
+		uint64_t uncompressedSize;
+		BlockEncoding encoding;
+		// Uncompressed size of each chunk, except the last one
+		uint32_t chunkSize;
+	};
+
 	// Scene instance data
 	struct SceneInstance
 	{
@@ -100,6 +116,8 @@ namespace mtd
 		uint32_t meshID;
 		uint32_t firstInstance;
 		uint32_t instanceCount;
+		// Instances that passed the CPU frustum culling, placed at the beginning of the batch
+		uint32_t visibleInstanceCount = 0U;
 	};
 
 	// Vertex format
@@ -166,6 +184,19 @@ namespace mtd
 		std::vector<ResourceID> textureIDs = {};
 	};
 
+	// Initial camera settings of a scene, applied when the scene starts
+	struct SceneCameraInfo
+	{
+		bool orthographic = false;
+		float fov = 0.0f;
+		float viewWidth = 0.0f;
+		float nearPlane = 0.0f;
+		float farPlane = 0.0f;
+		Vec3 position = Vec3{0.0f};
+		float yaw = 0.0f;
+		float pitch = 0.0f;
+	};
+
 	// Descriptor set layout binding data
 	struct DescriptorLayoutBindingData
 	{
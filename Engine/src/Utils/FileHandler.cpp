@@ -2,23 +2,22 @@
 #include "FileHandler.hpp"
 
 #include <stb_image.h>
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
 
 #include "Logger.hpp"
 
 bool mtd::FileHandler::readFile(std::string_view filePath, std::vector<char>& fileData)
 {
-	std::ifstream file{filePath.data(), std::ios::binary | std::ios::ate};
-	if(!file)
+	VirtualFile file = VirtualFileSystem::openFile(filePath);
+	if(!file.isOpen())
 	{
-		LOG_ERROR("File \"%s\" was not found.", filePath);
+		LOG_ERROR("File \"%s\" was not found.", filePath.data());
 		return false;
 	}
 
-	fileData.resize(file.tellg());
-	file.seekg(0, std::ios::beg);
-
-	file.read(fileData.data(), fileData.size());
-	file.close();
+	fileData.resize(file.getSize());
+	memcpy(fileData.data(), file.getData(), file.getSize());
 
 	return true;
 }
@@ -43,29 +42,83 @@ bool mtd::FileHandler::readJSON(std::string_view filePath, nlohmann::json& json)
 	return true;
 }
 
-void* mtd::FileHandler::readImage(std::string_view path, UIntVec2& dimensions, uint32_t& channels)
+bool mtd::FileHandler::readImageInfo(std::string_view path, UIntVec2& dimensions, uint32_t& channels)
+{
+	return readImageInfo(VirtualFileSystem::openFile(path), dimensions, channels);
+}
+
+bool mtd::FileHandler::readImageInfo(const VirtualFile& imageFile, UIntVec2& dimensions, uint32_t& channels)
 {
 	int w, h, c;
 
-	if(!stbi_info(path.data(), &w, &h, &c))
+	if
+	(
+		!imageFile.isOpen() || !stbi_info_from_memory
+		(
+			reinterpret_cast<const stbi_uc*>(imageFile.getData()), static_cast<int>(imageFile.getSize()), &w, &h, &c
+		)
+	)
 	{
-		LOG_ERROR("Failed to find valid image file: \"%s\".", path.data());
-		return nullptr;
+		LOG_ERROR("Failed to find valid image file: \"%s\".", imageFile.getPath().c_str());
+		return false;
 	}
 
-	int desiredChannels = c;
-	if(c == 3) desiredChannels = 4;
+	// RGB images are expanded to RGBA, as most GPUs do not support sampling 3-channel formats
+	dimensions = {static_cast<uint32_t>(w), static_cast<uint32_t>(h)};
+	channels = (c == 3) ? 4U : static_cast<uint32_t>(c);
+
+	return true;
+}
+
+void* mtd::FileHandler::readImage(std::string_view path, UIntVec2& dimensions, uint32_t& channels)
+{
+	return readImage(VirtualFileSystem::openFile(path), dimensions, channels);
+}
+
+void* mtd::FileHandler::readImage(const VirtualFile& imageFile, UIntVec2& dimensions, uint32_t& channels)
+{
+	if(!readImageInfo(imageFile, dimensions, channels))
+		return nullptr;
 
-	stbi_set_flip_vertically_on_load(true);
-	stbi_uc* pixels = stbi_load(path.data(), &w, &h, &c, desiredChannels);
+	int w, h, c;
+
+	// Images may be decoded by multiple threads at once
+	stbi_set_flip_vertically_on_load_thread(true);
+	stbi_uc* pixels = stbi_load_from_memory
+	(
+		reinterpret_cast<const stbi_uc*>(imageFile.getData()),
+		static_cast<int>(imageFile.getSize()),
+		&w, &h, &c,
+		static_cast<int>(channels)
+	);
 	if(!pixels)
 	{
-		LOG_ERROR("Failed to load image file: \"%s\".", path.data());
+		LOG_ERROR("Failed to load image file: \"%s\".", imageFile.getPath().c_str());
 		return nullptr;
 	}
 
 	dimensions = {static_cast<uint32_t>(w), static_cast<uint32_t>(h)};
-	channels = static_cast<uint32_t>(desiredChannels);
 
 	return pixels;
 }
+
+bool mtd::FileHandler::writePNG(std::string_view path, UIntVec2 dimensions, uint32_t channels, const void* pixels)
+{
+	int result = stbi_write_png
+	(
+		path.data(),
+		static_cast<int>(dimensions.x),
+		static_cast<int>(dimensions.y),
+		static_cast<int>(channels),
+		pixels,
+		static_cast<int>(dimensions.x * channels)
+	);
+	if(result == 0)
+	{
+		LOG_ERROR("Failed to write PNG image file: \"%s\".", path.data());
+		return false;
+	}
+
+	LOG_VERBOSE("Saved PNG image: \"%s\".", path.data());
+	return true;
+}
@@ -4,11 +4,13 @@
 
 #include <meltdown/math.hpp>
 
+#include "VirtualFileSystem.hpp"
+
 #ifndef MTD_RESOURCES_PATH
 	#define MTD_RESOURCES_PATH "./resources/"
 #endif
 
-// Handles file manipulation
+// Handles file manipulation, reading the files through the virtual file system
 namespace mtd::FileHandler
 {
 	// Reads file data in the specified path
@@ -17,6 +19,13 @@ namespace mtd::FileHandler
 	// Reads a file and return its content as a JSON
 	bool readJSON(std::string_view filePath, nlohmann::json& json);
 
+	// Reads only the image file header, getting the dimensions and channels the decoded image will have
+	bool readImageInfo(std::string_view path, UIntVec2& dimensions, uint32_t& channels);
+	bool readImageInfo(const VirtualFile& imageFile, UIntVec2& dimensions, uint32_t& channels);
 	// Reads an image file and returns the pointer data or a `nullptr` if it fails
 	void* readImage(std::string_view path, UIntVec2& dimensions, uint32_t& channels);
+	void* readImage(const VirtualFile& imageFile, UIntVec2& dimensions, uint32_t& channels);
+
+	// Writes 8-bit per channel pixel data to a PNG image file
+	bool writePNG(std::string_view path, UIntVec2 dimensions, uint32_t channels, const void* pixels);
 }
@@ -0,0 +1,116 @@
+#include <pch.hpp>
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#define NOMINMAX
+	#include <windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+#include "Logger.hpp"
+
+mtd::MappedFile::MappedFile(std::string_view filePath, bool sequentialAccess)
+{
+	const std::string path{filePath};
+
+	#ifdef _WIN32
+		HANDLE file = CreateFileA
+		(
+			path.c_str(),
+			GENERIC_READ,
+			FILE_SHARE_READ,
+			nullptr,
+			OPEN_EXISTING,
+			sequentialAccess ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS,
+			nullptr
+		);
+		if(file == INVALID_HANDLE_VALUE) return;
+		fileHandle = file;
+
+		LARGE_INTEGER fileSize;
+		if(!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0)
+		{
+			unmap();
+			return;
+		}
+		size = static_cast<size_t>(fileSize.QuadPart);
+
+		mappingHandle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if(mappingHandle)
+			pData = static_cast<const std::byte*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+	#else
+		int file = open(path.c_str(), O_RDONLY);
+		if(file < 0) return;
+
+		struct stat fileStatus;
+		if(fstat(file, &fileStatus) == 0 && fileStatus.st_size > 0)
+		{
+			size = static_cast<size_t>(fileStatus.st_size);
+			void* pMapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+			if(pMapping != MAP_FAILED)
+			{
+				madvise(pMapping, size, sequentialAccess ? MADV_SEQUENTIAL : MADV_RANDOM);
+				pData = static_cast<const std::byte*>(pMapping);
+			}
+		}
+		// The mapping stays valid after the descriptor is closed
+		close(file);
+	#endif
+
+	if(!pData)
+	{
+		LOG_WARNING("Failed to map file \"%s\".", path.c_str());
+		unmap();
+	}
+}
+
+mtd::MappedFile::~MappedFile()
+{
+	unmap();
+}
+
+mtd::MappedFile::MappedFile(MappedFile&& other) noexcept
+	: pData{other.pData}, size{other.size}, fileHandle{other.fileHandle}, mappingHandle{other.mappingHandle}
+{
+	other.pData = nullptr;
+	other.size = 0;
+	other.fileHandle = nullptr;
+	other.mappingHandle = nullptr;
+}
+
+mtd::MappedFile& mtd::MappedFile::operator=(MappedFile&& other) noexcept
+{
+	if(this == &other) return *this;
+
+	unmap();
+	std::swap(pData, other.pData);
+	std::swap(size, other.size);
+	std::swap(fileHandle, other.fileHandle);
+	std::swap(mappingHandle, other.mappingHandle);
+	return *this;
+}
+
+void mtd::MappedFile::unmap()
+{
+	#ifdef _WIN32
+		if(pData)
+			UnmapViewOfFile(pData);
+		if(mappingHandle)
+			CloseHandle(mappingHandle);
+		if(fileHandle)
+			CloseHandle(fileHandle);
+	#else
+		if(pData)
+			munmap(const_cast<std::byte*>(pData), size);
+	#endif
+
+	pData = nullptr;
+	size = 0;
+	fileHandle = nullptr;
+	mappingHandle = nullptr;
+}
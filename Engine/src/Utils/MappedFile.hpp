@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+
+namespace mtd
+{
+	// Read-only memory mapping of a whole file, letting the OS page the data in on demand
+	class MappedFile
+	{
+		public:
+			MappedFile() = default;
+			// Maps the file, hinting the OS to read ahead if it is read front to back
+			MappedFile(std::string_view filePath, bool sequentialAccess = true);
+			~MappedFile();
+
+			MappedFile(const MappedFile&) = delete;
+			MappedFile& operator=(const MappedFile&) = delete;
+			MappedFile(MappedFile&& other) noexcept;
+			MappedFile& operator=(MappedFile&& other) noexcept;
+
+			// Getters
+			bool isMapped() const { return pData != nullptr; }
+			const std::byte* getData() const { return pData; }
+			size_t getSize() const { return size; }
+
+		private:
+			// Mapped file contents
+			const std::byte* pData = nullptr;
+			size_t size = 0;
+
+			// OS handles of the mapping
+			void* fileHandle = nullptr;
+			void* mappingHandle = nullptr;
+
+			// Releases the mapping and its handles
+			void unmap();
+	};
+}
@@ -1,35 +1,298 @@
 #include <pch.hpp>
 #include "Profiler.hpp"
 
-#include <Meltdown.hpp>
+#include <algorithm>
+#include <cstring>
+
+#include "Logger.hpp"
+
+// Events kept for each thread, before the oldest ones start being overwritten
+#define PROFILER_EVENT_CAPACITY 16384U
+// Frames kept in the frame history
+#define PROFILER_FRAME_HISTORY_SIZE 240U
+// Maximum nesting of zones in a single thread
+#define PROFILER_MAX_ZONE_DEPTH 64U
+// Maximum length of the event names, including the null terminator
+#define PROFILER_EVENT_NAME_SIZE 48U
 
 using ChronoClock = std::chrono::steady_clock;
 using ChronoTime = ChronoClock::time_point;
 using ChronoDuration = std::chrono::duration<float, std::milli>;
+using ChronoMicroseconds = std::chrono::duration<double, std::micro>;
+
+// Measured interval of a zone or a frame stage
+struct ProfilerEvent
+{
+	char name[PROFILER_EVENT_NAME_SIZE];
+	ChronoTime startTime;
+	ChronoTime endTime;
+};
+
+// Zone started but not yet ended
+struct OpenZone
+{
+	const char* name;
+	ChronoTime startTime;
+	bool recorded;
+};
+
+// Ring buffer of events written only by its owner thread, without locking
+struct ThreadEventBuffer
+{
+	// Thread identification, guarded by the registry mutex
+	uint32_t threadID;
+	std::string threadName;
+	bool inUse;
+
+	// Total events written, the last PROFILER_EVENT_CAPACITY of which are still stored
+	std::atomic<uint64_t> writeCount;
+	std::array<ProfilerEvent, PROFILER_EVENT_CAPACITY> events;
+
+	// Zones currently open in the owner thread
+	std::array<OpenZone, PROFILER_MAX_ZONE_DEPTH> openZones;
+	uint32_t zoneDepth;
+};
+
+// Releases the thread buffer for reuse when the owner thread exits
+struct ThreadBufferHandle
+{
+	ThreadEventBuffer* pBuffer = nullptr;
+
+	~ThreadBufferHandle();
+};
+
+static std::atomic<bool> profilerEnabled{true};
+static const ChronoTime profilerEpoch = ChronoClock::now();
+
+static std::mutex registryMutex;
+static std::vector<std::unique_ptr<ThreadEventBuffer>> threadBuffers;
+static thread_local ThreadBufferHandle threadBufferHandle;
 
 static ChronoTime initialFrameTime;
 static ChronoTime lastStageTime;
 static const char* lastStage;
 static mtd::Profiler::FrameData currentFrameData;
-static mtd::Profiler::FrameData profiledData;
+static std::array<mtd::Profiler::FrameData, PROFILER_FRAME_HISTORY_SIZE> frameHistory;
+static uint32_t frameHistoryCount = 0U;
+static uint32_t lastHistoryIndex = 0U;
+
+ThreadBufferHandle::~ThreadBufferHandle()
+{
+	if(!pBuffer) return;
+
+	std::lock_guard<std::mutex> registryLock{registryMutex};
+	pBuffer->inUse = false;
+}
+
+// Gets the event buffer of the calling thread, registering it in the first call
+static ThreadEventBuffer& getThreadBuffer()
+{
+	if(threadBufferHandle.pBuffer)
+		return *threadBufferHandle.pBuffer;
+
+	std::lock_guard<std::mutex> registryLock{registryMutex};
+
+	// Buffers from finished threads are recycled, discarding their events
+	ThreadEventBuffer* pBuffer = nullptr;
+	for(const std::unique_ptr<ThreadEventBuffer>& threadBuffer: threadBuffers)
+	{
+		if(threadBuffer->inUse) continue;
+
+		pBuffer = threadBuffer.get();
+		pBuffer->writeCount.store(0U, std::memory_order_relaxed);
+		break;
+	}
+	if(!pBuffer)
+	{
+		pBuffer = threadBuffers.emplace_back(std::make_unique<ThreadEventBuffer>()).get();
+		pBuffer->threadID = static_cast<uint32_t>(threadBuffers.size());
+		pBuffer->writeCount.store(0U, std::memory_order_relaxed);
+	}
+
+	pBuffer->threadName = "Thread " + std::to_string(pBuffer->threadID);
+	pBuffer->inUse = true;
+	pBuffer->zoneDepth = 0U;
+
+	threadBufferHandle.pBuffer = pBuffer;
+	return *pBuffer;
+}
+
+// Appends an event to the thread buffer, overwriting the oldest event if full
+static void recordEvent(ThreadEventBuffer& buffer, const char* name, ChronoTime startTime, ChronoTime endTime)
+{
+	uint64_t writeIndex = buffer.writeCount.load(std::memory_order_relaxed);
+	ProfilerEvent& event = buffer.events[writeIndex % PROFILER_EVENT_CAPACITY];
+
+	std::strncpy(event.name, name, PROFILER_EVENT_NAME_SIZE - 1U);
+	event.name[PROFILER_EVENT_NAME_SIZE - 1U] = '\0';
+	event.startTime = startTime;
+	event.endTime = endTime;
+
+	buffer.writeCount.store(writeIndex + 1U, std::memory_order_release);
+}
+
+// Copies the stored events of a thread, discarding the ones overwritten while copying
+static void copyEvents(const ThreadEventBuffer& buffer, std::vector<ProfilerEvent>& events)
+{
+	uint64_t endIndex = buffer.writeCount.load(std::memory_order_acquire);
+	uint64_t beginIndex = (endIndex > PROFILER_EVENT_CAPACITY) ? endIndex - PROFILER_EVENT_CAPACITY : 0U;
+
+	events.clear();
+	events.reserve(endIndex - beginIndex);
+	for(uint64_t index = beginIndex; index < endIndex; index++)
+		events.push_back(buffer.events[index % PROFILER_EVENT_CAPACITY]);
+
+	// While writing the next event, not counted yet, the writer is already overwriting its slot
+	std::atomic_thread_fence(std::memory_order_acquire);
+	uint64_t overwrittenCount = buffer.writeCount.load(std::memory_order_relaxed) - beginIndex;
+	if(overwrittenCount >= PROFILER_EVENT_CAPACITY)
+	{
+		uint64_t discardCount = std::min<uint64_t>(overwrittenCount - PROFILER_EVENT_CAPACITY + 1U, events.size());
+		events.erase(events.begin(), events.begin() + discardCount);
+	}
+}
+
+// Writes a string to the JSON file, escaping special characters
+static void writeJsonString(std::ofstream& file, std::string_view text)
+{
+	file << '"';
+	for(char character: text)
+	{
+		if(character == '"' || character == '\\')
+			file << '\\' << character;
+		else if(static_cast<unsigned char>(character) < 0x20U)
+			file << ' ';
+		else
+			file << character;
+	}
+	file << '"';
+}
 
 const mtd::Profiler::FrameData& mtd::Profiler::getProfiledData()
 {
-	return profiledData;
+	return frameHistory[lastHistoryIndex];
+}
+
+std::vector<mtd::Profiler::FrameData> mtd::Profiler::getFrameHistory()
+{
+	std::vector<FrameData> history;
+	history.reserve(frameHistoryCount);
+
+	uint32_t oldestIndex = (lastHistoryIndex + PROFILER_FRAME_HISTORY_SIZE + 1U - frameHistoryCount);
+	for(uint32_t i = 0U; i < frameHistoryCount; i++)
+		history.push_back(frameHistory[(oldestIndex + i) % PROFILER_FRAME_HISTORY_SIZE]);
+
+	return history;
+}
+
+void mtd::Profiler::setEnabled(bool enable)
+{
+	profilerEnabled.store(enable, std::memory_order_relaxed);
+}
+
+void mtd::Profiler::beginZone(const char* name)
+{
+	ThreadEventBuffer& buffer = getThreadBuffer();
+	uint32_t depth = buffer.zoneDepth++;
+	if(depth >= PROFILER_MAX_ZONE_DEPTH) return;
+
+	OpenZone& zone = buffer.openZones[depth];
+	zone.name = name;
+	zone.recorded = profilerEnabled.load(std::memory_order_relaxed);
+	if(zone.recorded)
+		zone.startTime = ChronoClock::now();
+}
+
+void mtd::Profiler::endZone()
+{
+	ThreadEventBuffer& buffer = getThreadBuffer();
+	if(buffer.zoneDepth == 0U)
+	{
+		LOG_WARNING("Profiler zone ended without being started.");
+		return;
+	}
+
+	uint32_t depth = --buffer.zoneDepth;
+	if(depth >= PROFILER_MAX_ZONE_DEPTH) return;
+
+	const OpenZone& zone = buffer.openZones[depth];
+	if(zone.recorded)
+		recordEvent(buffer, zone.name, zone.startTime, ChronoClock::now());
+}
+
+bool mtd::Profiler::exportChromeTrace(const char* filePath)
+{
+	std::ofstream file{filePath};
+	if(!file)
+	{
+		LOG_ERROR("Failed to open \"%s\" to export the profiler trace.", filePath);
+		return false;
+	}
+
+	file << std::fixed << std::setprecision(3);
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	bool firstEvent = true;
+	std::vector<ProfilerEvent> events;
+
+	std::lock_guard<std::mutex> registryLock{registryMutex};
+	for(const std::unique_ptr<ThreadEventBuffer>& threadBuffer: threadBuffers)
+	{
+		copyEvents(*threadBuffer, events);
+		if(events.empty()) continue;
+
+		file << (firstEvent ? "\n" : ",\n");
+		file << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << threadBuffer->threadID;
+		file << ",\"args\":{\"name\":";
+		writeJsonString(file, threadBuffer->threadName);
+		file << "}}";
+		firstEvent = false;
+
+		for(const ProfilerEvent& event: events)
+		{
+			ChronoMicroseconds timestamp = event.startTime - profilerEpoch;
+			ChronoMicroseconds duration = event.endTime - event.startTime;
+
+			file << ",\n{\"ph\":\"X\",\"name\":";
+			writeJsonString(file, event.name);
+			file << ",\"pid\":1,\"tid\":" << threadBuffer->threadID;
+			file << ",\"ts\":" << timestamp.count() << ",\"dur\":" << duration.count() << '}';
+		}
+	}
+
+	file << "\n]}\n";
+	if(!file)
+	{
+		LOG_ERROR("Failed to write the profiler trace to \"%s\".", filePath);
+		return false;
+	}
+
+	LOG_INFO("Profiler trace exported to \"%s\".", filePath);
+	return true;
 }
 
 void mtd::Profiler::startFrame(const char* initialStage)
 {
+	if(!profilerEnabled.load(std::memory_order_relaxed))
+	{
+		lastStage = nullptr;
+		return;
+	}
+
 	lastStage = initialStage;
 	lastStageTime = ChronoClock::now();
 	initialFrameTime = lastStageTime;
+	currentFrameData.drawCallCount = 0U;
 }
 
 void mtd::Profiler::nextStage(const char* stage)
 {
+	if(!lastStage) return;
+
 	ChronoTime currentTime = ChronoClock::now();
 	ChronoDuration duration = currentTime - lastStageTime;
 	currentFrameData.stageTimes[lastStage] = duration.count();
+	recordEvent(getThreadBuffer(), lastStage, lastStageTime, currentTime);
 
 	lastStage = stage;
 	lastStageTime = currentTime;
@@ -37,6 +300,8 @@ void mtd::Profiler::nextStage(const char* stage)
 
 void mtd::Profiler::endFrame()
 {
+	if(!lastStage) return;
+
 	ChronoTime currentTime = ChronoClock::now();
 	ChronoDuration duration = currentTime - lastStageTime;
 	currentFrameData.stageTimes[lastStage] = duration.count();
@@ -44,12 +309,38 @@ void mtd::Profiler::endFrame()
 	ChronoDuration frameDuration = currentTime - initialFrameTime;
 	currentFrameData.totalFrameTime = frameDuration.count();
 
-	profiledData = currentFrameData;
+	ThreadEventBuffer& buffer = getThreadBuffer();
+	recordEvent(buffer, lastStage, lastStageTime, currentTime);
+	recordEvent(buffer, "Frame", initialFrameTime, currentTime);
+
+	lastHistoryIndex = (frameHistoryCount == 0U) ? 0U : (lastHistoryIndex + 1U) % PROFILER_FRAME_HISTORY_SIZE;
+	frameHistory[lastHistoryIndex] = currentFrameData;
+	frameHistoryCount = std::min(frameHistoryCount + 1U, PROFILER_FRAME_HISTORY_SIZE);
+
 	lastStage = nullptr;
 }
 
+void mtd::Profiler::addDrawCalls(uint32_t drawCallCount)
+{
+	if(!lastStage) return;
+
+	currentFrameData.drawCallCount += drawCallCount;
+}
+
 void mtd::Profiler::clearStages()
 {
 	currentFrameData.stageTimes.clear();
-	profiledData.stageTimes.clear();
+	for(FrameData& frameData: frameHistory)
+		frameData = FrameData{};
+
+	frameHistoryCount = 0U;
+	lastHistoryIndex = 0U;
+}
+
+void mtd::Profiler::setThreadName(const char* threadName)
+{
+	ThreadEventBuffer& buffer = getThreadBuffer();
+
+	std::lock_guard<std::mutex> registryLock{registryMutex};
+	buffer.threadName = threadName;
 }
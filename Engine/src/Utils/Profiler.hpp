@@ -1,5 +1,7 @@
 #pragma once
 
+#include <Meltdown.hpp>
+
 // Gathers real-time performance information
 namespace mtd::Profiler
 {
@@ -9,17 +11,21 @@ namespace mtd::Profiler
 	void nextStage(const char* stage);
 	// Ends the last frame stage and also calculates the total frame duration
 	void endFrame();
+	// Adds to the amount of draw calls recorded in the current frame
+	void addDrawCalls(uint32_t drawCallCount);
 
-	// Clears the unordered map of frame stages
+	// Clears the unordered map of frame stages and the frame history
 	void clearStages();
+
+	// Sets the name used to identify the calling thread in the exported trace
+	void setThreadName(const char* threadName);
 }
 
-#ifdef MTD_DEBUG
-	#define PROFILER_START_FRAME(initialStage) Profiler::startFrame(initialStage)
-	#define PROFILER_NEXT_STAGE(stage) Profiler::nextStage(stage)
-	#define PROFILER_END_FRAME() Profiler::endFrame()
-#else
-	#define PROFILER_START_FRAME(stage)
-	#define PROFILER_NEXT_STAGE(stage)
-	#define PROFILER_END_FRAME()
-#endif
+#define PROFILER_CONCAT_IMPL(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_IMPL(a, b)
+
+#define PROFILER_START_FRAME(initialStage) Profiler::startFrame(initialStage)
+#define PROFILER_NEXT_STAGE(stage) Profiler::nextStage(stage)
+#define PROFILER_END_FRAME() Profiler::endFrame()
+#define PROFILER_ADD_DRAW_CALLS(drawCallCount) Profiler::addDrawCalls(drawCallCount)
+#define PROFILER_ZONE(name) Profiler::ScopedZone PROFILER_CONCAT(profilerZone, __LINE__){name}
@@ -0,0 +1,130 @@
+#include <pch.hpp>
+#include "VirtualFileSystem.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <shared_mutex>
+
+#include "Compression.hpp"
+#include "Logger.hpp"
+
+namespace mtd::VirtualFileSystem
+{
+	// Archive resolving the paths inside its mount folder
+	struct MountedArchive
+	{
+		std::string mountPath;
+		std::shared_ptr<const AssetArchive> pArchive;
+	};
+
+	static std::vector<MountedArchive> mountedArchives;
+	// Guards the mounted archives, as files are opened by the job system workers
+	static std::shared_mutex mountMutex;
+
+	// Converts a path to the generic format used by the archive entries
+	static std::string normalizePath(std::string_view path);
+}
+
+mtd::VirtualFile::VirtualFile(std::string_view filePath, MappedFile looseFile)
+	: path{filePath}, looseFile{std::move(looseFile)}
+{
+	pData = this->looseFile.getData();
+	size = this->looseFile.getSize();
+}
+
+mtd::VirtualFile::VirtualFile
+(
+	std::string_view filePath, std::shared_ptr<const AssetArchive> pArchive, const ArchiveEntry& entry
+) : path{filePath}, pArchive{std::move(pArchive)}
+{
+	const std::byte* pStoredData = this->pArchive->getEntryData(entry);
+	if(entry.compression == ArchiveCompression::None)
+	{
+		pData = pStoredData;
+		size = entry.size;
+		return;
+	}
+
+	decompressedData.resize(entry.size);
+	if(!Compression::decompressLZ4(pStoredData, entry.storedSize, decompressedData.data(), decompressedData.size()))
+	{
+		LOG_WARNING("Failed to decompress archived file \"%s\".", path.c_str());
+		decompressedData.clear();
+		return;
+	}
+	pData = decompressedData.data();
+	size = decompressedData.size();
+}
+
+uint32_t mtd::VirtualFileSystem::mountArchives(std::string_view folderPath)
+{
+	std::vector<std::filesystem::path> archivePaths;
+	std::error_code errorCode;
+	for(const std::filesystem::directory_entry& entry: std::filesystem::directory_iterator{folderPath, errorCode})
+	{
+		if(entry.is_regular_file() && entry.path().extension() == ".mpak")
+			archivePaths.push_back(entry.path());
+	}
+	std::ranges::sort(archivePaths);
+
+	uint32_t mountedCount = 0U;
+	for(const std::filesystem::path& archivePath: archivePaths)
+		mountedCount += mountArchive(archivePath.string(), folderPath) ? 1U : 0U;
+	return mountedCount;
+}
+
+bool mtd::VirtualFileSystem::mountArchive(std::string_view archivePath, std::string_view mountPath)
+{
+	std::shared_ptr<const AssetArchive> pArchive = std::make_shared<AssetArchive>(archivePath);
+	if(!pArchive->isValid())
+	{
+		LOG_WARNING("Asset archive \"%s\" was not mounted.", archivePath.data());
+		return false;
+	}
+
+	std::string normalizedMountPath = normalizePath(mountPath);
+	if(!normalizedMountPath.empty() && normalizedMountPath.back() != '/')
+		normalizedMountPath.push_back('/');
+
+	std::unique_lock lock{mountMutex};
+	mountedArchives.push_back(MountedArchive{std::move(normalizedMountPath), std::move(pArchive)});
+	return true;
+}
+
+void mtd::VirtualFileSystem::unmountArchives()
+{
+	std::unique_lock lock{mountMutex};
+	mountedArchives.clear();
+}
+
+mtd::VirtualFile mtd::VirtualFileSystem::openFile(std::string_view filePath)
+{
+	{
+		std::shared_lock lock{mountMutex};
+		if(!mountedArchives.empty())
+		{
+			const std::string normalizedPath = normalizePath(filePath);
+			for(auto archiveIterator = mountedArchives.rbegin(); archiveIterator != mountedArchives.rend(); archiveIterator++)
+			{
+				const std::string& mountPath = archiveIterator->mountPath;
+				if(!normalizedPath.starts_with(mountPath)) continue;
+
+				std::string_view relativePath{normalizedPath};
+				relativePath.remove_prefix(mountPath.size());
+				const ArchiveEntry* pEntry = archiveIterator->pArchive->findEntry(relativePath);
+				if(pEntry)
+					return VirtualFile{filePath, archiveIterator->pArchive, *pEntry};
+			}
+		}
+	}
+
+	// Loose files are used during development, before the assets are packed
+	return VirtualFile{filePath, MappedFile{filePath}};
+}
+
+std::string mtd::VirtualFileSystem::normalizePath(std::string_view path)
+{
+	std::string genericPath{path};
+	std::ranges::replace(genericPath, '\\', '/');
+	return std::filesystem::path{genericPath}.lexically_normal().generic_string();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "AssetArchive.hpp"
+
+namespace mtd
+{
+	// File opened through the virtual file system, reading an archive entry or a loose file
+	class VirtualFile
+	{
+		public:
+			VirtualFile() = default;
+			// Opens a loose file from the file system
+			VirtualFile(std::string_view filePath, MappedFile looseFile);
+			// Opens an archive entry, decompressing it if needed
+			VirtualFile(std::string_view filePath, std::shared_ptr<const AssetArchive> pArchive, const ArchiveEntry& entry);
+			~VirtualFile() = default;
+
+			VirtualFile(const VirtualFile&) = delete;
+			VirtualFile& operator=(const VirtualFile&) = delete;
+			VirtualFile(VirtualFile&&) noexcept = default;
+			VirtualFile& operator=(VirtualFile&&) noexcept = default;
+
+			// Getters
+			bool isOpen() const { return pData != nullptr; }
+			bool isArchived() const { return pArchive != nullptr; }
+			const std::byte* getData() const { return pData; }
+			size_t getSize() const { return size; }
+			const std::string& getPath() const { return path; }
+
+		private:
+			// Path requested by the loader
+			std::string path;
+			// File contents, pointing to the archive mapping, the decompressed data or the loose file mapping
+			const std::byte* pData = nullptr;
+			size_t size = 0;
+
+			// Archive holding the entry, kept mapped while the file is open
+			std::shared_ptr<const AssetArchive> pArchive;
+			std::vector<std::byte> decompressedData;
+			MappedFile looseFile;
+	};
+
+	// Resolves the asset files from the mounted archives, falling back to the loose files
+	namespace VirtualFileSystem
+	{
+		// Mounts every .mpak archive in the folder, in name order, for the files inside the folder
+		uint32_t mountArchives(std::string_view folderPath);
+		// Mounts an archive for the files inside the mount folder, taking precedence over the archives mounted before
+		bool mountArchive(std::string_view archivePath, std::string_view mountPath);
+		// Unmounts all archives, which stay mapped until their open files are closed
+		void unmountArchives();
+
+		// Opens a file from the last mounted archive holding it, or from the file system if no archive does
+		VirtualFile openFile(std::string_view filePath);
+	}
+}
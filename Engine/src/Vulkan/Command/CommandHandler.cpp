@@ -1,6 +1,7 @@
 #include <pch.hpp>
 #include "CommandHandler.hpp"
 
+#include "../../Jobs/JobScheduler.hpp"
 #include "../../Utils/Logger.hpp"
 
 mtd::CommandHandler::CommandHandler(const Device& mtdDevice) : mtdDevice{mtdDevice}
@@ -22,16 +23,20 @@ mtd::CommandHandler::CommandHandler(const Device& mtdDevice) : mtdDevice{mtdDevi
 
 mtd::CommandHandler::~CommandHandler()
 {
+	for(ThreadCommands& commands: threadCommands)
+		mtdDevice.getDevice().destroyCommandPool(commands.commandPool);
 	mtdDevice.getDevice().destroyCommandPool(commandPool);
 }
 
 mtd::CommandHandler::CommandHandler(CommandHandler&& other) noexcept
 	: mtdDevice{other.mtdDevice},
 	commandPool{std::move(other.commandPool)},
-	mainCommandBuffer{std::move(other.mainCommandBuffer)}
+	mainCommandBuffer{std::move(other.mainCommandBuffer)},
+	threadCommands{std::move(other.threadCommands)}
 {
 	other.commandPool = nullptr;
 	other.mainCommandBuffer = nullptr;
+	other.threadCommands.clear();
 }
 
 void mtd::CommandHandler::allocateCommandBuffer(vk::CommandBuffer& commandBuffer) const
@@ -75,17 +80,41 @@ void mtd::CommandHandler::endSingleTimeCommand(const vk::CommandBuffer& commandB
 	submitInfo.signalSemaphoreCount = 0U;
 	submitInfo.pSignalSemaphores = nullptr;
 
-	vk::Result result = mtdDevice.getGraphicsQueue().submit(1U, &submitInfo, nullptr);
+	// Waits only for this submission, instead of every frame in flight on the graphics queue
+	vk::Fence fence;
+	vk::FenceCreateInfo fenceCreateInfo{};
+	vk::Result result = mtdDevice.getDevice().createFence(&fenceCreateInfo, nullptr, &fence);
+	if(result != vk::Result::eSuccess)
+		LOG_ERROR("Failed to create single time command fence. Vulkan result: %d", result);
+
+	{
+		std::lock_guard<std::mutex> queueLock{mtdDevice.getQueueMutex()};
+		result = mtdDevice.getGraphicsQueue().submit(1U, &submitInfo, fence);
+	}
 	if(result != vk::Result::eSuccess)
 		LOG_ERROR("Failed to submit command buffer. Vulkan result: %d", result);
 
-	mtdDevice.getGraphicsQueue().waitIdle();
+	result = mtdDevice.getDevice().waitForFences(1U, &fence, vk::True, UINT64_MAX);
+	if(result != vk::Result::eSuccess)
+		LOG_ERROR("Failed to wait for the single time command. Vulkan result: %d", result);
 
+	mtdDevice.getDevice().destroyFence(fence);
 	mtdDevice.getDevice().freeCommandBuffers(commandPool, 1U, &commandBuffer);
 }
 
 void mtd::CommandHandler::beginCommand() const
 {
+	// The previous recording of this handler has finished executing, so its secondary command buffers can be reused
+	createThreadCommandPools();
+	recordingThreadID = std::this_thread::get_id();
+	for(ThreadCommands& commands: threadCommands)
+	{
+		if(commands.usedCount == 0U) continue;
+
+		mtdDevice.getDevice().resetCommandPool(commands.commandPool, vk::CommandPoolResetFlags());
+		commands.usedCount = 0U;
+	}
+
 	mainCommandBuffer.reset();
 
 	vk::CommandBufferBeginInfo commandBufferBeginInfo{};
@@ -97,6 +126,45 @@ void mtd::CommandHandler::beginCommand() const
 		LOG_ERROR("Failed to begin command buffer. Vulkan result: %d", result);
 }
 
+vk::CommandBuffer mtd::CommandHandler::beginSecondaryCommand
+(
+	const vk::CommandBufferInheritanceInfo& inheritanceInfo
+) const
+{
+	uint32_t threadIndex = JobScheduler::getCurrentThreadIndex();
+	assert
+	(
+		(threadIndex != 0U || std::this_thread::get_id() == recordingThreadID)
+		&& "Secondary command buffers must be begun by a worker thread or by the recording thread."
+	);
+
+	ThreadCommands& commands = threadCommands[threadIndex];
+	if(commands.usedCount == commands.commandBuffers.size())
+	{
+		vk::CommandBufferAllocateInfo commandBufferAllocateInfo{};
+		commandBufferAllocateInfo.commandPool = commands.commandPool;
+		commandBufferAllocateInfo.level = vk::CommandBufferLevel::eSecondary;
+		commandBufferAllocateInfo.commandBufferCount = 1U;
+
+		vk::CommandBuffer& commandBuffer = commands.commandBuffers.emplace_back();
+		vk::Result result = mtdDevice.getDevice().allocateCommandBuffers(&commandBufferAllocateInfo, &commandBuffer);
+		if(result != vk::Result::eSuccess)
+			LOG_ERROR("Failed to allocate secondary command buffer. Vulkan result: %d", result);
+	}
+	vk::CommandBuffer commandBuffer = commands.commandBuffers[commands.usedCount++];
+
+	vk::CommandBufferBeginInfo commandBufferBeginInfo{};
+	commandBufferBeginInfo.flags =
+		vk::CommandBufferUsageFlagBits::eOneTimeSubmit | vk::CommandBufferUsageFlagBits::eRenderPassContinue;
+	commandBufferBeginInfo.pInheritanceInfo = &inheritanceInfo;
+
+	vk::Result result = commandBuffer.begin(&commandBufferBeginInfo);
+	if(result != vk::Result::eSuccess)
+		LOG_ERROR("Failed to begin secondary command buffer. Vulkan result: %d", result);
+
+	return commandBuffer;
+}
+
 void mtd::CommandHandler::endCommand() const
 {
 	mainCommandBuffer.end();
@@ -114,7 +182,49 @@ void mtd::CommandHandler::submitDrawCommandBuffer(const SynchronizationBundle& s
 	submitInfo.signalSemaphoreCount = 1U;
 	submitInfo.pSignalSemaphores = &(syncBundle.renderFinished);
 
+	std::lock_guard<std::mutex> queueLock{mtdDevice.getQueueMutex()};
 	vk::Result result = mtdDevice.getGraphicsQueue().submit(1U, &submitInfo, syncBundle.inFlightFence);
 	if(result != vk::Result::eSuccess)
 		LOG_ERROR("Failed to submit draw command to the GPU. Vulkan result: %d", result);
 }
+
+void mtd::CommandHandler::submitOffscreenDrawCommandBuffer(const SynchronizationBundle& syncBundle) const
+{
+	vk::SubmitInfo submitInfo{};
+	submitInfo.waitSemaphoreCount = 0U;
+	submitInfo.pWaitSemaphores = nullptr;
+	submitInfo.pWaitDstStageMask = nullptr;
+	submitInfo.commandBufferCount = 1U;
+	submitInfo.pCommandBuffers = &mainCommandBuffer;
+	submitInfo.signalSemaphoreCount = 0U;
+	submitInfo.pSignalSemaphores = nullptr;
+
+	std::lock_guard<std::mutex> queueLock{mtdDevice.getQueueMutex()};
+	vk::Result result = mtdDevice.getGraphicsQueue().submit(1U, &submitInfo, syncBundle.inFlightFence);
+	if(result != vk::Result::eSuccess)
+		LOG_ERROR("Failed to submit offscreen draw command to the GPU. Vulkan result: %d", result);
+}
+
+void mtd::CommandHandler::createThreadCommandPools() const
+{
+	// Every worker thread may record, besides the thread waiting for them
+	const uint32_t threadCount = JobSystem::getWorkerCount() + 1U;
+	if(threadCommands.size() >= threadCount) return;
+
+	vk::CommandPoolCreateInfo commandPoolCreateInfo{};
+	commandPoolCreateInfo.flags = vk::CommandPoolCreateFlags() | vk::CommandPoolCreateFlagBits::eTransient;
+	commandPoolCreateInfo.queueFamilyIndex = mtdDevice.getQueueFamilies().getGraphicsFamilyIndex();
+
+	threadCommands.reserve(threadCount);
+	while(threadCommands.size() < threadCount)
+	{
+		ThreadCommands& commands = threadCommands.emplace_back();
+		commands.usedCount = 0U;
+
+		vk::Result result =
+			mtdDevice.getDevice().createCommandPool(&commandPoolCreateInfo, nullptr, &commands.commandPool);
+		if(result != vk::Result::eSuccess)
+			LOG_ERROR("Failed to create job thread command pool. Vulkan result: %d", result);
+	}
+	LOG_VERBOSE("Created command pools for %d job threads.", threadCount);
+}
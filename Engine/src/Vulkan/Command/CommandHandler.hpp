@@ -28,21 +28,41 @@ namespace mtd
 			// Submits and finalizes the single time command
 			void endSingleTimeCommand(const vk::CommandBuffer& commandBuffer) const;
 
-			// Begins the main command buffer
+			// Begins the main command buffer, resetting the secondary command buffers of the previous recording
 			void beginCommand() const;
+			// Begins a secondary command buffer continuing a render pass, from the pool of the calling job thread.
+			// Must be called by a worker thread or by the thread that began the main command buffer.
+			vk::CommandBuffer beginSecondaryCommand(const vk::CommandBufferInheritanceInfo& inheritanceInfo) const;
 			// Ends the main command buffer
 			void endCommand() const;
 
 			// Submits recorded draw command
 			void submitDrawCommandBuffer(const SynchronizationBundle& syncBundle) const;
+			// Submits recorded draw command without swapchain synchronization (headless rendering)
+			void submitOffscreenDrawCommandBuffer(const SynchronizationBundle& syncBundle) const;
 
 		private:
+			// Command pool and secondary command buffers used by a single job thread, padded against false sharing
+			struct alignas(64) ThreadCommands
+			{
+				vk::CommandPool commandPool;
+				std::vector<vk::CommandBuffer> commandBuffers;
+				uint32_t usedCount;
+			};
+
 			// Command buffer allocator
 			vk::CommandPool commandPool;
 			// Main command buffer for the handler
 			vk::CommandBuffer mainCommandBuffer;
+			// Secondary command buffers of each job thread, created when the main command buffer begins
+			mutable std::vector<ThreadCommands> threadCommands;
+			// Thread recording the main command buffer, the only one outside the job system using the secondaries
+			mutable std::thread::id recordingThreadID;
 
 			// Device reference
 			const Device& mtdDevice;
+
+			// Creates the command pools of the job threads missing one
+			void createThreadCommandPools() const;
 	};
 }
@@ -24,3 +24,22 @@ void mtd::Synchronization::createSemaphore(const vk::Device& device, vk::Semapho
 	if(result != vk::Result::eSuccess)
 		LOG_ERROR("Failed to create semaphore. Vulkan result: %d", result);
 }
+
+// Creates a Vulkan timeline semaphore
+void mtd::Synchronization::createTimelineSemaphore
+(
+	const vk::Device& device, vk::Semaphore& semaphore, uint64_t initialValue
+)
+{
+	vk::SemaphoreTypeCreateInfo semaphoreTypeCreateInfo{};
+	semaphoreTypeCreateInfo.semaphoreType = vk::SemaphoreType::eTimeline;
+	semaphoreTypeCreateInfo.initialValue = initialValue;
+
+	vk::SemaphoreCreateInfo semaphoreCreateInfo{};
+	semaphoreCreateInfo.flags = vk::SemaphoreCreateFlags();
+	semaphoreCreateInfo.pNext = &semaphoreTypeCreateInfo;
+
+	vk::Result result = device.createSemaphore(&semaphoreCreateInfo, nullptr, &semaphore);
+	if(result != vk::Result::eSuccess)
+		LOG_ERROR("Failed to create timeline semaphore. Vulkan result: %d", result);
+}
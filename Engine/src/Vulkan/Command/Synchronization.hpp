@@ -10,4 +10,6 @@ namespace mtd::Synchronization
 
 	// Creates a Vulkan semaphore
 	void createSemaphore(const vk::Device& device, vk::Semaphore& semaphore);
+	// Creates a Vulkan timeline semaphore, with a counter that only increases
+	void createTimelineSemaphore(const vk::Device& device, vk::Semaphore& semaphore, uint64_t initialValue = 0UL);
 }
\ No newline at end of file
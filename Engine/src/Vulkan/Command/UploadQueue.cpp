@@ -0,0 +1,439 @@
+#include <pch.hpp>
+#include "UploadQueue.hpp"
+
+#include "Synchronization.hpp"
+#include "../../Utils/Logger.hpp"
+#include "../../Utils/Profiler.hpp"
+
+namespace mtd
+{
+	// Minimum size of each staging buffer of a batch
+	constexpr vk::DeviceSize STAGING_BUFFER_SIZE = 16UL << 20;
+	// Staging data alignment, compatible with the texel sizes of buffer to image copies
+	constexpr vk::DeviceSize STAGING_ALIGNMENT = 16UL;
+	// Staging size that submits the open batch, so the transfers overlap with the CPU work queuing more uploads
+	constexpr vk::DeviceSize BATCH_SUBMIT_SIZE = 64UL << 20;
+}
+
+mtd::UploadQueue::UploadQueue(const Device& mtdDevice)
+	: dedicatedTransferQueue
+	{
+		mtdDevice.getQueueFamilies().getTransferFamilyIndex() != mtdDevice.getQueueFamilies().getGraphicsFamilyIndex()
+	},
+	mtdDevice{mtdDevice}
+{
+	createCommandPool(mtdDevice.getQueueFamilies().getTransferFamilyIndex(), transferCommandPool);
+	if(dedicatedTransferQueue)
+		createCommandPool(mtdDevice.getQueueFamilies().getGraphicsFamilyIndex(), graphicsCommandPool);
+
+	Synchronization::createTimelineSemaphore(mtdDevice.getDevice(), timelineSemaphore);
+	openBatch.timelineValue = openBatchValue();
+
+	LOG_VERBOSE
+	(
+		"Created upload queue %s.",
+		dedicatedTransferQueue ? "on a dedicated transfer queue family" : "on the graphics queue family"
+	);
+}
+
+mtd::UploadQueue::~UploadQueue()
+{
+	if(submittedValue != 0UL)
+		wait(UploadTicket{submittedValue});
+	retireFinishedBatches();
+
+	const vk::Device& device = mtdDevice.getDevice();
+	device.destroySemaphore(timelineSemaphore);
+	device.destroyCommandPool(transferCommandPool);
+	if(graphicsCommandPool)
+		device.destroyCommandPool(graphicsCommandPool);
+}
+
+mtd::UploadTicket mtd::UploadQueue::uploadToBuffer
+(
+	vk::Buffer dstBuffer, vk::DeviceSize bufferOffset, vk::DeviceSize dataSize, const void* pData
+)
+{
+	return uploadToBuffer
+	(
+		dstBuffer, bufferOffset, dataSize,
+		[pData, dataSize](void* pStagingData) { memcpy(pStagingData, pData, dataSize); }
+	);
+}
+
+mtd::UploadTicket mtd::UploadQueue::uploadToBuffer
+(
+	vk::Buffer dstBuffer, vk::DeviceSize bufferOffset, vk::DeviceSize dataSize, const UploadWriter& writeData
+)
+{
+	if(dataSize == 0UL) return UploadTicket{};
+
+	std::lock_guard<std::mutex> lock{uploadMutex};
+	retireFinishedBatches();
+
+	vk::DeviceSize stagingOffset;
+	void* pStagingData;
+	vk::Buffer stagingBuffer = allocateStaging(dataSize, stagingOffset, pStagingData);
+	writeData(pStagingData);
+	openBatch.bufferUploads.push_back(BufferUpload{stagingBuffer, stagingOffset, dstBuffer, bufferOffset, dataSize});
+
+	UploadTicket ticket{openBatch.timelineValue};
+	if(openBatch.stagingSize >= BATCH_SUBMIT_SIZE)
+		submitOpenBatch();
+	return ticket;
+}
+
+mtd::UploadTicket mtd::UploadQueue::uploadToImage
+(
+	vk::Image dstImage, UIntVec2 dimensions, vk::ImageAspectFlags aspects, vk::DeviceSize dataSize, const void* pData
+)
+{
+	if(dataSize == 0UL) return UploadTicket{};
+
+	std::lock_guard<std::mutex> lock{uploadMutex};
+	retireFinishedBatches();
+
+	vk::DeviceSize stagingOffset;
+	void* pStagingData;
+	vk::Buffer stagingBuffer = allocateStaging(dataSize, stagingOffset, pStagingData);
+	memcpy(pStagingData, pData, dataSize);
+	openBatch.imageUploads.push_back(ImageUpload{stagingBuffer, stagingOffset, dstImage, dimensions, aspects});
+
+	UploadTicket ticket{openBatch.timelineValue};
+	if(openBatch.stagingSize >= BATCH_SUBMIT_SIZE)
+		submitOpenBatch();
+	return ticket;
+}
+
+mtd::UploadTicket mtd::UploadQueue::submit()
+{
+	std::lock_guard<std::mutex> lock{uploadMutex};
+	submitOpenBatch();
+	return UploadTicket{submittedValue};
+}
+
+bool mtd::UploadQueue::isComplete(UploadTicket ticket) const
+{
+	return ticket.timelineValue <= fetchCompletedValue();
+}
+
+void mtd::UploadQueue::wait(UploadTicket ticket)
+{
+	{
+		std::lock_guard<std::mutex> lock{uploadMutex};
+		if(ticket.timelineValue > submittedValue)
+			submitOpenBatch();
+	}
+	if(isComplete(ticket)) return;
+
+	PROFILER_ZONE("Wait for uploads");
+
+	vk::SemaphoreWaitInfo semaphoreWaitInfo{};
+	semaphoreWaitInfo.semaphoreCount = 1U;
+	semaphoreWaitInfo.pSemaphores = &timelineSemaphore;
+	semaphoreWaitInfo.pValues = &(ticket.timelineValue);
+
+	vk::Result result = mtdDevice.getDevice().waitSemaphores(&semaphoreWaitInfo, UINT64_MAX);
+	if(result != vk::Result::eSuccess)
+		LOG_ERROR("Failed to wait for the upload timeline semaphore. Vulkan result: %d", result);
+}
+
+void mtd::UploadQueue::flush()
+{
+	wait(submit());
+
+	std::lock_guard<std::mutex> lock{uploadMutex};
+	retireFinishedBatches();
+}
+
+vk::Buffer mtd::UploadQueue::allocateStaging
+(
+	vk::DeviceSize dataSize, vk::DeviceSize& stagingOffset, void*& pStagingData
+)
+{
+	stagingOffset = (openBatch.stagingHead + STAGING_ALIGNMENT - 1UL) & ~(STAGING_ALIGNMENT - 1UL);
+	if(openBatch.stagingBuffers.empty() || stagingOffset + dataSize > openBatch.stagingBuffers.back()->getSize())
+	{
+		openBatch.stagingBuffers.push_back(std::make_unique<GpuBuffer>
+		(
+			mtdDevice,
+			std::max(STAGING_BUFFER_SIZE, dataSize),
+			vk::BufferUsageFlagBits::eTransferSrc,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+		));
+		stagingOffset = 0UL;
+	}
+
+	GpuBuffer& stagingBuffer = *(openBatch.stagingBuffers.back());
+	pStagingData = static_cast<char*>(stagingBuffer.getAllocation().pMappedData) + stagingOffset;
+
+	openBatch.stagingHead = stagingOffset + dataSize;
+	openBatch.stagingSize += dataSize;
+	return stagingBuffer.getBuffer();
+}
+
+void mtd::UploadQueue::submitOpenBatch()
+{
+	if(openBatch.bufferUploads.empty() && openBatch.imageUploads.empty()) return;
+
+	PROFILER_ZONE("Submit upload batch");
+
+	openBatch.transferCommandBuffer = beginCommandBuffer(transferCommandPool);
+	recordTransferCommands(openBatch);
+	openBatch.transferCommandBuffer.end();
+
+	// With a dedicated transfer queue, the graphics queue acquires the resources after the copies finish
+	uint64_t transferValue = dedicatedTransferQueue ? openBatch.timelineValue - 1UL : openBatch.timelineValue;
+
+	vk::TimelineSemaphoreSubmitInfo timelineSubmitInfo{};
+	timelineSubmitInfo.signalSemaphoreValueCount = 1U;
+	timelineSubmitInfo.pSignalSemaphoreValues = &transferValue;
+
+	vk::SubmitInfo submitInfo{};
+	submitInfo.waitSemaphoreCount = 0U;
+	submitInfo.pWaitSemaphores = nullptr;
+	submitInfo.pWaitDstStageMask = nullptr;
+	submitInfo.commandBufferCount = 1U;
+	submitInfo.pCommandBuffers = &(openBatch.transferCommandBuffer);
+	submitInfo.signalSemaphoreCount = 1U;
+	submitInfo.pSignalSemaphores = &timelineSemaphore;
+	submitInfo.pNext = &timelineSubmitInfo;
+
+	std::lock_guard<std::mutex> queueLock{mtdDevice.getQueueMutex()};
+	vk::Result result = mtdDevice.getTransferQueue().submit(1U, &submitInfo, nullptr);
+	if(result != vk::Result::eSuccess)
+		LOG_ERROR("Failed to submit upload batch. Vulkan result: %d", result);
+
+	if(dedicatedTransferQueue)
+	{
+		openBatch.acquireCommandBuffer = beginCommandBuffer(graphicsCommandPool);
+		recordAcquireCommands(openBatch);
+		openBatch.acquireCommandBuffer.end();
+
+		vk::PipelineStageFlags waitStage = vk::PipelineStageFlagBits::eAllCommands;
+		timelineSubmitInfo.waitSemaphoreValueCount = 1U;
+		timelineSubmitInfo.pWaitSemaphoreValues = &transferValue;
+		timelineSubmitInfo.pSignalSemaphoreValues = &(openBatch.timelineValue);
+
+		submitInfo.waitSemaphoreCount = 1U;
+		submitInfo.pWaitSemaphores = &timelineSemaphore;
+		submitInfo.pWaitDstStageMask = &waitStage;
+		submitInfo.pCommandBuffers = &(openBatch.acquireCommandBuffer);
+
+		result = mtdDevice.getGraphicsQueue().submit(1U, &submitInfo, nullptr);
+		if(result != vk::Result::eSuccess)
+			LOG_ERROR("Failed to submit upload ownership acquisition. Vulkan result: %d", result);
+	}
+
+	LOG_VERBOSE
+	(
+		"Submitted upload batch with %d buffer and %d image copies (%d KiB).",
+		openBatch.bufferUploads.size(),
+		openBatch.imageUploads.size(),
+		static_cast<uint32_t>(openBatch.stagingSize >> 10)
+	);
+
+	submittedValue = openBatch.timelineValue;
+	submittedBatches.push_back(std::move(openBatch));
+	openBatch = UploadBatch{};
+	openBatch.timelineValue = openBatchValue();
+}
+
+void mtd::UploadQueue::recordTransferCommands(const UploadBatch& batch) const
+{
+	const vk::CommandBuffer& commandBuffer = batch.transferCommandBuffer;
+
+	std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+	std::vector<vk::ImageMemoryBarrier> imageBarriers(batch.imageUploads.size());
+	for(size_t i = 0; i < batch.imageUploads.size(); i++)
+	{
+		imageBarriers[i].srcAccessMask = vk::AccessFlagBits::eNone;
+		imageBarriers[i].dstAccessMask = vk::AccessFlagBits::eTransferWrite;
+		imageBarriers[i].oldLayout = vk::ImageLayout::eUndefined;
+		imageBarriers[i].newLayout = vk::ImageLayout::eTransferDstOptimal;
+		imageBarriers[i].srcQueueFamilyIndex = vk::QueueFamilyIgnored;
+		imageBarriers[i].dstQueueFamilyIndex = vk::QueueFamilyIgnored;
+		imageBarriers[i].image = batch.imageUploads[i].dstImage;
+		imageBarriers[i].subresourceRange = vk::ImageSubresourceRange{batch.imageUploads[i].aspects, 0U, 1U, 0U, 1U};
+	}
+	if(!imageBarriers.empty())
+	{
+		commandBuffer.pipelineBarrier
+		(
+			vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eTransfer,
+			vk::DependencyFlags(), nullptr, nullptr, imageBarriers
+		);
+	}
+
+	for(const BufferUpload& upload: batch.bufferUploads)
+	{
+		vk::BufferCopy bufferCopy{};
+		bufferCopy.srcOffset = upload.stagingOffset;
+		bufferCopy.dstOffset = upload.bufferOffset;
+		bufferCopy.size = upload.size;
+
+		commandBuffer.copyBuffer(upload.stagingBuffer, upload.dstBuffer, 1U, &bufferCopy);
+	}
+	for(const ImageUpload& upload: batch.imageUploads)
+	{
+		vk::BufferImageCopy bufferImageCopy{};
+		bufferImageCopy.bufferOffset = upload.stagingOffset;
+		bufferImageCopy.bufferRowLength = 0U;
+		bufferImageCopy.bufferImageHeight = 0U;
+		bufferImageCopy.imageSubresource = vk::ImageSubresourceLayers{upload.aspects, 0U, 0U, 1U};
+		bufferImageCopy.imageOffset = vk::Offset3D{0, 0, 0};
+		bufferImageCopy.imageExtent = vk::Extent3D{upload.dimensions.x, upload.dimensions.y, 1U};
+
+		commandBuffer.copyBufferToImage
+		(
+			upload.stagingBuffer, upload.dstImage, vk::ImageLayout::eTransferDstOptimal, bufferImageCopy
+		);
+	}
+
+	// Releases the ownership to the graphics queue family, or makes the data visible in the same queue
+	fillUploadBarriers(batch, bufferBarriers, imageBarriers);
+	uint32_t srcFamilyIndex = vk::QueueFamilyIgnored;
+	uint32_t dstFamilyIndex = vk::QueueFamilyIgnored;
+	if(dedicatedTransferQueue)
+	{
+		srcFamilyIndex = mtdDevice.getQueueFamilies().getTransferFamilyIndex();
+		dstFamilyIndex = mtdDevice.getQueueFamilies().getGraphicsFamilyIndex();
+	}
+	for(vk::BufferMemoryBarrier& barrier: bufferBarriers)
+	{
+		barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+		barrier.dstAccessMask = dedicatedTransferQueue ? vk::AccessFlagBits::eNone : vk::AccessFlagBits::eMemoryRead;
+		barrier.srcQueueFamilyIndex = srcFamilyIndex;
+		barrier.dstQueueFamilyIndex = dstFamilyIndex;
+	}
+	for(vk::ImageMemoryBarrier& barrier: imageBarriers)
+	{
+		barrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+		barrier.dstAccessMask = dedicatedTransferQueue ? vk::AccessFlagBits::eNone : vk::AccessFlagBits::eShaderRead;
+		barrier.srcQueueFamilyIndex = srcFamilyIndex;
+		barrier.dstQueueFamilyIndex = dstFamilyIndex;
+	}
+
+	commandBuffer.pipelineBarrier
+	(
+		vk::PipelineStageFlagBits::eTransfer,
+		dedicatedTransferQueue ? vk::PipelineStageFlagBits::eBottomOfPipe : vk::PipelineStageFlagBits::eAllCommands,
+		vk::DependencyFlags(), nullptr, bufferBarriers, imageBarriers
+	);
+}
+
+void mtd::UploadQueue::recordAcquireCommands(const UploadBatch& batch) const
+{
+	std::vector<vk::BufferMemoryBarrier> bufferBarriers;
+	std::vector<vk::ImageMemoryBarrier> imageBarriers;
+	fillUploadBarriers(batch, bufferBarriers, imageBarriers);
+
+	uint32_t srcFamilyIndex = mtdDevice.getQueueFamilies().getTransferFamilyIndex();
+	uint32_t dstFamilyIndex = mtdDevice.getQueueFamilies().getGraphicsFamilyIndex();
+	for(vk::BufferMemoryBarrier& barrier: bufferBarriers)
+	{
+		barrier.srcAccessMask = vk::AccessFlagBits::eNone;
+		barrier.dstAccessMask = vk::AccessFlagBits::eMemoryRead;
+		barrier.srcQueueFamilyIndex = srcFamilyIndex;
+		barrier.dstQueueFamilyIndex = dstFamilyIndex;
+	}
+	for(vk::ImageMemoryBarrier& barrier: imageBarriers)
+	{
+		barrier.srcAccessMask = vk::AccessFlagBits::eNone;
+		barrier.dstAccessMask = vk::AccessFlagBits::eShaderRead;
+		barrier.srcQueueFamilyIndex = srcFamilyIndex;
+		barrier.dstQueueFamilyIndex = dstFamilyIndex;
+	}
+
+	batch.acquireCommandBuffer.pipelineBarrier
+	(
+		vk::PipelineStageFlagBits::eTopOfPipe, vk::PipelineStageFlagBits::eAllCommands,
+		vk::DependencyFlags(), nullptr, bufferBarriers, imageBarriers
+	);
+}
+
+void mtd::UploadQueue::fillUploadBarriers
+(
+	const UploadBatch& batch,
+	std::vector<vk::BufferMemoryBarrier>& bufferBarriers,
+	std::vector<vk::ImageMemoryBarrier>& imageBarriers
+) const
+{
+	bufferBarriers.resize(batch.bufferUploads.size());
+	for(size_t i = 0; i < batch.bufferUploads.size(); i++)
+	{
+		bufferBarriers[i].buffer = batch.bufferUploads[i].dstBuffer;
+		bufferBarriers[i].offset = batch.bufferUploads[i].bufferOffset;
+		bufferBarriers[i].size = batch.bufferUploads[i].size;
+	}
+
+	imageBarriers.resize(batch.imageUploads.size());
+	for(size_t i = 0; i < batch.imageUploads.size(); i++)
+	{
+		imageBarriers[i].oldLayout = vk::ImageLayout::eTransferDstOptimal;
+		imageBarriers[i].newLayout = vk::ImageLayout::eShaderReadOnlyOptimal;
+		imageBarriers[i].image = batch.imageUploads[i].dstImage;
+		imageBarriers[i].subresourceRange = vk::ImageSubresourceRange{batch.imageUploads[i].aspects, 0U, 1U, 0U, 1U};
+	}
+}
+
+void mtd::UploadQueue::retireFinishedBatches()
+{
+	if(submittedBatches.empty()) return;
+
+	const vk::Device& device = mtdDevice.getDevice();
+	uint64_t completedValue = fetchCompletedValue();
+	while(!submittedBatches.empty() && submittedBatches.front().timelineValue <= completedValue)
+	{
+		UploadBatch& batch = submittedBatches.front();
+		device.freeCommandBuffers(transferCommandPool, 1U, &(batch.transferCommandBuffer));
+		if(batch.acquireCommandBuffer)
+			device.freeCommandBuffers(graphicsCommandPool, 1U, &(batch.acquireCommandBuffer));
+
+		submittedBatches.pop_front();
+	}
+}
+
+void mtd::UploadQueue::createCommandPool(uint32_t queueFamilyIndex, vk::CommandPool& commandPool) const
+{
+	vk::CommandPoolCreateInfo commandPoolCreateInfo{};
+	commandPoolCreateInfo.flags = vk::CommandPoolCreateFlagBits::eTransient;
+	commandPoolCreateInfo.queueFamilyIndex = queueFamilyIndex;
+
+	vk::Result result = mtdDevice.getDevice().createCommandPool(&commandPoolCreateInfo, nullptr, &commandPool);
+	if(result != vk::Result::eSuccess)
+		LOG_ERROR("Failed to create upload command pool. Vulkan result: %d", result);
+}
+
+vk::CommandBuffer mtd::UploadQueue::beginCommandBuffer(vk::CommandPool commandPool) const
+{
+	vk::CommandBufferAllocateInfo commandBufferAllocateInfo{};
+	commandBufferAllocateInfo.commandPool = commandPool;
+	commandBufferAllocateInfo.level = vk::CommandBufferLevel::ePrimary;
+	commandBufferAllocateInfo.commandBufferCount = 1U;
+
+	vk::CommandBuffer commandBuffer;
+	vk::Result result = mtdDevice.getDevice().allocateCommandBuffers(&commandBufferAllocateInfo, &commandBuffer);
+	if(result != vk::Result::eSuccess)
+		LOG_ERROR("Failed to allocate upload command buffer. Vulkan result: %d", result);
+
+	vk::CommandBufferBeginInfo commandBufferBeginInfo{};
+	commandBufferBeginInfo.flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit;
+	commandBufferBeginInfo.pInheritanceInfo = nullptr;
+
+	result = commandBuffer.begin(&commandBufferBeginInfo);
+	if(result != vk::Result::eSuccess)
+		LOG_ERROR("Failed to begin upload command buffer. Vulkan result: %d", result);
+
+	return commandBuffer;
+}
+
+uint64_t mtd::UploadQueue::fetchCompletedValue() const
+{
+	uint64_t completedValue = 0UL;
+	vk::Result result = mtdDevice.getDevice().getSemaphoreCounterValue(timelineSemaphore, &completedValue);
+	if(result != vk::Result::eSuccess)
+		LOG_ERROR("Failed to read the upload timeline semaphore. Vulkan result: %d", result);
+
+	return completedValue;
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <deque>
+
+#include "../Device/GpuBuffer.hpp"
+
+namespace mtd
+{
+	// Identifies the batch containing an upload, finished when the upload timeline reaches its value
+	struct UploadTicket
+	{
+		uint64_t timelineValue = 0UL;
+	};
+
+	// Fills the staging memory reserved for an upload, so the data can be produced without an intermediate copy
+	using UploadWriter = std::function<void(void* pStagingData)>;
+
+	// Batches uploads to GPU resources that are not in use yet, submitting them without blocking the CPU
+	class UploadQueue
+	{
+		public:
+			UploadQueue(const Device& mtdDevice);
+			~UploadQueue();
+
+			UploadQueue(const UploadQueue&) = delete;
+			UploadQueue& operator=(const UploadQueue&) = delete;
+
+			// Queues a copy of CPU data to a buffer region
+			UploadTicket uploadToBuffer
+			(
+				vk::Buffer dstBuffer, vk::DeviceSize bufferOffset, vk::DeviceSize dataSize, const void* pData
+			);
+			// Queues a copy to a buffer region, with the data written directly to the staging memory
+			UploadTicket uploadToBuffer
+			(
+				vk::Buffer dstBuffer, vk::DeviceSize bufferOffset, vk::DeviceSize dataSize, const UploadWriter& writeData
+			);
+			// Queues a copy of CPU data to a whole image, leaving it ready to be sampled by shaders
+			UploadTicket uploadToImage
+			(
+				vk::Image dstImage,
+				UIntVec2 dimensions,
+				vk::ImageAspectFlags aspects,
+				vk::DeviceSize dataSize,
+				const void* pData
+			);
+
+			// Submits the queued uploads as a single batch
+			UploadTicket submit();
+			// Checks if all uploads of the ticket have finished
+			bool isComplete(UploadTicket ticket) const;
+			// Blocks until all uploads of the ticket have finished, submitting them if needed
+			void wait(UploadTicket ticket);
+			// Submits the queued uploads and blocks until every upload has finished
+			void flush();
+
+		private:
+			// Copy from the staging memory to a buffer region
+			struct BufferUpload
+			{
+				vk::Buffer stagingBuffer;
+				vk::DeviceSize stagingOffset;
+				vk::Buffer dstBuffer;
+				vk::DeviceSize bufferOffset;
+				vk::DeviceSize size;
+			};
+			// Copy from the staging memory to an image
+			struct ImageUpload
+			{
+				vk::Buffer stagingBuffer;
+				vk::DeviceSize stagingOffset;
+				vk::Image dstImage;
+				UIntVec2 dimensions;
+				vk::ImageAspectFlags aspects;
+			};
+			// Uploads submitted together, with the resources kept alive until the batch finishes
+			struct UploadBatch
+			{
+				std::vector<std::unique_ptr<GpuBuffer>> stagingBuffers;
+				vk::DeviceSize stagingHead = 0UL;
+				vk::DeviceSize stagingSize = 0UL;
+
+				std::vector<BufferUpload> bufferUploads;
+				std::vector<ImageUpload> imageUploads;
+
+				vk::CommandBuffer transferCommandBuffer = nullptr;
+				vk::CommandBuffer acquireCommandBuffer = nullptr;
+				uint64_t timelineValue = 0UL;
+			};
+
+			// Batch receiving new uploads, and the submitted batches still running on the GPU
+			UploadBatch openBatch;
+			std::deque<UploadBatch> submittedBatches;
+
+			// Command pools for the transfer queue and for the graphics queue ownership acquisition
+			vk::CommandPool transferCommandPool;
+			vk::CommandPool graphicsCommandPool;
+			// Signals the timeline value of each batch once its uploads finish
+			vk::Semaphore timelineSemaphore;
+			// Last timeline value submitted
+			uint64_t submittedValue = 0UL;
+			// Flags if uploads run on a dedicated transfer queue family, which requires ownership transfers
+			bool dedicatedTransferQueue;
+
+			// Guards the batches and command pools, as uploads may be requested from multiple threads
+			mutable std::mutex uploadMutex;
+
+			// Device reference
+			const Device& mtdDevice;
+
+			// Reserves staging memory in the open batch
+			vk::Buffer allocateStaging(vk::DeviceSize dataSize, vk::DeviceSize& stagingOffset, void*& pStagingData);
+			// Timeline value of the open batch once submitted
+			uint64_t openBatchValue() const { return submittedValue + (dedicatedTransferQueue ? 2UL : 1UL); }
+
+			// Records and submits the open batch
+			void submitOpenBatch();
+			// Records the copies of the batch, releasing the resources to the graphics queue if needed
+			void recordTransferCommands(const UploadBatch& batch) const;
+			// Records the acquisition of the uploaded resources by the graphics queue
+			void recordAcquireCommands(const UploadBatch& batch) const;
+			// Sets the resources and layouts of the barriers releasing and acquiring the uploaded resources
+			void fillUploadBarriers
+			(
+				const UploadBatch& batch,
+				std::vector<vk::BufferMemoryBarrier>& bufferBarriers,
+				std::vector<vk::ImageMemoryBarrier>& imageBarriers
+			) const;
+			// Releases the staging memory and command buffers of the finished batches
+			void retireFinishedBatches();
+
+			// Creates a command pool for the queue family
+			void createCommandPool(uint32_t queueFamilyIndex, vk::CommandPool& commandPool) const;
+			// Allocates and begins a command buffer to be submitted once
+			vk::CommandBuffer beginCommandBuffer(vk::CommandPool commandPool) const;
+			// Reads the current timeline value
+			uint64_t fetchCompletedValue() const;
+	};
+}
@@ -186,8 +186,14 @@ void mtd::DescriptorManager::updateResourceDescriptors(ResourceID resourceID)
     ResourceDescriptorsMapIterator it = resourceDescriptorsMap.find(resourceID);
     if(it == resourceDescriptorsMap.cend()) return;
 
-    for(DescriptorIdentifier descriptorIdentity: it->second)
+    pendingWrites.insert(pendingWrites.end(), it->second.cbegin(), it->second.cend());
+}
+
+void mtd::DescriptorManager::writePendingDescriptors()
+{
+    for(DescriptorIdentifier descriptorIdentity: pendingWrites)
         write(descriptorIdentity.setID, descriptorIdentity.binding);
+    pendingWrites.clear();
 }
 
 void mtd::DescriptorManager::clear()
@@ -200,6 +206,7 @@ void mtd::DescriptorManager::clear()
     totalBufferResourcesCount = 0;
     totalImageResourcesCount = 0;
     totalDescriptorTypeCount.clear();
+    pendingWrites.clear();
 
     for(DescriptorLayoutData& layoutData: layouts)
         mtdDevice.getDevice().destroyDescriptorSetLayout(layoutData.layout);
@@ -32,8 +32,13 @@ namespace mtd
             // Write a specific descriptor binding
             void write(DescriptorSetID setID, uint32_t binding);
 
-            // Updates all descriptors associated with the specified resource
+            // Queues the update of all descriptors associated with the specified resource, as the descriptor sets may
+            // be in use by the frames in flight
             void updateResourceDescriptors(ResourceID resourceID);
+            // Checks if there are queued descriptor updates
+            bool hasPendingWrites() const { return !pendingWrites.empty(); }
+            // Writes the queued descriptor updates, which must only be called when no frame in flight uses the sets
+            void writePendingDescriptors();
 
             // Clears all descriptor data stored
             void clear();
@@ -49,6 +54,8 @@ namespace mtd
 
             // Registry of which descriptors are associated with a specific resource
             std::unordered_map<ResourceID, std::vector<DescriptorIdentifier>> resourceDescriptorsMap;
+            // Descriptors waiting for the frames in flight to finish before being written
+            std::vector<DescriptorIdentifier> pendingWrites;
 
             // Number of descriptor bindings from all descriptor layouts
             size_t totalBindingsCount = 0;
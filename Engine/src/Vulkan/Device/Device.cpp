@@ -5,9 +5,10 @@
 
 mtd::Device::Device(const vk::Instance& vulkanInstance, const vk::SurfaceKHR surface, bool tryEnableRayTracing)
 	: device{nullptr},
-	physicalDevice{vulkanInstance},
+	physicalDevice{vulkanInstance, static_cast<bool>(surface)},
 	queueFamilies{physicalDevice.getPhysicalDevice(), surface},
-	rayTracingEnabled{tryEnableRayTracing && physicalDevice.isRayTracingCompatible()}
+	rayTracingEnabled{tryEnableRayTracing && physicalDevice.isRayTracingCompatible()},
+	presentationEnabled{static_cast<bool>(surface)}
 {
 	std::vector<vk::DeviceQueueCreateInfo> deviceQueueCreateInfos;
 	configureQueues(deviceQueueCreateInfos);
@@ -15,25 +16,14 @@ mtd::Device::Device(const vk::Instance& vulkanInstance, const vk::SurfaceKHR sur
 	std::vector<const char*> extensions;
 	selectExtensions(extensions);
 
-	vk::PhysicalDeviceDescriptorIndexingFeatures descriptorIndexingFeatures{};
-	descriptorIndexingFeatures.runtimeDescriptorArray = vk::True;
-	descriptorIndexingFeatures.descriptorBindingPartiallyBound = vk::True;
-	descriptorIndexingFeatures.descriptorBindingVariableDescriptorCount = vk::True;
-	descriptorIndexingFeatures.shaderSampledImageArrayNonUniformIndexing = vk::True;
+	vk::PhysicalDeviceVulkan12Features vulkan12Features{};
 	vk::PhysicalDevice16BitStorageFeatures sixteenBitStorageFeatures{};
-	sixteenBitStorageFeatures.storageBuffer16BitAccess = vk::True;
-	sixteenBitStorageFeatures.pNext = &descriptorIndexingFeatures;
-	vk::PhysicalDeviceBufferDeviceAddressFeaturesKHR bufferDeviceAddressFeatures{};
-	bufferDeviceAddressFeatures.bufferDeviceAddress = vk::True;
-	bufferDeviceAddressFeatures.pNext = &sixteenBitStorageFeatures;
+	sixteenBitStorageFeatures.pNext = &vulkan12Features;
 	vk::PhysicalDeviceAccelerationStructureFeaturesKHR accelerationFeatures{};
-	accelerationFeatures.accelerationStructure = vk::True;
-	accelerationFeatures.pNext = &bufferDeviceAddressFeatures;
+	accelerationFeatures.pNext = &sixteenBitStorageFeatures;
 	vk::PhysicalDeviceRayTracingPipelineFeaturesKHR rayTracingFeatures{};
-	rayTracingFeatures.rayTracingPipeline = vk::True;
 	rayTracingFeatures.pNext = &accelerationFeatures;
 
-	vk::PhysicalDeviceFeatures physicalDeviceFeatures{};
 	vk::PhysicalDeviceFeatures2 physicalDeviceFeatures2{};
 	physicalDeviceFeatures2.pNext = &rayTracingFeatures;
 
@@ -42,23 +32,64 @@ mtd::Device::Device(const vk::Instance& vulkanInstance, const vk::SurfaceKHR sur
 	(
 		!rayTracingFeatures.rayTracingPipeline ||
 		!accelerationFeatures.accelerationStructure ||
-		!bufferDeviceAddressFeatures.bufferDeviceAddress ||
+		!vulkan12Features.bufferDeviceAddress ||
 		!sixteenBitStorageFeatures.storageBuffer16BitAccess ||
-		!descriptorIndexingFeatures.runtimeDescriptorArray
+		!vulkan12Features.runtimeDescriptorArray
 	)
 	{
 		rayTracingEnabled = false;
 		LOG_WARNING("Required ray tracing features not available on the current device.");
 	}
 
+	// Indirect draws start at the first instance of their draw batch, and several of them are drawn per call
+	const vk::PhysicalDeviceFeatures& supportedFeatures = physicalDeviceFeatures2.features;
+	multiDrawIndirectEnabled = supportedFeatures.multiDrawIndirect && supportedFeatures.drawIndirectFirstInstance;
+	if(!multiDrawIndirectEnabled)
+		LOG_WARNING("Multi draw indirect not available on the current device. Submeshes will be drawn one by one.");
+
+	// GPU culling writes a variable amount of indirect draws per pipeline
+	drawIndirectCountEnabled = vulkan12Features.drawIndirectCount && multiDrawIndirectEnabled;
+	if(!drawIndirectCountEnabled)
+		LOG_WARNING("Indirect draw count not available on the current device. GPU culling will be disabled.");
+
+	// Only the required features are enabled, as the queried chain would enable every supported feature
+	vk::PhysicalDeviceFeatures2 requiredFeatures2{};
+	requiredFeatures2.features.multiDrawIndirect = multiDrawIndirectEnabled;
+	requiredFeatures2.features.drawIndirectFirstInstance = multiDrawIndirectEnabled;
+	vk::PhysicalDeviceVulkan12Features requiredVulkan12Features{};
+	requiredVulkan12Features.timelineSemaphore = vk::True;
+	requiredVulkan12Features.drawIndirectCount = drawIndirectCountEnabled;
+	requiredFeatures2.pNext = &requiredVulkan12Features;
+
+	vk::PhysicalDevice16BitStorageFeatures requiredSixteenBitStorageFeatures{};
+	vk::PhysicalDeviceAccelerationStructureFeaturesKHR requiredAccelerationFeatures{};
+	vk::PhysicalDeviceRayTracingPipelineFeaturesKHR requiredRayTracingFeatures{};
+	if(rayTracingEnabled)
+	{
+		requiredVulkan12Features.bufferDeviceAddress = vk::True;
+		requiredVulkan12Features.runtimeDescriptorArray = vk::True;
+		requiredVulkan12Features.descriptorBindingPartiallyBound = vulkan12Features.descriptorBindingPartiallyBound;
+		requiredVulkan12Features.descriptorBindingVariableDescriptorCount =
+			vulkan12Features.descriptorBindingVariableDescriptorCount;
+		requiredVulkan12Features.shaderSampledImageArrayNonUniformIndexing =
+			vulkan12Features.shaderSampledImageArrayNonUniformIndexing;
+		requiredSixteenBitStorageFeatures.storageBuffer16BitAccess = vk::True;
+		requiredAccelerationFeatures.accelerationStructure = vk::True;
+		requiredRayTracingFeatures.rayTracingPipeline = vk::True;
+
+		requiredVulkan12Features.pNext = &requiredSixteenBitStorageFeatures;
+		requiredSixteenBitStorageFeatures.pNext = &requiredAccelerationFeatures;
+		requiredAccelerationFeatures.pNext = &requiredRayTracingFeatures;
+	}
+
 	vk::DeviceCreateInfo deviceCreateInfo{};
 	deviceCreateInfo.flags = vk::DeviceCreateFlags();
 	deviceCreateInfo.queueCreateInfoCount = static_cast<uint32_t>(deviceQueueCreateInfos.size());
 	deviceCreateInfo.pQueueCreateInfos = deviceQueueCreateInfos.data();
 	deviceCreateInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
 	deviceCreateInfo.ppEnabledExtensionNames = extensions.data();
-	deviceCreateInfo.pEnabledFeatures = rayTracingEnabled ? nullptr : &physicalDeviceFeatures;
-	deviceCreateInfo.pNext = rayTracingEnabled ? &physicalDeviceFeatures2 : nullptr;
+	deviceCreateInfo.pEnabledFeatures = nullptr;
+	deviceCreateInfo.pNext = &requiredFeatures2;
 
 	vk::Result result = physicalDevice.getPhysicalDevice().createDevice(&deviceCreateInfo, nullptr, &device);
 	if(result != vk::Result::eSuccess)
@@ -72,19 +103,35 @@ mtd::Device::Device(const vk::Instance& vulkanInstance, const vk::SurfaceKHR sur
 	(
 		vulkanInstance, vkGetInstanceProcAddr, device, vkGetDeviceProcAddr
 	);
+
+	// Buffer device addresses are only enabled along with ray tracing
+	memoryAllocator = std::make_unique<MemoryAllocator>(device, physicalDevice.getPhysicalDevice(), rayTracingEnabled);
 }
 
 mtd::Device::~Device()
 {
+	memoryAllocator.reset();
 	device.destroy();
 }
 
+void mtd::Device::waitIdle() const
+{
+	std::lock_guard<std::mutex> queueLock{queueMutex};
+	device.waitIdle();
+}
+
 void mtd::Device::configureQueues(std::vector<vk::DeviceQueueCreateInfo>& deviceQueueCreateInfos) const
 {
 	std::vector<uint32_t> uniqueQueueFamilyIndices = {queueFamilies.getGraphicsFamilyIndex()};
 
 	if(queueFamilies.getGraphicsFamilyIndex() != queueFamilies.getPresentFamilyIndex())
 		uniqueQueueFamilyIndices.push_back(queueFamilies.getPresentFamilyIndex());
+	if
+	(
+		queueFamilies.getTransferFamilyIndex() != queueFamilies.getGraphicsFamilyIndex() &&
+		queueFamilies.getTransferFamilyIndex() != queueFamilies.getPresentFamilyIndex()
+	)
+		uniqueQueueFamilyIndices.push_back(queueFamilies.getTransferFamilyIndex());
 
 	static constexpr float queuePriority = 1.0f;
 	for(uint32_t uniqueQueueFamilyIndex: uniqueQueueFamilyIndices)
@@ -101,20 +148,21 @@ void mtd::Device::configureQueues(std::vector<vk::DeviceQueueCreateInfo>& device
 
 void mtd::Device::selectExtensions(std::vector<const char*>& extensions) const
 {
+	if(presentationEnabled)
+		extensions.push_back(vk::KHRSwapchainExtensionName);
+
 	if(rayTracingEnabled)
 	{
-		extensions =
-		{
-			vk::KHRSwapchainExtensionName,
-			vk::KHRRayTracingPipelineExtensionName,
-			vk::KHRAccelerationStructureExtensionName,
-			vk::KHRDeferredHostOperationsExtensionName,
-			vk::KHRBufferDeviceAddressExtensionName,
-			vk::EXTDescriptorIndexingExtensionName
-		};
-	}
-	else
-	{
-		extensions = {vk::KHRSwapchainExtensionName};
+		extensions.insert
+		(
+			extensions.end(),
+			{
+				vk::KHRRayTracingPipelineExtensionName,
+				vk::KHRAccelerationStructureExtensionName,
+				vk::KHRDeferredHostOperationsExtensionName,
+				vk::KHRBufferDeviceAddressExtensionName,
+				vk::EXTDescriptorIndexingExtensionName
+			}
+		);
 	}
 }
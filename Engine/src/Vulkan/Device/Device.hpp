@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../Instance/VulkanInstance.hpp"
+#include "MemoryAllocator.hpp"
 #include "PhysicalDevice.hpp"
 #include "QueueFamilies.hpp"
 
@@ -21,6 +22,7 @@ namespace mtd
 			const vk::PhysicalDevice& getPhysicalDevice() const
 				{ return physicalDevice.getPhysicalDevice(); }
 			const vk::detail::DispatchLoaderDynamic& getDLDI() const { return *dldi; }
+			MemoryAllocator& getMemoryAllocator() const { return *memoryAllocator; }
 
 			// Queue getters
 			const QueueFamilies& getQueueFamilies() const { return queueFamilies; }
@@ -28,9 +30,22 @@ namespace mtd
 				{ return device.getQueue(queueFamilies.getGraphicsFamilyIndex(), 0); }
 			const vk::Queue getPresentQueue() const
 				{ return device.getQueue(queueFamilies.getPresentFamilyIndex(), 0); }
+			const vk::Queue getTransferQueue() const
+				{ return device.getQueue(queueFamilies.getTransferFamilyIndex(), 0); }
+			// Guards the queue submissions and presentation, which may come from the scene loading thread
+			std::mutex& getQueueMutex() const { return queueMutex; }
+
+			// Waits for all queues to become idle
+			void waitIdle() const;
 
 			// Checks if hardware ray tracing is enabled
 			bool isRayTracingEnabled() const { return rayTracingEnabled; }
+			// Checks if the device can present to a surface
+			bool isPresentationEnabled() const { return presentationEnabled; }
+			// Checks if several indirect draws, starting at any instance, can be recorded in a single call
+			bool isMultiDrawIndirectEnabled() const { return multiDrawIndirectEnabled; }
+			// Checks if indirect draws with a GPU written draw count are enabled
+			bool isDrawIndirectCountEnabled() const { return drawIndirectCountEnabled; }
 
 			// Acquires the physical device ray tracing properties
 			const vk::PhysicalDeviceRayTracingPipelinePropertiesKHR& fetchRayTracingProperties() const
@@ -46,9 +61,19 @@ namespace mtd
 
 			// Dispatch loader dynamic instance
 			std::unique_ptr<vk::detail::DispatchLoaderDynamic> dldi;
+			// Device memory sub-allocator, shared by all GPU resources
+			std::unique_ptr<MemoryAllocator> memoryAllocator;
+			// Queue access lock, as Vulkan queues must be externally synchronized
+			mutable std::mutex queueMutex;
 
 			// Ray tracing hardware support status
 			bool rayTracingEnabled;
+			// Surface presentation status (disabled when rendering headless)
+			bool presentationEnabled;
+			// Multi draw indirect support status, including draws starting at any instance
+			bool multiDrawIndirectEnabled = false;
+			// Indirect draw count support status, required by the GPU culling
+			bool drawIndirectCountEnabled = false;
 
 			// Configures the Vulkan queues
 			void configureQueues(std::vector<vk::DeviceQueueCreateInfo>& deviceQueueCreateInfos) const;
@@ -0,0 +1,70 @@
+#include <pch.hpp>
+#include "FrameRingBuffer.hpp"
+
+#include "../../Utils/Logger.hpp"
+
+mtd::FrameRingBuffer::FrameRingBuffer(const Device& device, vk::DeviceSize frameCapacity)
+	: device{device}, frameCapacity{frameCapacity}
+{}
+
+void mtd::FrameRingBuffer::beginFrame(uint32_t frameIndex, uint32_t frameCount)
+{
+	assert(frameCount > 0U && frameIndex < frameCount && "Invalid frame index for the ring buffer.");
+
+	// Retired buffers are released once every frame has moved on to the new buffer
+	for(auto& [retiredBuffer, remainingFrames]: retiredBuffers)
+		remainingFrames--;
+	std::erase_if(retiredBuffers, [](const auto& retiredBuffer) { return retiredBuffer.second == 0U; });
+
+	this->frameIndex = frameIndex;
+	frameHead = 0UL;
+
+	if(!ringBuffer || frameCount != this->frameCount)
+	{
+		this->frameCount = frameCount;
+		createRingBuffer();
+	}
+}
+
+mtd::RingAllocation mtd::FrameRingBuffer::allocate(vk::DeviceSize size, vk::DeviceSize alignment)
+{
+	assert(ringBuffer && "The ring buffer frame must begin before allocating.");
+
+	vk::DeviceSize offset = (frameHead + alignment - 1UL) / alignment * alignment;
+	if(offset + size > frameCapacity)
+	{
+		// Earlier allocations of this frame keep referencing the retired buffer
+		while(frameCapacity < size)
+			frameCapacity *= 2UL;
+		frameCapacity *= 2UL;
+		createRingBuffer();
+
+		LOG_VERBOSE("Upload ring buffer grown to %d KiB per frame.", static_cast<uint32_t>(frameCapacity >> 10));
+		offset = 0UL;
+	}
+	frameHead = offset + size;
+
+	vk::DeviceSize bufferOffset = frameIndex * frameCapacity + offset;
+	const MemoryAllocation& allocation = ringBuffer->getAllocation();
+	return RingAllocation
+	{
+		ringBuffer->getBuffer(),
+		bufferOffset,
+		static_cast<char*>(allocation.pMappedData) + bufferOffset
+	};
+}
+
+void mtd::FrameRingBuffer::createRingBuffer()
+{
+	if(ringBuffer)
+		retiredBuffers.emplace_back(std::move(ringBuffer), frameCount);
+
+	ringBuffer = std::make_unique<GpuBuffer>
+	(
+		device,
+		frameCount * frameCapacity,
+		vk::BufferUsageFlagBits::eTransferSrc,
+		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+	);
+	frameHead = 0UL;
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "GpuBuffer.hpp"
+
+namespace mtd
+{
+	// Region reserved in the ring buffer for the current frame
+	struct RingAllocation
+	{
+		vk::Buffer buffer;
+		vk::DeviceSize offset;
+		void* pData;
+	};
+
+	// Persistently mapped upload buffer, split in one section per frame in flight
+	class FrameRingBuffer
+	{
+		public:
+			FrameRingBuffer(const Device& device, vk::DeviceSize frameCapacity);
+			~FrameRingBuffer() = default;
+
+			FrameRingBuffer(const FrameRingBuffer&) = delete;
+			FrameRingBuffer& operator=(const FrameRingBuffer&) = delete;
+
+			// Starts writing to the section of the frame, whose previous commands must have finished
+			void beginFrame(uint32_t frameIndex, uint32_t frameCount);
+
+			// Reserves memory in the current frame section, growing the ring if it is full
+			RingAllocation allocate(vk::DeviceSize size, vk::DeviceSize alignment);
+
+		private:
+			// Ring buffer in use, and the replaced ones, kept until the frames using them finish
+			std::unique_ptr<GpuBuffer> ringBuffer;
+			std::vector<std::pair<std::unique_ptr<GpuBuffer>, uint32_t>> retiredBuffers;
+
+			// Size of each frame section
+			vk::DeviceSize frameCapacity;
+			// Frames in flight, each one with its own section
+			uint32_t frameCount = 0U;
+			// Section of the current frame
+			uint32_t frameIndex = 0U;
+			// Bytes used in the current frame section
+			vk::DeviceSize frameHead = 0UL;
+
+			// Device reference
+			const Device& device;
+
+			// Creates a ring buffer with a section for each frame, retiring the current one
+			void createRingBuffer();
+	};
+}
@@ -3,9 +3,12 @@
 
 #include "../../Utils/Logger.hpp"
 
+// Alignment of buffers accessed by device address, enough for acceleration structure scratch buffers
+#define DEVICE_ADDRESS_ALIGNMENT 256UL
+
 mtd::GpuBuffer::GpuBuffer(const Device& device, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags memoryProperties)
 	: device{device}, size{0UL}, usage{usage}, memoryProperties{memoryProperties},
-	buffer{nullptr}, bufferMemory{nullptr}
+	buffer{nullptr}
 {}
 
 mtd::GpuBuffer::GpuBuffer
@@ -36,11 +39,9 @@ mtd::GpuBuffer::GpuBuffer
 
 mtd::GpuBuffer::~GpuBuffer()
 {
-	if(buffer && bufferMemory)
-	{
+	if(buffer)
 		device.getDevice().destroyBuffer(buffer);
-		device.getDevice().freeMemory(bufferMemory);
-	}
+	device.getMemoryAllocator().free(allocation);
 }
 
 mtd::GpuBuffer::GpuBuffer(GpuBuffer&& other) noexcept
@@ -49,15 +50,15 @@ mtd::GpuBuffer::GpuBuffer(GpuBuffer&& other) noexcept
 	usage{other.usage},
 	memoryProperties{other.memoryProperties},
 	buffer{other.buffer},
-	bufferMemory{other.bufferMemory}
+	allocation{other.allocation}
 {
 	other.buffer = nullptr;
-	other.bufferMemory = nullptr;
+	other.allocation = MemoryAllocation{};
 }
 
 vk::DeviceAddress mtd::GpuBuffer::getBufferAddress() const
 {
-	assert(bufferMemory && size != 0UL && "Invalid GPU buffer address.");
+	assert(allocation.memory && size != 0UL && "Invalid GPU buffer address.");
 
 	vk::BufferDeviceAddressInfo addressInfo{buffer};
 	return device.getDevice().getBufferAddress(addressInfo);
@@ -65,7 +66,7 @@ vk::DeviceAddress mtd::GpuBuffer::getBufferAddress() const
 
 void mtd::GpuBuffer::create(vk::DeviceSize dataSize)
 {
-	assert(!buffer && !bufferMemory && "The GPU buffer has already been created.");
+	assert(!buffer && !allocation.memory && "The GPU buffer has already been created.");
 
 	size = dataSize;
 
@@ -92,7 +93,7 @@ void mtd::GpuBuffer::createDeviceLocal
 	const CommandHandler& commandHandler, vk::DeviceSize dataSize, const void* data
 )
 {
-	assert(!buffer && !bufferMemory && "The GPU buffer has already been created.");
+	assert(!buffer && !allocation.memory && "The GPU buffer has already been created.");
 
 	GpuBuffer stagingBuffer
 	{
@@ -112,36 +113,28 @@ void mtd::GpuBuffer::createDeviceLocal
 	copyDataFromBuffer(stagingBuffer, commandHandler);
 }
 
-void mtd::GpuBuffer::resizeBuffer(const CommandHandler& commandHandler, vk::DeviceSize newSize)
+std::unique_ptr<mtd::GpuBuffer> mtd::GpuBuffer::resizeBuffer
+(
+	const CommandHandler& commandHandler, vk::DeviceSize newSize
+)
 {
-	assert(buffer && bufferMemory && "Cannot resize an invalid GPU buffer.");
+	assert(buffer && allocation.memory && "Cannot resize an invalid GPU buffer.");
 	
-	if(newSize == size) return;
-
-	GpuBuffer newBuffer
-	{
-		device,
-		newSize,
-		usage | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst,
-		memoryProperties
-	};
-	newBuffer.copyDataFromBuffer(*this, commandHandler);
+	if(newSize == size) return nullptr;
 
-	device.getDevice().destroyBuffer(buffer);
-	device.getDevice().freeMemory(bufferMemory);
+	return reallocate(commandHandler, newSize);
+}
 
-	buffer = newBuffer.buffer;
-	bufferMemory = newBuffer.bufferMemory;
-	size = newSize;
-	usage = newBuffer.usage;
+std::unique_ptr<mtd::GpuBuffer> mtd::GpuBuffer::relocate(const CommandHandler& commandHandler)
+{
+	assert(buffer && allocation.memory && "Cannot relocate an invalid GPU buffer.");
 
-	newBuffer.buffer = nullptr;
-	newBuffer.bufferMemory = nullptr;
+	return reallocate(commandHandler, size);
 }
 
 void mtd::GpuBuffer::copyMemoryToBuffer(vk::DeviceSize copySize, const void* srcData, vk::DeviceSize bufferOffset)
 {
-	assert(buffer && bufferMemory && "Cannot copy memory to an invalid GPU buffer.");
+	assert(buffer && allocation.memory && "Cannot copy memory to an invalid GPU buffer.");
 	assert(bufferOffset < size && "The buffer offset cannot be greater the the GPU buffer size.");
 
 	if(copySize > size - bufferOffset)
@@ -150,9 +143,35 @@ void mtd::GpuBuffer::copyMemoryToBuffer(vk::DeviceSize copySize, const void* src
 		LOG_WARNING("Copy size exceeded the available GPU buffer size. Only part of the data will be copied.");
 	}
 
-	void* memoryLocation = device.getDevice().mapMemory(bufferMemory, bufferOffset, copySize);
-	memcpy(memoryLocation, srcData, copySize);
-	device.getDevice().unmapMemory(bufferMemory);
+	if(!allocation.pMappedData)
+	{
+		LOG_ERROR("Cannot copy memory to a GPU buffer that is not host visible.");
+		return;
+	}
+
+	memcpy(static_cast<char*>(allocation.pMappedData) + bufferOffset, srcData, copySize);
+	device.getMemoryAllocator().flush(allocation, bufferOffset, copySize);
+}
+
+void mtd::GpuBuffer::copyBufferToMemory(vk::DeviceSize copySize, void* dstData, vk::DeviceSize bufferOffset) const
+{
+	assert(buffer && allocation.memory && "Cannot copy memory from an invalid GPU buffer.");
+	assert(bufferOffset < size && "The buffer offset cannot be greater the the GPU buffer size.");
+
+	if(copySize > size - bufferOffset)
+	{
+		copySize = size - bufferOffset;
+		LOG_WARNING("Copy size exceeded the available GPU buffer size. Only part of the data will be copied.");
+	}
+
+	if(!allocation.pMappedData)
+	{
+		LOG_ERROR("Cannot copy memory from a GPU buffer that is not host visible.");
+		return;
+	}
+
+	device.getMemoryAllocator().invalidate(allocation, bufferOffset, copySize);
+	memcpy(dstData, static_cast<const char*>(allocation.pMappedData) + bufferOffset, copySize);
 }
 
 void mtd::GpuBuffer::updateDescriptorInfo(vk::DescriptorBufferInfo& descriptorInfo) const
@@ -166,27 +185,41 @@ void mtd::GpuBuffer::updateDescriptorInfo(vk::DescriptorBufferInfo& descriptorIn
 
 void mtd::GpuBuffer::allocateBufferMemory()
 {
-	const vk::Device& vulkanDevice = device.getDevice();
-	vk::MemoryRequirements memoryRequirements = vulkanDevice.getBufferMemoryRequirements(buffer);
+	vk::DeviceSize minimumAlignment =
+		(usage & vk::BufferUsageFlagBits::eShaderDeviceAddress) ? DEVICE_ADDRESS_ALIGNMENT : 1UL;
 
-	vk::MemoryAllocateFlagsInfo memoryAllocateFlagsInfo{};
-	if(usage & vk::BufferUsageFlagBits::eShaderDeviceAddress)
-		memoryAllocateFlagsInfo.flags = vk::MemoryAllocateFlagBits::eDeviceAddress;
-
-	vk::MemoryAllocateInfo memoryAllocateInfo{};
-	memoryAllocateInfo.allocationSize = memoryRequirements.size;
-	memoryAllocateInfo.memoryTypeIndex =
-		Memory::findMemoryTypeIndex(device.getPhysicalDevice(), memoryRequirements.memoryTypeBits, memoryProperties);
-	memoryAllocateInfo.pNext = &memoryAllocateFlagsInfo;
+	if(!device.getMemoryAllocator().allocateBufferMemory(buffer, memoryProperties, allocation, minimumAlignment))
+		LOG_ERROR("Failed to allocate memory for buffer.");
+}
 
-	vk::Result result = vulkanDevice.allocateMemory(&memoryAllocateInfo, nullptr, &bufferMemory);
-	if(result != vk::Result::eSuccess)
+std::unique_ptr<mtd::GpuBuffer> mtd::GpuBuffer::reallocate
+(
+	const CommandHandler& commandHandler, vk::DeviceSize newSize
+)
+{
+	GpuBuffer newBuffer
 	{
-		LOG_ERROR("Failed to allocate memory for buffer. Vulkan result: %d", result);
-		return;
-	}
+		device,
+		newSize,
+		usage | vk::BufferUsageFlagBits::eTransferSrc | vk::BufferUsageFlagBits::eTransferDst,
+		memoryProperties
+	};
+	newBuffer.copyDataFromBuffer(*this, commandHandler);
 
-	vulkanDevice.bindBufferMemory(buffer, bufferMemory, 0UL);
+	// The replaced buffer takes over the old handles, since frames in flight may still be using them
+	std::unique_ptr<GpuBuffer> pReplacedBuffer = std::make_unique<GpuBuffer>(device, usage, memoryProperties);
+	pReplacedBuffer->buffer = buffer;
+	pReplacedBuffer->allocation = allocation;
+	pReplacedBuffer->size = size;
+
+	buffer = newBuffer.buffer;
+	allocation = newBuffer.allocation;
+	size = newSize;
+	usage = newBuffer.usage;
+
+	newBuffer.buffer = nullptr;
+	newBuffer.allocation = MemoryAllocation{};
+	return pReplacedBuffer;
 }
 
 void mtd::GpuBuffer::copyDataFromBuffer(const GpuBuffer& srcBuffer, const CommandHandler& commandHandler) const
@@ -195,6 +228,20 @@ void mtd::GpuBuffer::copyDataFromBuffer(const GpuBuffer& srcBuffer, const Comman
 
 	vk::CommandBuffer commandBuffer = commandHandler.beginSingleTimeCommand();
 
+	// Frames submitted earlier to the same queue may still be writing to the source buffer
+	vk::MemoryBarrier memoryBarrier{};
+	memoryBarrier.srcAccessMask = vk::AccessFlagBits::eMemoryWrite;
+	memoryBarrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+	commandBuffer.pipelineBarrier
+	(
+		vk::PipelineStageFlagBits::eAllCommands,
+		vk::PipelineStageFlagBits::eTransfer,
+		vk::DependencyFlags(),
+		memoryBarrier,
+		nullptr,
+		nullptr
+	);
+
 	vk::BufferCopy bufferCopy{};
 	bufferCopy.srcOffset = 0UL;
 	bufferCopy.dstOffset = 0UL;
@@ -204,24 +251,3 @@ void mtd::GpuBuffer::copyDataFromBuffer(const GpuBuffer& srcBuffer, const Comman
 
 	commandHandler.endSingleTimeCommand(commandBuffer);
 }
-
-uint32_t mtd::Memory::findMemoryTypeIndex
-(
-	const vk::PhysicalDevice& physicalDevice,
-	uint32_t supportedMemoryIndex,
-	vk::MemoryPropertyFlags requestedProperties
-)
-{
-	vk::PhysicalDeviceMemoryProperties memoryProperties = physicalDevice.getMemoryProperties();
-
-	for(uint32_t i = 0U; i < memoryProperties.memoryTypeCount; i++)
-	{
-		bool supported = static_cast<bool>(supportedMemoryIndex & (1U << i));
-		bool sufficient = (memoryProperties.memoryTypes[i].propertyFlags & requestedProperties) == requestedProperties;
-
-		if(supported && sufficient) return i;
-	}
-
-	LOG_ERROR("Could not find memory type index with the requested properties.");
-	return 0U;
-}
@@ -25,7 +25,7 @@ namespace mtd
 
 			// Getters
 			const vk::Buffer& getBuffer() const { return buffer; }
-			const vk::DeviceMemory& getBufferMemory() const { return bufferMemory; }
+			const MemoryAllocation& getAllocation() const { return allocation; }
 			vk::DeviceSize getSize() const { return size; }
 			vk::DeviceAddress getBufferAddress() const;
 
@@ -34,11 +34,16 @@ namespace mtd
 			// Initializes the buffer using device local memory
 			void createDeviceLocal(const CommandHandler& commandHandler, vk::DeviceSize dataSize, const void* data);
 
-			// Changes the buffer size by reallocating it
-			void resizeBuffer(const CommandHandler& commandHandler, vk::DeviceSize newSize);
+			// Changes the buffer size by reallocating it, returning the replaced buffer (if any), which must be kept
+			// until the GPU commands using it finish
+			std::unique_ptr<GpuBuffer> resizeBuffer(const CommandHandler& commandHandler, vk::DeviceSize newSize);
+			// Moves the buffer to a new memory region, keeping its data and returning the replaced buffer
+			std::unique_ptr<GpuBuffer> relocate(const CommandHandler& commandHandler);
 
 			// Copies data to the buffer
 			void copyMemoryToBuffer(vk::DeviceSize copySize, const void* srcData, vk::DeviceSize bufferOffset = 0);
+			// Copies data from the buffer to CPU memory
+			void copyBufferToMemory(vk::DeviceSize copySize, void* dstData, vk::DeviceSize bufferOffset = 0) const;
 
 			// Updates the descriptor info with the buffer data
 			void updateDescriptorInfo(vk::DescriptorBufferInfo& descriptorInfo) const;
@@ -46,7 +51,8 @@ namespace mtd
 		private:
 			// Vulkan buffer handles
 			vk::Buffer buffer;
-			vk::DeviceMemory bufferMemory;
+			// Memory region sub-allocated from the device memory allocator
+			MemoryAllocation allocation;
 
 			// Buffer data
 			vk::DeviceSize size;
@@ -58,19 +64,10 @@ namespace mtd
 
 			// Allocates memory for the buffer
 			void allocateBufferMemory();
+			// Recreates the buffer with the specified size in a new memory region, copying the data
+			std::unique_ptr<GpuBuffer> reallocate(const CommandHandler& commandHandler, vk::DeviceSize newSize);
 			// Copies the data from another buffer to this buffer
 			void copyDataFromBuffer(const GpuBuffer& srcBuffer, const CommandHandler& commandHandler) const;
 	};
 
-	// Handles GPU memory management
-	namespace Memory
-	{
-		// Finds the memory type index that fits the requirements
-		uint32_t findMemoryTypeIndex
-		(
-			const vk::PhysicalDevice& physicalDevice,
-			uint32_t supportedMemoryIndex,
-			vk::MemoryPropertyFlags requestedProperties
-		);
-	}
 }
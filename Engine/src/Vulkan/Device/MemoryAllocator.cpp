@@ -0,0 +1,577 @@
+#include <pch.hpp>
+#include "MemoryAllocator.hpp"
+
+#include <bit>
+
+#include "../../Utils/Logger.hpp"
+
+// Default size of the device memory blocks
+#define MEMORY_BLOCK_SIZE (64UL << 20)
+// Heaps smaller than this use blocks of an eighth of the heap size
+#define MEMORY_SMALL_HEAP_SIZE (1UL << 30)
+// Block usage below which its allocations should be moved, so the block can be released
+#define MEMORY_DEFRAGMENTATION_THRESHOLD 0.25
+// Subdivisions of each power of two size class, as a power of two
+#define MEMORY_SECOND_LEVEL_BITS 5U
+#define MEMORY_SECOND_LEVEL_COUNT (1U << MEMORY_SECOND_LEVEL_BITS)
+// Size classes of power of two sizes, enough for 64 bit sizes
+#define MEMORY_FIRST_LEVEL_COUNT (64U - MEMORY_SECOND_LEVEL_BITS + 1U)
+// Marks the absence of a node
+#define MEMORY_INVALID_NODE std::numeric_limits<uint32_t>::max()
+
+// Rounds the value up to a multiple of the alignment, which must be a power of two
+static vk::DeviceSize alignUp(vk::DeviceSize value, vk::DeviceSize alignment)
+{
+	return (value + alignment - 1UL) & ~(alignment - 1UL);
+}
+
+// Rounds the value down to a multiple of the alignment, which must be a power of two
+static vk::DeviceSize alignDown(vk::DeviceSize value, vk::DeviceSize alignment)
+{
+	return value & ~(alignment - 1UL);
+}
+
+// Maps a size to its free list, given by the first level (power of two) and the second level (subdivision)
+static void mapSizeToFreeList(vk::DeviceSize size, uint32_t& firstLevel, uint32_t& secondLevel)
+{
+	if(size < MEMORY_SECOND_LEVEL_COUNT)
+	{
+		firstLevel = 0U;
+		secondLevel = static_cast<uint32_t>(size);
+		return;
+	}
+
+	uint32_t mostSignificantBit = static_cast<uint32_t>(std::bit_width(size)) - 1U;
+	secondLevel = static_cast<uint32_t>(size >> (mostSignificantBit - MEMORY_SECOND_LEVEL_BITS)) ^
+		MEMORY_SECOND_LEVEL_COUNT;
+	firstLevel = mostSignificantBit - MEMORY_SECOND_LEVEL_BITS + 1U;
+}
+
+mtd::MemoryAllocator::MemoryAllocator
+(
+	const vk::Device& device, const vk::PhysicalDevice& physicalDevice, bool deviceAddressEnabled
+) : memoryProperties{physicalDevice.getMemoryProperties()},
+	nonCoherentAtomSize{physicalDevice.getProperties().limits.nonCoherentAtomSize},
+	deviceAddressEnabled{deviceAddressEnabled},
+	device{device}
+{
+	pools.resize(2UL * memoryProperties.memoryTypeCount);
+	for(uint32_t i = 0U; i < memoryProperties.memoryTypeCount; i++)
+	{
+		vk::DeviceSize heapSize = memoryProperties.memoryHeaps[memoryProperties.memoryTypes[i].heapIndex].size;
+		vk::DeviceSize blockSize = (heapSize < MEMORY_SMALL_HEAP_SIZE) ? heapSize / 8UL : MEMORY_BLOCK_SIZE;
+
+		pools[2U * i].blockSize = blockSize;
+		pools[2U * i + 1U].blockSize = blockSize;
+	}
+}
+
+mtd::MemoryAllocator::~MemoryAllocator()
+{
+	for(MemoryPool& pool: pools)
+	{
+		for(const std::unique_ptr<MemoryBlock>& block: pool.blocks)
+		{
+			if(block->getAllocationCount() != 0U)
+				LOG_WARNING("Memory block destroyed with %d allocations still in use.", block->getAllocationCount());
+
+			if(block->getMappedData())
+				device.unmapMemory(block->getMemory());
+			device.freeMemory(block->getMemory());
+		}
+	}
+
+	if(dedicatedAllocationCount != 0U)
+		LOG_WARNING("Memory allocator destroyed with %d dedicated allocations still in use.", dedicatedAllocationCount);
+}
+
+bool mtd::MemoryAllocator::allocateBufferMemory
+(
+	vk::Buffer buffer, vk::MemoryPropertyFlags properties, MemoryAllocation& allocation, vk::DeviceSize minimumAlignment
+)
+{
+	vk::MemoryRequirements requirements = device.getBufferMemoryRequirements(buffer);
+	requirements.alignment = std::max(requirements.alignment, minimumAlignment);
+
+	if(!allocate(requirements, properties, MemoryResourceType::Linear, allocation))
+		return false;
+
+	device.bindBufferMemory(buffer, allocation.memory, allocation.offset);
+	return true;
+}
+
+bool mtd::MemoryAllocator::allocateImageMemory
+(
+	vk::Image image, vk::ImageTiling tiling, vk::MemoryPropertyFlags properties, MemoryAllocation& allocation
+)
+{
+	vk::MemoryRequirements requirements = device.getImageMemoryRequirements(image);
+	MemoryResourceType resourceType =
+		(tiling == vk::ImageTiling::eLinear) ? MemoryResourceType::Linear : MemoryResourceType::Optimal;
+
+	if(!allocate(requirements, properties, resourceType, allocation))
+		return false;
+
+	device.bindImageMemory(image, allocation.memory, allocation.offset);
+	return true;
+}
+
+bool mtd::MemoryAllocator::allocate
+(
+	const vk::MemoryRequirements& requirements,
+	vk::MemoryPropertyFlags properties,
+	MemoryResourceType resourceType,
+	MemoryAllocation& allocation
+)
+{
+	assert(!allocation.memory && "The memory allocation is already in use.");
+
+	uint32_t memoryTypeIndex = findMemoryTypeIndex(requirements.memoryTypeBits, properties);
+	vk::DeviceSize alignment = requirements.alignment;
+	vk::DeviceSize allocationSize = requirements.size;
+	if(isNonCoherent(memoryTypeIndex))
+	{
+		alignment = std::max(alignment, nonCoherentAtomSize);
+		allocationSize = alignUp(allocationSize, nonCoherentAtomSize);
+	}
+
+	std::lock_guard<std::mutex> allocatorLock{allocatorMutex};
+	MemoryPool& pool = pools[2U * memoryTypeIndex + static_cast<uint32_t>(resourceType)];
+
+	// Large resources would waste most of a block, so they get their own device memory
+	if(allocationSize > pool.blockSize / 2UL)
+	{
+		if(!allocateDeviceMemory(allocationSize, memoryTypeIndex, allocation.memory, allocation.pMappedData))
+			return false;
+
+		allocation.offset = 0UL;
+		allocation.size = allocationSize;
+		allocation.pBlock = nullptr;
+		allocation.memoryTypeIndex = memoryTypeIndex;
+
+		dedicatedAllocationCount++;
+		dedicatedAllocationBytes += allocationSize;
+		return true;
+	}
+
+	for(const std::unique_ptr<MemoryBlock>& block: pool.blocks)
+	{
+		if(block->allocate(allocationSize, alignment, allocation))
+		{
+			allocation.memoryTypeIndex = memoryTypeIndex;
+			return true;
+		}
+	}
+
+	vk::DeviceMemory blockMemory = nullptr;
+	void* pBlockMappedData = nullptr;
+	if(!allocateDeviceMemory(pool.blockSize, memoryTypeIndex, blockMemory, pBlockMappedData))
+		return false;
+
+	MemoryBlock& block =
+		*pool.blocks.emplace_back(std::make_unique<MemoryBlock>(blockMemory, pool.blockSize, pBlockMappedData));
+	if(!block.allocate(allocationSize, alignment, allocation))
+	{
+		LOG_ERROR
+		(
+			"Failed to sub-allocate %llu bytes from a new memory block.", static_cast<unsigned long long>(allocationSize)
+		);
+		return false;
+	}
+
+	allocation.memoryTypeIndex = memoryTypeIndex;
+	return true;
+}
+
+void mtd::MemoryAllocator::free(MemoryAllocation& allocation)
+{
+	if(!allocation.memory) return;
+
+	std::lock_guard<std::mutex> allocatorLock{allocatorMutex};
+
+	if(!allocation.pBlock)
+	{
+		if(allocation.pMappedData)
+			device.unmapMemory(allocation.memory);
+		device.freeMemory(allocation.memory);
+
+		dedicatedAllocationCount--;
+		dedicatedAllocationBytes -= allocation.size;
+		allocation = MemoryAllocation{};
+		return;
+	}
+
+	MemoryBlock* pBlock = allocation.pBlock;
+	pBlock->free(allocation.nodeIndex);
+	allocation = MemoryAllocation{};
+
+	if(pBlock->getAllocationCount() != 0U) return;
+
+	// A single empty block is kept per pool, avoiding reallocations when resources are recreated
+	for(MemoryPool& pool: pools)
+	{
+		auto blockIterator = std::find_if
+		(
+			pool.blocks.begin(),
+			pool.blocks.end(),
+			[pBlock](const std::unique_ptr<MemoryBlock>& block) { return block.get() == pBlock; }
+		);
+		if(blockIterator == pool.blocks.end()) continue;
+
+		uint32_t emptyBlockCount = static_cast<uint32_t>(std::count_if
+		(
+			pool.blocks.cbegin(),
+			pool.blocks.cend(),
+			[](const std::unique_ptr<MemoryBlock>& block) { return block->getAllocationCount() == 0U; }
+		));
+		if(emptyBlockCount > 1U)
+		{
+			if(pBlock->getMappedData())
+				device.unmapMemory(pBlock->getMemory());
+			device.freeMemory(pBlock->getMemory());
+			pool.blocks.erase(blockIterator);
+		}
+		return;
+	}
+}
+
+void mtd::MemoryAllocator::flush(const MemoryAllocation& allocation, vk::DeviceSize offset, vk::DeviceSize size) const
+{
+	if(!isNonCoherent(allocation.memoryTypeIndex)) return;
+
+	vk::DeviceSize memorySize = allocation.pBlock ? allocation.pBlock->getSize() : allocation.size;
+	vk::DeviceSize rangeBegin = alignDown(allocation.offset + offset, nonCoherentAtomSize);
+	vk::DeviceSize rangeEnd = std::min(alignUp(allocation.offset + offset + size, nonCoherentAtomSize), memorySize);
+
+	vk::MappedMemoryRange memoryRange{allocation.memory, rangeBegin, rangeEnd - rangeBegin};
+	(void) device.flushMappedMemoryRanges(1U, &memoryRange);
+}
+
+void mtd::MemoryAllocator::invalidate
+(
+	const MemoryAllocation& allocation, vk::DeviceSize offset, vk::DeviceSize size
+) const
+{
+	if(!isNonCoherent(allocation.memoryTypeIndex)) return;
+
+	vk::DeviceSize memorySize = allocation.pBlock ? allocation.pBlock->getSize() : allocation.size;
+	vk::DeviceSize rangeBegin = alignDown(allocation.offset + offset, nonCoherentAtomSize);
+	vk::DeviceSize rangeEnd = std::min(alignUp(allocation.offset + offset + size, nonCoherentAtomSize), memorySize);
+
+	vk::MappedMemoryRange memoryRange{allocation.memory, rangeBegin, rangeEnd - rangeBegin};
+	(void) device.invalidateMappedMemoryRanges(1U, &memoryRange);
+}
+
+bool mtd::MemoryAllocator::shouldRelocate(const MemoryAllocation& allocation) const
+{
+	if(!allocation.pBlock) return false;
+
+	std::lock_guard<std::mutex> allocatorLock{allocatorMutex};
+
+	// New allocations fill the first blocks, so moving out of a sparse later block tends to empty it
+	for(const MemoryPool& pool: pools)
+	{
+		if(pool.blocks.size() < 2UL || pool.blocks.front().get() == allocation.pBlock) continue;
+
+		for(const std::unique_ptr<MemoryBlock>& block: pool.blocks)
+		{
+			if(block.get() != allocation.pBlock) continue;
+
+			return static_cast<double>(block->getUsedSize()) <
+				MEMORY_DEFRAGMENTATION_THRESHOLD * static_cast<double>(block->getSize());
+		}
+	}
+	return false;
+}
+
+void mtd::MemoryAllocator::releaseEmptyBlocks()
+{
+	std::lock_guard<std::mutex> allocatorLock{allocatorMutex};
+
+	for(MemoryPool& pool: pools)
+	{
+		std::erase_if(pool.blocks, [this](const std::unique_ptr<MemoryBlock>& block)
+		{
+			if(block->getAllocationCount() != 0U) return false;
+
+			if(block->getMappedData())
+				device.unmapMemory(block->getMemory());
+			device.freeMemory(block->getMemory());
+			return true;
+		});
+	}
+}
+
+mtd::MemoryStatistics mtd::MemoryAllocator::getStatistics() const
+{
+	std::lock_guard<std::mutex> allocatorLock{allocatorMutex};
+
+	MemoryStatistics statistics{};
+	statistics.dedicatedAllocationCount = dedicatedAllocationCount;
+	statistics.allocationCount = dedicatedAllocationCount;
+	statistics.reservedBytes = dedicatedAllocationBytes;
+	statistics.usedBytes = dedicatedAllocationBytes;
+
+	for(const MemoryPool& pool: pools)
+	{
+		for(const std::unique_ptr<MemoryBlock>& block: pool.blocks)
+		{
+			statistics.blockCount++;
+			statistics.allocationCount += block->getAllocationCount();
+			statistics.freeRangeCount += block->getFreeRangeCount();
+			statistics.reservedBytes += block->getSize();
+			statistics.usedBytes += block->getUsedSize();
+		}
+	}
+	return statistics;
+}
+
+bool mtd::MemoryAllocator::allocateDeviceMemory
+(
+	vk::DeviceSize size, uint32_t memoryTypeIndex, vk::DeviceMemory& memory, void*& pMappedData
+) const
+{
+	vk::MemoryAllocateFlagsInfo memoryAllocateFlagsInfo{};
+	if(deviceAddressEnabled)
+		memoryAllocateFlagsInfo.flags = vk::MemoryAllocateFlagBits::eDeviceAddress;
+
+	vk::MemoryAllocateInfo memoryAllocateInfo{};
+	memoryAllocateInfo.allocationSize = size;
+	memoryAllocateInfo.memoryTypeIndex = memoryTypeIndex;
+	memoryAllocateInfo.pNext = &memoryAllocateFlagsInfo;
+
+	vk::Result result = device.allocateMemory(&memoryAllocateInfo, nullptr, &memory);
+	if(result != vk::Result::eSuccess)
+	{
+		LOG_ERROR
+		(
+			"Failed to allocate %llu bytes of device memory. Vulkan result: %d",
+			static_cast<unsigned long long>(size),
+			result
+		);
+		memory = nullptr;
+		return false;
+	}
+
+	// Host visible memory stays mapped, as different resources in the same block cannot map it concurrently
+	pMappedData = nullptr;
+	if(memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible)
+		pMappedData = device.mapMemory(memory, 0UL, vk::WholeSize);
+
+	return true;
+}
+
+uint32_t mtd::MemoryAllocator::findMemoryTypeIndex
+(
+	uint32_t supportedMemoryIndex, vk::MemoryPropertyFlags requestedProperties
+) const
+{
+	for(uint32_t i = 0U; i < memoryProperties.memoryTypeCount; i++)
+	{
+		bool supported = static_cast<bool>(supportedMemoryIndex & (1U << i));
+		bool sufficient = (memoryProperties.memoryTypes[i].propertyFlags & requestedProperties) == requestedProperties;
+
+		if(supported && sufficient) return i;
+	}
+
+	LOG_ERROR("Could not find memory type index with the requested properties.");
+	return 0U;
+}
+
+bool mtd::MemoryAllocator::isNonCoherent(uint32_t memoryTypeIndex) const
+{
+	vk::MemoryPropertyFlags propertyFlags = memoryProperties.memoryTypes[memoryTypeIndex].propertyFlags;
+	return (propertyFlags & vk::MemoryPropertyFlagBits::eHostVisible) &&
+		!(propertyFlags & vk::MemoryPropertyFlagBits::eHostCoherent);
+}
+
+mtd::MemoryBlock::MemoryBlock(vk::DeviceMemory memory, vk::DeviceSize size, void* pMappedData)
+	: memory{memory}, size{size}, pMappedData{pMappedData},
+	secondLevelBitmaps(MEMORY_FIRST_LEVEL_COUNT, 0U),
+	freeListHeads(MEMORY_FIRST_LEVEL_COUNT * MEMORY_SECOND_LEVEL_COUNT, MEMORY_INVALID_NODE)
+{
+	insertFreeNode(createNode(0UL, size));
+}
+
+bool mtd::MemoryBlock::allocate(vk::DeviceSize allocationSize, vk::DeviceSize alignment, MemoryAllocation& allocation)
+{
+	// Searching for the worst case padding guarantees the aligned allocation fits in the node found
+	uint32_t nodeIndex = findFreeNode(allocationSize + alignment - 1UL);
+	if(nodeIndex == MEMORY_INVALID_NODE) return false;
+
+	removeFreeNode(nodeIndex);
+
+	vk::DeviceSize padding = alignUp(nodes[nodeIndex].offset, alignment) - nodes[nodeIndex].offset;
+	if(padding > 0UL)
+	{
+		uint32_t paddingIndex = createNode(nodes[nodeIndex].offset, padding);
+		Node& paddingNode = nodes[paddingIndex];
+		Node& node = nodes[nodeIndex];
+
+		paddingNode.previousPhysical = node.previousPhysical;
+		paddingNode.nextPhysical = nodeIndex;
+		if(node.previousPhysical != MEMORY_INVALID_NODE)
+			nodes[node.previousPhysical].nextPhysical = paddingIndex;
+		node.previousPhysical = paddingIndex;
+		node.offset += padding;
+		node.size -= padding;
+
+		insertFreeNode(paddingIndex);
+	}
+
+	vk::DeviceSize remainingSize = nodes[nodeIndex].size - allocationSize;
+	if(remainingSize > 0UL)
+	{
+		uint32_t remainderIndex = createNode(nodes[nodeIndex].offset + allocationSize, remainingSize);
+		Node& remainderNode = nodes[remainderIndex];
+		Node& node = nodes[nodeIndex];
+
+		remainderNode.previousPhysical = nodeIndex;
+		remainderNode.nextPhysical = node.nextPhysical;
+		if(node.nextPhysical != MEMORY_INVALID_NODE)
+			nodes[node.nextPhysical].previousPhysical = remainderIndex;
+		node.nextPhysical = remainderIndex;
+		node.size = allocationSize;
+
+		insertFreeNode(remainderIndex);
+	}
+
+	Node& node = nodes[nodeIndex];
+	node.free = false;
+	usedSize += node.size;
+	allocationCount++;
+
+	allocation.memory = memory;
+	allocation.offset = node.offset;
+	allocation.size = node.size;
+	allocation.pMappedData = pMappedData ? static_cast<char*>(pMappedData) + node.offset : nullptr;
+	allocation.pBlock = this;
+	allocation.nodeIndex = nodeIndex;
+	return true;
+}
+
+void mtd::MemoryBlock::free(uint32_t nodeIndex)
+{
+	assert(nodeIndex < nodes.size() && !nodes[nodeIndex].free && "Invalid memory block node to free.");
+
+	usedSize -= nodes[nodeIndex].size;
+	allocationCount--;
+
+	uint32_t previousIndex = nodes[nodeIndex].previousPhysical;
+	if(previousIndex != MEMORY_INVALID_NODE && nodes[previousIndex].free)
+	{
+		removeFreeNode(previousIndex);
+
+		Node& previousNode = nodes[previousIndex];
+		previousNode.size += nodes[nodeIndex].size;
+		previousNode.nextPhysical = nodes[nodeIndex].nextPhysical;
+		if(previousNode.nextPhysical != MEMORY_INVALID_NODE)
+			nodes[previousNode.nextPhysical].previousPhysical = previousIndex;
+
+		unusedNodes.push_back(nodeIndex);
+		nodeIndex = previousIndex;
+	}
+
+	uint32_t nextIndex = nodes[nodeIndex].nextPhysical;
+	if(nextIndex != MEMORY_INVALID_NODE && nodes[nextIndex].free)
+	{
+		removeFreeNode(nextIndex);
+
+		Node& node = nodes[nodeIndex];
+		node.size += nodes[nextIndex].size;
+		node.nextPhysical = nodes[nextIndex].nextPhysical;
+		if(node.nextPhysical != MEMORY_INVALID_NODE)
+			nodes[node.nextPhysical].previousPhysical = nodeIndex;
+
+		unusedNodes.push_back(nextIndex);
+	}
+
+	insertFreeNode(nodeIndex);
+}
+
+uint32_t mtd::MemoryBlock::createNode(vk::DeviceSize offset, vk::DeviceSize nodeSize)
+{
+	Node node{offset, nodeSize, MEMORY_INVALID_NODE, MEMORY_INVALID_NODE, MEMORY_INVALID_NODE, MEMORY_INVALID_NODE, false};
+	if(unusedNodes.empty())
+	{
+		nodes.push_back(node);
+		return static_cast<uint32_t>(nodes.size() - 1UL);
+	}
+
+	uint32_t nodeIndex = unusedNodes.back();
+	unusedNodes.pop_back();
+	nodes[nodeIndex] = node;
+	return nodeIndex;
+}
+
+void mtd::MemoryBlock::insertFreeNode(uint32_t nodeIndex)
+{
+	uint32_t firstLevel, secondLevel;
+	mapSizeToFreeList(nodes[nodeIndex].size, firstLevel, secondLevel);
+	uint32_t& listHead = freeListHeads[firstLevel * MEMORY_SECOND_LEVEL_COUNT + secondLevel];
+
+	Node& node = nodes[nodeIndex];
+	node.free = true;
+	node.previousFree = MEMORY_INVALID_NODE;
+	node.nextFree = listHead;
+	if(listHead != MEMORY_INVALID_NODE)
+		nodes[listHead].previousFree = nodeIndex;
+	listHead = nodeIndex;
+
+	firstLevelBitmap |= (1ULL << firstLevel);
+	secondLevelBitmaps[firstLevel] |= (1U << secondLevel);
+	freeRangeCount++;
+}
+
+void mtd::MemoryBlock::removeFreeNode(uint32_t nodeIndex)
+{
+	uint32_t firstLevel, secondLevel;
+	mapSizeToFreeList(nodes[nodeIndex].size, firstLevel, secondLevel);
+	uint32_t& listHead = freeListHeads[firstLevel * MEMORY_SECOND_LEVEL_COUNT + secondLevel];
+
+	Node& node = nodes[nodeIndex];
+	if(node.previousFree != MEMORY_INVALID_NODE)
+		nodes[node.previousFree].nextFree = node.nextFree;
+	if(node.nextFree != MEMORY_INVALID_NODE)
+		nodes[node.nextFree].previousFree = node.previousFree;
+	if(listHead == nodeIndex)
+		listHead = node.nextFree;
+	node.free = false;
+
+	if(listHead == MEMORY_INVALID_NODE)
+	{
+		secondLevelBitmaps[firstLevel] &= ~(1U << secondLevel);
+		if(secondLevelBitmaps[firstLevel] == 0U)
+			firstLevelBitmap &= ~(1ULL << firstLevel);
+	}
+	freeRangeCount--;
+}
+
+uint32_t mtd::MemoryBlock::findFreeNode(vk::DeviceSize minimumSize) const
+{
+	// Rounding up to the next list guarantees that any node in the lists searched is large enough
+	if(minimumSize >= MEMORY_SECOND_LEVEL_COUNT)
+	{
+		uint32_t mostSignificantBit = static_cast<uint32_t>(std::bit_width(minimumSize)) - 1U;
+		minimumSize += (1ULL << (mostSignificantBit - MEMORY_SECOND_LEVEL_BITS)) - 1UL;
+	}
+
+	uint32_t firstLevel, secondLevel;
+	mapSizeToFreeList(minimumSize, firstLevel, secondLevel);
+	if(firstLevel >= MEMORY_FIRST_LEVEL_COUNT) return MEMORY_INVALID_NODE;
+
+	uint32_t secondLevelMap = secondLevelBitmaps[firstLevel] & (~0U << secondLevel);
+	if(secondLevelMap == 0U)
+	{
+		if(firstLevel + 1U >= MEMORY_FIRST_LEVEL_COUNT) return MEMORY_INVALID_NODE;
+
+		uint64_t firstLevelMap = firstLevelBitmap & (~0ULL << (firstLevel + 1U));
+		if(firstLevelMap == 0ULL) return MEMORY_INVALID_NODE;
+
+		firstLevel = static_cast<uint32_t>(std::countr_zero(firstLevelMap));
+		secondLevelMap = secondLevelBitmaps[firstLevel];
+	}
+
+	secondLevel = static_cast<uint32_t>(std::countr_zero(secondLevelMap));
+	return freeListHeads[firstLevel * MEMORY_SECOND_LEVEL_COUNT + secondLevel];
+}
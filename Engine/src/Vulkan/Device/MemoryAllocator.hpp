@@ -0,0 +1,189 @@
+#pragma once
+
+namespace mtd
+{
+	class MemoryBlock;
+
+	// Kind of resource bound to an allocation, kept in separate blocks to respect the buffer-image granularity
+	enum class MemoryResourceType
+	{
+		Linear,
+		Optimal
+	};
+
+	// Region of device memory bound to a resource
+	struct MemoryAllocation
+	{
+		vk::DeviceMemory memory = nullptr;
+		vk::DeviceSize offset = 0UL;
+		vk::DeviceSize size = 0UL;
+		// Persistent mapping of the region, or null if the memory is not host visible
+		void* pMappedData = nullptr;
+
+		// Block containing the allocation, or null for dedicated allocations
+		MemoryBlock* pBlock = nullptr;
+		uint32_t nodeIndex = 0U;
+		uint32_t memoryTypeIndex = 0U;
+	};
+
+	// Memory usage information of the allocator
+	struct MemoryStatistics
+	{
+		uint32_t blockCount = 0U;
+		uint32_t allocationCount = 0U;
+		uint32_t dedicatedAllocationCount = 0U;
+		uint32_t freeRangeCount = 0U;
+		vk::DeviceSize reservedBytes = 0UL;
+		vk::DeviceSize usedBytes = 0UL;
+	};
+
+	// Sub-allocates resources from large device memory blocks, one set of blocks per memory type
+	class MemoryAllocator
+	{
+		public:
+			MemoryAllocator(const vk::Device& device, const vk::PhysicalDevice& physicalDevice, bool deviceAddressEnabled);
+			~MemoryAllocator();
+
+			MemoryAllocator(const MemoryAllocator&) = delete;
+			MemoryAllocator& operator=(const MemoryAllocator&) = delete;
+
+			// Allocates and binds memory for a buffer
+			bool allocateBufferMemory
+			(
+				vk::Buffer buffer,
+				vk::MemoryPropertyFlags properties,
+				MemoryAllocation& allocation,
+				vk::DeviceSize minimumAlignment = 1UL
+			);
+			// Allocates and binds memory for an image
+			bool allocateImageMemory
+			(
+				vk::Image image, vk::ImageTiling tiling, vk::MemoryPropertyFlags properties, MemoryAllocation& allocation
+			);
+
+			// Allocates memory fitting the requirements, using a dedicated allocation for large resources
+			bool allocate
+			(
+				const vk::MemoryRequirements& requirements,
+				vk::MemoryPropertyFlags properties,
+				MemoryResourceType resourceType,
+				MemoryAllocation& allocation
+			);
+			// Releases the allocation, returning the region to its block
+			void free(MemoryAllocation& allocation);
+
+			// Makes host writes visible to the device, for non-coherent memory
+			void flush(const MemoryAllocation& allocation, vk::DeviceSize offset, vk::DeviceSize size) const;
+			// Makes device writes visible to the host, for non-coherent memory
+			void invalidate(const MemoryAllocation& allocation, vk::DeviceSize offset, vk::DeviceSize size) const;
+
+			// Defragmentation hook: checks if moving the resource would help releasing a sparsely used block
+			bool shouldRelocate(const MemoryAllocation& allocation) const;
+			// Frees the device memory of all blocks without allocations
+			void releaseEmptyBlocks();
+
+			// Gathers the current memory usage
+			MemoryStatistics getStatistics() const;
+
+		private:
+			// Blocks sharing a memory type and resource type
+			struct MemoryPool
+			{
+				std::vector<std::unique_ptr<MemoryBlock>> blocks;
+				vk::DeviceSize blockSize = 0UL;
+			};
+
+			// Pools indexed by memory type and resource type
+			std::vector<MemoryPool> pools;
+			// Memory properties of the physical device
+			vk::PhysicalDeviceMemoryProperties memoryProperties;
+			// Alignment for flushing non-coherent memory
+			vk::DeviceSize nonCoherentAtomSize;
+			// Flags if the memory must support buffer device addresses
+			bool deviceAddressEnabled;
+
+			// Dedicated allocations, to be counted in the statistics
+			uint32_t dedicatedAllocationCount = 0U;
+			vk::DeviceSize dedicatedAllocationBytes = 0UL;
+
+			// Guards the pools, as resources may be created from multiple threads
+			mutable std::mutex allocatorMutex;
+
+			// Device reference
+			const vk::Device& device;
+
+			// Allocates a device memory object, mapping it if host visible
+			bool allocateDeviceMemory
+			(
+				vk::DeviceSize size, uint32_t memoryTypeIndex, vk::DeviceMemory& memory, void*& pMappedData
+			) const;
+			// Finds the first memory type index that fits the requirements
+			uint32_t findMemoryTypeIndex(uint32_t supportedMemoryIndex, vk::MemoryPropertyFlags requestedProperties) const;
+			// Checks if the memory type needs explicit flushes and invalidations
+			bool isNonCoherent(uint32_t memoryTypeIndex) const;
+	};
+
+	// Range of device memory from which allocations are sub-allocated with a two-level segregated fit
+	class MemoryBlock
+	{
+		public:
+			MemoryBlock(vk::DeviceMemory memory, vk::DeviceSize size, void* pMappedData);
+			~MemoryBlock() = default;
+
+			MemoryBlock(const MemoryBlock&) = delete;
+			MemoryBlock& operator=(const MemoryBlock&) = delete;
+
+			// Getters
+			vk::DeviceMemory getMemory() const { return memory; }
+			vk::DeviceSize getSize() const { return size; }
+			vk::DeviceSize getUsedSize() const { return usedSize; }
+			uint32_t getAllocationCount() const { return allocationCount; }
+			uint32_t getFreeRangeCount() const { return freeRangeCount; }
+			void* getMappedData() const { return pMappedData; }
+
+			// Finds a free range fitting the size and alignment, returning false if none fits
+			bool allocate(vk::DeviceSize allocationSize, vk::DeviceSize alignment, MemoryAllocation& allocation);
+			// Returns the range to the free lists, merging it with its free neighbours
+			void free(uint32_t nodeIndex);
+
+		private:
+			// Contiguous range of the block, either allocated or free
+			struct Node
+			{
+				vk::DeviceSize offset;
+				vk::DeviceSize size;
+				uint32_t previousPhysical;
+				uint32_t nextPhysical;
+				uint32_t previousFree;
+				uint32_t nextFree;
+				bool free;
+			};
+
+			// Device memory handles
+			vk::DeviceMemory memory;
+			vk::DeviceSize size;
+			void* pMappedData;
+
+			// Range nodes, with the indices of the unused ones
+			std::vector<Node> nodes;
+			std::vector<uint32_t> unusedNodes;
+
+			// Bitmaps of non-empty free lists, and the first free node of each list
+			uint64_t firstLevelBitmap = 0UL;
+			std::vector<uint32_t> secondLevelBitmaps;
+			std::vector<uint32_t> freeListHeads;
+
+			// Usage counters
+			vk::DeviceSize usedSize = 0UL;
+			uint32_t allocationCount = 0U;
+			uint32_t freeRangeCount = 0U;
+
+			// Creates a node, reusing an unused one if available
+			uint32_t createNode(vk::DeviceSize offset, vk::DeviceSize nodeSize);
+			// Adds or removes a free node from its free list
+			void insertFreeNode(uint32_t nodeIndex);
+			void removeFreeNode(uint32_t nodeIndex);
+			// Finds a free node with at least the specified size
+			uint32_t findFreeNode(vk::DeviceSize minimumSize) const;
+	};
+}
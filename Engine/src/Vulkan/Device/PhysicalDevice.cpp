@@ -3,7 +3,8 @@
 
 #include "../../Utils/Logger.hpp"
 
-mtd::PhysicalDevice::PhysicalDevice(const vk::Instance& vulkanInstance) : physicalDevice{nullptr}
+mtd::PhysicalDevice::PhysicalDevice(const vk::Instance& vulkanInstance, bool requiresPresentation)
+	: physicalDevice{nullptr}, presentationRequired{requiresPresentation}
 {
 	std::vector<vk::PhysicalDevice> availableDevices = vulkanInstance.enumeratePhysicalDevices();
 	LOG_VERBOSE("There are %d device(s) available.", availableDevices.size());
@@ -89,6 +90,8 @@ void mtd::PhysicalDevice::selectPhysicalDevice
 // Checks if the available device is appropriate for usage
 bool mtd::PhysicalDevice::isDeviceSuitable(const vk::PhysicalDevice& availableDevice)
 {
+	if(!presentationRequired) return true;
+
 	const std::vector<vk::ExtensionProperties> availableExtensions =
 		availableDevice.enumerateDeviceExtensionProperties();
 
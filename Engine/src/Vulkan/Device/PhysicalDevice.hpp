@@ -8,7 +8,7 @@ namespace mtd
 	class PhysicalDevice
 	{
 		public:
-			PhysicalDevice(const vk::Instance& vulkanInstance);
+			PhysicalDevice(const vk::Instance& vulkanInstance, bool requiresPresentation);
 			~PhysicalDevice() = default;
 
 			PhysicalDevice(const PhysicalDevice&) = delete;
@@ -32,6 +32,9 @@ namespace mtd
 			vk::PhysicalDeviceProperties2 properties;
 			vk::PhysicalDeviceRayTracingPipelinePropertiesKHR rayTracingProperties;
 
+			// Whether the device must support presenting to a surface (false when rendering headless)
+			bool presentationRequired;
+
 			// Selects a physical with the specified type
 			void selectPhysicalDevice
 			(
@@ -21,7 +21,13 @@ mtd::QueueFamilies::QueueFamilies
 			LOG_VERBOSE("Queue family %d is suitable for graphics.", i);
 		}
 
-		if(physicalDevice.getSurfaceSupportKHR(i, surface))
+		// Without a surface (headless rendering), the graphics queue family stands in for the present one
+		if(!surface && graphicsFamilyIndex.has_value())
+		{
+			presentFamilyIndex = graphicsFamilyIndex;
+			LOG_VERBOSE("No surface to present. Queue family %d will be used without presentation.", i);
+		}
+		else if(surface && physicalDevice.getSurfaceSupportKHR(i, surface))
 		{
 			presentFamilyIndex = i;
 			if(graphicsFamilyIndex != i)
@@ -37,6 +43,8 @@ mtd::QueueFamilies::QueueFamilies
 		LOG_ERROR("The available queue families does not support all required features.");
 		return;
 	}
+
+	selectTransferFamily(queueFamilyProperties);
 }
 
 // Checks if all queue famuly indices have been set
@@ -53,3 +61,21 @@ void mtd::QueueFamilies::addIndexToVector(uint32_t index)
 
 	queueFamilyIndices.push_back(index);
 }
+
+// Selects a transfer-only queue family, falling back to the graphics queue family
+void mtd::QueueFamilies::selectTransferFamily(const std::vector<vk::QueueFamilyProperties>& queueFamilyProperties)
+{
+	transferFamilyIndex = graphicsFamilyIndex;
+
+	for(uint32_t i = 0; i < queueFamilyProperties.size(); i++)
+	{
+		// Queue families without graphics and compute usually map to the dedicated DMA engines
+		const vk::QueueFlags& flags = queueFamilyProperties[i].queueFlags;
+		if((flags & vk::QueueFlagBits::eTransfer) && !(flags & (vk::QueueFlagBits::eGraphics | vk::QueueFlagBits::eCompute)))
+		{
+			transferFamilyIndex = i;
+			LOG_VERBOSE("Queue family %d is dedicated to transfers.", i);
+			return;
+		}
+	}
+}
@@ -19,6 +19,7 @@ namespace mtd
 			// Getters
 			uint32_t getGraphicsFamilyIndex() const { return graphicsFamilyIndex.value(); }
 			uint32_t getPresentFamilyIndex() const { return presentFamilyIndex.value(); }
+			uint32_t getTransferFamilyIndex() const { return transferFamilyIndex.value(); }
 			const std::vector<uint32_t>& getUniqueIndices() const { return queueFamilyIndices; }
 
 		private:
@@ -26,6 +27,8 @@ namespace mtd
 			std::optional<uint32_t> graphicsFamilyIndex;
 			// Stores the queue family index that supports surface presentation
 			std::optional<uint32_t> presentFamilyIndex;
+			// Stores the queue family index used for uploads, dedicated to transfers if available
+			std::optional<uint32_t> transferFamilyIndex;
 
 			// Unique queue family indices
 			std::vector<uint32_t> queueFamilyIndices;
@@ -34,5 +37,7 @@ namespace mtd
 			inline bool isComplete() const;
 			// Adds queue family index to vector if unique
 			void addIndexToVector(uint32_t index);
+			// Selects a transfer-only queue family, falling back to the graphics queue family
+			void selectTransferFamily(const std::vector<vk::QueueFamilyProperties>& queueFamilyProperties);
 	};
 }
@@ -15,6 +15,8 @@ vk::BufferUsageFlags mtd::EnumMapping::getBufferUsage(GpuBufferType bufferType)
         bufferUsage |= (vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
     if((bufferType & GpuBufferType::Index) != GpuBufferType::None)
         bufferUsage |= (vk::BufferUsageFlagBits::eIndexBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
+    if((bufferType & GpuBufferType::Indirect) != GpuBufferType::None)
+        bufferUsage |= (vk::BufferUsageFlagBits::eIndirectBuffer | vk::BufferUsageFlagBits::eStorageBuffer);
 
     if((bufferType & GpuBufferType::TransferSource) != GpuBufferType::None)
         bufferUsage |= vk::BufferUsageFlagBits::eTransferSrc;
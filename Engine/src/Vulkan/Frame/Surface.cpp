@@ -2,10 +2,11 @@
 #include "Surface.hpp"
 
 mtd::Surface::Surface(const vk::Instance& instance, const WindowHandler* pWindowHandler)
-	: instance{instance}, surface{pWindowHandler->createSurface(instance)}
+	: instance{instance}, surface{pWindowHandler ? pWindowHandler->createSurface(instance) : nullptr}
 {}
 
 mtd::Surface::~Surface()
 {
-	instance.destroySurfaceKHR(surface);
+	if(surface)
+		instance.destroySurfaceKHR(surface);
 }
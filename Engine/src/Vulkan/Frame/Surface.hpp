@@ -4,7 +4,7 @@
 
 namespace mtd
 {
-	// Handles the Vulkan surface of the window
+	// Handles the Vulkan surface of the window (null when rendering headless)
 	class Surface
 	{
 		public:
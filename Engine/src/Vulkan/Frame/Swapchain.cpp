@@ -3,14 +3,26 @@
 
 #include "../../Utils/Logger.hpp"
 
-mtd::Swapchain::Swapchain(const Device& device, vk::SurfaceKHR surface, UIntVec2 frameDimensions)
-	: swapchain{nullptr}, device{device.getDevice()}
+mtd::Swapchain::Swapchain
+(
+	const Device& device, ResourceManager& resourceManager, vk::SurfaceKHR surface, UIntVec2 frameDimensions
+) : swapchain{nullptr}, headless{!surface}, device{device.getDevice()}, resourceManager{resourceManager}
 {
 	configureDefaultSettings();
-	getSupportedDetails(device.getPhysicalDevice(), surface);
-	checkImageCount();
-	selectExtent(frameDimensions);
-	createSwapchain(device, surface);
+
+	if(headless)
+	{
+		extent = vk::Extent2D{frameDimensions.x, frameDimensions.y};
+		setOffscreenFrames(device);
+	}
+	else
+	{
+		getSupportedDetails(device.getPhysicalDevice(), surface);
+		checkImageCount();
+		selectExtent(frameDimensions);
+		createSwapchain(device, surface);
+	}
+
 	createRenderPass();
 }
 
@@ -21,6 +33,8 @@ mtd::Swapchain::~Swapchain()
 
 void mtd::Swapchain::recreate(const Device& device, vk::SurfaceKHR surface, UIntVec2 frameDimensions)
 {
+	assert(!headless && "Offscreen frames have a fixed resolution and can not be recreated.");
+
 	destroy();
 
 	getSupportedDetails(device.getPhysicalDevice(), surface);
@@ -32,6 +46,12 @@ void mtd::Swapchain::recreate(const Device& device, vk::SurfaceKHR surface, UInt
 
 bool mtd::Swapchain::setVSync(bool enableVSync)
 {
+	if(headless)
+	{
+		LOG_WARNING("V-Sync has no effect when rendering headless.");
+		return false;
+	}
+
 	if(enableVSync)
 	{
 		if(settings.presentMode == vk::PresentModeKHR::eFifo) return false;
@@ -61,10 +81,39 @@ bool mtd::Swapchain::setVSync(bool enableVSync)
 	return false;
 }
 
+bool mtd::Swapchain::readbackFrame(uint32_t frameIndex, std::vector<uint8_t>& pixels) const
+{
+	if(!headless)
+	{
+		LOG_WARNING("Frame readback is only available when rendering headless.");
+		return false;
+	}
+
+	return resourceManager.readbackImage
+	(
+		offscreenImageIDs[frameIndex % offscreenImageIDs.size()], vk::ImageLayout::eTransferSrcOptimal, pixels
+	);
+}
+
+void mtd::Swapchain::waitForFrames() const
+{
+	std::vector<vk::Fence> inFlightFences;
+	inFlightFences.reserve(frames.size());
+	for(const Frame& frame: frames)
+		inFlightFences.push_back(frame.getInFlightFence());
+
+	vk::Result result = device.waitForFences
+	(
+		static_cast<uint32_t>(inFlightFences.size()), inFlightFences.data(), vk::True, UINT64_MAX
+	);
+	if(result != vk::Result::eSuccess)
+		LOG_ERROR("Failed to wait for the frames in flight. Vulkan result: %d", result);
+}
+
 void mtd::Swapchain::configureDefaultSettings()
 {
 	settings.frameCount = 3U;
-	settings.colorFormat = vk::Format::eB8G8R8A8Unorm;
+	settings.colorFormat = headless ? vk::Format::eR8G8B8A8Unorm : vk::Format::eB8G8R8A8Unorm;
 	settings.colorSpace = vk::ColorSpaceKHR::eSrgbNonlinear;
 	settings.compositeAlpha = vk::CompositeAlphaFlagBitsKHR::eOpaque;
 	settings.presentMode = vk::PresentModeKHR::eFifo;
@@ -128,7 +177,8 @@ void mtd::Swapchain::createRenderPass()
 	colorAttachmentDescription.stencilLoadOp = vk::AttachmentLoadOp::eDontCare;
 	colorAttachmentDescription.stencilStoreOp = vk::AttachmentStoreOp::eDontCare;
 	colorAttachmentDescription.initialLayout = vk::ImageLayout::eUndefined;
-	colorAttachmentDescription.finalLayout = vk::ImageLayout::ePresentSrcKHR;
+	colorAttachmentDescription.finalLayout =
+		headless ? vk::ImageLayout::eTransferSrcOptimal : vk::ImageLayout::ePresentSrcKHR;
 
 	vk::AttachmentReference colorAttachmentReference{};
 	colorAttachmentReference.attachment = 0U;
@@ -278,9 +328,44 @@ void mtd::Swapchain::setSwapchainFrames(const Device& device)
 		frames.emplace_back(device, UIntVec2{extent.width, extent.height}, images[i], settings.colorFormat, i);
 }
 
+void mtd::Swapchain::setOffscreenFrames(const Device& device)
+{
+	frames.reserve(settings.frameCount);
+	offscreenImageIDs.reserve(settings.frameCount);
+	for(uint32_t i = 0U; i < settings.frameCount; i++)
+	{
+		ResourceID imageID = resourceManager.createImage
+		(
+			"HeadlessFrame" + std::to_string(i),
+			UIntVec2{extent.width, extent.height},
+			settings.colorFormat,
+			vk::ImageUsageFlagBits::eColorAttachment | vk::ImageUsageFlagBits::eTransferSrc
+		);
+		resourceManager.setPersistent(imageID);
+		offscreenImageIDs.push_back(imageID);
+
+		frames.emplace_back
+		(
+			device, UIntVec2{extent.width, extent.height},
+			resourceManager.getVulkanImage(imageID), settings.colorFormat, i
+		);
+	}
+
+	LOG_INFO("Created %d offscreen frames (%dx%d).\n", settings.frameCount, extent.width, extent.height);
+}
+
 void mtd::Swapchain::destroy()
 {
 	device.destroyRenderPass(renderPass);
 	frames.clear();
+
+	if(headless)
+	{
+		for(ResourceID imageID: offscreenImageIDs)
+			resourceManager.deleteResource(imageID);
+		offscreenImageIDs.clear();
+		return;
+	}
+
 	device.destroySwapchainKHR(swapchain);
 }
@@ -1,15 +1,19 @@
 #pragma once
 
 #include "../Device/Device.hpp"
+#include "../../AssetManager/ResourceManager.hpp"
 #include "Frame.hpp"
 
 namespace mtd
 {
-	// Handles frame swapping
+	// Handles frame swapping (or offscreen frames owned by the resource manager, when rendering headless)
 	class Swapchain
 	{
 		public:
-			Swapchain(const Device& device, vk::SurfaceKHR surface, UIntVec2 frameDimensions);
+			Swapchain
+			(
+				const Device& device, ResourceManager& resourceManager, vk::SurfaceKHR surface, UIntVec2 frameDimensions
+			);
 			~Swapchain();
 
 			Swapchain(const Swapchain&) = delete;
@@ -21,6 +25,7 @@ namespace mtd
 			const vk::RenderPass& getRenderPass() const { return renderPass; }
 			const Frame& getFrame(uint32_t index) const { return frames[index]; }
 			uint32_t getFrameCount() const { return static_cast<uint32_t>(frames.size()); }
+			bool isHeadless() const { return headless; }
 
 			// Recreates swapchain to handle resizes
 			void recreate(const Device& device, vk::SurfaceKHR surface, UIntVec2 frameDimensions);
@@ -28,6 +33,12 @@ namespace mtd
 			// Enables or disables V-Sync
 			bool setVSync(bool enableVSync);
 
+			// Copies the specified offscreen frame to CPU memory (headless only)
+			bool readbackFrame(uint32_t frameIndex, std::vector<uint8_t>& pixels) const;
+
+			// Blocks until the submitted commands of every frame finish
+			void waitForFrames() const;
+
 		private:
 			// Vulkan swapchain
 			vk::SwapchainKHR swapchain;
@@ -38,6 +49,11 @@ namespace mtd
 
 			// Frames stored by the swapchain
 			std::vector<Frame> frames;
+			// Offscreen color images used as frames when rendering headless
+			std::vector<ResourceID> offscreenImageIDs;
+
+			// Rendering without a surface flag
+			bool headless;
 
 			// Frame size
 			vk::Extent2D extent = {0U, 0U};
@@ -47,6 +63,8 @@ namespace mtd
 
 			// Vulkan device reference
 			const vk::Device& device;
+			// Resource manager reference
+			ResourceManager& resourceManager;
 
 			// Sets up default swapchain settings
 			void configureDefaultSettings();
@@ -74,6 +92,8 @@ namespace mtd
 
 			// Creates all the swapchain frames
 			void setSwapchainFrames(const Device& device);
+			// Creates the offscreen frames for headless rendering
+			void setOffscreenFrames(const Device& device);
 
 			// Destroys the swapchain
 			void destroy();
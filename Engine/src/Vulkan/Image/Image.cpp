@@ -1,11 +1,10 @@
 #include <pch.hpp>
 #include "Image.hpp"
 
-#include "../Device/GpuBuffer.hpp"
 #include "../../Utils/Logger.hpp"
 
 mtd::Image::Image(const Device& mtdDevice)
-	: mtdDevice{mtdDevice}, image{nullptr}, imageMemory{nullptr}, view{nullptr}
+	: mtdDevice{mtdDevice}, image{nullptr}, view{nullptr}
 {}
 
 mtd::Image::Image
@@ -21,7 +20,7 @@ mtd::Image::Image
 	SamplerType sampler,
 	Vec2 windowResolutionRatio,
 	vk::ImageCreateFlags imageFlags
-) : mtdDevice{mtdDevice}, image{nullptr}, imageMemory{nullptr}, view{nullptr},
+) : mtdDevice{mtdDevice}, image{nullptr}, view{nullptr},
 	dimensions{imageDimensions}, format{imageFormat}, tiling{imageTiling}, usageFlags{usage},
 	memoryProperties{memoryPropertyFlags}, aspectFlags{aspects}, viewType{imageViewType},
 	samplerType{sampler}, createFlags{imageFlags}, windowResolutionRatio{windowResolutionRatio}
@@ -35,14 +34,14 @@ mtd::Image::~Image()
 {
 	const vk::Device& device = mtdDevice.getDevice();
 	device.destroyImageView(view);
-	device.freeMemory(imageMemory);
 	device.destroyImage(image);
+	mtdDevice.getMemoryAllocator().free(imageAllocation);
 }
 
 mtd::Image::Image(Image&& other) noexcept
 	: mtdDevice{other.mtdDevice},
 	image{std::move(other.image)},
-	imageMemory{std::move(other.imageMemory)},
+	imageAllocation{other.imageAllocation},
 	view{std::move(other.view)},
 	dimensions{other.dimensions},
 	format{other.format},
@@ -56,7 +55,7 @@ mtd::Image::Image(Image&& other) noexcept
 	layout{other.layout}
 {
 	other.image = nullptr;
-	other.imageMemory = nullptr;
+	other.imageAllocation = MemoryAllocation{};
 	other.view = nullptr;
 
 	other.dimensions = UIntVec2{0U, 0U};
@@ -95,11 +94,10 @@ void mtd::Image::resize(UIntVec2 newDimensions)
 	assert(image && "The Vulkan image must be created before resizing.");
 
 	mtdDevice.getDevice().destroyImageView(view);
-	mtdDevice.getDevice().freeMemory(imageMemory);
 	mtdDevice.getDevice().destroyImage(image);
+	mtdDevice.getMemoryAllocator().free(imageAllocation);
 
 	image = nullptr;
-	imageMemory = nullptr;
 	view = nullptr;
 	layout = vk::ImageLayout::eUndefined;
 
@@ -234,6 +232,65 @@ void mtd::Image::copyBufferToImage(const CommandHandler& commandHandler, vk::Buf
 	commandHandler.endSingleTimeCommand(commandBuffer);
 }
 
+mtd::UploadTicket mtd::Image::uploadData(UploadQueue& uploadQueue, vk::DeviceSize dataSize, const void* pData)
+{
+	assert(image && "The image must be created before uploading data to it.");
+
+	layout = vk::ImageLayout::eShaderReadOnlyOptimal;
+	return uploadQueue.uploadToImage(image, dimensions, vk::ImageAspectFlagBits::eColor, dataSize, pData);
+}
+
+void mtd::Image::copyImageToBuffer
+(
+	const CommandHandler& commandHandler, vk::Buffer dstBuffer, vk::ImageLayout currentLayout
+) const
+{
+	assert(image && "The image must be created before copying from it.");
+
+	vk::ImageSubresourceRange subresourceRange{};
+	subresourceRange.aspectMask = vk::ImageAspectFlagBits::eColor;
+	subresourceRange.baseMipLevel = 0U;
+	subresourceRange.levelCount = 1U;
+	subresourceRange.baseArrayLayer = 0U;
+	subresourceRange.layerCount = 1U;
+
+	vk::ImageMemoryBarrier barrier{};
+	barrier.srcAccessMask = vk::AccessFlagBits::eColorAttachmentWrite;
+	barrier.dstAccessMask = vk::AccessFlagBits::eTransferRead;
+	barrier.oldLayout = currentLayout;
+	barrier.newLayout = vk::ImageLayout::eTransferSrcOptimal;
+	barrier.srcQueueFamilyIndex = vk::QueueFamilyIgnored;
+	barrier.dstQueueFamilyIndex = vk::QueueFamilyIgnored;
+	barrier.image = image;
+	barrier.subresourceRange = subresourceRange;
+
+	vk::ImageSubresourceLayers subresource{};
+	subresource.aspectMask = vk::ImageAspectFlagBits::eColor;
+	subresource.mipLevel = 0U;
+	subresource.baseArrayLayer = 0U;
+	subresource.layerCount = 1U;
+
+	vk::BufferImageCopy bufferImageCopy{};
+	bufferImageCopy.bufferOffset = 0UL;
+	bufferImageCopy.bufferRowLength = 0U;
+	bufferImageCopy.bufferImageHeight = 0U;
+	bufferImageCopy.imageSubresource = subresource;
+	bufferImageCopy.imageOffset = vk::Offset3D{0, 0, 0};
+	bufferImageCopy.imageExtent = vk::Extent3D{dimensions.x, dimensions.y, 1U};
+
+	vk::CommandBuffer commandBuffer = commandHandler.beginSingleTimeCommand();
+
+	commandBuffer.pipelineBarrier
+	(
+		vk::PipelineStageFlagBits::eColorAttachmentOutput, vk::PipelineStageFlagBits::eTransfer,
+		vk::DependencyFlags(), nullptr, nullptr, barrier
+	);
+	commandBuffer.copyImageToBuffer(image, vk::ImageLayout::eTransferSrcOptimal, dstBuffer, bufferImageCopy);
+
+	commandHandler.endSingleTimeCommand(commandBuffer);
+	layout = vk::ImageLayout::eTransferSrcOptimal;
+}
+
 void mtd::Image::createImage()
 {
 	assert(!image && "The Vulkan image has already been created.");
@@ -262,27 +319,10 @@ void mtd::Image::createImage()
 void mtd::Image::createMemory()
 {
 	assert(image && "The image must be created before the image memory.");
-	assert(!imageMemory && "The Vulkan image memory has already been created.");
-
-	vk::MemoryRequirements requirements = mtdDevice.getDevice().getImageMemoryRequirements(image);
-
-	vk::MemoryAllocateInfo allocationInfo{};
-	allocationInfo.allocationSize = requirements.size;
-	allocationInfo.memoryTypeIndex = Memory::findMemoryTypeIndex
-	(
-		mtdDevice.getPhysicalDevice(),
-		requirements.memoryTypeBits,
-		memoryProperties
-	);
-
-	vk::Result result = mtdDevice.getDevice().allocateMemory(&allocationInfo, nullptr, &imageMemory);
-	if(result != vk::Result::eSuccess)
-	{
-		LOG_ERROR("Failed to allocate memory for image. Vulkan result: %d", result);
-		return;
-	}
+	assert(!imageAllocation.memory && "The Vulkan image memory has already been created.");
 
-	mtdDevice.getDevice().bindImageMemory(image, imageMemory, 0UL);
+	if(!mtdDevice.getMemoryAllocator().allocateImageMemory(image, tiling, memoryProperties, imageAllocation))
+		LOG_ERROR("Failed to allocate memory for image.");
 }
 
 void mtd::Image::createView()
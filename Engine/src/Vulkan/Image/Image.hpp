@@ -1,7 +1,7 @@
 #pragma once
 
 #include "SamplerManager.hpp"
-#include "../Command/CommandHandler.hpp"
+#include "../Command/UploadQueue.hpp"
 
 namespace mtd
 {
@@ -37,6 +37,7 @@ namespace mtd
 			vk::Format getFormat() const { return format; }
 			UIntVec2 getDimensions() const { return dimensions; }
 			Vec2 getWindowResolutionRatio() const { return windowResolutionRatio; }
+			vk::DeviceSize getMemorySize() const { return imageAllocation.size; }
 
 			// Creates the Vulkan image, image memory and image view of the resource
 			void create
@@ -68,12 +69,19 @@ namespace mtd
 			) const;
 			// Copies buffer data to Vulkan image
 			void copyBufferToImage(const CommandHandler& commandHandler, vk::Buffer srcBuffer);
+			// Queues the upload of CPU data to the Vulkan image, which can be sampled once the upload finishes
+			UploadTicket uploadData(UploadQueue& uploadQueue, vk::DeviceSize dataSize, const void* pData);
+			// Copies the Vulkan image data to a buffer, after it has been written as a color attachment
+			void copyImageToBuffer
+			(
+				const CommandHandler& commandHandler, vk::Buffer dstBuffer, vk::ImageLayout currentLayout
+			) const;
 
 		private:
 			// Vulkan image data
 			vk::Image image;
 			// GPU memory region of the image
-			vk::DeviceMemory imageMemory;
+			MemoryAllocation imageAllocation;
 			// Image description
 			vk::ImageView view;
 
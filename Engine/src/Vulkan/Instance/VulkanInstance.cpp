@@ -20,12 +20,16 @@ mtd::VulkanInstance::VulkanInstance(const EngineInfo& info) : instance{nullptr}
 	appInfo.engineVersion = VK_MAKE_API_VERSION(0, 1, 0, 0);
 	appInfo.apiVersion = version;
 
-	uint32_t glfwExtensionCount = 0;
-	const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-	std::vector<const char*> requiredExtensions{glfwExtensions, glfwExtensions + glfwExtensionCount};
+	std::vector<const char*> requiredExtensions;
 	std::vector<const char*> requiredLayers;
 
+	if(!info.headless)
+	{
+		uint32_t glfwExtensionCount = 0;
+		const char** glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+		requiredExtensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+	}
+
 	#ifdef MTD_DEBUG
 		requiredExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 		requiredLayers.push_back("VK_LAYER_KHRONOS_validation");
@@ -22,12 +22,12 @@ namespace mtd
 					MeshType& mesh = meshes[meshIndexMap.at(event.getModelID())];
 					uint32_t instanceVariation = event.getInstanceCount();
 
-					mesh.addInstances(commandHandler, instanceVariation);
+					mesh.addInstances(instanceVariation);
 				});
 				removeInstanceCallbackHandle = EventManager::addCallback([this](const RemoveInstanceEvent& event)
 				{
 					for(MeshType& mesh: meshes)
-						mesh.removeInstanceByID(commandHandler, event.getInstanceID());
+						mesh.removeInstanceByID(event.getInstanceID());
 				});
 			}
 
@@ -48,11 +48,28 @@ namespace mtd
 					mesh.start();
 			}
 
-			// Updates mesh data
-			virtual void update(double frameTime) override
+			// Updates mesh data, submitting the parallel updates to the job system tracked by the counter
+			virtual void update(double frameTime, JobCounter& jobCounter) override
 			{
 				for(MeshType& mesh: meshes)
-					mesh.update(frameTime);
+				{
+					if(mesh.supportsParallelUpdate())
+						JobSystem::submit([&mesh, frameTime]() { mesh.update(frameTime); }, &jobCounter);
+				}
+
+				// Legacy models are updated serially, while the jobs run
+				for(MeshType& mesh: meshes)
+				{
+					if(!mesh.supportsParallelUpdate())
+						mesh.update(frameTime);
+				}
+			}
+
+			// Copies the updated instances to the instance buffers of the frame being recorded
+			virtual void uploadInstances(uint32_t frameIndex, uint32_t frameCount) override
+			{
+				for(MeshType& mesh: meshes)
+					mesh.uploadInstances(frameIndex, frameCount);
 			}
 
 		protected:
@@ -1,7 +1,10 @@
 #include <pch.hpp>
 #include "Mesh.hpp"
 
-#include <cstring>
+#include <meltdown/jobs.hpp>
+
+// Maximum amount of instances updated by each job
+#define INSTANCE_UPDATE_GRAIN_SIZE 2048U
 
 mtd::Mesh::Mesh
 (
@@ -13,32 +16,31 @@ mtd::Mesh::Mesh
 ) : device{device},
 	meshIndex{index},
 	modelID{modelID},
-	modelFactory{ModelHandler::getModelFactory(modelID)},
-	models{},
+	modelBatch{ModelHandler::createModelBatch(modelID)},
 	instanceLump{preTransforms},
-	instanceBufferBindIndex{instanceBufferBindIndex},
-	instanceBuffer
-	{
-		device,
-		vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferSrc,
-		vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
-	}
+	instanceIDs(preTransforms.size()),
+	instanceBufferBindIndex{instanceBufferBindIndex}
 {
-	for(const Mat4x4& preTransform: preTransforms)
-	{
-		std::unique_ptr<Model> pModel = modelFactory(preTransform);
-		models[pModel->getInstanceID()] = std::move(pModel);
-	}
+	modelBatch->addInstances(instanceLump, instanceIDs);
+
+	instanceIndices.reserve(instanceIDs.size());
+	for(uint32_t i = 0; i < instanceIDs.size(); i++)
+		instanceIndices[instanceIDs[i]] = i;
 }
 
 mtd::Mesh::Mesh(Mesh&& other) noexcept
 	: device{other.device},
 	meshIndex{other.meshIndex},
 	modelID{std::move(other.modelID)},
-	modelFactory{std::move(other.modelFactory)},
-	models{std::move(other.models)},
+	modelBatch{std::move(other.modelBatch)},
 	instanceLump{std::move(other.instanceLump)},
-	instanceBuffer{std::move(other.instanceBuffer)},
+	instanceIDs{std::move(other.instanceIDs)},
+	instanceIndices{std::move(other.instanceIndices)},
+	stagedInstances{std::move(other.stagedInstances)},
+	stagedVersion{other.stagedVersion},
+	instanceBuffers{std::move(other.instanceBuffers)},
+	uploadedVersions{std::move(other.uploadedVersions)},
+	currentInstanceBuffer{other.currentInstanceBuffer},
 	instanceBufferBindIndex{other.instanceBufferBindIndex}
 {
 }
@@ -46,84 +48,131 @@ mtd::Mesh::Mesh(Mesh&& other) noexcept
 // Runs once at the beginning of the scene for all instances
 void mtd::Mesh::start()
 {
-	uint32_t i = 0;
-	for(const auto& [instanceID, pModel]: models)
-	{
-		pModel->start();
-		std::memcpy(&(instanceLump[i]), &(pModel->getTransform()), sizeof(Mat4x4));
-		i++;
-	}
+	modelBatch->start(instanceLump, 0U);
 
-	instanceBuffer.copyMemoryToBuffer(instanceLump.size() * sizeof(Mat4x4), instanceLump.data());
+	stageInstances();
 }
 
 // Updates all instances
 void mtd::Mesh::update(double deltaTime)
 {
-	if(models.size() <= 0) return;
+	// Removing all instances must still reach the instance buffers
+	if(instanceLump.empty())
+	{
+		stageInstances();
+		return;
+	}
 
-	uint32_t i = 0;
-	for(const auto& [instanceID, pModel]: models)
+	if(modelBatch->supportsParallelUpdate())
+	{
+		JobSystem::parallelFor
+		(
+			0U,
+			static_cast<uint32_t>(instanceLump.size()),
+			INSTANCE_UPDATE_GRAIN_SIZE,
+			[this, deltaTime](uint32_t firstInstance, uint32_t lastInstance)
+			{
+				std::span<Mat4x4> transforms{instanceLump.data() + firstInstance, lastInstance - firstInstance};
+				modelBatch->update(transforms, firstInstance, deltaTime);
+			}
+		);
+	}
+	else
 	{
-		pModel->update(deltaTime);
-		std::memcpy(&(instanceLump[i]), &(pModel->getTransform()), sizeof(Mat4x4));
-		i++;
+		modelBatch->update(instanceLump, 0U, deltaTime);
 	}
 
-	instanceBuffer.copyMemoryToBuffer(instanceLump.size() * sizeof(Mat4x4), instanceLump.data());
+	stageInstances();
 }
 
 // Adds multiple new mesh instances with the identity pre-transform matrix
-void mtd::Mesh::addInstances(const CommandHandler& commandHandler, uint32_t instanceCount)
+void mtd::Mesh::addInstances(uint32_t instanceCount)
 {
-	uint32_t minimumBufferSize = (models.size() + instanceCount) * sizeof(Mat4x4);
-	if(minimumBufferSize > instanceBuffer.getSize())
-	{
-		uint32_t newSize = 2 * instanceBuffer.getSize();
-		while(newSize < minimumBufferSize)
-			newSize += newSize;
-
-		instanceBuffer.resizeBuffer(commandHandler, newSize);
-	}
-
-	for(uint32_t i = 0; i < instanceCount; i++)
-	{
-		instanceLump.emplace_back(Mat4x4{1.0f});
-		std::unique_ptr<Model> pModel = modelFactory(instanceLump.back());
+	uint32_t firstInstance = static_cast<uint32_t>(instanceLump.size());
+	instanceLump.resize(firstInstance + instanceCount, Mat4x4{1.0f});
+	instanceIDs.resize(firstInstance + instanceCount);
 
-		pModel->start();
-		std::memcpy(&(instanceLump[i]), &(pModel->getTransform()), sizeof(Mat4x4));
+	std::span<Mat4x4> newTransforms{instanceLump.data() + firstInstance, instanceCount};
+	std::span<uint64_t> newInstanceIDs{instanceIDs.data() + firstInstance, instanceCount};
+	modelBatch->addInstances(newTransforms, newInstanceIDs);
+	modelBatch->start(newTransforms, firstInstance);
 
-		models[pModel->getInstanceID()] = std::move(pModel);
-	}
+	for(uint32_t i = firstInstance; i < instanceIDs.size(); i++)
+		instanceIndices[instanceIDs[i]] = i;
 }
 
 // Removes the mesh instance associated with the provided instance ID
-void mtd::Mesh::removeInstanceByID(const CommandHandler& commandHandler, uint64_t instanceID)
+void mtd::Mesh::removeInstanceByID(uint64_t instanceID)
 {
-	if(models.find(instanceID) == models.cend()) return;
+	std::unordered_map<uint64_t, uint32_t>::const_iterator iterator = instanceIndices.find(instanceID);
+	if(iterator == instanceIndices.cend()) return;
+
+	uint32_t instanceIndex = iterator->second;
+	instanceIndices.erase(iterator);
+	modelBatch->removeInstance(instanceIndex);
 
-	models.erase(instanceID);
+	if(instanceIndex < instanceLump.size() - 1)
+	{
+		instanceLump[instanceIndex] = instanceLump.back();
+		instanceIDs[instanceIndex] = instanceIDs.back();
+		instanceIndices[instanceIDs[instanceIndex]] = instanceIndex;
+	}
 	instanceLump.pop_back();
+	instanceIDs.pop_back();
+}
 
-	if(models.size() <= 0) return;
+// Copies the last staged transformation matrices to the instance buffer of the frame
+void mtd::Mesh::uploadInstances(uint32_t frameIndex, uint32_t frameCount)
+{
+	assert(frameIndex < frameCount && "Invalid frame index for the instance buffers.");
 
-	vk::DeviceSize expectedBufferSize = models.size() * sizeof(Mat4x4);
+	// The swapchain recreation waits for the device, so no instance buffer is in use when their amount changes
+	if(instanceBuffers.size() != frameCount)
+	{
+		instanceBuffers.clear();
+		instanceBuffers.resize(frameCount);
+		uploadedVersions.assign(frameCount, 0UL);
+	}
+	currentInstanceBuffer = frameIndex;
 
-	if(2 * expectedBufferSize <= instanceBuffer.getSize())
-		instanceBuffer.resizeBuffer(commandHandler, expectedBufferSize);
-}
+	std::lock_guard<std::mutex> lock{stagingMutex};
+	if(uploadedVersions[frameIndex] == stagedVersion && instanceBuffers[frameIndex]) return;
 
-// Creates a GPU buffer for the transformation matrices
-void mtd::Mesh::createInstanceBuffer()
-{
-	instanceBuffer.create(instanceLump.size() * sizeof(Mat4x4));
-	instanceBuffer.copyMemoryToBuffer(instanceBuffer.getSize(), instanceLump.data());
+	// Grows geometrically and shrinks below a quarter of use, so instances added one by one do not recreate the
+	// buffer every frame
+	std::unique_ptr<GpuBuffer>& pInstanceBuffer = instanceBuffers[frameIndex];
+	vk::DeviceSize dataSize = stagedInstances.size() * sizeof(Mat4x4);
+	vk::DeviceSize currentSize = pInstanceBuffer ? pInstanceBuffer->getSize() : 0UL;
+	if(currentSize < dataSize || (currentSize > sizeof(Mat4x4) && 4UL * dataSize < currentSize))
+	{
+		pInstanceBuffer = std::make_unique<GpuBuffer>
+		(
+			device,
+			vk::BufferUsageFlagBits::eVertexBuffer | vk::BufferUsageFlagBits::eTransferSrc,
+			vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent
+		);
+		pInstanceBuffer->create(std::max<vk::DeviceSize>(2UL * dataSize, sizeof(Mat4x4)));
+	}
+
+	if(dataSize > 0UL)
+		pInstanceBuffer->copyMemoryToBuffer(dataSize, stagedInstances.data());
+	uploadedVersions[frameIndex] = stagedVersion;
 }
 
-// Binds the instance buffer for this mesh
+// Binds the instance buffer of the frame being recorded
 void mtd::Mesh::bindInstanceBuffer(const vk::CommandBuffer& commandBuffer) const
 {
+	assert(currentInstanceBuffer < instanceBuffers.size() && "The instances must be uploaded before binding them.");
+
 	vk::DeviceSize offset{0};
+	const GpuBuffer& instanceBuffer = *instanceBuffers[currentInstanceBuffer];
 	commandBuffer.bindVertexBuffers(instanceBufferBindIndex, 1, &(instanceBuffer.getBuffer()), &offset);
 }
+
+// Copies the transformation matrices for the next uploaded frame
+void mtd::Mesh::stageInstances()
+{
+	std::lock_guard<std::mutex> lock{stagingMutex};
+	stagedInstances = instanceLump;
+	stagedVersion++;
+}
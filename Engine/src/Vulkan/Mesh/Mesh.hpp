@@ -1,5 +1,6 @@
 #pragma once
 
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -29,23 +30,27 @@ namespace mtd
 			Mesh(Mesh&& other) noexcept;
 
 			// Getters
-			uint32_t getInstanceCount() const { return static_cast<uint32_t>(models.size()); }
+			uint32_t getInstanceCount() const { return static_cast<uint32_t>(instanceLump.size()); }
 			const char* getModelID() const { return modelID.c_str(); }
 
+			// Checks if the instances can be updated by the job system worker threads
+			bool supportsParallelUpdate() const { return modelBatch->supportsParallelUpdate(); }
+
 			// Runs once at the beginning of the scene for all instances
 			void start();
-			// Updates all instances
+			// Updates all instances, splitting them among the worker threads if supported by the model batch
 			void update(double deltaTime);
 
 			// Adds multiple new mesh instances with the identity pre-transform matrix
-			void addInstances(const CommandHandler& commandHandler, uint32_t instanceCount);
+			void addInstances(uint32_t instanceCount);
 			// Removes the mesh instance associated with the provided instance ID
-			void removeInstanceByID(const CommandHandler& commandHandler, uint64_t instanceID);
+			void removeInstanceByID(uint64_t instanceID);
 
-			// Creates a GPU buffer for the transformation matrices
-			void createInstanceBuffer();
+			// Copies the last staged transformation matrices to the instance buffer of the frame, whose previous
+			// commands must have finished, growing or shrinking only that buffer
+			void uploadInstances(uint32_t frameIndex, uint32_t frameCount);
 
-			// Binds the instance buffer for this mesh
+			// Binds the instance buffer of the frame being recorded
 			void bindInstanceBuffer(const vk::CommandBuffer& commandBuffer) const;
 
 		protected:
@@ -53,20 +58,36 @@ namespace mtd
 			uint32_t meshIndex;
 			// Model ID
 			std::string modelID;
-			// Model instance factory
-			ModelFactory modelFactory;
-
-			// Model data for each instance of the mesh
-			std::unordered_map<uint64_t, std::unique_ptr<Model>> models;
+			// Start and update logic for all instances of the mesh
+			std::unique_ptr<ModelBatch> modelBatch;
 
-			// Transformation matrices for each mesh instance
+			// Transformation matrices for each mesh instance, updated in place by the model batch
 			std::vector<Mat4x4> instanceLump;
-			// GPU buffer for the transformation matrices
-			GpuBuffer instanceBuffer;
+			// Instance IDs, in the same order as the transformation matrices
+			std::vector<uint64_t> instanceIDs;
+			// Maps an instance ID to its index in the instance lump
+			std::unordered_map<uint64_t, uint32_t> instanceIndices;
+			// Copy of the transformation matrices from the last update, read by the render thread
+			std::vector<Mat4x4> stagedInstances;
+			// Incremented whenever the transformation matrices are staged
+			uint64_t stagedVersion = 0UL;
+			// Guards the staged matrices, written by the update thread and uploaded by the render thread
+			std::mutex stagingMutex;
+
+			// GPU buffers for the transformation matrices, one per frame in flight, so the frames in flight keep
+			// reading the matrices they were recorded with
+			std::vector<std::unique_ptr<GpuBuffer>> instanceBuffers;
+			// Staged version copied to each instance buffer
+			std::vector<uint64_t> uploadedVersions;
+			// Instance buffer of the frame being recorded
+			uint32_t currentInstanceBuffer = 0U;
 			// Binding index for the instance buffer
 			uint32_t instanceBufferBindIndex;
 
 			// Device reference
 			const Device& device;
+
+			// Copies the transformation matrices for the next uploaded frame
+			void stageInstances();
 	};
 }
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <meltdown/jobs.hpp>
+
 #include "../Descriptors/DescriptorSetHandler.hpp"
 
 namespace mtd
@@ -30,8 +32,10 @@ namespace mtd
 
 			// Executes the start code for each mesh on scene loading
 			virtual void start() = 0;
-			// Updates mesh data
-			virtual void update(double frameTime) = 0;
+			// Updates mesh data, submitting the parallel updates to the job system tracked by the counter
+			virtual void update(double frameTime, JobCounter& jobCounter) = 0;
+			// Copies the updated instances to the instance buffers of the frame being recorded
+			virtual void uploadInstances(uint32_t frameIndex, uint32_t frameCount) = 0;
 
 		protected:
 			// Mesh manager command handler
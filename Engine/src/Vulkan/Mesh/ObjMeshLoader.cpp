@@ -1,23 +1,14 @@
 #include <pch.hpp>
 #include "ObjMeshLoader.hpp"
 
+#include "ObjParser.hpp"
 #include "../../Utils/Logger.hpp"
 #include "../../Utils/FileHandler.hpp"
+#include "../../Utils/VirtualFileSystem.hpp"
 #include "../../Utils/StringParser.hpp"
 
 namespace mtd::ObjMeshLoader
 {
-	// Data bundle for the .obj loader
-	struct ObjData
-	{
-		std::vector<Vertex>& vertices;
-		std::vector<uint32_t>& indices;
-		std::vector<Vec3> positions;
-		std::vector<Vec2> textureCoordinates;
-		std::vector<Vec3> normals;
-		std::unordered_map<std::string, uint32_t> history;
-	};
-
 	// Loads a single material from a .mtl file
 	static void loadMaterial(std::string filePath, Material& material);
 	// Loads the materials from a .mtl file
@@ -28,11 +19,6 @@ namespace mtd::ObjMeshLoader
 		std::unordered_map<std::string, uint32_t>& materialIDs,
 		const MaterialInfo& materialInfo
 	);
-
-	// Parses each triangle of a face, returning the number of triangles
-	static size_t readFaceData(const std::vector<std::string>& words, ObjData& data);
-	// Parses a single vertex
-	static void readVertex(const std::string& vertexDescription, ObjData& data);
 }
 
 void mtd::ObjMeshLoader::loadRayTracingMesh
@@ -60,33 +46,15 @@ void mtd::ObjMeshLoader::loadRayTracingMesh
 	}
 	materials.clear();
 
-	std::string line;
-	std::vector<std::string> words;
-	uint16_t currentMaterialID = 0;
-
-	ObjData data{vertices, indices};
-
-	std::ifstream file;
-	file.open(objMeshPath);
-	while(std::getline(file, line))
+	VirtualFile objFile = VirtualFileSystem::openFile(objMeshPath);
+	if(!objFile.isOpen())
 	{
-		StringParser::split(line, " ", words);
-
-		if(!words[0].compare("v"))
-			data.positions.emplace_back(std::stof(words[1]), std::stof(words[2]), std::stof(words[3]));
-		else if(!words[0].compare("vt"))
-			data.textureCoordinates.emplace_back(std::stof(words[1]), std::stof(words[2]));
-		else if(!words[0].compare("vn"))
-			data.normals.emplace_back(std::stof(words[1]), std::stof(words[2]), std::stof(words[3]));
-		else if(!words[0].compare("f"))
-		{
-			const size_t triangleCount = readFaceData(words, data);
-			materialIndices.insert(materialIndices.cend(), triangleCount, currentMaterialID);
-		}
-		else if(!words[0].compare("usemtl"))
-			currentMaterialID = materialIDs[words[1]];
+		LOG_ERROR("Failed to open mesh file \"%s\".", objMeshPath.c_str());
+		return;
 	}
-	file.close();
+
+	std::string_view objText{reinterpret_cast<const char*>(objFile.getData()), objFile.getSize()};
+	ObjParser::parse(objText, materialIDs, vertices, indices, materialIndices);
 
 	LOG_VERBOSE("Mesh \"%s\" loaded.", fileName);
 }
@@ -214,43 +182,3 @@ void mtd::ObjMeshLoader::loadMaterials
 	}
 	file.close();
 }
-
-size_t mtd::ObjMeshLoader::readFaceData(const std::vector<std::string>& words, ObjData& data)
-{
-	size_t triangleCount = words.size() - 3;
-	for(size_t i = 0; i < triangleCount; i++)
-	{
-		readVertex(words[1], data);
-		readVertex(words[2 + i], data);
-		readVertex(words[3 + i], data);
-	}
-	return triangleCount;
-}
-
-void mtd::ObjMeshLoader::readVertex(const std::string& vertexDescription, ObjData& data)
-{
-	if(data.history.contains(vertexDescription))
-	{
-		data.indices.push_back(data.history[vertexDescription]);
-		return;
-	}
-
-	uint32_t index = static_cast<uint32_t>(data.history.size());
-	data.history.insert({vertexDescription, index});
-	data.indices.push_back(index);
-
-	std::vector<std::string> fullVertexData;
-	StringParser::split(vertexDescription, "/", fullVertexData);
-
-	Vec3 pos = data.positions[stol(fullVertexData[0]) - 1];
-
-	mtd::Vec2 texCoord{0.0f, 0.0f};
-	if(fullVertexData.size() > 1 && fullVertexData[1].size() > 0)
-		texCoord = data.textureCoordinates[stol(fullVertexData[1]) - 1];
-
-	Vec3 normal{0.0f, 0.0f, -1.0f};
-	if(fullVertexData.size() > 2 && fullVertexData[2].size() > 0)
-		normal = data.normals[stol(fullVertexData[2]) - 1];
-
-	data.vertices.emplace_back(pos, texCoord, normal);
-}
@@ -0,0 +1,409 @@
+#include <pch.hpp>
+#include "ObjParser.hpp"
+
+#include <charconv>
+
+#include "../../Utils/Logger.hpp"
+#include "../../Utils/Profiler.hpp"
+
+namespace mtd::ObjParser
+{
+	// Smallest chunk of text worth parsing in a separate job
+	constexpr size_t MIN_CHUNK_SIZE = 256UL << 10;
+	// Marks an absent texture coordinate or normal index
+	constexpr int64_t MISSING_INDEX = INT64_MIN;
+
+	// Attribute indices of a triangle corner, zero-based
+	struct FaceCorner
+	{
+		// Absolute indices, or indices relative to the first attribute of the chunk when flagged in the mask
+		int64_t attributes[3];
+		uint8_t relativeMask;
+	};
+
+	// Absolute attribute indices of a corner plus one, with zero meaning an absent attribute
+	struct CornerKey
+	{
+		uint32_t position;
+		uint32_t textureCoordinate;
+		uint32_t normal;
+
+		bool operator==(const CornerKey& other) const = default;
+	};
+
+	// Attributes and triangles parsed from a chunk of lines
+	struct ChunkData
+	{
+		std::vector<Vec3> positions;
+		std::vector<Vec2> textureCoordinates;
+		std::vector<Vec3> normals;
+		// Three corners per triangle
+		std::vector<FaceCorner> corners;
+		// Materials selected in the chunk, with the first triangle using each of them
+		std::vector<std::pair<size_t, uint16_t>> materialChanges;
+		// Resolved attribute indices of each corner, used as the welding key
+		std::vector<CornerKey> cornerKeys;
+	};
+
+	// Open addressing table mapping the attribute indices of a corner to its welded vertex
+	class VertexWeldTable
+	{
+		public:
+			VertexWeldTable(size_t expectedVertexCount)
+			{
+				size_t capacity = 64;
+				while(capacity < 2 * expectedVertexCount)
+					capacity *= 2;
+				slots.resize(capacity, Slot{CornerKey{0U, 0U, 0U}, 0U});
+			}
+
+			// Finds the vertex of the key, inserting the next index if absent
+			uint32_t findOrInsert(const CornerKey& key, uint32_t nextIndex, bool& inserted)
+			{
+				if(2 * (count + 1) > slots.size())
+					grow();
+
+				size_t mask = slots.size() - 1;
+				for(size_t slot = hash(key) & mask;; slot = (slot + 1) & mask)
+				{
+					if(slots[slot].key == key)
+					{
+						inserted = false;
+						return slots[slot].index;
+					}
+					// Valid keys always have a position, so a zero position marks an empty slot
+					if(slots[slot].key.position == 0U)
+					{
+						slots[slot] = Slot{key, nextIndex};
+						count++;
+						inserted = true;
+						return nextIndex;
+					}
+				}
+			}
+
+		private:
+			// Key and vertex index, 16 bytes per slot
+			struct Slot
+			{
+				CornerKey key;
+				uint32_t index;
+			};
+			std::vector<Slot> slots;
+			size_t count = 0;
+
+			static size_t hash(const CornerKey& key)
+			{
+				uint64_t packedKey = (static_cast<uint64_t>(key.position) << 32) ^ key.normal;
+				packedKey ^= static_cast<uint64_t>(key.textureCoordinate) * 0x9e3779b97f4a7c15UL;
+				packedKey ^= packedKey >> 33;
+				packedKey *= 0xff51afd7ed558ccdUL;
+				packedKey ^= packedKey >> 33;
+				return static_cast<size_t>(packedKey);
+			}
+
+			void grow()
+			{
+				std::vector<Slot> oldSlots(slots.size() * 2, Slot{CornerKey{0U, 0U, 0U}, 0U});
+				std::swap(slots, oldSlots);
+				size_t mask = slots.size() - 1;
+				for(const Slot& oldSlot: oldSlots)
+				{
+					if(oldSlot.key.position == 0U) continue;
+
+					size_t slot = hash(oldSlot.key) & mask;
+					while(slots[slot].key.position != 0U)
+						slot = (slot + 1) & mask;
+					slots[slot] = oldSlot;
+				}
+			}
+	};
+
+	// Splits the text in chunks ending at line breaks
+	static std::vector<std::string_view> splitChunks(std::string_view objText);
+	// Parses the attributes and faces of a chunk
+	static void parseChunk
+	(
+		std::string_view chunkText,
+		const std::unordered_map<std::string_view, uint16_t>& materialSlots,
+		ChunkData& chunk
+	);
+	// Parses a "v/vt/vn" corner, converting the negative indices to indices relative to the chunk
+	static bool parseFaceCorner(std::string_view word, const ChunkData& chunk, FaceCorner& corner);
+
+	// Extracts the next whitespace separated word of the line
+	static std::string_view nextWord(std::string_view& line);
+	// Parses a float with `std::from_chars`, returning zero for invalid numbers
+	static float parseFloat(std::string_view word);
+}
+
+void mtd::ObjParser::parse
+(
+	std::string_view objText,
+	const std::unordered_map<std::string, uint32_t>& materialIDs,
+	std::vector<Vertex>& vertices,
+	std::vector<uint32_t>& indices,
+	std::vector<uint16_t>& materialIndices
+)
+{
+	PROFILER_ZONE("Parse OBJ");
+
+	std::unordered_map<std::string_view, uint16_t> materialSlots;
+	for(const auto& [materialName, materialID]: materialIDs)
+		materialSlots.emplace(materialName, static_cast<uint16_t>(materialID));
+
+	std::vector<std::string_view> chunkTexts = splitChunks(objText);
+	std::vector<ChunkData> chunks(chunkTexts.size());
+	JobSystem::parallelFor
+	(
+		0U, static_cast<uint32_t>(chunks.size()), 1U,
+		[&chunkTexts, &materialSlots, &chunks](uint32_t chunkBegin, uint32_t chunkEnd)
+		{
+			for(uint32_t i = chunkBegin; i < chunkEnd; i++)
+				parseChunk(chunkTexts[i], materialSlots, chunks[i]);
+		}
+	);
+
+	// Offsets of the attributes of each chunk, resolving the relative indices
+	std::vector<std::array<int64_t, 3>> attributeBases(chunks.size());
+	std::array<int64_t, 3> attributeCounts{0, 0, 0};
+	size_t triangleCount = 0;
+	for(size_t i = 0; i < chunks.size(); i++)
+	{
+		attributeBases[i] = attributeCounts;
+		attributeCounts[0] += static_cast<int64_t>(chunks[i].positions.size());
+		attributeCounts[1] += static_cast<int64_t>(chunks[i].textureCoordinates.size());
+		attributeCounts[2] += static_cast<int64_t>(chunks[i].normals.size());
+		triangleCount += chunks[i].corners.size() / 3;
+	}
+
+	std::atomic<bool> invalidIndices{false};
+	JobSystem::parallelFor
+	(
+		0U, static_cast<uint32_t>(chunks.size()), 1U,
+		[&](uint32_t chunkBegin, uint32_t chunkEnd)
+		{
+			for(uint32_t i = chunkBegin; i < chunkEnd; i++)
+			{
+				ChunkData& chunk = chunks[i];
+				chunk.cornerKeys.resize(chunk.corners.size());
+				for(size_t c = 0; c < chunk.corners.size(); c++)
+				{
+					const FaceCorner& corner = chunk.corners[c];
+					uint32_t keyIndices[3]{0U, 0U, 0U};
+					for(uint32_t attribute = 0U; attribute < 3U; attribute++)
+					{
+						int64_t index = corner.attributes[attribute];
+						if(index == MISSING_INDEX) continue;
+						if(corner.relativeMask & (1U << attribute))
+							index += attributeBases[i][attribute];
+
+						if(index < 0 || index >= attributeCounts[attribute])
+						{
+							invalidIndices.store(true, std::memory_order_relaxed);
+							index = 0;
+						}
+						keyIndices[attribute] = static_cast<uint32_t>(index + 1);
+					}
+					chunk.cornerKeys[c] = CornerKey{keyIndices[0], keyIndices[1], keyIndices[2]};
+				}
+			}
+		}
+	);
+	if(invalidIndices.load())
+		LOG_WARNING("OBJ face indices out of range. The first attribute will be used instead.");
+
+	std::vector<Vec3> positions;
+	std::vector<Vec2> textureCoordinates;
+	std::vector<Vec3> normals;
+	positions.reserve(attributeCounts[0]);
+	textureCoordinates.reserve(attributeCounts[1]);
+	normals.reserve(attributeCounts[2]);
+	for(const ChunkData& chunk: chunks)
+	{
+		positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+		textureCoordinates.insert(textureCoordinates.end(), chunk.textureCoordinates.begin(), chunk.textureCoordinates.end());
+		normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+	}
+	if(positions.empty()) return;
+
+	// Welding keeps the order of first use, so the result does not depend on the chunk count
+	size_t indexOffset = indices.size();
+	indices.reserve(indexOffset + 3 * triangleCount);
+	materialIndices.reserve(materialIndices.size() + triangleCount);
+	VertexWeldTable weldTable{static_cast<size_t>(attributeCounts[0])};
+	uint16_t currentMaterial = 0;
+
+	for(const ChunkData& chunk: chunks)
+	{
+		// The material selected in a previous chunk stays active until the chunk selects another one
+		auto materialChange = chunk.materialChanges.cbegin();
+		for(size_t triangle = 0; triangle < chunk.corners.size() / 3; triangle++)
+		{
+			for(; materialChange != chunk.materialChanges.cend() && materialChange->first == triangle; materialChange++)
+				currentMaterial = materialChange->second;
+			materialIndices.push_back(currentMaterial);
+
+			for(size_t c = 3 * triangle; c < 3 * triangle + 3; c++)
+			{
+				const CornerKey& key = chunk.cornerKeys[c];
+				bool inserted;
+				uint32_t vertexIndex = weldTable.findOrInsert(key, static_cast<uint32_t>(vertices.size()), inserted);
+				indices.push_back(vertexIndex);
+				if(!inserted) continue;
+
+				vertices.emplace_back
+				(
+					positions[key.position - 1],
+					key.textureCoordinate ? textureCoordinates[key.textureCoordinate - 1] : Vec2{0.0f, 0.0f},
+					key.normal ? normals[key.normal - 1] : Vec3{0.0f, 0.0f, -1.0f}
+				);
+			}
+		}
+
+		// A material selected after the last face of the chunk applies to the faces of the next chunks
+		if(materialChange != chunk.materialChanges.cend())
+			currentMaterial = chunk.materialChanges.back().second;
+	}
+}
+
+std::vector<std::string_view> mtd::ObjParser::splitChunks(std::string_view objText)
+{
+	size_t chunkCount = std::max<size_t>(objText.size() / MIN_CHUNK_SIZE, 1);
+	chunkCount = std::min<size_t>(chunkCount, 4 * (JobSystem::getWorkerCount() + 1));
+
+	std::vector<std::string_view> chunkTexts;
+	chunkTexts.reserve(chunkCount);
+	size_t chunkBegin = 0;
+	for(size_t i = 1; i <= chunkCount && chunkBegin < objText.size(); i++)
+	{
+		size_t chunkEnd = objText.size();
+		if(i < chunkCount)
+		{
+			chunkEnd = objText.find('\n', std::max(chunkBegin, i * objText.size() / chunkCount));
+			chunkEnd = (chunkEnd == std::string_view::npos) ? objText.size() : chunkEnd + 1;
+		}
+		chunkTexts.push_back(objText.substr(chunkBegin, chunkEnd - chunkBegin));
+		chunkBegin = chunkEnd;
+	}
+	return chunkTexts;
+}
+
+void mtd::ObjParser::parseChunk
+(
+	std::string_view chunkText,
+	const std::unordered_map<std::string_view, uint16_t>& materialSlots,
+	ChunkData& chunk
+)
+{
+	std::vector<FaceCorner> faceCorners;
+	bool invalidCorner = false;
+
+	while(!chunkText.empty())
+	{
+		size_t lineEnd = chunkText.find('\n');
+		std::string_view line = chunkText.substr(0, lineEnd);
+		chunkText.remove_prefix((lineEnd == std::string_view::npos) ? chunkText.size() : lineEnd + 1);
+
+		std::string_view keyword = nextWord(line);
+		if(keyword == "v")
+		{
+			float x = parseFloat(nextWord(line));
+			float y = parseFloat(nextWord(line));
+			float z = parseFloat(nextWord(line));
+			chunk.positions.emplace_back(x, y, z);
+		}
+		else if(keyword == "vt")
+		{
+			float u = parseFloat(nextWord(line));
+			float v = parseFloat(nextWord(line));
+			chunk.textureCoordinates.emplace_back(u, v);
+		}
+		else if(keyword == "vn")
+		{
+			float x = parseFloat(nextWord(line));
+			float y = parseFloat(nextWord(line));
+			float z = parseFloat(nextWord(line));
+			chunk.normals.emplace_back(x, y, z);
+		}
+		else if(keyword == "f")
+		{
+			faceCorners.clear();
+			for(std::string_view word = nextWord(line); !word.empty(); word = nextWord(line))
+			{
+				FaceCorner& corner = faceCorners.emplace_back();
+				invalidCorner |= !parseFaceCorner(word, chunk, corner);
+			}
+			if(invalidCorner || faceCorners.size() < 3)
+			{
+				invalidCorner = false;
+				continue;
+			}
+
+			// Polygons are triangulated as a fan around the first corner
+			for(size_t i = 1; i + 1 < faceCorners.size(); i++)
+			{
+				chunk.corners.push_back(faceCorners[0]);
+				chunk.corners.push_back(faceCorners[i]);
+				chunk.corners.push_back(faceCorners[i + 1]);
+			}
+		}
+		else if(keyword == "usemtl")
+		{
+			auto materialSlot = materialSlots.find(nextWord(line));
+			uint16_t material = (materialSlot != materialSlots.end()) ? materialSlot->second : 0;
+			chunk.materialChanges.emplace_back(chunk.corners.size() / 3, material);
+		}
+	}
+}
+
+bool mtd::ObjParser::parseFaceCorner(std::string_view word, const ChunkData& chunk, FaceCorner& corner)
+{
+	const size_t localCounts[3]{chunk.positions.size(), chunk.textureCoordinates.size(), chunk.normals.size()};
+	corner.relativeMask = 0U;
+
+	for(uint32_t attribute = 0U; attribute < 3U; attribute++)
+	{
+		corner.attributes[attribute] = MISSING_INDEX;
+		size_t separator = word.find('/');
+		std::string_view indexText = word.substr(0, separator);
+		word.remove_prefix((separator == std::string_view::npos) ? word.size() : separator + 1);
+		if(indexText.empty()) continue;
+
+		int64_t index = 0;
+		if(std::from_chars(indexText.data(), indexText.data() + indexText.size(), index).ec != std::errc{} || index == 0)
+			return false;
+
+		// Negative indices count back from the last attribute read, which may belong to an earlier chunk
+		if(index < 0)
+		{
+			corner.attributes[attribute] = static_cast<int64_t>(localCounts[attribute]) + index;
+			corner.relativeMask |= static_cast<uint8_t>(1U << attribute);
+		}
+		else
+			corner.attributes[attribute] = index - 1;
+	}
+	return corner.attributes[0] != MISSING_INDEX;
+}
+
+std::string_view mtd::ObjParser::nextWord(std::string_view& line)
+{
+	size_t wordBegin = line.find_first_not_of(" \t\r");
+	if(wordBegin == std::string_view::npos)
+	{
+		line = std::string_view{};
+		return line;
+	}
+
+	size_t wordEnd = line.find_first_of(" \t\r", wordBegin);
+	std::string_view word = line.substr(wordBegin, wordEnd - wordBegin);
+	line.remove_prefix((wordEnd == std::string_view::npos) ? line.size() : wordEnd);
+	return word;
+}
+
+float mtd::ObjParser::parseFloat(std::string_view word)
+{
+	float value = 0.0f;
+	std::from_chars(word.data(), word.data() + word.size(), value);
+	return value;
+}
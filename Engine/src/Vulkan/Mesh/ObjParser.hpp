@@ -0,0 +1,21 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "../../Utils/EngineStructs.hpp"
+
+// Parser for the geometry of Wavefront .obj files
+namespace mtd::ObjParser
+{
+	// Parses the triangles of the .obj text in parallel chunks, welding the vertices with equal attribute indices
+	void parse
+	(
+		std::string_view objText,
+		const std::unordered_map<std::string, uint32_t>& materialIDs,
+		std::vector<Vertex>& vertices,
+		std::vector<uint32_t>& indices,
+		std::vector<uint16_t>& materialIndices
+	);
+}
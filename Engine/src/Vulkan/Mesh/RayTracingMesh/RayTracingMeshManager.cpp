@@ -113,9 +113,6 @@ void mtd::RayTracingMeshManager::loadMeshesToGPU(const CommandHandler& traceRays
 	);
 	materialLump.loadMaterialsToGPU(traceRaysCommandHandler);
 
-	for(RayTracingMesh& mesh: meshes)
-		mesh.createInstanceBuffer();
-
 	vertexCount = vertexLump.size();
 	triangleCount = indexLump.size() / 3U;
 
@@ -7,12 +7,13 @@ mtd::ComputePipeline::ComputePipeline
 (
 	const Device& mtdDevice,
 	const DescriptorManager& descriptorManager,
+	AssetCache& assetCache,
 	const ComputePipelineInfo& info,
 	vk::Extent2D swapchainExtent
 ) : Pipeline{mtdDevice.getDevice(), descriptorManager, info}, outputImage{mtdDevice},
 	pushConstantData{UIntVec2{0U, 0U}, 0U, 4U, 4U, 4U, 0U, 0U, 0U}
 {
-	loadShaderModule();
+	loadShaderModule(assetCache);
 	createDescriptorSetLayouts();
 	createPipelineLayout();
 	createComputePipeline();
@@ -134,9 +135,9 @@ void mtd::ComputePipeline::resize(const Device& mtdDevice, vk::Extent2D swapchai
 	configurePipelineDescriptorSet();
 }
 
-void mtd::ComputePipeline::loadShaderModule()
+void mtd::ComputePipeline::loadShaderModule(AssetCache& assetCache)
 {
-	shaders.emplace_back(device, vk::ShaderStageFlagBits::eCompute, info.computeShaderPath.c_str());
+	shaders.push_back(assetCache.loadShader(vk::ShaderStageFlagBits::eCompute, info.computeShaderPath));
 }
 
 void mtd::ComputePipeline::createDescriptorSetLayouts()
@@ -194,7 +195,7 @@ void mtd::ComputePipeline::createComputePipeline()
 
 	vk::ComputePipelineCreateInfo pipelineCreateInfo{};
 	pipelineCreateInfo.flags = vk::PipelineCreateFlags();
-	pipelineCreateInfo.stage = shaders[0].generatePipelineShaderCreateInfo();
+	pipelineCreateInfo.stage = shaders[0]->generatePipelineShaderCreateInfo();
 	pipelineCreateInfo.layout = pipelineLayout;
 	pipelineCreateInfo.basePipelineHandle = nullptr;
 	pipelineCreateInfo.basePipelineIndex = 0;
@@ -13,6 +13,7 @@ namespace mtd
 			(
 				const Device& mtdDevice,
 				const DescriptorManager& descriptorManager,
+				AssetCache& assetCache,
 				const ComputePipelineInfo& info,
 				vk::Extent2D swapchainExtent
 			);
@@ -58,7 +59,7 @@ namespace mtd
 			EventCallbackHandle resetAccumulationCallbackHandle;
 
 			// Loads the compute shader module
-			void loadShaderModule();
+			void loadShaderModule(AssetCache& assetCache);
 			// Configures the descriptor set handlers to be used
 			void createDescriptorSetLayouts();
 
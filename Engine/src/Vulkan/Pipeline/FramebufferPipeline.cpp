@@ -8,13 +8,14 @@ mtd::FramebufferPipeline::FramebufferPipeline
 (
 	const vk::Device& device,
 	const DescriptorManager& descriptorManager,
+	AssetCache& assetCache,
 	const FramebufferPipelineInfo& info,
 	vk::Extent2D extent,
 	vk::RenderPass renderPass
 ) : Pipeline{device, descriptorManager, info}
 {
 	createDescriptorSetLayouts();
-	loadShaderModules();
+	loadShaderModules(assetCache);
 	createPipelineLayout();
 	createPipeline(extent, renderPass);
 }
@@ -92,11 +93,11 @@ void mtd::FramebufferPipeline::updateInputImagesDescriptors
 	descriptorSetHandler.writeDescriptorSet();
 }
 
-void mtd::FramebufferPipeline::loadShaderModules()
+void mtd::FramebufferPipeline::loadShaderModules(AssetCache& assetCache)
 {
 	shaders.reserve(2);
-	shaders.emplace_back(device, vk::ShaderStageFlagBits::eVertex, info.vertexShaderPath.c_str());
-	shaders.emplace_back(device, vk::ShaderStageFlagBits::eFragment, info.fragmentShaderPath.c_str());
+	shaders.push_back(assetCache.loadShader(vk::ShaderStageFlagBits::eVertex, info.vertexShaderPath));
+	shaders.push_back(assetCache.loadShader(vk::ShaderStageFlagBits::eFragment, info.fragmentShaderPath));
 }
 
 void mtd::FramebufferPipeline::createPipelineLayout()
@@ -128,8 +129,8 @@ void mtd::FramebufferPipeline::createPipeline(vk::Extent2D extent, vk::RenderPas
 {
 	std::vector<vk::PipelineShaderStageCreateInfo> shaderStageCreateInfos;
 	shaderStageCreateInfos.reserve(shaders.size());
-	for(const ShaderModule& shader: shaders)
-		shaderStageCreateInfos.emplace_back(shader.generatePipelineShaderCreateInfo());
+	for(const std::shared_ptr<const ShaderModule>& shader: shaders)
+		shaderStageCreateInfos.emplace_back(shader->generatePipelineShaderCreateInfo());
 
 	vk::Viewport viewport{};
 	vk::Rect2D scissor{};
@@ -14,6 +14,7 @@ namespace mtd
 			(
 				const vk::Device& device,
 				const DescriptorManager& descriptorManager,
+				AssetCache& assetCache,
 				const FramebufferPipelineInfo& info,
 				vk::Extent2D extent,
 				vk::RenderPass renderPass
@@ -44,7 +45,7 @@ namespace mtd
 
 		private:
 			// Loads the pipeline shader modules
-			void loadShaderModules();
+			void loadShaderModules(AssetCache& assetCache);
 
 			// Creates the layout for the framebuffer pipeline
 			void createPipelineLayout();
@@ -1,6 +1,6 @@
 #pragma once
 
-#include "ShaderModule.hpp"
+#include "../../AssetManager/AssetCache.hpp"
 #include "../Descriptors/DescriptorManager.hpp"
 #include "../Descriptors/DescriptorPool.hpp"
 
@@ -65,8 +65,8 @@ namespace mtd
 			// Pipeline layout
 			vk::PipelineLayout pipelineLayout;
 
-			// Shader modules used in the pipeline
-			std::vector<ShaderModule> shaders;
+			// Shader modules used in the pipeline, shared with other pipelines through the asset cache
+			std::vector<std::shared_ptr<const ShaderModule>> shaders;
 			// Descriptor sets and their layouts
 			std::vector<DescriptorSetHandler> descriptorSetHandlers;
 			// Required descriptor count for each descriptor type of the current pipeline
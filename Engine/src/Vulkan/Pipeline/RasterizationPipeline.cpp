@@ -10,12 +10,13 @@ mtd::RasterizationPipeline::RasterizationPipeline
 (
 	const vk::Device& device,
 	const DescriptorManager& descriptorManager,
+	AssetCache& assetCache,
 	const RasterizationPipelineInfo& info,
 	vk::Extent2D extent,
 	vk::RenderPass renderPass
 ) : Pipeline{device, descriptorManager, info}
 {
-	loadShaderModules();
+	loadShaderModules(assetCache);
 	createPipelineLayout();
 	createPipeline(extent, renderPass);
 }
@@ -60,11 +61,11 @@ void mtd::RasterizationPipeline::pushConstant(vk::CommandBuffer commandBuffer, c
 	);
 }
 
-void mtd::RasterizationPipeline::loadShaderModules()
+void mtd::RasterizationPipeline::loadShaderModules(AssetCache& assetCache)
 {
 	shaders.reserve(2);
-	shaders.emplace_back(device, vk::ShaderStageFlagBits::eVertex, info.vertexShaderPath.c_str());
-	shaders.emplace_back(device, vk::ShaderStageFlagBits::eFragment, info.fragmentShaderPath.c_str());
+	shaders.push_back(assetCache.loadShader(vk::ShaderStageFlagBits::eVertex, info.vertexShaderPath));
+	shaders.push_back(assetCache.loadShader(vk::ShaderStageFlagBits::eFragment, info.fragmentShaderPath));
 }
 
 void mtd::RasterizationPipeline::createPipelineLayout()
@@ -99,8 +100,8 @@ void mtd::RasterizationPipeline::createPipeline(vk::Extent2D extent, vk::RenderP
 {
 	std::vector<vk::PipelineShaderStageCreateInfo> shaderStageCreateInfos;
 	shaderStageCreateInfos.reserve(shaders.size());
-	for(const ShaderModule& shader: shaders)
-		shaderStageCreateInfos.emplace_back(shader.generatePipelineShaderCreateInfo());
+	for(const std::shared_ptr<const ShaderModule>& shader: shaders)
+		shaderStageCreateInfos.emplace_back(shader->generatePipelineShaderCreateInfo());
 
 	vk::Viewport viewport{};
 	vk::Rect2D scissor{};
@@ -13,6 +13,7 @@ namespace mtd
 			(
 				const vk::Device& device,
 				const DescriptorManager& descriptorManager,
+				AssetCache& assetCache,
 				const RasterizationPipelineInfo& info,
 				vk::Extent2D extent,
 				vk::RenderPass renderPass
@@ -24,6 +25,7 @@ namespace mtd
 			// Getters
 			int32_t getTargetFramebuffer() const { return info.targetFramebufferIndex; }
 			MeshType getAssociatedMeshType() const { return info.associatedMeshType; }
+			bool isFrustumCullingEnabled() const { return info.frustumCulling; }
 
 			// Recreates the pipeline
 			void recreate(vk::Extent2D extent, vk::RenderPass renderPass);
@@ -36,7 +38,7 @@ namespace mtd
 
 		private:
 			// Loads the pipeline shader modules
-			void loadShaderModules();
+			void loadShaderModules(AssetCache& assetCache);
 
 			// Creates the layout for the pipeline
 			void createPipelineLayout();
@@ -9,6 +9,7 @@ mtd::RayTracingPipeline::RayTracingPipeline
 (
 	const Device& mtdDevice,
 	const DescriptorManager& descriptorManager,
+	AssetCache& assetCache,
 	const RayTracingPipelineInfo& info,
 	vk::Extent2D swapchainExtent
 ) : Pipeline{mtdDevice.getDevice(), descriptorManager, info},
@@ -24,7 +25,7 @@ mtd::RayTracingPipeline::RayTracingPipeline
 	},
 	shaderRenderingInfo{2U, 4U, 1U, 0U, 0U}
 {
-	loadShaderModules();
+	loadShaderModules(assetCache);
 	createDescriptorSetLayouts();
 	createPipelineLayout();
 	createRayTracingPipeline(mtdDevice.getDLDI());
@@ -152,12 +153,12 @@ void mtd::RayTracingPipeline::resize(const Device& mtdDevice, vk::Extent2D swapc
 	resetAccumulation();
 }
 
-void mtd::RayTracingPipeline::loadShaderModules()
+void mtd::RayTracingPipeline::loadShaderModules(AssetCache& assetCache)
 {
 	shaders.reserve(3);
-	shaders.emplace_back(device, vk::ShaderStageFlagBits::eRaygenKHR, info.rayGenShaderPath.c_str());
-	shaders.emplace_back(device, vk::ShaderStageFlagBits::eMissKHR, info.missShaderPath.c_str());
-	shaders.emplace_back(device, vk::ShaderStageFlagBits::eClosestHitKHR, info.closestHitShaderPath.c_str());
+	shaders.push_back(assetCache.loadShader(vk::ShaderStageFlagBits::eRaygenKHR, info.rayGenShaderPath));
+	shaders.push_back(assetCache.loadShader(vk::ShaderStageFlagBits::eMissKHR, info.missShaderPath));
+	shaders.push_back(assetCache.loadShader(vk::ShaderStageFlagBits::eClosestHitKHR, info.closestHitShaderPath));
 }
 
 void mtd::RayTracingPipeline::createDescriptorSetLayouts()
@@ -292,8 +293,8 @@ void mtd::RayTracingPipeline::createRayTracingPipeline(const vk::detail::Dispatc
 {
 	std::vector<vk::PipelineShaderStageCreateInfo> shaderStageInfos;
 	shaderStageInfos.reserve(shaders.size());
-	for(const ShaderModule& shader: shaders)
-		shaderStageInfos.emplace_back(shader.generatePipelineShaderCreateInfo());
+	for(const std::shared_ptr<const ShaderModule>& shader: shaders)
+		shaderStageInfos.emplace_back(shader->generatePipelineShaderCreateInfo());
 
 	std::vector<vk::RayTracingShaderGroupCreateInfoKHR> shaderGroupCreateInfos;
 	defineShaderGroups(shaderGroupCreateInfos);
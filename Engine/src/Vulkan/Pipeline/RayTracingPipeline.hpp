@@ -15,6 +15,7 @@ namespace mtd
 			(
 				const Device& mtdDevice,
 				const DescriptorManager& descriptorManager,
+				AssetCache& assetCache,
 				const RayTracingPipelineInfo& info,
 				vk::Extent2D swapchainExtent
 			);
@@ -68,7 +69,7 @@ namespace mtd
 			EventCallbackHandle resetAccumulationCallbackHandle;
 
 			// Loads the pipeline shader modules
-			void loadShaderModules();
+			void loadShaderModules(AssetCache& assetCache);
 
 			// Configures the descriptor set handlers to be used
 			void createDescriptorSetLayouts();
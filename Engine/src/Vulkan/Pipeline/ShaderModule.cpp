@@ -15,18 +15,22 @@ mtd::ShaderModule::ShaderModule(const vk::Device& device, vk::ShaderStageFlagBit
 	if(!FileHandler::readFile(shaderPath.c_str(), shaderSourceCode))
 		return;
 
-	vk::ShaderModuleCreateInfo shaderModuleCreateInfo{};
-	shaderModuleCreateInfo.flags = vk::ShaderModuleCreateFlags();
-	shaderModuleCreateInfo.codeSize = shaderSourceCode.size();
-	shaderModuleCreateInfo.pCode = reinterpret_cast<const uint32_t*>(shaderSourceCode.data());
+	createShaderModule(shaderSourceCode, shaderPath.c_str());
+}
 
-	vk::Result result = device.createShaderModule(&shaderModuleCreateInfo, nullptr, &shaderModule);
-	if(result != vk::Result::eSuccess)
-	{
-		LOG_ERROR("Failed to create shader module for \"%s\". Vulkan result: %d", shaderPath.c_str(), result);
+mtd::ShaderModule::ShaderModule
+(
+	const vk::Device& device,
+	vk::ShaderStageFlagBits shaderStage,
+	const std::vector<char>& shaderCode,
+	const char* shaderName
+) : device{device}, shaderStage{shaderStage}
+{
+	// Shader files that failed to be read are left without a module, as in the file constructor
+	if(shaderCode.empty())
 		return;
-	}
-	LOG_VERBOSE("Loaded shader module: \"%s\"", shaderPath.c_str());
+
+	createShaderModule(shaderCode, shaderName);
 }
 
 mtd::ShaderModule::~ShaderModule()
@@ -46,3 +50,19 @@ vk::PipelineShaderStageCreateInfo mtd::ShaderModule::generatePipelineShaderCreat
 {
 	return {vk::PipelineShaderStageCreateFlags(), shaderStage, shaderModule, "main", nullptr};
 }
+
+void mtd::ShaderModule::createShaderModule(const std::vector<char>& shaderCode, const char* shaderName)
+{
+	vk::ShaderModuleCreateInfo shaderModuleCreateInfo{};
+	shaderModuleCreateInfo.flags = vk::ShaderModuleCreateFlags();
+	shaderModuleCreateInfo.codeSize = shaderCode.size();
+	shaderModuleCreateInfo.pCode = reinterpret_cast<const uint32_t*>(shaderCode.data());
+
+	vk::Result result = device.createShaderModule(&shaderModuleCreateInfo, nullptr, &shaderModule);
+	if(result != vk::Result::eSuccess)
+	{
+		LOG_ERROR("Failed to create shader module for \"%s\". Vulkan result: %d", shaderName, result);
+		return;
+	}
+	LOG_VERBOSE("Loaded shader module: \"%s\"", shaderName);
+}
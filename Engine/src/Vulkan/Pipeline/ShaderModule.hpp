@@ -9,6 +9,13 @@ namespace mtd
 	{
 		public:
 			ShaderModule(const vk::Device& device, vk::ShaderStageFlagBits shaderStage, const char* shaderFile);
+			ShaderModule
+			(
+				const vk::Device& device,
+				vk::ShaderStageFlagBits shaderStage,
+				const std::vector<char>& shaderCode,
+				const char* shaderName
+			);
 			~ShaderModule();
 
 			ShaderModule(const ShaderModule&) = delete;
@@ -16,6 +23,9 @@ namespace mtd
 
 			ShaderModule(ShaderModule&& other) noexcept;
 
+			// Checks if the shader file was read and its module created
+			bool isValid() const { return static_cast<bool>(shaderModule); }
+
 			// Creates the Vulkan pipeline shader stage create info
 			vk::PipelineShaderStageCreateInfo generatePipelineShaderCreateInfo() const;
 
@@ -28,5 +38,8 @@ namespace mtd
 
 			// Vulkan device reference
 			const vk::Device& device;
+
+			// Creates the Vulkan shader module from the SPIR-V code
+			void createShaderModule(const std::vector<char>& shaderCode, const char* shaderName);
 	};
 }
@@ -0,0 +1,484 @@
+#include <pch.hpp>
+#include "GpuCuller.hpp"
+
+#include "../../Utils/Logger.hpp"
+
+namespace mtd
+{
+	// Built-in culling shader, compiled along with the engine
+	constexpr const char* CULLING_SHADER_PATH = "engine/gpu-culling.comp.spv";
+	// Local workgroup size of the culling shader
+	constexpr uint32_t CULLING_WORKGROUP_SIZE = 64U;
+
+	// Passes of the culling shader
+	enum class CullingPass : uint32_t
+	{
+		Instances,
+		Draws
+	};
+
+	// Push constant data for the culling shader
+	struct CullingPushConstantData
+	{
+		CullingPass pass;
+		uint32_t renderObjectCount;
+		uint32_t batchCount;
+		uint32_t drawCount;
+	};
+
+	// Grows the buffer geometrically, so the draw batches changing every frame do not resize it every frame
+	static void reserveBuffer(ResourceManager& resourceManager, ResourceID bufferID, uint64_t size)
+	{
+		uint64_t currentSize = resourceManager.getBufferSize(bufferID);
+		if(currentSize < size)
+			resourceManager.resizeBuffer(bufferID, std::max<uint64_t>(size, 2UL * currentSize));
+	}
+}
+
+mtd::GpuCuller::GpuCuller(const Device& mtdDevice)
+	: pipeline{nullptr}, pipelineLayout{nullptr}, descriptorPool{mtdDevice.getDevice()}, mtdDevice{mtdDevice}
+{
+}
+
+mtd::GpuCuller::~GpuCuller()
+{
+	mtdDevice.getDevice().destroyPipeline(pipeline);
+	mtdDevice.getDevice().destroyPipelineLayout(pipelineLayout);
+}
+
+void mtd::GpuCuller::create
+(
+	AssetCache& assetCache,
+	ResourceManager& resourceManager,
+	const std::vector<RasterizationPipeline>& rasterizationPipelines,
+	ResourceID cameraResourceID,
+	ResourceID renderObjectBufferID
+)
+{
+	if(!mtdDevice.isDrawIndirectCountEnabled() || rasterizationPipelines.empty()) return;
+
+	shader = assetCache.loadShader(vk::ShaderStageFlagBits::eCompute, CULLING_SHADER_PATH);
+	if(!shader->isValid())
+	{
+		LOG_WARNING("GPU culling shader \"%s\" not available. Draws will be recorded by the CPU.", CULLING_SHADER_PATH);
+		return;
+	}
+
+	createDescriptorSet();
+	createPipeline();
+	if(!pipeline) return;
+
+	pipelineDraws.resize(rasterizationPipelines.size());
+	pipelineFrustumCulling.reserve(rasterizationPipelines.size());
+	for(const RasterizationPipeline& rasterizationPipeline: rasterizationPipelines)
+		pipelineFrustumCulling.push_back(rasterizationPipeline.isFrustumCullingEnabled() ? 1U : 0U);
+
+	this->cameraResourceID = cameraResourceID;
+	this->renderObjectBufferID = renderObjectBufferID;
+	batchBufferID = resourceManager.createBuffer
+	(
+		"CullBatchesBuffer",
+		GpuBufferType::Storage | GpuBufferType::TransferDestination,
+		GpuMemoryUsage::GpuOnly,
+		sizeof(CullBatch)
+	);
+	drawBufferID = resourceManager.createBuffer
+	(
+		"CullDrawsBuffer",
+		GpuBufferType::Storage | GpuBufferType::TransferDestination,
+		GpuMemoryUsage::GpuOnly,
+		sizeof(CullDraw)
+	);
+	commandBufferID = resourceManager.createBuffer
+	(
+		"IndirectDrawCommandsBuffer",
+		GpuBufferType::Indirect,
+		GpuMemoryUsage::GpuOnly,
+		sizeof(vk::DrawIndexedIndirectCommand)
+	);
+	drawCountBufferID = resourceManager.createBuffer
+	(
+		"IndirectDrawCountsBuffer",
+		GpuBufferType::Indirect | GpuBufferType::TransferDestination,
+		GpuMemoryUsage::GpuOnly,
+		rasterizationPipelines.size() * sizeof(uint32_t)
+	);
+	visibleObjectBufferID = resourceManager.createBuffer
+	(
+		"VisibleRenderObjectsBuffer",
+		GpuBufferType::Vertex,
+		GpuMemoryUsage::GpuOnly,
+		sizeof(RenderObject)
+	);
+	visibleRemapBufferID = resourceManager.createBuffer
+	(
+		"VisibleRenderObjectsRemapBuffer",
+		GpuBufferType::Storage,
+		GpuMemoryUsage::GpuOnly,
+		sizeof(uint32_t)
+	);
+	drawTemplateBufferID = resourceManager.createBuffer
+	(
+		"CullDrawTemplatesBuffer",
+		GpuBufferType::TransferSource | GpuBufferType::TransferDestination,
+		GpuMemoryUsage::GpuOnly,
+		sizeof(CullDraw)
+	);
+
+	enabled = true;
+	updateDescriptors(resourceManager);
+	LOG_VERBOSE("Created GPU culling for %d rasterization pipelines.", rasterizationPipelines.size());
+}
+
+void mtd::GpuCuller::updateDraws
+(
+	ResourceManager& resourceManager,
+	const RenderObjectManager& renderObjectManager,
+	const std::vector<MeshData>& meshes
+)
+{
+	if(!enabled) return;
+
+	renderObjectCount = renderObjectManager.getRenderObjectCount();
+	if(renderObjectManager.getDrawBatchVersion() != drawBatchVersion)
+	{
+		drawBatchVersion = renderObjectManager.getDrawBatchVersion();
+		buildDraws(renderObjectManager.getDrawBatches(), meshes);
+		uploadDraws(resourceManager);
+	}
+}
+
+bool mtd::GpuCuller::hasOutdatedDescriptors(const ResourceManager& resourceManager) const
+{
+	if(!enabled) return false;
+
+	const std::array<ResourceID, BINDING_COUNT> bindingBufferIDs = getBindingBufferIDs();
+	for(uint32_t binding = 0U; binding < BINDING_COUNT; binding++)
+	{
+		vk::DescriptorBufferInfo bufferInfo{};
+		if(!resourceManager.fetchDescriptorBufferInfo(bindingBufferIDs[binding], bufferInfo)) continue;
+		if(bufferInfo.buffer != boundBuffers[binding]) return true;
+	}
+	return false;
+}
+
+void mtd::GpuCuller::updateDescriptors(const ResourceManager& resourceManager)
+{
+	if(!enabled) return;
+
+	const std::array<ResourceID, BINDING_COUNT> bindingBufferIDs = getBindingBufferIDs();
+	for(uint32_t binding = 0U; binding < BINDING_COUNT; binding++)
+	{
+		vk::DescriptorBufferInfo bufferInfo{};
+		if(!resourceManager.fetchDescriptorBufferInfo(bindingBufferIDs[binding], bufferInfo)) continue;
+		if(bufferInfo.buffer == boundBuffers[binding]) continue;
+
+		pDescriptorSetHandler->assignBuffer(binding, bufferInfo);
+		pDescriptorSetHandler->writeDescriptor(binding);
+		boundBuffers[binding] = bufferInfo.buffer;
+	}
+}
+
+void mtd::GpuCuller::recordCulling(const ResourceManager& resourceManager, vk::CommandBuffer commandBuffer) const
+{
+	if(!enabled || cullDraws.empty()) return;
+
+	// The previous frames may still be reading the draws and the visible render objects
+	vk::MemoryBarrier memoryBarrier{};
+	memoryBarrier.srcAccessMask = vk::AccessFlagBits::eIndirectCommandRead
+		| vk::AccessFlagBits::eVertexAttributeRead | vk::AccessFlagBits::eShaderRead;
+	memoryBarrier.dstAccessMask = vk::AccessFlagBits::eTransferWrite | vk::AccessFlagBits::eShaderWrite;
+	commandBuffer.pipelineBarrier
+	(
+		vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput
+			| vk::PipelineStageFlagBits::eComputeShader,
+		vk::PipelineStageFlagBits::eTransfer | vk::PipelineStageFlagBits::eComputeShader,
+		vk::DependencyFlags(),
+		memoryBarrier,
+		nullptr,
+		nullptr
+	);
+
+	// Resets the instance counts of the draws and the draw counts of the pipelines
+	vk::BufferCopy drawsCopy{0UL, 0UL, cullDraws.size() * sizeof(CullDraw)};
+	commandBuffer.copyBuffer
+	(
+		resourceManager.getVulkanBuffer(drawTemplateBufferID),
+		resourceManager.getVulkanBuffer(drawBufferID),
+		1U, &drawsCopy
+	);
+	commandBuffer.fillBuffer(resourceManager.getVulkanBuffer(drawCountBufferID), 0UL, vk::WholeSize, 0U);
+
+	memoryBarrier.srcAccessMask = vk::AccessFlagBits::eTransferWrite;
+	memoryBarrier.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+	commandBuffer.pipelineBarrier
+	(
+		vk::PipelineStageFlagBits::eTransfer,
+		vk::PipelineStageFlagBits::eComputeShader,
+		vk::DependencyFlags(),
+		memoryBarrier,
+		nullptr,
+		nullptr
+	);
+
+	commandBuffer.bindPipeline(vk::PipelineBindPoint::eCompute, pipeline);
+	commandBuffer.bindDescriptorSets
+	(
+		vk::PipelineBindPoint::eCompute, pipelineLayout, 0U, 1U, &(pDescriptorSetHandler->getSet()), 0U, nullptr
+	);
+
+	CullingPushConstantData pushConstantData
+	{
+		CullingPass::Instances,
+		renderObjectCount,
+		static_cast<uint32_t>(cullBatches.size()),
+		static_cast<uint32_t>(cullDraws.size())
+	};
+	commandBuffer.pushConstants
+	(
+		pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0U, sizeof(CullingPushConstantData), &pushConstantData
+	);
+	commandBuffer.dispatch((renderObjectCount + CULLING_WORKGROUP_SIZE - 1U) / CULLING_WORKGROUP_SIZE, 1U, 1U);
+
+	// The draws are compacted only after all instances were counted
+	memoryBarrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+	memoryBarrier.dstAccessMask = vk::AccessFlagBits::eShaderRead | vk::AccessFlagBits::eShaderWrite;
+	commandBuffer.pipelineBarrier
+	(
+		vk::PipelineStageFlagBits::eComputeShader,
+		vk::PipelineStageFlagBits::eComputeShader,
+		vk::DependencyFlags(),
+		memoryBarrier,
+		nullptr,
+		nullptr
+	);
+
+	pushConstantData.pass = CullingPass::Draws;
+	commandBuffer.pushConstants
+	(
+		pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0U, sizeof(CullingPushConstantData), &pushConstantData
+	);
+	commandBuffer.dispatch
+	(
+		(pushConstantData.drawCount + CULLING_WORKGROUP_SIZE - 1U) / CULLING_WORKGROUP_SIZE, 1U, 1U
+	);
+
+	memoryBarrier.srcAccessMask = vk::AccessFlagBits::eShaderWrite;
+	memoryBarrier.dstAccessMask = vk::AccessFlagBits::eIndirectCommandRead | vk::AccessFlagBits::eVertexAttributeRead;
+	commandBuffer.pipelineBarrier
+	(
+		vk::PipelineStageFlagBits::eComputeShader,
+		vk::PipelineStageFlagBits::eDrawIndirect | vk::PipelineStageFlagBits::eVertexInput,
+		vk::DependencyFlags(),
+		memoryBarrier,
+		nullptr,
+		nullptr
+	);
+}
+
+void mtd::GpuCuller::bindVisibleObjects
+(
+	const ResourceManager& resourceManager, vk::CommandBuffer commandBuffer
+) const
+{
+	vk::DeviceSize offset{0UL};
+	vk::Buffer buffer = resourceManager.getVulkanBuffer(visibleObjectBufferID);
+	if(!buffer)
+	{
+		LOG_ERROR("Failed to bind visible render objects buffer.");
+		return;
+	}
+
+	commandBuffer.bindVertexBuffers(1U, 1U, &buffer, &offset);
+}
+
+uint32_t mtd::GpuCuller::drawPipeline
+(
+	const ResourceManager& resourceManager, vk::CommandBuffer commandBuffer, uint32_t pipelineIndex
+) const
+{
+	const DrawRange& drawRange = pipelineDraws[pipelineIndex];
+	if(drawRange.drawCount == 0U) return 0U;
+
+	commandBuffer.drawIndexedIndirectCount
+	(
+		resourceManager.getVulkanBuffer(commandBufferID),
+		drawRange.firstDraw * sizeof(vk::DrawIndexedIndirectCommand),
+		resourceManager.getVulkanBuffer(drawCountBufferID),
+		pipelineIndex * sizeof(uint32_t),
+		drawRange.drawCount,
+		sizeof(vk::DrawIndexedIndirectCommand)
+	);
+	return 1U;
+}
+
+void mtd::GpuCuller::createDescriptorSet()
+{
+	// The camera is a uniform buffer, followed by the storage buffers
+	std::vector<vk::DescriptorSetLayoutBinding> bindings(BINDING_COUNT);
+	for(uint32_t binding = 0U; binding < BINDING_COUNT; binding++)
+	{
+		bindings[binding].binding = binding;
+		bindings[binding].descriptorType =
+			(binding == 0U) ? vk::DescriptorType::eUniformBuffer : vk::DescriptorType::eStorageBuffer;
+		bindings[binding].descriptorCount = 1U;
+		bindings[binding].stageFlags = vk::ShaderStageFlagBits::eCompute;
+		bindings[binding].pImmutableSamplers = nullptr;
+	}
+	pDescriptorSetHandler = std::make_unique<DescriptorSetHandler>(mtdDevice.getDevice(), bindings);
+
+	descriptorPool.createDescriptorPool
+	({
+		{1U, vk::DescriptorType::eUniformBuffer},
+		{BINDING_COUNT - 1U, vk::DescriptorType::eStorageBuffer}
+	});
+	descriptorPool.allocateDescriptorSet(*pDescriptorSetHandler);
+}
+
+void mtd::GpuCuller::createPipeline()
+{
+	vk::PushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = vk::ShaderStageFlagBits::eCompute;
+	pushConstantRange.offset = 0U;
+	pushConstantRange.size = sizeof(CullingPushConstantData);
+
+	vk::PipelineLayoutCreateInfo pipelineLayoutCreateInfo{};
+	pipelineLayoutCreateInfo.flags = vk::PipelineLayoutCreateFlags();
+	pipelineLayoutCreateInfo.setLayoutCount = 1U;
+	pipelineLayoutCreateInfo.pSetLayouts = &(pDescriptorSetHandler->getLayout());
+	pipelineLayoutCreateInfo.pushConstantRangeCount = 1U;
+	pipelineLayoutCreateInfo.pPushConstantRanges = &pushConstantRange;
+
+	const vk::Device& device = mtdDevice.getDevice();
+	vk::Result result = device.createPipelineLayout(&pipelineLayoutCreateInfo, nullptr, &pipelineLayout);
+	if(result != vk::Result::eSuccess)
+	{
+		LOG_ERROR("Failed to create GPU culling pipeline layout. Vulkan result: %d", result);
+		return;
+	}
+
+	vk::ComputePipelineCreateInfo pipelineCreateInfo{};
+	pipelineCreateInfo.flags = vk::PipelineCreateFlags();
+	pipelineCreateInfo.stage = shader->generatePipelineShaderCreateInfo();
+	pipelineCreateInfo.layout = pipelineLayout;
+	pipelineCreateInfo.basePipelineHandle = nullptr;
+	pipelineCreateInfo.basePipelineIndex = 0;
+
+	result = device.createComputePipelines(nullptr, 1U, &pipelineCreateInfo, nullptr, &pipeline);
+	if(result != vk::Result::eSuccess)
+	{
+		LOG_ERROR("Failed to create GPU culling pipeline. Vulkan result: %d", result);
+		return;
+	}
+	LOG_VERBOSE("Created GPU culling pipeline.");
+}
+
+void mtd::GpuCuller::buildDraws(const std::vector<DrawBatch>& drawBatches, const std::vector<MeshData>& meshes)
+{
+	cullBatches.clear();
+	cullDraws.clear();
+	std::ranges::fill(pipelineDraws, DrawRange{0U, 0U});
+
+	// Each draw owns a range of the visible render objects, large enough for all instances of its batch
+	uint32_t visibleObjectCount = 0U;
+	for(const DrawBatch& drawBatch: drawBatches)
+	{
+		const MeshData& mesh = meshes[drawBatch.meshID];
+		// Batches of unknown pipelines are kept without draws, so every render object still has a batch
+		bool validPipeline = drawBatch.pipelineID < pipelineDraws.size();
+		uint32_t drawCount = validPipeline ? static_cast<uint32_t>(mesh.submeshes.size()) : 0U;
+
+		cullBatches.push_back
+		(
+			CullBatch
+			{
+				drawBatch.firstInstance,
+				drawBatch.instanceCount,
+				static_cast<uint32_t>(cullDraws.size()),
+				drawCount,
+				validPipeline ? pipelineFrustumCulling[drawBatch.pipelineID] : 0U
+			}
+		);
+		if(drawCount == 0U) continue;
+
+		// The draw batches are sorted by pipeline, so the draws of each pipeline are contiguous
+		DrawRange& drawRange = pipelineDraws[drawBatch.pipelineID];
+		if(drawRange.drawCount == 0U)
+			drawRange.firstDraw = static_cast<uint32_t>(cullDraws.size());
+		drawRange.drawCount += drawCount;
+
+		for(const SubmeshData& submesh: mesh.submeshes)
+		{
+			cullDraws.push_back
+			(
+				CullDraw
+				{
+					vk::DrawIndexedIndirectCommand
+					{
+						submesh.indexCount,
+						0U,
+						mesh.indexOffset + submesh.indexOffset,
+						static_cast<int32_t>(mesh.vertexOffset),
+						visibleObjectCount
+					},
+					drawBatch.pipelineID,
+					drawRange.firstDraw,
+					submesh.materialSlot
+				}
+			);
+			visibleObjectCount += drawBatch.instanceCount;
+		}
+	}
+
+	LOG_VERBOSE
+	(
+		"Built %d GPU culled draws for %d draw batches (%d visible render object slots).",
+		cullDraws.size(), cullBatches.size(), visibleObjectCount
+	);
+}
+
+void mtd::GpuCuller::uploadDraws(ResourceManager& resourceManager)
+{
+	uint64_t visibleObjectCount = 0UL;
+	for(const CullBatch& cullBatch: cullBatches)
+		visibleObjectCount += static_cast<uint64_t>(cullBatch.renderObjectCount) * cullBatch.drawCount;
+
+	reserveBuffer(resourceManager, batchBufferID, cullBatches.size() * sizeof(CullBatch));
+	reserveBuffer(resourceManager, drawBufferID, cullDraws.size() * sizeof(CullDraw));
+	reserveBuffer(resourceManager, drawTemplateBufferID, cullDraws.size() * sizeof(CullDraw));
+	reserveBuffer
+	(
+		resourceManager, commandBufferID, cullDraws.size() * sizeof(vk::DrawIndexedIndirectCommand)
+	);
+	reserveBuffer(resourceManager, visibleObjectBufferID, visibleObjectCount * sizeof(RenderObject));
+	reserveBuffer(resourceManager, visibleRemapBufferID, visibleObjectCount * sizeof(uint32_t));
+
+	if(cullBatches.empty()) return;
+
+	bool uploaded = resourceManager.updateBufferData
+	(
+		batchBufferID, cullBatches.size() * sizeof(CullBatch), cullBatches.data()
+	);
+	if(!cullDraws.empty())
+		uploaded &= resourceManager.updateBufferData
+		(
+			drawTemplateBufferID, cullDraws.size() * sizeof(CullDraw), cullDraws.data()
+		);
+	if(!uploaded)
+		LOG_ERROR("Failed to update GPU culling buffers data.");
+}
+
+std::array<mtd::ResourceID, mtd::GpuCuller::BINDING_COUNT> mtd::GpuCuller::getBindingBufferIDs() const
+{
+	return
+	{
+		cameraResourceID,
+		renderObjectBufferID,
+		batchBufferID,
+		drawBufferID,
+		commandBufferID,
+		drawCountBufferID,
+		visibleObjectBufferID,
+		visibleRemapBufferID
+	};
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include "RenderObjectManager.hpp"
+#include "../Descriptors/DescriptorPool.hpp"
+#include "../Pipeline/RasterizationPipeline.hpp"
+
+namespace mtd
+{
+	// Frustum culls the render objects on the GPU, writing compacted indirect draws for each rasterization pipeline
+	class GpuCuller
+	{
+		public:
+			GpuCuller(const Device& mtdDevice);
+			~GpuCuller();
+
+			GpuCuller(const GpuCuller&) = delete;
+			GpuCuller& operator=(const GpuCuller&) = delete;
+
+			// Getter
+			bool isEnabled() const { return enabled; }
+
+			// Creates the culling pipeline and buffers, if the device supports indirect draw counts
+			void create
+			(
+				AssetCache& assetCache,
+				ResourceManager& resourceManager,
+				const std::vector<RasterizationPipeline>& rasterizationPipelines,
+				ResourceID cameraResourceID,
+				ResourceID renderObjectBufferID
+			);
+
+			// Rebuilds the draws when the draw batches change
+			void updateDraws
+			(
+				ResourceManager& resourceManager,
+				const RenderObjectManager& renderObjectManager,
+				const std::vector<MeshData>& meshes
+			);
+
+			// Checks if any buffer was created or recreated since the descriptors were last written
+			bool hasOutdatedDescriptors(const ResourceManager& resourceManager) const;
+			// Writes the descriptors of the buffers that were created or recreated since the last write, which must
+			// only be called when no frame in flight uses the descriptor set
+			void updateDescriptors(const ResourceManager& resourceManager);
+
+			// Records the culling passes, after the pending uploads and before the render passes
+			void recordCulling(const ResourceManager& resourceManager, vk::CommandBuffer commandBuffer) const;
+
+			// Binds the visible render objects as the instance buffer
+			void bindVisibleObjects(const ResourceManager& resourceManager, vk::CommandBuffer commandBuffer) const;
+			// Draws the visible instances of a pipeline with a single indirect call, returning the amount of calls
+			uint32_t drawPipeline
+			(
+				const ResourceManager& resourceManager, vk::CommandBuffer commandBuffer, uint32_t pipelineIndex
+			) const;
+
+		private:
+			// Draw batch as read by the culling shader
+			struct CullBatch
+			{
+				uint32_t firstRenderObject;
+				uint32_t renderObjectCount;
+				uint32_t firstDraw;
+				uint32_t drawCount;
+				uint32_t frustumCulling;
+			};
+
+			// Submesh draw of a batch, with the instance count filled by the culling shader
+			struct CullDraw
+			{
+				vk::DrawIndexedIndirectCommand command;
+				uint32_t pipelineIndex;
+				uint32_t firstPipelineDraw;
+				uint32_t materialSlot;
+			};
+
+			// Range of the draws of a pipeline, which is also its range of the indirect commands
+			struct DrawRange
+			{
+				uint32_t firstDraw;
+				uint32_t drawCount;
+			};
+
+			// Amount of buffers bound to the culling shader
+			static constexpr uint32_t BINDING_COUNT = 8U;
+
+			// Culling compute pipeline
+			vk::Pipeline pipeline;
+			vk::PipelineLayout pipelineLayout;
+			std::shared_ptr<const ShaderModule> shader;
+			// Descriptors of the culling buffers
+			DescriptorPool descriptorPool;
+			std::unique_ptr<DescriptorSetHandler> pDescriptorSetHandler;
+			// Buffers currently written to each binding of the descriptor set
+			std::array<vk::Buffer, BINDING_COUNT> boundBuffers{};
+
+			// Scene buffers read by the culling shader
+			ResourceID cameraResourceID = 0U;
+			ResourceID renderObjectBufferID = 0U;
+			// Batches and draws built from the draw batches, and the draws with no instances copied over them each frame
+			ResourceID batchBufferID = 0U;
+			ResourceID drawBufferID = 0U;
+			ResourceID drawTemplateBufferID = 0U;
+			// Compacted indirect commands, and the amount of commands of each pipeline
+			ResourceID commandBufferID = 0U;
+			ResourceID drawCountBufferID = 0U;
+			// Copies of the visible render objects, used as instance data, and their render object indices
+			ResourceID visibleObjectBufferID = 0U;
+			ResourceID visibleRemapBufferID = 0U;
+
+			// Culling data of the current draw batches
+			std::vector<CullBatch> cullBatches;
+			std::vector<CullDraw> cullDraws;
+			std::vector<DrawRange> pipelineDraws;
+			// Frustum culling flag of each rasterization pipeline
+			std::vector<uint32_t> pipelineFrustumCulling;
+			// Amount of render objects tested in the current frame
+			uint32_t renderObjectCount = 0U;
+			// Version of the draw batches which the culling data was built from
+			uint64_t drawBatchVersion = std::numeric_limits<uint64_t>::max();
+
+			// Set if the culling pipeline was created
+			bool enabled = false;
+
+			// Device reference
+			const Device& mtdDevice;
+
+			// Creates the descriptor set of the culling buffers
+			void createDescriptorSet();
+			// Creates the layout and the compute pipeline
+			void createPipeline();
+
+			// Builds the culling data from the draw batches, splitting each batch in one draw per submesh
+			void buildDraws(const std::vector<DrawBatch>& drawBatches, const std::vector<MeshData>& meshes);
+			// Grows the culling buffers to fit the draws and uploads them
+			void uploadDraws(ResourceManager& resourceManager);
+			// Buffers bound to each binding of the descriptor set
+			std::array<ResourceID, BINDING_COUNT> getBindingBufferIDs() const;
+	};
+}
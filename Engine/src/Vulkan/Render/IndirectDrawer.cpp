@@ -0,0 +1,310 @@
+#include <pch.hpp>
+#include "IndirectDrawer.hpp"
+
+#include <algorithm>
+
+#include "../../Utils/Logger.hpp"
+
+namespace mtd
+{
+	// Draws per multi draw indirect call, within the minimum limit guaranteed by the devices supporting it
+	constexpr uint32_t MAX_DRAWS_PER_CALL = 65535U;
+
+	// Checks if two indirect commands draw the same instances of the same submesh
+	static bool equalCommands(const vk::DrawIndexedIndirectCommand& a, const vk::DrawIndexedIndirectCommand& b)
+	{
+		return a.indexCount == b.indexCount && a.instanceCount == b.instanceCount && a.firstIndex == b.firstIndex
+			&& a.vertexOffset == b.vertexOffset && a.firstInstance == b.firstInstance;
+	}
+
+	// Grows the buffer geometrically, so the draws changing every frame do not resize it every frame
+	static void reserveBuffer(ResourceManager& resourceManager, ResourceID bufferID, uint64_t size)
+	{
+		uint64_t currentSize = resourceManager.getBufferSize(bufferID);
+		if(currentSize < size)
+			resourceManager.resizeBuffer(bufferID, std::max<uint64_t>(size, 2UL * currentSize));
+	}
+}
+
+mtd::IndirectDrawer::IndirectDrawer(const Device& mtdDevice)
+	: mtdDevice{mtdDevice}
+{
+}
+
+void mtd::IndirectDrawer::create(ResourceManager& resourceManager, uint32_t pipelineCount)
+{
+	pipelineCommands.assign(pipelineCount, CommandRange{0U, 0U});
+	if(pipelineCount == 0U) return;
+
+	instanceCopyBufferID = resourceManager.createBuffer
+	(
+		"InstanceCopiesBuffer",
+		GpuBufferType::Vertex | GpuBufferType::TransferSource | GpuBufferType::TransferDestination,
+		GpuMemoryUsage::GpuOnly,
+		sizeof(RenderObject)
+	);
+
+	if(!mtdDevice.isMultiDrawIndirectEnabled()) return;
+
+	commandBufferID = resourceManager.createBuffer
+	(
+		"MultiDrawCommandsBuffer",
+		GpuBufferType::Indirect | GpuBufferType::TransferDestination,
+		GpuMemoryUsage::GpuOnly,
+		sizeof(vk::DrawIndexedIndirectCommand)
+	);
+
+	multiDrawEnabled = true;
+	LOG_VERBOSE("Created multi draw indirect commands for %d rasterization pipelines.", pipelineCount);
+}
+
+void mtd::IndirectDrawer::updateDraws
+(
+	ResourceManager& resourceManager,
+	const RenderObjectManager& renderObjectManager,
+	const std::vector<MeshData>& meshes
+)
+{
+	if(instanceCopyBufferID == 0U) return;
+
+	// The copies keep their layout while the draw batch ranges are the same, so only the render objects changed
+	// in this frame (including the ones moved by the culling) are copied again
+	bool fullUpload = renderObjectManager.getDrawBatchVersion() != drawBatchVersion;
+	if(fullUpload || renderObjectManager.areAllRenderObjectsChanged())
+	{
+		drawBatchVersion = renderObjectManager.getDrawBatchVersion();
+		buildCopies(renderObjectManager, meshes);
+		fullUpload = true;
+	}
+	else
+	{
+		for(uint32_t renderObjectIndex: renderObjectManager.getChangedRenderObjects())
+		{
+			if(renderObjectIndex >= renderObjectManager.getRenderObjectCount()) continue;
+
+			uint32_t batchIndex = renderObjectManager.findDrawBatch(renderObjectIndex);
+			writeCopies(renderObjectManager, meshes, batchIndex, renderObjectIndex);
+		}
+	}
+	uploadCopies(resourceManager, fullUpload);
+
+	drawCommands.clear();
+	std::ranges::fill(pipelineCommands, CommandRange{0U, 0U});
+
+	// The draw batches are sorted by pipeline, so the commands of each pipeline are contiguous
+	const std::vector<DrawBatch>& drawBatches = renderObjectManager.getDrawBatches();
+	for(uint32_t batchIndex = 0U; batchIndex < drawBatches.size(); batchIndex++)
+	{
+		const DrawBatch& drawBatch = drawBatches[batchIndex];
+		if(drawBatch.pipelineID >= pipelineCommands.size() || drawBatch.visibleInstanceCount == 0U) continue;
+
+		CommandRange& commandRange = pipelineCommands[drawBatch.pipelineID];
+		if(commandRange.commandCount == 0U)
+			commandRange.firstCommand = static_cast<uint32_t>(drawCommands.size());
+
+		// The visible render objects are at the beginning of the batch, and so are their copies
+		const MeshData& mesh = meshes[drawBatch.meshID];
+		uint32_t firstCopy = batchCopies[batchIndex].firstCopy;
+		for(const SubmeshData& submesh: mesh.submeshes)
+		{
+			drawCommands.push_back
+			(
+				vk::DrawIndexedIndirectCommand
+				{
+					submesh.indexCount,
+					drawBatch.visibleInstanceCount,
+					mesh.indexOffset + submesh.indexOffset,
+					static_cast<int32_t>(mesh.vertexOffset),
+					firstCopy
+				}
+			);
+			firstCopy += drawBatch.instanceCount;
+		}
+		commandRange.commandCount += static_cast<uint32_t>(mesh.submeshes.size());
+	}
+
+	if(multiDrawEnabled)
+		uploadDraws(resourceManager);
+}
+
+void mtd::IndirectDrawer::bindInstanceCopies
+(
+	const ResourceManager& resourceManager, vk::CommandBuffer commandBuffer
+) const
+{
+	vk::DeviceSize offset{0UL};
+	vk::Buffer buffer = resourceManager.getVulkanBuffer(instanceCopyBufferID);
+	if(!buffer)
+	{
+		LOG_ERROR("Failed to bind instance copies buffer.");
+		return;
+	}
+
+	commandBuffer.bindVertexBuffers(1U, 1U, &buffer, &offset);
+}
+
+uint32_t mtd::IndirectDrawer::drawPipeline
+(
+	const ResourceManager& resourceManager, vk::CommandBuffer commandBuffer, uint32_t pipelineIndex
+) const
+{
+	if(pipelineIndex >= pipelineCommands.size()) return 0U;
+
+	const CommandRange& commandRange = pipelineCommands[pipelineIndex];
+	if(commandRange.commandCount == 0U) return 0U;
+
+	// Without multi draw indirect, each submesh is drawn by a direct call
+	if(!multiDrawEnabled)
+	{
+		for(uint32_t i = 0U; i < commandRange.commandCount; i++)
+		{
+			const vk::DrawIndexedIndirectCommand& command = drawCommands[commandRange.firstCommand + i];
+			commandBuffer.drawIndexed
+			(
+				command.indexCount, command.instanceCount,
+				command.firstIndex, command.vertexOffset,
+				command.firstInstance
+			);
+		}
+		return commandRange.commandCount;
+	}
+
+	vk::Buffer buffer = resourceManager.getVulkanBuffer(commandBufferID);
+	uint32_t drawCallCount = 0U;
+	for(uint32_t firstCommand = 0U; firstCommand < commandRange.commandCount; firstCommand += MAX_DRAWS_PER_CALL)
+	{
+		commandBuffer.drawIndexedIndirect
+		(
+			buffer,
+			(commandRange.firstCommand + firstCommand) * sizeof(vk::DrawIndexedIndirectCommand),
+			std::min(commandRange.commandCount - firstCommand, MAX_DRAWS_PER_CALL),
+			sizeof(vk::DrawIndexedIndirectCommand)
+		);
+		drawCallCount++;
+	}
+	return drawCallCount;
+}
+
+void mtd::IndirectDrawer::buildCopies
+(
+	const RenderObjectManager& renderObjectManager, const std::vector<MeshData>& meshes
+)
+{
+	const std::vector<DrawBatch>& drawBatches = renderObjectManager.getDrawBatches();
+	batchCopies.clear();
+	batchCopies.reserve(drawBatches.size());
+
+	// Batches of unknown pipelines are never drawn, so they are kept without copies
+	uint32_t copyCount = 0U;
+	for(const DrawBatch& drawBatch: drawBatches)
+	{
+		bool validPipeline = drawBatch.pipelineID < pipelineCommands.size();
+		uint32_t submeshCount = validPipeline ? static_cast<uint32_t>(meshes[drawBatch.meshID].submeshes.size()) : 0U;
+
+		batchCopies.push_back(BatchCopies{copyCount, submeshCount});
+		copyCount += submeshCount * drawBatch.instanceCount;
+	}
+
+	// The whole buffer is uploaded after a rebuild, so the copies are not kept as dirty
+	instanceCopies.resize(copyCount);
+	for(uint32_t batchIndex = 0U; batchIndex < drawBatches.size(); batchIndex++)
+	{
+		const DrawBatch& drawBatch = drawBatches[batchIndex];
+		for(uint32_t i = drawBatch.firstInstance; i < drawBatch.firstInstance + drawBatch.instanceCount; i++)
+			writeCopies(renderObjectManager, meshes, batchIndex, i);
+	}
+	dirtyCopies.clear();
+}
+
+void mtd::IndirectDrawer::writeCopies
+(
+	const RenderObjectManager& renderObjectManager,
+	const std::vector<MeshData>& meshes,
+	uint32_t batchIndex,
+	uint32_t renderObjectIndex
+)
+{
+	const DrawBatch& drawBatch = renderObjectManager.getDrawBatches()[batchIndex];
+	const BatchCopies& copies = batchCopies[batchIndex];
+	const RenderObject& renderObject = renderObjectManager.getRenderObjects()[renderObjectIndex];
+	const std::vector<SubmeshData>& submeshes = meshes[drawBatch.meshID].submeshes;
+
+	uint32_t copyIndex = copies.firstCopy + (renderObjectIndex - drawBatch.firstInstance);
+	for(uint32_t i = 0U; i < copies.submeshCount; i++)
+	{
+		instanceCopies[copyIndex] = renderObject;
+		instanceCopies[copyIndex].materialSetID += submeshes[i].materialSlot;
+		dirtyCopies.push_back(copyIndex);
+		copyIndex += drawBatch.instanceCount;
+	}
+}
+
+void mtd::IndirectDrawer::uploadCopies(ResourceManager& resourceManager, bool fullUpload)
+{
+	if(instanceCopies.empty() || (!fullUpload && dirtyCopies.empty()))
+	{
+		dirtyCopies.clear();
+		return;
+	}
+
+	reserveBuffer(resourceManager, instanceCopyBufferID, instanceCopies.size() * sizeof(RenderObject));
+
+	if(fullUpload)
+	{
+		if
+		(
+			!resourceManager.updateBufferData
+			(
+				instanceCopyBufferID, instanceCopies.size() * sizeof(RenderObject), instanceCopies.data()
+			)
+		)
+			LOG_ERROR("Failed to update instance copies buffer data.");
+
+		dirtyCopies.clear();
+		return;
+	}
+
+	std::sort(dirtyCopies.begin(), dirtyCopies.end());
+	dirtyCopies.erase(std::unique(dirtyCopies.begin(), dirtyCopies.end()), dirtyCopies.end());
+
+	// Contiguous dirty copies are uploaded together
+	size_t rangeBegin = 0UL;
+	while(rangeBegin < dirtyCopies.size())
+	{
+		size_t rangeEnd = rangeBegin + 1UL;
+		while(rangeEnd < dirtyCopies.size() && dirtyCopies[rangeEnd] == dirtyCopies[rangeEnd - 1UL] + 1U)
+			rangeEnd++;
+
+		uint32_t firstIndex = dirtyCopies[rangeBegin];
+		uint64_t rangeSize = (rangeEnd - rangeBegin) * sizeof(RenderObject);
+		if
+		(
+			!resourceManager.updateBufferData
+			(
+				instanceCopyBufferID, rangeSize, &(instanceCopies[firstIndex]), firstIndex * sizeof(RenderObject)
+			)
+		)
+			LOG_ERROR("Failed to update instance copies buffer data.");
+
+		rangeBegin = rangeEnd;
+	}
+	dirtyCopies.clear();
+}
+
+void mtd::IndirectDrawer::uploadDraws(ResourceManager& resourceManager)
+{
+	if(drawCommands.empty()) return;
+	if(std::ranges::equal(drawCommands, uploadedCommands, equalCommands)) return;
+
+	// Grows the buffer geometrically, since the visible instances change every frame
+	uint64_t commandsSize = drawCommands.size() * sizeof(vk::DrawIndexedIndirectCommand);
+	reserveBuffer(resourceManager, commandBufferID, commandsSize);
+
+	if(!resourceManager.updateBufferData(commandBufferID, commandsSize, drawCommands.data()))
+	{
+		LOG_ERROR("Failed to update multi draw indirect commands buffer data.");
+		uploadedCommands.clear();
+		return;
+	}
+	uploadedCommands = drawCommands;
+}
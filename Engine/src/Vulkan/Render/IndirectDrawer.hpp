@@ -0,0 +1,98 @@
+#pragma once
+
+#include "RenderObjectManager.hpp"
+
+namespace mtd
+{
+	// Draws the CPU culled draw batches of each rasterization pipeline with a single multi draw indirect call.
+	// Each submesh draws its own copies of the render objects, with the submesh material slot added to the material
+	// set, laid out as the GPU culled instances.
+	class IndirectDrawer
+	{
+		public:
+			IndirectDrawer(const Device& mtdDevice);
+			~IndirectDrawer() = default;
+
+			IndirectDrawer(const IndirectDrawer&) = delete;
+			IndirectDrawer& operator=(const IndirectDrawer&) = delete;
+
+			// Creates the instance copies buffer, and the indirect commands buffer if the device supports multi draw
+			// indirect
+			void create(ResourceManager& resourceManager, uint32_t pipelineCount);
+
+			// Updates the copies of the render objects changed in the current frame, rebuilding all copies when the
+			// draw batches change, and rebuilds the indirect commands from the visible instances, uploading them if
+			// changed
+			void updateDraws
+			(
+				ResourceManager& resourceManager,
+				const RenderObjectManager& renderObjectManager,
+				const std::vector<MeshData>& meshes
+			);
+
+			// Binds the instance copies as the instance buffer
+			void bindInstanceCopies(const ResourceManager& resourceManager, vk::CommandBuffer commandBuffer) const;
+			// Draws the visible submeshes of a pipeline, returning the amount of draw calls recorded
+			uint32_t drawPipeline
+			(
+				const ResourceManager& resourceManager, vk::CommandBuffer commandBuffer, uint32_t pipelineIndex
+			) const;
+
+		private:
+			// Instance copies of a draw batch, with a range of one copy per render object for each submesh
+			struct BatchCopies
+			{
+				uint32_t firstCopy;
+				uint32_t submeshCount;
+			};
+
+			// Range of the indirect commands of a pipeline
+			struct CommandRange
+			{
+				uint32_t firstCommand;
+				uint32_t commandCount;
+			};
+
+			// Indirect commands of all pipelines, sorted by pipeline
+			ResourceID commandBufferID = 0U;
+			std::vector<vk::DrawIndexedIndirectCommand> drawCommands;
+			// Commands currently stored in the buffer, compared to skip unchanged uploads
+			std::vector<vk::DrawIndexedIndirectCommand> uploadedCommands;
+			// Commands of each pipeline
+			std::vector<CommandRange> pipelineCommands;
+
+			// Render object copies of each submesh draw, used as instance data
+			ResourceID instanceCopyBufferID = 0U;
+			std::vector<RenderObject> instanceCopies;
+			// Copies of each draw batch
+			std::vector<BatchCopies> batchCopies;
+			// Copies modified since the last upload
+			std::vector<uint32_t> dirtyCopies;
+			// Version of the draw batches which the copies were built from
+			uint64_t drawBatchVersion = std::numeric_limits<uint64_t>::max();
+
+			// Set if the commands are drawn from the buffer, instead of one direct call per command
+			bool multiDrawEnabled = false;
+
+			// Device reference
+			const Device& mtdDevice;
+
+			// Lays out the copies of each draw batch, copying all render objects
+			void buildCopies
+			(
+				const RenderObjectManager& renderObjectManager, const std::vector<MeshData>& meshes
+			);
+			// Copies a render object to each submesh draw of its batch
+			void writeCopies
+			(
+				const RenderObjectManager& renderObjectManager,
+				const std::vector<MeshData>& meshes,
+				uint32_t batchIndex,
+				uint32_t renderObjectIndex
+			);
+			// Uploads the modified copies, or all copies after a rebuild
+			void uploadCopies(ResourceManager& resourceManager, bool fullUpload);
+			// Grows the commands buffer to fit the commands and uploads them
+			void uploadDraws(ResourceManager& resourceManager);
+	};
+}
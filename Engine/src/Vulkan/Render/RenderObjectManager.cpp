@@ -1,93 +1,146 @@
 #include <pch.hpp>
 #include "RenderObjectManager.hpp"
 
+#include <meltdown/jobs.hpp>
+
 #include "../../Utils/Logger.hpp"
 
+// Marks scene instances without a render object
+#define INVALID_RENDER_OBJECT std::numeric_limits<uint32_t>::max()
+// Render objects whose world bounds are computed by each job when rebuilding the instance hierarchy
+#define HIERARCHY_GRAIN_SIZE 16384U
+
+// Checks if the draw batch renders the instance pipeline and mesh
+static bool matchesDrawBatch(const mtd::DrawBatch& drawBatch, const mtd::SceneInstance& instance)
+{
+    return drawBatch.pipelineID == instance.pipelineID && drawBatch.meshID == instance.meshID;
+}
+
 void mtd::RenderObjectManager::createBuffer(ResourceManager& resourceManager)
 {
+    renderObjects.clear();
+    renderObjectInstances.clear();
+    instanceRenderObjects.clear();
+    drawBatches.clear();
+    renderObjectVisibility.clear();
+    dirtyRenderObjects.clear();
+    fullUploadRequired = false;
+    changedRenderObjects.clear();
+    allRenderObjectsChanged = false;
+    culledPlanesValid = false;
+    drawBatchVersion++;
+    {
+        std::unique_lock hierarchyLock{hierarchyMutex};
+        instanceHierarchy.clear();
+    }
+
     renderObjectBufferID = resourceManager.createBuffer
     (
         "RenderObjectsBuffer",
-        GpuBufferType::Vertex | GpuBufferType::TransferSource,
-        GpuMemoryUsage::CpuUpload,
+        GpuBufferType::Vertex | GpuBufferType::TransferSource | GpuBufferType::TransferDestination,
+        GpuMemoryUsage::GpuOnly,
         sizeof(RenderObject)
     );
 }
 
-void mtd::RenderObjectManager::createFrameRenderObjects
+void mtd::RenderObjectManager::updateRenderObjects
 (
     ResourceManager& resourceManager,
     const std::vector<MeshData>& meshes,
-    const std::vector<SceneInstance>& sceneInstances,
-    std::vector<DrawBatch>& drawBatches,
+    InstanceManager& instanceManager,
     DescriptorManager& descriptorManager
 )
 {
-    for(const SceneInstance& instance: sceneInstances)
+    // Without render objects (e.g. after loading a scene), sorting all instances once is cheaper than inserting each
+    bool rebuildRequired = renderObjects.empty();
+    std::vector<std::pair<uint32_t, SceneInstance>> visibleInstances;
+    changedRenderObjects.clear();
+    allRenderObjectsChanged = false;
+    std::vector<uint32_t> changedInstances;
+
+    instanceManager.processChanges([&](uint32_t instanceIndex, const SceneInstance* pInstance)
     {
-        if(instance.visible)
-            visibleInstances.push_back(&instance);
-    }
+        changedInstances.push_back(instanceIndex);
+        if(!rebuildRequired)
+            updateInstance(instanceIndex, pInstance, meshes);
+        else if(pInstance && pInstance->visible)
+            visibleInstances.emplace_back(instanceIndex, *pInstance);
+    });
 
-    if(visibleInstances.empty()) return;
+    if(!visibleInstances.empty())
+        buildRenderObjects(visibleInstances, meshes);
+    if(!changedInstances.empty())
+        updateInstanceHierarchy(changedInstances);
 
-    std::sort
-    (
-        visibleInstances.begin(),
-        visibleInstances.end(),
-        [](const SceneInstance* a, const SceneInstance* b)
-        {
-            if(a->pipelineID != b->pipelineID)
-                return a->pipelineID < b->pipelineID;
-            return a->meshID < b->meshID;
-        }
-    );
+    if(fullUploadRequired || !dirtyRenderObjects.empty())
+        updateBufferData(resourceManager, descriptorManager);
+}
 
-    const SceneInstance* firstInstance = visibleInstances.front();
-    const MeshData& firstMesh = meshes[firstInstance->meshID];
-    renderObjects.push_back(RenderObject
-    {
-        firstInstance->transform,
-        firstInstance->materialSetID,
-        firstMesh.submeshOffset,
-        static_cast<uint32_t>(firstMesh.submeshes.size()),
-        firstMesh.vertexOffset,
-        firstMesh.centerAABB, 0.0f,
-        firstMesh.extentAABB, 0.0f
-    });
+void mtd::RenderObjectManager::cullRenderObjects
+(
+    ResourceManager& resourceManager,
+    DescriptorManager& descriptorManager,
+    const Mat4x4& projectionView,
+    const std::vector<RasterizationPipeline>& rasterizationPipelines
+)
+{
+    FrustumPlanes planes = FrustumCulling::extractPlanes(projectionView);
+    bool cameraMoved = !culledPlanesValid || planes != culledPlanes;
+    culledPlanes = planes;
+    culledPlanesValid = true;
 
-    drawBatches.push_back(DrawBatch{firstInstance->pipelineID, firstInstance->meshID, 0U, 0U});
-    DrawBatch* pCurrentBatch = &(drawBatches.back());
-
-    for(size_t i = 1UL; i < visibleInstances.size(); i++)
-    {
-        const SceneInstance* pInstance = visibleInstances[i];
-        const MeshData& mesh = meshes[firstInstance->meshID];
-        renderObjects.push_back(RenderObject{
-            pInstance->transform,
-            pInstance->materialSetID,
-            mesh.submeshOffset,
-            static_cast<uint32_t>(mesh.submeshes.size()),
-            mesh.vertexOffset,
-            mesh.centerAABB, 0.0f,
-            mesh.extentAABB, 0.0f
-        });
+    if(cameraMoved)
+    {
+        // Only this thread changes the hierarchy, so reading it does not need the lock
+        frustumInstances.clear();
+        instanceHierarchy.cullFrustum(planes, frustumInstances);
+
+        renderObjectVisibility.assign(renderObjects.size(), 0U);
+        for(uint32_t instanceIndex: frustumInstances)
+            renderObjectVisibility[instanceRenderObjects[instanceIndex]] = 1U;
+    }
+    else if(allRenderObjectsChanged)
+        FrustumCulling::cullRenderObjects(planes, renderObjects, renderObjectVisibility);
+    else if(!changedRenderObjects.empty())
+    {
+        // The other render objects keep their visibility, as neither them nor the frustum changed
+        std::sort(changedRenderObjects.begin(), changedRenderObjects.end());
+        changedRenderObjects.erase
+        (
+            std::unique(changedRenderObjects.begin(), changedRenderObjects.end()), changedRenderObjects.end()
+        );
+        FrustumCulling::cullRenderObjects(planes, renderObjects, changedRenderObjects, renderObjectVisibility);
+    }
 
-        if(pCurrentBatch->pipelineID != pInstance->pipelineID || pCurrentBatch->meshID != pInstance->meshID)
+    for(DrawBatch& drawBatch: drawBatches)
+    {
+        bool frustumCulling = drawBatch.pipelineID < rasterizationPipelines.size()
+            && rasterizationPipelines[drawBatch.pipelineID].isFrustumCullingEnabled();
+        if(!frustumCulling)
         {
-            pCurrentBatch->instanceCount = i - pCurrentBatch->firstInstance;
-            drawBatches.push_back(DrawBatch{pInstance->pipelineID, pInstance->meshID, static_cast<uint32_t>(i), 0U});
-            pCurrentBatch = &(drawBatches.back());
+            drawBatch.visibleInstanceCount = drawBatch.instanceCount;
+            continue;
         }
-    }
-    pCurrentBatch->instanceCount = visibleInstances.size() - pCurrentBatch->firstInstance;
 
-    visibleInstances.clear();
+        // Visible render objects from the end of the batch are swapped with hidden ones from the beginning, so only
+        // the render objects that changed visibility since the last frame are moved and uploaded again
+        uint32_t visibleEnd = drawBatch.firstInstance;
+        uint32_t hiddenBegin = drawBatch.firstInstance + drawBatch.instanceCount;
+        while(true)
+        {
+            while(visibleEnd < hiddenBegin && renderObjectVisibility[visibleEnd])
+                visibleEnd++;
+            while(visibleEnd < hiddenBegin && !renderObjectVisibility[hiddenBegin - 1U])
+                hiddenBegin--;
+            if(visibleEnd == hiddenBegin) break;
 
-    updateBufferData(resourceManager, descriptorManager);
+            swapRenderObjects(visibleEnd, hiddenBegin - 1U);
+        }
+        drawBatch.visibleInstanceCount = visibleEnd - drawBatch.firstInstance;
+    }
 
-    renderObjectCount = renderObjects.size();
-    renderObjects.clear();
+    if(!dirtyRenderObjects.empty())
+        updateBufferData(resourceManager, descriptorManager);
 }
 
 void mtd::RenderObjectManager::updateDescriptor
@@ -118,18 +171,343 @@ void mtd::RenderObjectManager::bindBuffer
     commandBuffer.bindVertexBuffers(1U, 1U, &buffer, &offset);
 }
 
+void mtd::RenderObjectManager::overlapBox(const BoundingBox& box, std::vector<uint32_t>& instanceIndices) const
+{
+    std::shared_lock hierarchyLock{hierarchyMutex};
+    instanceHierarchy.overlapBox(box, instanceIndices);
+}
+
+void mtd::RenderObjectManager::overlapSphere
+(
+    const Vec3& center, float radius, std::vector<uint32_t>& instanceIndices
+) const
+{
+    std::shared_lock hierarchyLock{hierarchyMutex};
+    instanceHierarchy.overlapSphere(center, radius, instanceIndices);
+}
+
+bool mtd::RenderObjectManager::raycast
+(
+    const Vec3& origin, const Vec3& direction, float maxDistance, uint32_t& instanceIndex, float& distance
+) const
+{
+    std::shared_lock hierarchyLock{hierarchyMutex};
+    return instanceHierarchy.raycast(origin, direction, maxDistance, instanceIndex, distance);
+}
+
+void mtd::RenderObjectManager::buildRenderObjects
+(
+    std::vector<std::pair<uint32_t, SceneInstance>>& visibleInstances, const std::vector<MeshData>& meshes
+)
+{
+    std::sort
+    (
+        visibleInstances.begin(),
+        visibleInstances.end(),
+        [](const std::pair<uint32_t, SceneInstance>& a, const std::pair<uint32_t, SceneInstance>& b)
+        {
+            if(a.second.pipelineID != b.second.pipelineID)
+                return a.second.pipelineID < b.second.pipelineID;
+            if(a.second.meshID != b.second.meshID)
+                return a.second.meshID < b.second.meshID;
+            return a.first < b.first;
+        }
+    );
+
+    renderObjects.resize(visibleInstances.size());
+    renderObjectInstances.resize(visibleInstances.size());
+    renderObjectVisibility.assign(visibleInstances.size(), 0U);
+    drawBatches.clear();
+
+    for(uint32_t i = 0U; i < visibleInstances.size(); i++)
+    {
+        const auto& [instanceIndex, instance] = visibleInstances[i];
+        writeRenderObject(i, instance, meshes[instance.meshID]);
+
+        renderObjectInstances[i] = instanceIndex;
+        if(instanceIndex >= instanceRenderObjects.size())
+            instanceRenderObjects.resize(instanceIndex + 1U, INVALID_RENDER_OBJECT);
+        instanceRenderObjects[instanceIndex] = i;
+
+        if(drawBatches.empty() || !matchesDrawBatch(drawBatches.back(), instance))
+            drawBatches.push_back(DrawBatch{instance.pipelineID, instance.meshID, i, 0U});
+        drawBatches.back().instanceCount++;
+    }
+
+    dirtyRenderObjects.clear();
+    fullUploadRequired = true;
+    drawBatchVersion++;
+}
+
+void mtd::RenderObjectManager::updateInstance
+(
+    uint32_t instanceIndex, const SceneInstance* pInstance, const std::vector<MeshData>& meshes
+)
+{
+    if(instanceIndex >= instanceRenderObjects.size())
+        instanceRenderObjects.resize(instanceIndex + 1U, INVALID_RENDER_OBJECT);
+
+    bool shouldRender = pInstance && pInstance->visible;
+    uint32_t renderObjectIndex = instanceRenderObjects[instanceIndex];
+    if(renderObjectIndex != INVALID_RENDER_OBJECT)
+    {
+        // Only pipeline or mesh changes move the render object to another draw batch
+        if(shouldRender && matchesDrawBatch(drawBatches[findDrawBatch(renderObjectIndex)], *pInstance))
+        {
+            writeRenderObject(renderObjectIndex, *pInstance, meshes[pInstance->meshID]);
+            dirtyRenderObjects.push_back(renderObjectIndex);
+            return;
+        }
+        removeRenderObject(renderObjectIndex);
+    }
+
+    if(shouldRender)
+        insertRenderObject(instanceIndex, *pInstance, meshes);
+}
+
+void mtd::RenderObjectManager::insertRenderObject
+(
+    uint32_t instanceIndex, const SceneInstance& instance, const std::vector<MeshData>& meshes
+)
+{
+    std::vector<DrawBatch>::iterator batchIterator = std::lower_bound
+    (
+        drawBatches.begin(),
+        drawBatches.end(),
+        instance,
+        [](const DrawBatch& drawBatch, const SceneInstance& instance)
+        {
+            if(drawBatch.pipelineID != instance.pipelineID)
+                return drawBatch.pipelineID < instance.pipelineID;
+            return drawBatch.meshID < instance.meshID;
+        }
+    );
+    if(batchIterator == drawBatches.end() || !matchesDrawBatch(*batchIterator, instance))
+    {
+        uint32_t firstInstance = (batchIterator == drawBatches.end())
+            ? static_cast<uint32_t>(renderObjects.size())
+            : batchIterator->firstInstance;
+        batchIterator = drawBatches.insert
+        (
+            batchIterator, DrawBatch{instance.pipelineID, instance.meshID, firstInstance, 0U}
+        );
+    }
+    uint32_t batchIndex = static_cast<uint32_t>(batchIterator - drawBatches.begin());
+
+    // Each following batch moves its first render object to its end, opening a slot after the target batch
+    renderObjects.emplace_back();
+    renderObjectInstances.emplace_back();
+    renderObjectVisibility.emplace_back(0U);
+    for(uint32_t i = static_cast<uint32_t>(drawBatches.size()) - 1U; i > batchIndex; i--)
+    {
+        DrawBatch& drawBatch = drawBatches[i];
+        moveRenderObject(drawBatch.firstInstance, drawBatch.firstInstance + drawBatch.instanceCount);
+        drawBatch.firstInstance++;
+    }
+
+    DrawBatch& drawBatch = drawBatches[batchIndex];
+    uint32_t renderObjectIndex = drawBatch.firstInstance + drawBatch.instanceCount;
+    drawBatch.instanceCount++;
+
+    writeRenderObject(renderObjectIndex, instance, meshes[instance.meshID]);
+    renderObjectInstances[renderObjectIndex] = instanceIndex;
+    instanceRenderObjects[instanceIndex] = renderObjectIndex;
+    dirtyRenderObjects.push_back(renderObjectIndex);
+    drawBatchVersion++;
+}
+
+void mtd::RenderObjectManager::removeRenderObject(uint32_t renderObjectIndex)
+{
+    uint32_t batchIndex = findDrawBatch(renderObjectIndex);
+    DrawBatch& drawBatch = drawBatches[batchIndex];
+
+    instanceRenderObjects[renderObjectInstances[renderObjectIndex]] = INVALID_RENDER_OBJECT;
+
+    // The last render object of the batch fills the gap, as the order inside a batch is irrelevant
+    uint32_t freeIndex = drawBatch.firstInstance + drawBatch.instanceCount - 1U;
+    if(renderObjectIndex != freeIndex)
+        moveRenderObject(freeIndex, renderObjectIndex);
+    drawBatch.instanceCount--;
+
+    // Each following batch moves its last render object to the slot before its beginning
+    for(uint32_t i = batchIndex + 1U; i < drawBatches.size(); i++)
+    {
+        DrawBatch& nextBatch = drawBatches[i];
+        nextBatch.firstInstance--;
+
+        uint32_t lastIndex = nextBatch.firstInstance + nextBatch.instanceCount;
+        moveRenderObject(lastIndex, freeIndex);
+        freeIndex = lastIndex;
+    }
+
+    renderObjects.pop_back();
+    renderObjectInstances.pop_back();
+    renderObjectVisibility.pop_back();
+
+    if(drawBatch.instanceCount == 0U)
+        drawBatches.erase(drawBatches.begin() + batchIndex);
+    drawBatchVersion++;
+}
+
+void mtd::RenderObjectManager::moveRenderObject(uint32_t sourceIndex, uint32_t destinationIndex)
+{
+    renderObjects[destinationIndex] = renderObjects[sourceIndex];
+    renderObjectInstances[destinationIndex] = renderObjectInstances[sourceIndex];
+    renderObjectVisibility[destinationIndex] = renderObjectVisibility[sourceIndex];
+    instanceRenderObjects[renderObjectInstances[destinationIndex]] = destinationIndex;
+    dirtyRenderObjects.push_back(destinationIndex);
+}
+
+void mtd::RenderObjectManager::swapRenderObjects(uint32_t firstIndex, uint32_t secondIndex)
+{
+    std::swap(renderObjects[firstIndex], renderObjects[secondIndex]);
+    std::swap(renderObjectInstances[firstIndex], renderObjectInstances[secondIndex]);
+    std::swap(renderObjectVisibility[firstIndex], renderObjectVisibility[secondIndex]);
+    instanceRenderObjects[renderObjectInstances[firstIndex]] = firstIndex;
+    instanceRenderObjects[renderObjectInstances[secondIndex]] = secondIndex;
+    dirtyRenderObjects.push_back(firstIndex);
+    dirtyRenderObjects.push_back(secondIndex);
+}
+
+void mtd::RenderObjectManager::writeRenderObject
+(
+    uint32_t renderObjectIndex, const SceneInstance& instance, const MeshData& mesh
+)
+{
+    renderObjects[renderObjectIndex] = RenderObject
+    {
+        instance.transform,
+        instance.materialSetID,
+        mesh.submeshOffset,
+        static_cast<uint32_t>(mesh.submeshes.size()),
+        mesh.vertexOffset,
+        mesh.centerAABB, 0.0f,
+        mesh.extentAABB, 0.0f
+    };
+}
+
+uint32_t mtd::RenderObjectManager::findDrawBatch(uint32_t renderObjectIndex) const
+{
+    std::vector<DrawBatch>::const_iterator batchIterator = std::upper_bound
+    (
+        drawBatches.cbegin(),
+        drawBatches.cend(),
+        renderObjectIndex,
+        [](uint32_t renderObjectIndex, const DrawBatch& drawBatch)
+        {
+            return renderObjectIndex < drawBatch.firstInstance;
+        }
+    );
+    assert(batchIterator != drawBatches.cbegin() && "Render object must belong to a draw batch.");
+    return static_cast<uint32_t>(batchIterator - drawBatches.cbegin()) - 1U;
+}
+
+mtd::BoundingBox mtd::RenderObjectManager::getWorldBounds(uint32_t renderObjectIndex) const
+{
+    const RenderObject& renderObject = renderObjects[renderObjectIndex];
+    return BoundingBox::fromTransformedBox(renderObject.transform, renderObject.centerAABB, renderObject.extentAABB);
+}
+
+void mtd::RenderObjectManager::updateInstanceHierarchy(const std::vector<uint32_t>& changedInstances)
+{
+    std::unique_lock hierarchyLock{hierarchyMutex};
+
+    // Past a quarter of the instances, a parallel build is faster than the incremental changes and keeps the
+    // hierarchy from degrading
+    if(4UL * changedInstances.size() >= instanceHierarchy.getLeafCount())
+    {
+        uint32_t renderObjectCount = static_cast<uint32_t>(renderObjects.size());
+        std::vector<BoundingBox> worldBounds(renderObjectCount);
+        JobSystem::parallelFor(0U, renderObjectCount, HIERARCHY_GRAIN_SIZE, [&](uint32_t begin, uint32_t end)
+        {
+            for(uint32_t i = begin; i < end; i++)
+                worldBounds[i] = getWorldBounds(i);
+        });
+
+        instanceHierarchy.build(renderObjectInstances, worldBounds);
+        return;
+    }
+
+    for(uint32_t instanceIndex: changedInstances)
+    {
+        uint32_t renderObjectIndex = (instanceIndex < instanceRenderObjects.size())
+            ? instanceRenderObjects[instanceIndex]
+            : INVALID_RENDER_OBJECT;
+
+        if(renderObjectIndex == INVALID_RENDER_OBJECT)
+            instanceHierarchy.remove(instanceIndex);
+        else
+            instanceHierarchy.update(instanceIndex, getWorldBounds(renderObjectIndex));
+    }
+}
+
 void mtd::RenderObjectManager::updateBufferData(ResourceManager& resourceManager, DescriptorManager& descriptorManager)
 {
     assert(renderObjectBufferID != 0U && "The render objects buffer must be created before updating it.");
 
+    if(renderObjects.empty())
+    {
+        dirtyRenderObjects.clear();
+        fullUploadRequired = false;
+        return;
+    }
+
     uint64_t minimumBufferSize = renderObjects.size() * sizeof(RenderObject);
     uint64_t currentBufferSize = resourceManager.getBufferSize(renderObjectBufferID);
     if(currentBufferSize < minimumBufferSize)
     {
-        resourceManager.resizeBuffer(renderObjectBufferID, minimumBufferSize);
+        // Grows geometrically, so instances added one by one do not resize the buffer every frame
+        resourceManager.resizeBuffer(renderObjectBufferID, std::max<uint64_t>(minimumBufferSize, 2UL * currentBufferSize));
         descriptorManager.updateResourceDescriptors(renderObjectBufferID);
+        fullUploadRequired = true;
+    }
+
+    if(fullUploadRequired)
+    {
+        if(!resourceManager.updateBufferData(renderObjectBufferID, minimumBufferSize, renderObjects.data()))
+            LOG_ERROR("Failed to update render objects buffer data.");
+
+        dirtyRenderObjects.clear();
+        allRenderObjectsChanged = true;
+        fullUploadRequired = false;
+        return;
     }
 
-    if(!resourceManager.updateBufferData(renderObjectBufferID, minimumBufferSize, renderObjects.data()))
-        LOG_ERROR("Failed to update render objects buffer data.");
+    std::sort(dirtyRenderObjects.begin(), dirtyRenderObjects.end());
+    dirtyRenderObjects.erase
+    (
+        std::unique(dirtyRenderObjects.begin(), dirtyRenderObjects.end()), dirtyRenderObjects.end()
+    );
+
+    // Contiguous dirty render objects are uploaded together, skipping the ones removed after being changed
+    size_t rangeBegin = 0UL;
+    while(rangeBegin < dirtyRenderObjects.size() && dirtyRenderObjects[rangeBegin] < renderObjects.size())
+    {
+        size_t rangeEnd = rangeBegin + 1UL;
+        while
+        (
+            rangeEnd < dirtyRenderObjects.size() &&
+            dirtyRenderObjects[rangeEnd] == dirtyRenderObjects[rangeEnd - 1UL] + 1U &&
+            dirtyRenderObjects[rangeEnd] < renderObjects.size()
+        )
+            rangeEnd++;
+
+        uint32_t firstIndex = dirtyRenderObjects[rangeBegin];
+        uint64_t rangeSize = (rangeEnd - rangeBegin) * sizeof(RenderObject);
+        if
+        (
+            !resourceManager.updateBufferData
+            (
+                renderObjectBufferID, rangeSize, &(renderObjects[firstIndex]), firstIndex * sizeof(RenderObject)
+            )
+        )
+            LOG_ERROR("Failed to update render objects buffer data.");
+
+        rangeBegin = rangeEnd;
+    }
+    changedRenderObjects.insert
+    (
+        changedRenderObjects.end(), dirtyRenderObjects.begin(), dirtyRenderObjects.begin() + rangeBegin
+    );
+    dirtyRenderObjects.clear();
 }
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <shared_mutex>
+
 #include "../Descriptors/DescriptorSetHandler.hpp"
 #include "../Descriptors/DescriptorManager.hpp"
+#include "../Pipeline/RasterizationPipeline.hpp"
+#include "../../Culling/BoundingVolumeHierarchy.hpp"
 #include "../../Scene/InstanceManager.hpp"
 
 namespace mtd
@@ -16,21 +20,40 @@ namespace mtd
             RenderObjectManager(const RenderObjectManager&) = delete;
             RenderObjectManager& operator=(const RenderObjectManager&) = delete;
 
-            // Getter
-            uint32_t getRenderObjectCount() const { return renderObjectCount; }
+            // Getters
+            uint32_t getRenderObjectCount() const { return static_cast<uint32_t>(renderObjects.size()); }
+            const std::vector<RenderObject>& getRenderObjects() const { return renderObjects; }
+            const std::vector<uint32_t>& getChangedRenderObjects() const { return changedRenderObjects; }
+            bool areAllRenderObjectsChanged() const { return allRenderObjectsChanged; }
+            const std::vector<DrawBatch>& getDrawBatches() const { return drawBatches; }
+            uint64_t getDrawBatchVersion() const { return drawBatchVersion; }
+            ResourceID getBufferID() const { return renderObjectBufferID; }
 
-            // Creates the render objects GPU buffer at the beginning of the scene
+            // Creates the render objects GPU buffer at the beginning of the scene, clearing the render objects
             void createBuffer(ResourceManager& resourceManager);
 
-            // Creates the render objects and the draw batches from the scene instances
-            void createFrameRenderObjects
+            // Applies the scene instance changes to the sorted render objects and to the instance hierarchy,
+            // uploading only the changed ranges
+            void updateRenderObjects
             (
                 ResourceManager& resourceManager,
                 const std::vector<MeshData>& meshes,
-                const std::vector<SceneInstance>& sceneInstances,
-                std::vector<DrawBatch>& drawBatches,
+                InstanceManager& instanceManager,
                 DescriptorManager& descriptorManager
             );
+            // Moves the render objects inside the camera frustum to the beginning of their draw batches, counting
+            // them as the visible instances of each batch. The instance hierarchy is traversed when the camera moves,
+            // otherwise only the render objects changed in this frame are tested again.
+            void cullRenderObjects
+            (
+                ResourceManager& resourceManager,
+                DescriptorManager& descriptorManager,
+                const Mat4x4& projectionView,
+                const std::vector<RasterizationPipeline>& rasterizationPipelines
+            );
+            // Finds the index of the draw batch containing the render object
+            uint32_t findDrawBatch(uint32_t renderObjectIndex) const;
+
             // Updates the descriptor data for the render objects buffer
             void updateDescriptor
             (
@@ -40,18 +63,82 @@ namespace mtd
             // Binds the render object buffer
             void bindBuffer(const ResourceManager& resourceManager, vk::CommandBuffer commandBuffer) const;
 
+            // Spatial queries over the world bounding boxes of the rendered instances, safe to call from any thread
+            void overlapBox(const BoundingBox& box, std::vector<uint32_t>& instanceIndices) const;
+            void overlapSphere(const Vec3& center, float radius, std::vector<uint32_t>& instanceIndices) const;
+            bool raycast
+            (
+                const Vec3& origin, const Vec3& direction, float maxDistance, uint32_t& instanceIndex, float& distance
+            ) const;
+
         private:
             // Resource ID for the render objects that will be used in the current frame
             ResourceID renderObjectBufferID = 0U;
 
-            // List of instances visible in the current frame
-            std::vector<const SceneInstance*> visibleInstances;
-            // List of render objects for the current frame
+            // Render objects of the visible instances, sorted by pipeline and mesh
             std::vector<RenderObject> renderObjects;
-            // Count of active render objects in the GPU buffer
-            uint32_t renderObjectCount = 0U;
+            // Scene instance index of each render object
+            std::vector<uint32_t> renderObjectInstances;
+            // Render object index of each scene instance, if rendered
+            std::vector<uint32_t> instanceRenderObjects;
+            // Draw batches, sorted by pipeline and mesh, each covering a range of render objects
+            std::vector<DrawBatch> drawBatches;
+            // Frustum culling result of each render object, moved along with the render objects
+            std::vector<uint8_t> renderObjectVisibility;
+            // Scene instances inside the camera frustum in the current frame
+            std::vector<uint32_t> frustumInstances;
+
+            // Hierarchy over the world bounding boxes of the rendered instances, keyed by scene instance index
+            BoundingVolumeHierarchy instanceHierarchy;
+            // Guards the instance hierarchy, which may be queried by other threads while being updated
+            mutable std::shared_mutex hierarchyMutex;
+            // Incremented whenever the draw batch ranges change, so the draws built from them can be rebuilt
+            uint64_t drawBatchVersion = 0UL;
+
+            // Render objects modified since the last upload
+            std::vector<uint32_t> dirtyRenderObjects;
+            // Flags if the whole buffer must be uploaded
+            bool fullUploadRequired = false;
+
+            // Render objects uploaded in the current frame, kept after the upload to be culled and copied again
+            std::vector<uint32_t> changedRenderObjects;
+            // Flags if all render objects were uploaded in the current frame
+            bool allRenderObjectsChanged = false;
+            // Frustum planes of the last culling, and whether the render object visibility matches them
+            FrustumPlanes culledPlanes{};
+            bool culledPlanesValid = false;
+
+            // Sorts and creates all render objects at once, used when there are no render objects yet
+            void buildRenderObjects
+            (
+                std::vector<std::pair<uint32_t, SceneInstance>>& visibleInstances, const std::vector<MeshData>& meshes
+            );
+            // Inserts, updates or removes the render object of a changed scene instance
+            void updateInstance
+            (
+                uint32_t instanceIndex, const SceneInstance* pInstance, const std::vector<MeshData>& meshes
+            );
+
+            // Inserts a render object at the end of its draw batch, shifting the following batches
+            void insertRenderObject
+            (
+                uint32_t instanceIndex, const SceneInstance& instance, const std::vector<MeshData>& meshes
+            );
+            // Removes a render object, filling the gap by shifting the following batches
+            void removeRenderObject(uint32_t renderObjectIndex);
+            // Moves a render object to another position, keeping the instance references
+            void moveRenderObject(uint32_t sourceIndex, uint32_t destinationIndex);
+            // Swaps the positions of two render objects, keeping the instance references
+            void swapRenderObjects(uint32_t firstIndex, uint32_t secondIndex);
+            // Writes the data of a scene instance to a render object
+            void writeRenderObject(uint32_t renderObjectIndex, const SceneInstance& instance, const MeshData& mesh);
+            // Computes the world bounding box of a render object
+            BoundingBox getWorldBounds(uint32_t renderObjectIndex) const;
+
+            // Applies the changed scene instances to the instance hierarchy, rebuilding it if most instances changed
+            void updateInstanceHierarchy(const std::vector<uint32_t>& changedInstances);
 
-            // Updates the render objects buffer contents
+            // Uploads the changed render objects to the buffer
             void updateBufferData(ResourceManager& resourceManager, DescriptorManager& descriptorManager);
     };
 }
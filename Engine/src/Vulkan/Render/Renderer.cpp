@@ -1,9 +1,14 @@
 #include <pch.hpp>
 #include "Renderer.hpp"
 
+#include <meltdown/jobs.hpp>
+
 #include "../../Utils/Logger.hpp"
 #include "../../Utils/Profiler.hpp"
 
+// Rasterization pipelines of a render pass recorded by each job into a secondary command buffer
+#define PIPELINES_PER_CHUNK 4U
+
 mtd::Renderer::Renderer(const Device& mtdDevice)
 	: mtdDevice{mtdDevice},
 	clearValues{vk::ClearColorValue{0.1f, 0.1f, 0.1f, 1.0f}, vk::ClearDepthStencilValue{1.0f, 0U}}
@@ -18,23 +23,40 @@ void mtd::Renderer::render
 (
 	const Swapchain& swapchain,
 	const ImGuiHandler& guiHandler,
-	const std::vector<Framebuffer>& framebuffers,
-	const PipelineBundle& pipelines,
-	const Scene& scene,
-	ResourceManager& resourceManager,
-	DescriptorManager& descriptorManager,
+	SceneContext& sceneContext,
+	const Mat4x4& projectionView,
 	DrawInfo& drawInfo,
 	std::atomic<bool>& shouldUpdateEngine
 )
 {
 	PROFILER_NEXT_STAGE("Render - Create render objects");
 
-	std::vector<DrawBatch> drawBatches;
-	renderObjectManager.createFrameRenderObjects
+	Scene& scene = sceneContext.getScene();
+	ResourceManager& resourceManager = sceneContext.getResourceManager();
+	RenderObjectManager& renderObjectManager = sceneContext.getRenderObjectManager();
+	renderObjectManager.updateRenderObjects
 	(
-		resourceManager, scene.getMeshes(), scene.getInstances(), drawBatches, descriptorManager
+		resourceManager, scene.getMeshes(), scene.getInstanceManager(), sceneContext.getDescriptorManager()
 	);
 
+	GpuCuller& gpuCuller = sceneContext.getGpuCuller();
+	if(gpuCuller.isEnabled())
+	{
+		gpuCuller.updateDraws(resourceManager, renderObjectManager, scene.getMeshes());
+	}
+	else
+	{
+		PROFILER_NEXT_STAGE("Render - CPU culling");
+		renderObjectManager.cullRenderObjects
+		(
+			resourceManager,
+			sceneContext.getDescriptorManager(),
+			projectionView,
+			sceneContext.getPipelines().rasterizationPipelines
+		);
+		sceneContext.getIndirectDrawer().updateDraws(resourceManager, renderObjectManager, scene.getMeshes());
+	}
+
 	PROFILER_NEXT_STAGE("Render - Acquire frame");
 
 	const vk::Device& device = mtdDevice.getDevice();
@@ -42,49 +64,65 @@ void mtd::Renderer::render
 	const vk::Fence& inFlightFence = frame.getInFlightFence();
 
 	(void) device.waitForFences(1U, &inFlightFence, vk::True, UINT64_MAX);
+
+	// The descriptor sets are shared by all frames, so the descriptors of the buffers recreated when growing are only
+	// written after the frames in flight finish. The current fence is still signaled, so no wait can block forever.
+	DescriptorManager& descriptorManager = sceneContext.getDescriptorManager();
+	if(descriptorManager.hasPendingWrites() || gpuCuller.hasOutdatedDescriptors(resourceManager))
+	{
+		PROFILER_ZONE("Render - Wait frames for descriptor writes");
+		swapchain.waitForFrames();
+		descriptorManager.writePendingDescriptors();
+		gpuCuller.updateDescriptors(resourceManager);
+	}
 	(void) device.resetFences(1U, &inFlightFence);
 
-	vk::Result result = device.acquireNextImageKHR
-	(
-		swapchain.getSwapchain(),
-		UINT64_MAX,
-		frame.getImageAvailableSemaphore(),
-		nullptr,
-		&currentFrameIndex
-	);
-	if(result != vk::Result::eSuccess)
+	if(!swapchain.isHeadless())
 	{
-		if
+		vk::Result result = device.acquireNextImageKHR
 		(
-			result == vk::Result::eErrorOutOfDateKHR ||
-			result == vk::Result::eErrorIncompatibleDisplayKHR ||
-			result == vk::Result::eSuboptimalKHR
-		)
+			swapchain.getSwapchain(),
+			UINT64_MAX,
+			frame.getImageAvailableSemaphore(),
+			nullptr,
+			&currentFrameIndex
+		);
+		if(result != vk::Result::eSuccess)
 		{
-			currentFrameIndex = 0U;
-			shouldUpdateEngine.store(true);
-		}
-		else
-		{
-			LOG_ERROR("Failed to acquire swapchain image. Vulkan result: %d", result);
+			if
+			(
+				result == vk::Result::eErrorOutOfDateKHR ||
+				result == vk::Result::eErrorIncompatibleDisplayKHR ||
+				result == vk::Result::eSuboptimalKHR
+			)
+			{
+				currentFrameIndex = 0U;
+				shouldUpdateEngine.store(true);
+			}
+			else
+			{
+				LOG_ERROR("Failed to acquire swapchain image. Vulkan result: %d", result);
+			}
+			return;
 		}
-		return;
 	}
 
 	swapchain.getFrame(currentFrameIndex).fetchFrameDrawData(drawInfo);
+	resourceManager.beginUploadFrame(currentFrameIndex, swapchain.getFrameCount());
+	scene.uploadMeshInstances(currentFrameIndex, swapchain.getFrameCount());
 	const CommandHandler& commandHandler = swapchain.getFrame(currentFrameIndex).getCommandHandler();
 
-	recordDrawCommands
-	(
-		framebuffers,
-		pipelines,
-		scene,
-		resourceManager,
-		commandHandler,
-		drawInfo,
-		drawBatches,
-		guiHandler
-	);
+	recordDrawCommands(sceneContext, commandHandler, drawInfo, guiHandler);
+	lastFrameIndex = currentFrameIndex;
+	submittedFrameCount++;
+
+	if(swapchain.isHeadless())
+	{
+		commandHandler.submitOffscreenDrawCommandBuffer(*(drawInfo.syncBundle));
+		currentFrameIndex = (currentFrameIndex + 1U) % swapchain.getFrameCount();
+		return;
+	}
+
 	commandHandler.submitDrawCommandBuffer(*(drawInfo.syncBundle));
 
 	PROFILER_NEXT_STAGE("Present frame");
@@ -98,31 +136,21 @@ void mtd::Renderer::render
 	currentFrameIndex = shouldUpdateEngine.load() ? 0U : (currentFrameIndex + 1U) % swapchain.getFrameCount();
 }
 
-void mtd::Renderer::createRenderObjectsBuffer(ResourceManager& resourceManager)
-{
-	renderObjectManager.createBuffer(resourceManager);
-}
-
-void mtd::Renderer::configureRendererDescriptor
-(
-	const ResourceManager& resourceManager, DescriptorSetHandler& descriptorSetHandler
-)
-{
-	renderObjectManager.updateDescriptor(resourceManager, descriptorSetHandler);
-}
-
 void mtd::Renderer::recordDrawCommands
 (
-	const std::vector<Framebuffer>& framebuffers,
-	const PipelineBundle& pipelines,
-	const Scene& scene,
-	const ResourceManager& resourceManager,
+	SceneContext& sceneContext,
 	const CommandHandler& commandHandler,
 	const DrawInfo& drawInfo,
-	const std::vector<DrawBatch>& drawBatches,
 	const ImGuiHandler& guiHandler
-) const
+)
 {
+	const std::vector<Framebuffer>& framebuffers = sceneContext.getFramebuffers();
+	const PipelineBundle& pipelines = sceneContext.getPipelines();
+	ResourceManager& resourceManager = sceneContext.getResourceManager();
+	const RenderObjectManager& renderObjectManager = sceneContext.getRenderObjectManager();
+	const GpuCuller& gpuCuller = sceneContext.getGpuCuller();
+	const std::vector<RenderPassInfo>& renderOrder = sceneContext.getRenderOrder();
+
 	assert
 	(
 		!(pipelines.rasterizationPipelines.empty() && pipelines.framebufferPipelines.empty()) &&
@@ -130,14 +158,15 @@ void mtd::Renderer::recordDrawCommands
 	);
 
 	const vk::CommandBuffer& commandBuffer = commandHandler.getCommandBuffer();
-	const vk::PipelineLayout& firstPipelineLayout =
-		pipelines.rasterizationPipelines.empty()
-		? pipelines.framebufferPipelines[0].getLayout()
-		: pipelines.rasterizationPipelines[0].getLayout();
 
 	commandHandler.beginCommand();
+	resourceManager.recordPendingUploads(commandBuffer);
 
-	scene.bindMeshData(resourceManager, commandBuffer);
+	if(gpuCuller.isEnabled())
+	{
+		PROFILER_NEXT_STAGE("Render - GPU culling");
+		gpuCuller.recordCulling(resourceManager, commandBuffer);
+	}
 
 	for(const ComputePipeline& computePipeline: pipelines.computePipelines)
 	{
@@ -152,16 +181,82 @@ void mtd::Renderer::recordDrawCommands
 		rayTracingPipeline.traceRays(commandBuffer, mtdDevice.getDLDI());
 	}
 
+	PROFILER_NEXT_STAGE("Render - Record render passes");
+
 	vk::Rect2D renderArea{};
 	renderArea.offset = vk::Offset2D{0, 0};
 
-	for(const RenderPassInfo& renderPassInfo: renderOrder)
+	renderPassBeginInfos.resize(renderOrder.size());
+	for(uint32_t passIndex = 0U; passIndex < renderOrder.size(); passIndex++)
 	{
-		int32_t fbIndex = renderPassInfo.targetFramebufferIndex;
+		int32_t fbIndex = renderOrder[passIndex].targetFramebufferIndex;
 		bool toSwapchain = (fbIndex == -1);
 
 		renderArea.extent = toSwapchain ? drawInfo.extent : framebuffers[fbIndex].getExtent();
 
+		vk::RenderPassBeginInfo& renderPassBeginInfo = renderPassBeginInfos[passIndex];
+		renderPassBeginInfo.renderPass = toSwapchain ? drawInfo.renderPass : framebuffers[fbIndex].getRenderPass();
+		renderPassBeginInfo.framebuffer =
+			toSwapchain ? *(drawInfo.framebuffer) : framebuffers[fbIndex].getFramebuffer();
+		renderPassBeginInfo.renderArea = renderArea;
+		renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
+		renderPassBeginInfo.pClearValues = clearValues.data();
+	}
+
+	// Without worker threads, the render passes are recorded inline, skipping the secondary command buffers
+	const bool parallelRecording = JobSystem::getWorkerCount() > 0U;
+	std::atomic<uint32_t> drawCallCount{0U};
+	JobCounter chunkCounter;
+	vk::CommandBuffer guiCommandBuffer{nullptr};
+
+	buildPassChunks(renderOrder);
+	if(parallelRecording)
+	{
+		for(PassChunk& passChunk: passChunks)
+		{
+			JobSystem::submit([this, &sceneContext, &commandHandler, &passChunk, &drawCallCount]()
+			{
+				const vk::RenderPassBeginInfo& renderPassBeginInfo = renderPassBeginInfos[passChunk.renderPassIndex];
+
+				vk::CommandBufferInheritanceInfo inheritanceInfo{};
+				inheritanceInfo.renderPass = renderPassBeginInfo.renderPass;
+				inheritanceInfo.subpass = 0U;
+				inheritanceInfo.framebuffer = renderPassBeginInfo.framebuffer;
+
+				passChunk.commandBuffer = commandHandler.beginSecondaryCommand(inheritanceInfo);
+				drawCallCount += recordPassChunk(sceneContext, passChunk, passChunk.commandBuffer);
+				passChunk.commandBuffer.end();
+			}, &chunkCounter);
+		}
+
+		// The GUI is updated along with its recording, so it stays in this thread while the jobs record the chunks
+		for(uint32_t passIndex = 0U; passIndex < renderOrder.size(); passIndex++)
+		{
+			if(renderOrder[passIndex].targetFramebufferIndex != -1) continue;
+
+			vk::CommandBufferInheritanceInfo inheritanceInfo{};
+			inheritanceInfo.renderPass = renderPassBeginInfos[passIndex].renderPass;
+			inheritanceInfo.subpass = 0U;
+			inheritanceInfo.framebuffer = renderPassBeginInfos[passIndex].framebuffer;
+
+			PROFILER_ZONE("Render - ImGUI");
+			guiCommandBuffer = commandHandler.beginSecondaryCommand(inheritanceInfo);
+			guiHandler.renderGui(guiCommandBuffer);
+			guiCommandBuffer.end();
+			break;
+		}
+
+		JobSystem::wait(chunkCounter);
+	}
+
+	uint32_t chunkIndex = 0U;
+	bool guiRecorded = false;
+	std::vector<vk::CommandBuffer> passCommandBuffers;
+	for(uint32_t passIndex = 0U; passIndex < renderOrder.size(); passIndex++)
+	{
+		const RenderPassInfo& renderPassInfo = renderOrder[passIndex];
+		bool toSwapchain = (renderPassInfo.targetFramebufferIndex == -1);
+
 		vk::ImageMemoryBarrier barrier{};
 		if(renderPassInfo.framebufferPipelineIndex.has_value())
 		{
@@ -175,63 +270,124 @@ void mtd::Renderer::recordDrawCommands
 			}
 		}
 
-		vk::RenderPassBeginInfo renderPassBeginInfo{};
-		renderPassBeginInfo.renderPass = toSwapchain ? drawInfo.renderPass : framebuffers[fbIndex].getRenderPass();
-		renderPassBeginInfo.framebuffer =
-			toSwapchain ? *(drawInfo.framebuffer) : framebuffers[fbIndex].getFramebuffer();
-		renderPassBeginInfo.renderArea = renderArea;
-		renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-		renderPassBeginInfo.pClearValues = clearValues.data();
-
-		commandBuffer.beginRenderPass(&renderPassBeginInfo, vk::SubpassContents::eInline);
+		commandBuffer.beginRenderPass
+		(
+			&(renderPassBeginInfos[passIndex]),
+			parallelRecording ? vk::SubpassContents::eSecondaryCommandBuffers : vk::SubpassContents::eInline
+		);
 
-		if(renderPassInfo.framebufferPipelineIndex.has_value())
+		// The chunks are sorted by render pass, so the ones of this pass follow the previous pass chunks
+		passCommandBuffers.clear();
+		for(; chunkIndex < passChunks.size() && passChunks[chunkIndex].renderPassIndex == passIndex; chunkIndex++)
 		{
-			const FramebufferPipeline& fbPipeline =
-				pipelines.framebufferPipelines[renderPassInfo.framebufferPipelineIndex.value()];
-			PROFILER_NEXT_STAGE(fbPipeline.getName().c_str());
+			if(parallelRecording)
+				passCommandBuffers.push_back(passChunks[chunkIndex].commandBuffer);
+			else
+				drawCallCount += recordPassChunk(sceneContext, passChunks[chunkIndex], commandBuffer);
+		}
 
-			fbPipeline.bind(commandBuffer);
-			commandBuffer.draw(3U, 1U, 0U, 0U);
+		// The GUI is drawn once, over the first render pass to the swapchain
+		if(toSwapchain && !guiRecorded)
+		{
+			if(parallelRecording)
+			{
+				passCommandBuffers.push_back(guiCommandBuffer);
+			}
+			else
+			{
+				PROFILER_ZONE("Render - ImGUI");
+				guiHandler.renderGui(commandBuffer);
+			}
+			guiRecorded = true;
 		}
 
-		renderObjectManager.bindBuffer(resourceManager, commandBuffer);
-		const std::vector<MeshData>& meshes = scene.getMeshes();
+		if(!passCommandBuffers.empty())
+			commandBuffer.executeCommands(static_cast<uint32_t>(passCommandBuffers.size()), passCommandBuffers.data());
 
-		for(uint32_t pipelineIndex: renderPassInfo.pipelineIndices)
-		{
-			const RasterizationPipeline& rasterizationPipeline = pipelines.rasterizationPipelines[pipelineIndex];
-			PROFILER_NEXT_STAGE(rasterizationPipeline.getName().c_str());
+		commandBuffer.endRenderPass();
+	}
+	commandHandler.endCommand();
 
-			rasterizationPipeline.bind(commandBuffer);
+	PROFILER_ADD_DRAW_CALLS(drawCallCount.load());
+}
 
-			for(const DrawBatch& drawBatch: drawBatches)
-			{
-				if(drawBatch.pipelineID != pipelineIndex) continue;
-				const MeshData& mesh = meshes[drawBatch.meshID];
+void mtd::Renderer::buildPassChunks(const std::vector<RenderPassInfo>& renderOrder)
+{
+	passChunks.clear();
+	for(uint32_t passIndex = 0U; passIndex < renderOrder.size(); passIndex++)
+	{
+		const RenderPassInfo& renderPassInfo = renderOrder[passIndex];
+		uint32_t pipelineCount = static_cast<uint32_t>(renderPassInfo.pipelineIndices.size());
 
-				for(const SubmeshData& submesh: mesh.submeshes)
+		// The framebuffer pipeline is drawn first, so it goes to the first chunk of the pass
+		bool framebufferPipeline = renderPassInfo.framebufferPipelineIndex.has_value();
+		if(framebufferPipeline && pipelineCount == 0U)
+			passChunks.push_back(PassChunk{passIndex, 0U, 0U, true, nullptr});
+
+		for(uint32_t firstPipeline = 0U; firstPipeline < pipelineCount; firstPipeline += PIPELINES_PER_CHUNK)
+		{
+			passChunks.push_back
+			(
+				PassChunk
 				{
-					rasterizationPipeline.pushConstant(commandBuffer, submesh.materialSlot);
-					commandBuffer.drawIndexed
-					(
-						submesh.indexCount, drawBatch.instanceCount,
-						mesh.indexOffset + submesh.indexOffset, mesh.vertexOffset,
-						drawBatch.firstInstance
-					);
+					passIndex,
+					firstPipeline,
+					std::min(pipelineCount - firstPipeline, PIPELINES_PER_CHUNK),
+					framebufferPipeline && firstPipeline == 0U,
+					nullptr
 				}
-			}
+			);
 		}
+	}
+}
 
-		if(toSwapchain)
-		{
-			PROFILER_NEXT_STAGE("Render - ImGUI");
-			guiHandler.renderGui(commandBuffer);
-		}
+uint32_t mtd::Renderer::recordPassChunk
+(
+	SceneContext& sceneContext, const PassChunk& passChunk, vk::CommandBuffer commandBuffer
+) const
+{
+	const PipelineBundle& pipelines = sceneContext.getPipelines();
+	const RenderPassInfo& renderPassInfo = sceneContext.getRenderOrder()[passChunk.renderPassIndex];
+	const ResourceManager& resourceManager = sceneContext.getResourceManager();
+	const GpuCuller& gpuCuller = sceneContext.getGpuCuller();
+	const IndirectDrawer& indirectDrawer = sceneContext.getIndirectDrawer();
+	uint32_t drawCallCount = 0U;
+
+	if(passChunk.framebufferPipeline)
+	{
+		const FramebufferPipeline& fbPipeline =
+			pipelines.framebufferPipelines[renderPassInfo.framebufferPipelineIndex.value()];
+		PROFILER_ZONE(fbPipeline.getName().c_str());
 
-		commandBuffer.endRenderPass();
+		fbPipeline.bind(commandBuffer);
+		commandBuffer.draw(3U, 1U, 0U, 0U);
+		drawCallCount++;
 	}
-	commandHandler.endCommand();
+	if(passChunk.pipelineCount == 0U) return drawCallCount;
+
+	// Secondary command buffers do not inherit the bound buffers, so each chunk binds its own
+	sceneContext.getScene().bindMeshData(resourceManager, commandBuffer);
+	if(gpuCuller.isEnabled())
+		gpuCuller.bindVisibleObjects(resourceManager, commandBuffer);
+	else
+		indirectDrawer.bindInstanceCopies(resourceManager, commandBuffer);
+
+	for(uint32_t i = passChunk.firstPipeline; i < passChunk.firstPipeline + passChunk.pipelineCount; i++)
+	{
+		uint32_t pipelineIndex = renderPassInfo.pipelineIndices[i];
+		const RasterizationPipeline& rasterizationPipeline = pipelines.rasterizationPipelines[pipelineIndex];
+		PROFILER_ZONE(rasterizationPipeline.getName().c_str());
+
+		rasterizationPipeline.bind(commandBuffer);
+
+		// The drawn instances already carry their submesh material slot
+		rasterizationPipeline.pushConstant(commandBuffer, 0U);
+		if(gpuCuller.isEnabled())
+			drawCallCount += gpuCuller.drawPipeline(resourceManager, commandBuffer, pipelineIndex);
+		else
+			drawCallCount += indirectDrawer.drawPipeline(resourceManager, commandBuffer, pipelineIndex);
+	}
+	return drawCallCount;
 }
 
 void mtd::Renderer::presentFrame
@@ -247,6 +403,7 @@ void mtd::Renderer::presentFrame
 	presentInfo.pImageIndices = &currentFrameIndex;
 	presentInfo.pResults = nullptr;
 
+	std::lock_guard<std::mutex> queueLock{mtdDevice.getQueueMutex()};
 	vk::Result result = presentQueue.presentKHR(&presentInfo);
 	if
 	(
@@ -1,11 +1,7 @@
 #pragma once
 
-#include "RenderObjectManager.hpp"
-#include "../Frame/Swapchain.hpp"
-#include "../Frame/Framebuffer.hpp"
 #include "../ImGui/ImGuiHandler.hpp"
-#include "../Pipeline/PipelineBundles.hpp"
-#include "../../Scene/Scene.hpp"
+#include "../../Scene/SceneContext.hpp"
 
 namespace mtd
 {
@@ -19,8 +15,9 @@ namespace mtd
 			Renderer(const Renderer&) = delete;
 			Renderer& operator=(const Renderer&) = delete;
 
-			// Getter
-			std::vector<RenderPassInfo>& getRenderOrder() { return renderOrder; }
+			// Getters
+			uint32_t getLastFrameIndex() const { return lastFrameIndex; }
+			uint64_t getSubmittedFrameCount() const { return submittedFrameCount; }
 
 			// Setter
 			void setClearColor(const Vec4& color);
@@ -30,48 +27,52 @@ namespace mtd
 			(
 				const Swapchain& swapchain,
 				const ImGuiHandler& guiHandler,
-				const std::vector<Framebuffer>& framebuffers,
-				const PipelineBundle& pipelines,
-				const Scene& scene,
-				ResourceManager& resourceManager,
-				DescriptorManager& descriptorManager,
+				SceneContext& sceneContext,
+				const Mat4x4& projectionView,
 				DrawInfo& drawInfo,
 				std::atomic<bool>& shouldUpdateEngine
 			);
 
-			// Creates the render objects GPU buffer
-			void createRenderObjectsBuffer(ResourceManager& resourceManager);
-			// Configures the descriptor for the render objects
-			void configureRendererDescriptor
-			(
-				const ResourceManager& resourceManager, DescriptorSetHandler& descriptorSetHandler
-			);
-
 		private:
+			// Consecutive rasterization pipelines of a render pass, recorded together into a secondary command buffer
+			struct PassChunk
+			{
+				uint32_t renderPassIndex;
+				uint32_t firstPipeline;
+				uint32_t pipelineCount;
+				bool framebufferPipeline;
+				vk::CommandBuffer commandBuffer;
+			};
+
 			// Index of the frame being rendered
 			uint32_t currentFrameIndex = 0U;
+			// Index of the last frame submitted for rendering
+			uint32_t lastFrameIndex = 0U;
+			// Amount of frames submitted since the engine started
+			uint64_t submittedFrameCount = 0UL;
 			// Framebuffer clear values
 			std::array<vk::ClearValue, 2> clearValues;
-			// Order which the framebuffers will be rendered
-			std::vector<RenderPassInfo> renderOrder;
-
-			// Handler for per frame data to be sent to the GPU
-			RenderObjectManager renderObjectManager;
+			// Begin infos of the render passes in the current frame, and their chunks sorted by render pass
+			std::vector<vk::RenderPassBeginInfo> renderPassBeginInfos;
+			std::vector<PassChunk> passChunks;
 
 			// Device reference
 			const Device& mtdDevice;
 
-			// Records draw commands to the command buffer
+			// Records draw commands to the command buffer, recording the render pass chunks in the job system
 			void recordDrawCommands
 			(
-				const std::vector<Framebuffer>& framebuffers,
-				const PipelineBundle& pipelines,
-				const Scene& scene,
-				const ResourceManager& resourceManager,
+				SceneContext& sceneContext,
 				const CommandHandler& commandHandler,
 				const DrawInfo& drawInfo,
-				const std::vector<DrawBatch>& drawBatches,
 				const ImGuiHandler& guiHandler
+			);
+			// Splits the rasterization pipelines of each render pass into chunks
+			void buildPassChunks(const std::vector<RenderPassInfo>& renderOrder);
+			// Records the draws of a render pass chunk, returning the amount of draw calls
+			uint32_t recordPassChunk
+			(
+				SceneContext& sceneContext, const PassChunk& passChunk, vk::CommandBuffer commandBuffer
 			) const;
 
 			// Presents frame to screen when ready